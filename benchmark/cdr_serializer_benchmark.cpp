@@ -0,0 +1,239 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Parker-Lord Inertial Device Driver Implementation File
+//
+// Copyright (c) 2017, Brian Bingham
+// Copyright (c) 2020, Parker Hannifin Corp
+// This code is licensed under MIT license (see LICENSE file for details)
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Compares serializing the fixed layout messages with CdrSerializer against serializing them with the middleware.
+// Built against the ROS 2 driver library by configuring with -DMICROSTRAIN_BUILD_BENCHMARKS=ON, and run with
+//   cdr_serializer_benchmark [iterations]
+// Each message type is serialized the given number of times both ways, changing the stamp every time like the driver does when publishing.
+// The wall and CPU time per message and the throughput are printed for both, and the serialized bytes are checked to be identical
+
+#include <time.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "rclcpp/serialization.hpp"
+
+#include "microstrain_inertial_driver_common/utils/cdr_serializer.h"
+
+// Number of times each message is serialized before timing starts, so the buffers are allocated and the caches are warm
+constexpr size_t WARMUP_ITERATIONS = 1000;
+
+/**
+ * Time taken to serialize a message
+ */
+struct Timing
+{
+  double wall_ns = 0;  /// Wall time per message in nanoseconds
+  double cpu_ns = 0;  /// CPU time of this thread per message in nanoseconds
+  size_t bytes = 0;  /// Size of the serialized message in bytes
+};
+
+/**
+ * \brief Gets the CPU time used by the calling thread
+ * \return CPU time used by the calling thread in seconds
+ */
+static double threadCpuSecs()
+{
+  timespec cpu_time;
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &cpu_time);
+  return static_cast<double>(cpu_time.tv_sec) + static_cast<double>(cpu_time.tv_nsec) / 1000000000.0;
+}
+
+/**
+ * \brief Times a serialization function
+ * \param iterations Number of messages to serialize
+ * \param serialize Function that serializes message i and returns the size of the serialized message
+ * \return Time taken per message
+ */
+template<typename Serialize>
+static Timing timeSerialize(const size_t iterations, Serialize serialize)
+{
+  Timing timing;
+  for (size_t i = 0; i < WARMUP_ITERATIONS; i++)
+    timing.bytes = serialize(i);
+
+  const auto wall_start = std::chrono::steady_clock::now();
+  const double cpu_start = threadCpuSecs();
+  for (size_t i = 0; i < iterations; i++)
+    timing.bytes = serialize(i);
+  const double cpu_end = threadCpuSecs();
+  const auto wall_end = std::chrono::steady_clock::now();
+
+  timing.wall_ns = std::chrono::duration<double, std::nano>(wall_end - wall_start).count() / iterations;
+  timing.cpu_ns = (cpu_end - cpu_start) * 1000000000.0 / iterations;
+  return timing;
+}
+
+/**
+ * \brief Prints a timing as one row of the results
+ * \param name Name of the message type
+ * \param path Name of the serialization path
+ * \param timing The timing to print
+ */
+static void printTiming(const char* name, const char* path, const Timing& timing)
+{
+  const double megabytes_per_second = timing.bytes / timing.wall_ns * 1000.0;
+  printf("%-28s %-10s %6zu %12.1f %12.1f %12.1f\n", name, path, timing.bytes, timing.wall_ns, timing.cpu_ns, megabytes_per_second);
+}
+
+/**
+ * \brief Benchmarks both serialization paths for one message type
+ * \param name Name of the message type
+ * \param msg Message to serialize. The stamp is changed for every message
+ * \param iterations Number of messages to serialize with each path
+ * \return true if both paths produced the same bytes
+ */
+template<typename MessageType>
+static bool benchmark(const char* name, MessageType msg, const size_t iterations)
+{
+  microstrain::CdrSerializer<MessageType> direct;
+  rclcpp::Serialization<MessageType> middleware;
+  rclcpp::SerializedMessage middleware_msg;
+
+  const Timing direct_timing = timeSerialize(iterations, [&](const size_t i)
+  {
+    msg.header.stamp.nanosec = static_cast<uint32_t>(i % 1000000000);
+    return direct.serialize(msg).size();
+  });
+  const Timing middleware_timing = timeSerialize(iterations, [&](const size_t i)
+  {
+    msg.header.stamp.nanosec = static_cast<uint32_t>(i % 1000000000);
+    middleware.serialize_message(&msg, &middleware_msg);
+    return middleware_msg.size();
+  });
+  printTiming(name, "direct", direct_timing);
+  printTiming(name, "middleware", middleware_timing);
+  printf("%-28s speedup %.2fx wall, %.2fx CPU\n", name, middleware_timing.wall_ns / direct_timing.wall_ns, middleware_timing.cpu_ns / direct_timing.cpu_ns);
+
+  // Both paths have to produce a message any subscriber can read, so they should be byte for byte the same
+  const rcl_serialized_message_t& direct_bytes = direct.serialize(msg).get_rcl_serialized_message();
+  middleware.serialize_message(&msg, &middleware_msg);
+  const rcl_serialized_message_t& middleware_bytes = middleware_msg.get_rcl_serialized_message();
+  const bool identical = direct_bytes.buffer_length == middleware_bytes.buffer_length &&
+      memcmp(direct_bytes.buffer, middleware_bytes.buffer, direct_bytes.buffer_length) == 0;
+  if (!identical)
+    printf("%-28s ERROR: direct serialization does not match the middleware\n", name);
+  return identical;
+}
+
+/**
+ * \brief Benchmarks both serialization paths for raw IMU samples. The middleware path has to convert the sample to a message first
+ * \param sample Sample to serialize. The stamp is changed for every sample
+ * \param iterations Number of samples to serialize with each path
+ * \return true if both paths produced the same bytes
+ */
+static bool benchmarkImuSample(microstrain::ImuSample sample, const size_t iterations)
+{
+  const char* name = "ImuSample";
+  microstrain::CdrSerializer<microstrain::ImuSample> direct;
+  rclcpp::Serialization<microstrain::ImuMsg> middleware;
+  rclcpp::SerializedMessage middleware_msg;
+  microstrain::ImuMsg converted;
+
+  const Timing direct_timing = timeSerialize(iterations, [&](const size_t i)
+  {
+    sample.header.stamp.nanosec = static_cast<uint32_t>(i % 1000000000);
+    return direct.serialize(sample).size();
+  });
+  const Timing middleware_timing = timeSerialize(iterations, [&](const size_t i)
+  {
+    sample.header.stamp.nanosec = static_cast<uint32_t>(i % 1000000000);
+    microstrain::toRosMessage(sample, &converted);
+    middleware.serialize_message(&converted, &middleware_msg);
+    return middleware_msg.size();
+  });
+  printTiming(name, "direct", direct_timing);
+  printTiming(name, "middleware", middleware_timing);
+  printf("%-28s speedup %.2fx wall, %.2fx CPU\n", name, middleware_timing.wall_ns / direct_timing.wall_ns, middleware_timing.cpu_ns / direct_timing.cpu_ns);
+
+  const rcl_serialized_message_t& direct_bytes = direct.serialize(sample).get_rcl_serialized_message();
+  microstrain::toRosMessage(sample, &converted);
+  middleware.serialize_message(&converted, &middleware_msg);
+  const rcl_serialized_message_t& middleware_bytes = middleware_msg.get_rcl_serialized_message();
+  const bool identical = direct_bytes.buffer_length == middleware_bytes.buffer_length &&
+      memcmp(direct_bytes.buffer, middleware_bytes.buffer, direct_bytes.buffer_length) == 0;
+  if (!identical)
+    printf("%-28s ERROR: direct serialization does not match the middleware\n", name);
+  return identical;
+}
+
+/**
+ * \brief Fills an array with distinct values, so a misplaced value shows up when the paths are compared
+ * \param values The array to fill
+ * \param start The first value
+ */
+template<typename ArrayType>
+static void fillArray(ArrayType* values, const double start)
+{
+  for (size_t i = 0; i < values->size(); i++)
+    (*values)[i] = start + i * 0.001;
+}
+
+int main(int argc, char** argv)
+{
+  const size_t iterations = argc > 1 ? static_cast<size_t>(strtoull(argv[1], nullptr, 10)) : 1000000;
+  if (iterations == 0)
+  {
+    fprintf(stderr, "Usage: %s [iterations]\n", argv[0]);
+    return 1;
+  }
+
+  // Same frame IDs the driver publishes with by default
+  microstrain::ImuMsg imu;
+  imu.header.frame_id = "imu_link";
+  imu.header.stamp.sec = 1700000000;
+  imu.orientation.w = 1;
+  imu.angular_velocity.z = 0.01;
+  imu.linear_acceleration.z = -9.81;
+  fillArray(&imu.orientation_covariance, 1);
+  fillArray(&imu.angular_velocity_covariance, 2);
+  fillArray(&imu.linear_acceleration_covariance, 3);
+
+  // Raw IMU topic, which publishes samples that share their covariance
+  microstrain::ImuSample imu_sample;
+  imu_sample.header = imu.header;
+  imu_sample.angular_velocity = imu.angular_velocity;
+  imu_sample.linear_acceleration = imu.linear_acceleration;
+  auto imu_sample_covariance = std::make_shared<microstrain::ImuSample::Covariance>();
+  fillArray(&imu_sample_covariance->angular_velocity, 2);
+  fillArray(&imu_sample_covariance->linear_acceleration, 3);
+  imu_sample.covariance = imu_sample_covariance;
+
+  microstrain::OdometryMsg odometry;
+  odometry.header.frame_id = "earth";
+  odometry.header.stamp.sec = 1700000000;
+  odometry.child_frame_id = "base_link";
+  odometry.pose.pose.position.x = -1000000.5;
+  odometry.pose.pose.position.y = 4000000.25;
+  odometry.pose.pose.position.z = 5000000.125;
+  odometry.pose.pose.orientation.w = 1;
+  odometry.twist.twist.linear.x = 1.5;
+  fillArray(&odometry.pose.covariance, 4);
+  fillArray(&odometry.twist.covariance, 5);
+
+  microstrain::TwistWithCovarianceStampedMsg twist;
+  twist.header.frame_id = "base_link";
+  twist.header.stamp.sec = 1700000000;
+  twist.twist.twist.linear.x = 1.5;
+  twist.twist.twist.angular.z = 0.1;
+  fillArray(&twist.twist.covariance, 6);
+
+  printf("%zu messages of each type\n", iterations);
+  printf("%-28s %-10s %6s %12s %12s %12s\n", "message", "path", "bytes", "wall ns/msg", "CPU ns/msg", "MB/s");
+  bool identical = true;
+  identical &= benchmark("sensor_msgs/Imu", imu, iterations);
+  identical &= benchmarkImuSample(imu_sample, iterations);
+  identical &= benchmark("nav_msgs/Odometry", odometry, iterations);
+  identical &= benchmark("TwistWithCovarianceStamped", twist, iterations);
+  return identical ? 0 : 1;
+}
@@ -0,0 +1,172 @@
+# Sources, include directories and build options shared by the ROS and ROS 2 driver packages.
+#
+# Include this from the driver package's CMakeLists.txt once the ROS dependencies and the MIP SDK have been found, for example
+#   include(${COMMON_DIR}/cmake/microstrain_inertial_driver_common.cmake)
+#   add_library(${PROJECT_NAME} ${MICROSTRAIN_COMMON_SRC_FILES} ...)
+#   target_include_directories(${PROJECT_NAME} PUBLIC ${MICROSTRAIN_COMMON_INC_DIRS} ...)
+#   microstrain_common_configure_target(${PROJECT_NAME})
+# New files in src/ are added to MICROSTRAIN_COMMON_SRC_FILES here, so the packages pick them up without changes of their own.
+
+set(MICROSTRAIN_COMMON_DIR "${CMAKE_CURRENT_LIST_DIR}/..")
+get_filename_component(MICROSTRAIN_COMMON_DIR "${MICROSTRAIN_COMMON_DIR}" ABSOLUTE)
+set(MICROSTRAIN_COMMON_SRC_DIR "${MICROSTRAIN_COMMON_DIR}/src")
+set(MICROSTRAIN_COMMON_INC_DIRS "${MICROSTRAIN_COMMON_DIR}/include")
+
+# Headers of the MIP SDK submodule. The packages build the SDK itself, but the tests below only need its headers
+set(MICROSTRAIN_MIP_SDK_DIR "${MICROSTRAIN_COMMON_DIR}/mip_sdk" CACHE PATH "Path to the MIP SDK")
+set(MICROSTRAIN_MIP_SDK_INC_DIRS "${MICROSTRAIN_MIP_SDK_DIR}/src/c" "${MICROSTRAIN_MIP_SDK_DIR}/src/cpp")
+
+set(MICROSTRAIN_COMMON_SRC_FILES
+  ${MICROSTRAIN_COMMON_SRC_DIR}/config.cpp
+  ${MICROSTRAIN_COMMON_SRC_DIR}/node_common.cpp
+  ${MICROSTRAIN_COMMON_SRC_DIR}/publishers.cpp
+  ${MICROSTRAIN_COMMON_SRC_DIR}/services.cpp
+  ${MICROSTRAIN_COMMON_SRC_DIR}/subscribers.cpp
+  ${MICROSTRAIN_COMMON_SRC_DIR}/utils/aiding_callback_benchmark.cpp
+  ${MICROSTRAIN_COMMON_SRC_DIR}/utils/aiding_health.cpp
+  ${MICROSTRAIN_COMMON_SRC_DIR}/utils/allan_variance.cpp
+  ${MICROSTRAIN_COMMON_SRC_DIR}/utils/byte_proxy.cpp
+  ${MICROSTRAIN_COMMON_SRC_DIR}/utils/cdr_serializer.cpp
+  ${MICROSTRAIN_COMMON_SRC_DIR}/utils/clock.cpp
+  ${MICROSTRAIN_COMMON_SRC_DIR}/utils/clock_bias_monitor.cpp
+  ${MICROSTRAIN_COMMON_SRC_DIR}/utils/dejitter_stage.cpp
+  ${MICROSTRAIN_COMMON_SRC_DIR}/utils/gnss_integrity.cpp
+  ${MICROSTRAIN_COMMON_SRC_DIR}/utils/handoff.cpp
+  ${MICROSTRAIN_COMMON_SRC_DIR}/utils/imu_sample.cpp
+  ${MICROSTRAIN_COMMON_SRC_DIR}/utils/mag_calibrator.cpp
+  ${MICROSTRAIN_COMMON_SRC_DIR}/utils/memory_tracker.cpp
+  ${MICROSTRAIN_COMMON_SRC_DIR}/utils/nmea_generator.cpp
+  ${MICROSTRAIN_COMMON_SRC_DIR}/utils/perf_profiler.cpp
+  ${MICROSTRAIN_COMMON_SRC_DIR}/utils/realtime.cpp
+  ${MICROSTRAIN_COMMON_SRC_DIR}/utils/rtcm_framer.cpp
+  ${MICROSTRAIN_COMMON_SRC_DIR}/utils/target_frame_transform.cpp
+  ${MICROSTRAIN_COMMON_SRC_DIR}/utils/vibration_analyzer.cpp
+  ${MICROSTRAIN_COMMON_SRC_DIR}/utils/windowed_statistics.cpp
+  ${MICROSTRAIN_COMMON_SRC_DIR}/utils/mappings/mip_mapping.cpp
+  ${MICROSTRAIN_COMMON_SRC_DIR}/utils/mappings/mip_publisher_mapping.cpp
+  ${MICROSTRAIN_COMMON_SRC_DIR}/utils/mip/emulated_aiding_device.cpp
+  ${MICROSTRAIN_COMMON_SRC_DIR}/utils/mip/replay_connection.cpp
+  ${MICROSTRAIN_COMMON_SRC_DIR}/utils/mip/ros_connection.cpp
+  ${MICROSTRAIN_COMMON_SRC_DIR}/utils/mip/ros_mip_device.cpp
+  ${MICROSTRAIN_COMMON_SRC_DIR}/utils/mip/ros_mip_device_aux.cpp
+  ${MICROSTRAIN_COMMON_SRC_DIR}/utils/mip/ros_mip_device_main.cpp
+  ${MICROSTRAIN_COMMON_SRC_DIR}/utils/mip/serial_fd_connection.cpp
+)
+
+# Device families and features compiled into the driver. See include/microstrain_inertial_driver_common/utils/build_profile.h
+set(MICROSTRAIN_BUILD_PROFILE "full" CACHE STRING "Build profile of the driver: full, gq7 or cv7")
+set_property(CACHE MICROSTRAIN_BUILD_PROFILE PROPERTY STRINGS full gq7 cv7)
+if(NOT MICROSTRAIN_BUILD_PROFILE MATCHES "^(full|gq7|cv7)$")
+  message(FATAL_ERROR "MICROSTRAIN_BUILD_PROFILE must be full, gq7 or cv7, not ${MICROSTRAIN_BUILD_PROFILE}")
+endif()
+string(TOUPPER "${MICROSTRAIN_BUILD_PROFILE}" MICROSTRAIN_BUILD_PROFILE_UPPER)
+
+# Lets the linker drop the handlers the build profile no longer references
+option(MICROSTRAIN_GC_SECTIONS "Compile with -ffunction-sections -fdata-sections and link with --gc-sections" OFF)
+
+# Both of these replace the global allocation functions, so they are off unless asked for
+option(MICROSTRAIN_MEMORY_TRACKING "Attribute heap usage to driver subsystems. See memory_tracking_enable in params.yml" OFF)
+option(MICROSTRAIN_RT_AUDIT "Report allocations on the hot path while rt_audit is enabled. See rt_audit in params.yml" OFF)
+
+# Tests that do not need ROS or a device
+option(MICROSTRAIN_BUILD_TESTS "Build the tests in the test directory" OFF)
+
+# Benchmarks in the benchmark directory. They link against the driver library, so they are only built by the ROS 2 package
+option(MICROSTRAIN_BUILD_BENCHMARKS "Build the benchmarks in the benchmark directory" OFF)
+
+# Harnesses in the fuzz directory, built with ASan and UBSan. See fuzz/README.md
+option(MICROSTRAIN_BUILD_FUZZERS "Build the harnesses in the fuzz directory with the sanitizers" OFF)
+if(MICROSTRAIN_BUILD_FUZZERS)
+  set(MICROSTRAIN_SANITIZE_FLAGS -fsanitize=address,undefined -fno-sanitize-recover=undefined -fno-omit-frame-pointer -g -O1)
+  if(CMAKE_CXX_COMPILER_ID MATCHES "Clang")
+    set(MICROSTRAIN_FUZZ_MAIN "")
+    set(MICROSTRAIN_FUZZ_ENGINE_FLAG -fsanitize=fuzzer)
+    set(MICROSTRAIN_FUZZ_INSTRUMENT_FLAG -fsanitize=fuzzer-no-link)
+    set(MICROSTRAIN_FUZZ_CORPUS_ARGS -runs=0)
+  else()
+    # Without libFuzzer the harnesses can only run the inputs they are given, which is still enough to check the corpus and reproduce a crash
+    message(STATUS "libFuzzer needs clang, so the fuzzing harnesses will only run the inputs they are given")
+    set(MICROSTRAIN_FUZZ_MAIN ${MICROSTRAIN_COMMON_DIR}/fuzz/replay_main.cpp)
+    set(MICROSTRAIN_FUZZ_ENGINE_FLAG "")
+    set(MICROSTRAIN_FUZZ_INSTRUMENT_FLAG "")
+    set(MICROSTRAIN_FUZZ_CORPUS_ARGS "")
+  endif()
+  string(REPLACE ";" " " MICROSTRAIN_SANITIZE_LINK_FLAGS "${MICROSTRAIN_SANITIZE_FLAGS}")
+endif()
+
+# Applies the options above to a target built from MICROSTRAIN_COMMON_SRC_FILES
+function(microstrain_common_configure_target target)
+  target_compile_definitions(${target} PRIVATE MICROSTRAIN_BUILD_PROFILE=MICROSTRAIN_BUILD_PROFILE_${MICROSTRAIN_BUILD_PROFILE_UPPER})
+  if(MICROSTRAIN_GC_SECTIONS)
+    target_compile_options(${target} PRIVATE -ffunction-sections -fdata-sections)
+    set_property(TARGET ${target} APPEND_STRING PROPERTY LINK_FLAGS " -Wl,--gc-sections")
+  endif()
+  if(MICROSTRAIN_MEMORY_TRACKING)
+    target_compile_definitions(${target} PRIVATE MICROSTRAIN_MEMORY_TRACKING)
+  endif()
+  if(MICROSTRAIN_RT_AUDIT)
+    target_compile_definitions(${target} PRIVATE MICROSTRAIN_RT_AUDIT)
+  endif()
+
+  # Everything a harness links has to be built with the sanitizers, so they check the driver as well as the harness
+  if(MICROSTRAIN_BUILD_FUZZERS)
+    target_compile_options(${target} PRIVATE ${MICROSTRAIN_SANITIZE_FLAGS} ${MICROSTRAIN_FUZZ_INSTRUMENT_FLAG})
+    set_property(TARGET ${target} APPEND_STRING PROPERTY LINK_FLAGS " ${MICROSTRAIN_SANITIZE_LINK_FLAGS}")
+  endif()
+endfunction()
+
+# Adds the benchmarks, linked against the driver library and built with the same definitions as it.
+# Call it from the package's CMakeLists.txt after the library. Does nothing unless MICROSTRAIN_BUILD_BENCHMARKS is on
+function(microstrain_common_add_benchmarks library_target)
+  if(NOT MICROSTRAIN_BUILD_BENCHMARKS)
+    return()
+  endif()
+  if(NOT rclcpp_FOUND)
+    message(FATAL_ERROR "The benchmarks serialize with rclcpp, so they can only be built by the ROS 2 package")
+  endif()
+  add_executable(cdr_serializer_benchmark ${MICROSTRAIN_COMMON_DIR}/benchmark/cdr_serializer_benchmark.cpp)
+  target_include_directories(cdr_serializer_benchmark PRIVATE ${MICROSTRAIN_COMMON_INC_DIRS})
+  target_link_libraries(cdr_serializer_benchmark ${library_target})
+endfunction()
+
+if(MICROSTRAIN_BUILD_FUZZERS)
+  find_package(Threads REQUIRED)
+  enable_testing()
+
+  # Adds a harness built from one file in the fuzz directory and the sources it fuzzes, and a test that runs it on its checked in corpus
+  function(microstrain_common_add_fuzzer name corpus)
+    add_executable(${name} ${MICROSTRAIN_COMMON_DIR}/fuzz/${name}.cpp ${MICROSTRAIN_FUZZ_MAIN} ${ARGN})
+    target_include_directories(${name} PRIVATE ${MICROSTRAIN_COMMON_INC_DIRS} ${MICROSTRAIN_MIP_SDK_INC_DIRS})
+    target_compile_options(${name} PRIVATE ${MICROSTRAIN_SANITIZE_FLAGS} ${MICROSTRAIN_FUZZ_ENGINE_FLAG})
+    set_property(TARGET ${name} APPEND_STRING PROPERTY LINK_FLAGS " ${MICROSTRAIN_SANITIZE_LINK_FLAGS} ${MICROSTRAIN_FUZZ_ENGINE_FLAG}")
+    target_link_libraries(${name} Threads::Threads)
+    add_test(NAME ${name} COMMAND ${name} ${MICROSTRAIN_FUZZ_CORPUS_ARGS} ${MICROSTRAIN_COMMON_DIR}/fuzz/corpus/${corpus})
+  endfunction()
+
+  # Adds the harness that runs the whole driver, linked against the ROS 2 driver library. Call it from the package's CMakeLists.txt after the library.
+  # The harnesses that do not need ROS are built by fuzz/CMakeLists.txt
+  function(microstrain_common_add_fuzzers library_target)
+    if(NOT rclcpp_FOUND)
+      message(FATAL_ERROR "mip_dispatch_fuzzer runs the driver on a ROS 2 node, so it can only be built by the ROS 2 package")
+    endif()
+    microstrain_common_add_fuzzer(mip_dispatch_fuzzer mip_dispatch)
+    target_link_libraries(mip_dispatch_fuzzer ${library_target})
+  endfunction()
+endif()
+
+if(MICROSTRAIN_BUILD_TESTS)
+  find_package(GTest REQUIRED)
+  find_package(Threads REQUIRED)
+  enable_testing()
+
+  # Adds a test built from one file in the test directory and the sources it tests
+  function(microstrain_common_add_test name)
+    add_executable(${name} ${MICROSTRAIN_COMMON_DIR}/test/${name}.cpp ${ARGN})
+    target_include_directories(${name} PRIVATE ${MICROSTRAIN_COMMON_INC_DIRS} ${MICROSTRAIN_MIP_SDK_INC_DIRS})
+    target_link_libraries(${name} GTest::GTest GTest::Main Threads::Threads)
+    add_test(NAME ${name} COMMAND ${name})
+  endfunction()
+
+  microstrain_common_add_test(test_byte_proxy ${MICROSTRAIN_COMMON_SRC_DIR}/utils/byte_proxy.cpp)
+  microstrain_common_add_test(test_handoff ${MICROSTRAIN_COMMON_SRC_DIR}/utils/handoff.cpp)
+endif()
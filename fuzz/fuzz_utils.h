@@ -0,0 +1,150 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Parker-Lord Driver Definition File
+//
+// Copyright (c) 2017, Brian Bingham
+// Copyright (c) 2020, Parker Hannifin Corp
+//
+// This code is licensed under MIT license (see LICENSE file for details)
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef MICROSTRAIN_INERTIAL_DRIVER_COMMON_FUZZ_FUZZ_UTILS_H
+#define MICROSTRAIN_INERTIAL_DRIVER_COMMON_FUZZ_FUZZ_UTILS_H
+
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <cstdint>
+#include <algorithm>
+
+#include "microstrain_inertial_driver_common/utils/ros_compat.h"
+#include "microstrain_inertial_driver_common/utils/clock.h"
+
+#ifndef MICROSTRAIN_ROS_STUB
+#include "rcutils/logging.h"
+#endif
+
+// Largest number of bytes written to the port at once. Well under what a socket pair buffers, so a write never blocks
+constexpr size_t FUZZ_FEED_CHUNK_SIZE = 4096;
+
+// Sanitizer settings the harnesses run with. Options set in ASAN_OPTIONS or UBSAN_OPTIONS still take priority.
+// The ROS client library keeps allocations alive until exit, so leaks are only reported by the harnesses built with the stub ROS layer
+extern "C" const char* __asan_default_options()
+{
+#ifdef MICROSTRAIN_ROS_STUB
+  return "detect_leaks=1:detect_stack_use_after_return=1:check_initialization_order=1:strict_init_order=1";
+#else
+  return "detect_leaks=0:detect_stack_use_after_return=1:check_initialization_order=1:strict_init_order=1";
+#endif
+}
+extern "C" const char* __ubsan_default_options()
+{
+  return "print_stacktrace=1:halt_on_error=1";
+}
+
+namespace microstrain
+{
+
+/**
+ * Clock that moves forward a millisecond every time it is read. Stamps are the same on every run of an input,
+ * and anything waiting on the clock, like a command waiting on a reply that will never come, still times out
+ */
+class SteppingClock : public Clock
+{
+ public:
+  RosTimeType rosNow() const final
+  {
+    const int64_t nanoseconds = nanoseconds_.fetch_add(1000000) + 1000000;
+    RosTimeType time;
+    setRosTime(&time, static_cast<int32_t>(nanoseconds / 1000000000), static_cast<int32_t>(nanoseconds % 1000000000));
+    return time;
+  }
+
+  void sleepFor(const double seconds) final
+  {
+    if (seconds > 0)
+      nanoseconds_ += static_cast<int64_t>(seconds * 1000000000.0);
+  }
+
+ private:
+  mutable std::atomic<int64_t> nanoseconds_{1700000000LL * 1000000000LL};  /// The current time in nanoseconds
+};
+
+#ifndef MICROSTRAIN_ROS_STUB
+/**
+ * \brief Starts ROS and creates the node the harness runs the driver on. Nothing subscribes to the node and it is never spun,
+ *        so publishing stops at the middleware. Only errors are logged, so the output is not flooded by every packet
+ * \param argc Pointer to the argument count passed to LLVMFuzzerInitialize
+ * \param argv Pointer to the arguments passed to LLVMFuzzerInitialize
+ * \param name Name of the node
+ * \param parameters Parameters to start the node with, in place of a params file
+ * \return The node
+ */
+inline std::shared_ptr<RosNodeType> createFuzzNode(int* argc, char*** argv, const std::string& name, const std::vector<rclcpp::Parameter>& parameters)
+{
+  setenv("ROS_LOCALHOST_ONLY", "1", 0);
+  rclcpp::init(*argc, *argv);
+  rcutils_logging_set_default_logger_level(RCUTILS_LOG_SEVERITY_ERROR);
+  return std::make_shared<RosNodeType>(name, rclcpp::NodeOptions().parameter_overrides(parameters));
+}
+#endif
+
+/**
+ * \brief Opens a pair of connected sockets that stand in for a serial port
+ * \param device_fd End of the pair the harness writes to, in place of the device
+ * \param driver_fd End of the pair the driver reads from, in place of the port
+ * \return true if the pair was opened
+ */
+inline bool openFuzzPort(int* device_fd, int* driver_fd)
+{
+  int fds[2];
+  if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) != 0)
+    return false;
+  *device_fd = fds[0];
+  *driver_fd = fds[1];
+  return true;
+}
+
+/**
+ * \brief Writes data to the device end of the port in pieces, and has the driver read each piece before writing the next
+ * \param device_fd End of the pair the harness writes to
+ * \param driver_fd End of the pair the driver reads from
+ * \param data The data to write
+ * \param size Number of bytes in data
+ * \param read Called while the driver end has bytes waiting. Must read at least one byte from it every call
+ * \return true if all the data was written and read
+ */
+template<typename Read>
+inline bool feedFuzzPort(const int device_fd, const int driver_fd, const uint8_t* data, const size_t size, Read read)
+{
+  size_t offset = 0;
+  while (offset < size)
+  {
+    const ssize_t written = write(device_fd, data + offset, std::min(size - offset, FUZZ_FEED_CHUNK_SIZE));
+    if (written <= 0)
+      return false;
+    offset += static_cast<size_t>(written);
+
+    // Every read takes at least a byte, so more reads than bytes means the driver stopped reading
+    int available = 0;
+    size_t reads = 0;
+    while (ioctl(driver_fd, FIONREAD, &available) == 0 && available > 0)
+    {
+      if (reads++ > FUZZ_FEED_CHUNK_SIZE)
+        return false;
+      read();
+    }
+  }
+  return true;
+}
+
+}  // namespace microstrain
+
+#endif  // MICROSTRAIN_INERTIAL_DRIVER_COMMON_FUZZ_FUZZ_UTILS_H
@@ -0,0 +1,121 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Parker-Lord Inertial Device Driver Implementation File
+//
+// Copyright (c) 2017, Brian Bingham
+// Copyright (c) 2020, Parker Hannifin Corp
+// This code is licensed under MIT license (see LICENSE file for details)
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Fuzzes everything bytes from the main port go through: the connection, the MIP parser, the data callbacks and the publishers.
+// The driver is started the same way it is when it takes over from a running driver, on one end of a socket pair that stands in for the port,
+// with a device that supports every descriptor. That way it is configured without sending a single command, and every input is just
+// bytes the device sent. Each input is written to the other end of the pair and parsed the same way the main port timer does.
+// This is the only harness that needs ROS 2, since it runs the publishers. mip_parser_fuzzer covers the parsing without them. See README.md for how to build and run it
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "microstrain_inertial_driver_common/node_common.h"
+
+#include "fuzz_utils.h"
+#include "mip_mutator.h"
+
+// Base rate given to every descriptor set of the device, and the rate every topic is streamed at
+constexpr uint16_t FUZZ_BASE_RATE = 1000;
+constexpr double FUZZ_DATA_RATE = 100;
+
+// Time to let pass after every input. Longer than the parse timeout, so a packet one input leaves incomplete is dropped before the next one
+constexpr double INPUT_GAP_SECS = 2.0;
+
+/**
+ * Node that runs the driver on a port that looks like it was handed off by a running driver
+ */
+class FuzzNode : public microstrain::NodeCommon
+{
+ public:
+  /**
+   * \brief Configures and activates the driver on a port, without sending any commands to it
+   * \param node The node to run the driver on
+   * \param driver_fd End of the socket pair the driver reads from. The driver takes ownership of it
+   * \param clock Clock the driver stamps data and waits with
+   * \return true if the driver was started
+   */
+  bool start(RosNodeType* node, const int driver_fd, std::shared_ptr<microstrain::Clock> clock)
+  {
+    auto state = std::make_shared<microstrain::HandoffState>();
+    strncpy(state->device_info.model_name, "3DM-GQ7", sizeof(state->device_info.model_name) - 1);
+    strncpy(state->device_info.serial_number, "fuzz", sizeof(state->device_info.serial_number) - 1);
+    state->device_info.firmware_version = 1000;
+    for (const uint8_t descriptor_set : DESCRIPTOR_SETS)
+    {
+      state->base_rates[descriptor_set] = FUZZ_BASE_RATE;
+      for (uint16_t field_descriptor = 1; field_descriptor <= UINT8_MAX; field_descriptor++)
+        state->supported_descriptors.push_back(static_cast<uint16_t>((descriptor_set << 8) | field_descriptor));
+    }
+
+    // The driver only leaves the device alone if it streams exactly what the previous driver did, so work out what that is first
+    int scratch_device_fd, scratch_driver_fd;
+    if (!microstrain::openFuzzPort(&scratch_device_fd, &scratch_driver_fd))
+      return false;
+    {
+      state->main_fd = scratch_driver_fd;
+      auto scratch_device = std::make_shared<microstrain::RosMipDeviceMain>(node, clock);
+      if (!scratch_device->adopt(node, *state))
+        return false;
+      microstrain::MipPublisherMapping scratch_mapping(node, scratch_device);
+      if (!scratch_mapping.configure(node, false))
+        return false;
+      state->stream_hash = scratch_mapping.streamHash();
+    }
+    close(scratch_device_fd);
+
+    state->main_fd = driver_fd;
+    if (!initialize(node))
+      return false;
+    config_.clock_ = clock;
+    config_.handoff_state_ = state;
+    return configure(node) && activate();
+  }
+};
+
+static std::shared_ptr<RosNodeType> node;
+static std::shared_ptr<microstrain::SteppingClock> fuzz_clock;
+static std::unique_ptr<FuzzNode> fuzz_node;
+static int device_fd = -1;
+static int driver_fd = -1;
+
+extern "C" int LLVMFuzzerInitialize(int* argc, char*** argv)
+{
+  // Stream every topic, and leave out anything that would talk to something other than the port
+  std::vector<rclcpp::Parameter> parameters = {
+    rclcpp::Parameter("device_setup", false),
+    rclcpp::Parameter("ntrip_interface_enable", false),
+  };
+  for (const auto& topic_to_data_rate_config_key : microstrain::MipPublisherMapping::static_topic_to_data_rate_config_key_mapping_)
+    parameters.emplace_back(topic_to_data_rate_config_key.second, FUZZ_DATA_RATE);
+  node = microstrain::createFuzzNode(argc, argv, "mip_dispatch_fuzzer", parameters);
+
+  fuzz_clock = std::make_shared<microstrain::SteppingClock>();
+  fuzz_node = std::unique_ptr<FuzzNode>(new FuzzNode());
+  if (!microstrain::openFuzzPort(&device_fd, &driver_fd) || !fuzz_node->start(node.get(), driver_fd, fuzz_clock))
+  {
+    fprintf(stderr, "Failed to start the driver on the fuzzing port\n");
+    abort();
+  }
+  return 0;
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size)
+{
+  if (!microstrain::feedFuzzPort(device_fd, driver_fd, data, size, []() { fuzz_node->parseAndPublishMain(); }))
+    abort();
+
+  // Let the parser time out anything left incomplete, so it does not run into the next input
+  fuzz_clock->sleepFor(INPUT_GAP_SECS);
+  fuzz_node->parseAndPublishMain();
+  return 0;
+}
@@ -0,0 +1,176 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Parker-Lord Driver Definition File
+//
+// Copyright (c) 2017, Brian Bingham
+// Copyright (c) 2020, Parker Hannifin Corp
+//
+// This code is licensed under MIT license (see LICENSE file for details)
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Custom mutator for the harnesses that take MIP packets. It keeps inputs as valid MIP packets most of the time, so they get past the checksum
+// and reach the callbacks. Include it in exactly one file of a harness
+
+#ifndef MICROSTRAIN_INERTIAL_DRIVER_COMMON_FUZZ_MIP_MUTATOR_H
+#define MICROSTRAIN_INERTIAL_DRIVER_COMMON_FUZZ_MIP_MUTATOR_H
+
+#include <cstring>
+#include <random>
+#include <vector>
+#include <cstdint>
+
+#include "mip/definitions/commands_base.hpp"
+#include "mip/definitions/commands_3dm.hpp"
+#include "mip/definitions/data_sensor.hpp"
+#include "mip/definitions/data_gnss.hpp"
+#include "mip/definitions/data_filter.hpp"
+#include "mip/definitions/data_system.hpp"
+
+// MIP packet layout
+constexpr uint8_t MIP_SYNC1 = 0x75;
+constexpr uint8_t MIP_SYNC2 = 0x65;
+constexpr size_t MIP_HEADER_SIZE = 4;
+constexpr size_t MIP_CHECKSUM_SIZE = 2;
+constexpr size_t MIP_FIELD_HEADER_SIZE = 2;
+constexpr size_t MIP_MAX_PAYLOAD_SIZE = 255;
+
+// Largest field the mutator adds
+constexpr size_t MAX_NEW_FIELD_DATA_SIZE = 32;
+
+// Descriptor sets the mutator gives the packets it adds. The data sets the driver has callbacks for, and the command sets it gets replies from
+static const uint8_t DESCRIPTOR_SETS[] = {
+  mip::data_sensor::DESCRIPTOR_SET, mip::data_gnss::DESCRIPTOR_SET, mip::data_gnss::MIP_GNSS1_DATA_DESC_SET, mip::data_gnss::MIP_GNSS2_DATA_DESC_SET,
+  mip::data_gnss::MIP_GNSS3_DATA_DESC_SET, mip::data_filter::DESCRIPTOR_SET, mip::data_system::DESCRIPTOR_SET,
+  mip::commands_base::DESCRIPTOR_SET, mip::commands_3dm::DESCRIPTOR_SET,
+};
+
+extern "C" size_t LLVMFuzzerMutate(uint8_t* data, size_t size, size_t max_size);
+
+/**
+ * \brief Splits data into the MIP packets in it. Checksums are not checked, and anything between packets is dropped
+ * \param data The data to split
+ * \param size Number of bytes in data
+ * \param packets Vector to append the header and payload of each packet to
+ */
+static void splitPackets(const uint8_t* data, const size_t size, std::vector<std::vector<uint8_t>>* packets)
+{
+  size_t offset = 0;
+  while (offset + MIP_HEADER_SIZE + MIP_CHECKSUM_SIZE <= size)
+  {
+    const size_t packet_size = MIP_HEADER_SIZE + data[offset + 3] + MIP_CHECKSUM_SIZE;
+    if (data[offset] != MIP_SYNC1 || data[offset + 1] != MIP_SYNC2 || offset + packet_size > size)
+    {
+      offset++;
+      continue;
+    }
+    packets->emplace_back(data + offset, data + offset + packet_size - MIP_CHECKSUM_SIZE);
+    offset += packet_size;
+  }
+}
+
+/**
+ * \brief Fixes the field lengths in a packet so the fields exactly fill the payload, and the payload length to match
+ * \param packet The header and payload of the packet
+ */
+static void repairFields(std::vector<uint8_t>* packet)
+{
+  size_t offset = MIP_HEADER_SIZE;
+  while (offset < packet->size())
+  {
+    const size_t remaining = packet->size() - offset;
+    if (remaining < MIP_FIELD_HEADER_SIZE)
+    {
+      packet->resize(offset);
+      break;
+    }
+    if ((*packet)[offset] < MIP_FIELD_HEADER_SIZE || (*packet)[offset] > remaining)
+      (*packet)[offset] = static_cast<uint8_t>(remaining);
+    offset += (*packet)[offset];
+  }
+  (*packet)[3] = static_cast<uint8_t>(packet->size() - MIP_HEADER_SIZE);
+}
+
+/**
+ * \brief Appends a field with random contents to a packet, if there is room for it
+ * \param packet The header and payload of the packet
+ * \param random Random number generator to fill the field with
+ */
+static void addField(std::vector<uint8_t>* packet, std::minstd_rand* random)
+{
+  const size_t data_size = (*random)() % (MAX_NEW_FIELD_DATA_SIZE + 1);
+  if (packet->size() - MIP_HEADER_SIZE + MIP_FIELD_HEADER_SIZE + data_size > MIP_MAX_PAYLOAD_SIZE)
+    return;
+  packet->push_back(static_cast<uint8_t>(MIP_FIELD_HEADER_SIZE + data_size));
+  packet->push_back(static_cast<uint8_t>((*random)() % UINT8_MAX + 1));
+  for (size_t i = 0; i < data_size; i++)
+    packet->push_back(static_cast<uint8_t>((*random)()));
+  (*packet)[3] = static_cast<uint8_t>(packet->size() - MIP_HEADER_SIZE);
+}
+
+/**
+ * \brief Mutates inputs as a list of MIP packets, and writes them back with valid framing and checksums
+ */
+extern "C" size_t LLVMFuzzerCustomMutator(uint8_t* data, size_t size, size_t max_size, unsigned int seed)
+{
+  std::minstd_rand random(seed);
+
+  // Now and then mutate the raw bytes, so broken framing and bad checksums are still covered
+  if (random() % 8 == 0)
+    return LLVMFuzzerMutate(data, size, max_size);
+
+  std::vector<std::vector<uint8_t>> packets;
+  splitPackets(data, size, &packets);
+  const uint8_t descriptor_set = DESCRIPTOR_SETS[random() % sizeof(DESCRIPTOR_SETS)];
+  std::vector<uint8_t>* packet = packets.empty() ? nullptr : &packets[random() % packets.size()];
+  switch (packet == nullptr ? 0 : random() % 5)
+  {
+    case 0:  // Add a packet with a single field
+    {
+      std::vector<uint8_t> new_packet = {MIP_SYNC1, MIP_SYNC2, descriptor_set, 0};
+      addField(&new_packet, &random);
+      packets.insert(packets.begin() + random() % (packets.size() + 1), new_packet);
+      break;
+    }
+    case 1:  // Add a field to a packet
+      addField(packet, &random);
+      break;
+    case 2:  // Mutate the payload of a packet
+    {
+      uint8_t payload[MIP_MAX_PAYLOAD_SIZE];
+      const size_t payload_size = packet->size() - MIP_HEADER_SIZE;
+      memcpy(payload, packet->data() + MIP_HEADER_SIZE, payload_size);
+      packet->resize(MIP_HEADER_SIZE + LLVMFuzzerMutate(payload, payload_size, sizeof(payload)));
+      memcpy(packet->data() + MIP_HEADER_SIZE, payload, packet->size() - MIP_HEADER_SIZE);
+      break;
+    }
+    case 3:  // Move a packet to another descriptor set
+      (*packet)[2] = descriptor_set;
+      break;
+    default:  // Drop a packet
+      packets.erase(packets.begin() + (packet - packets.data()));
+      break;
+  }
+
+  // Write the packets back with their checksums, leaving off any that do not fit
+  size_t out_size = 0;
+  for (auto& out_packet : packets)
+  {
+    repairFields(&out_packet);
+    if (out_size + out_packet.size() + MIP_CHECKSUM_SIZE > max_size)
+      break;
+    uint8_t checksum_msb = 0, checksum_lsb = 0;
+    for (const uint8_t byte : out_packet)
+    {
+      checksum_msb += byte;
+      checksum_lsb += checksum_msb;
+    }
+    memcpy(data + out_size, out_packet.data(), out_packet.size());
+    out_size += out_packet.size();
+    data[out_size++] = checksum_msb;
+    data[out_size++] = checksum_lsb;
+  }
+  return out_size;
+}
+
+#endif  // MICROSTRAIN_INERTIAL_DRIVER_COMMON_FUZZ_MIP_MUTATOR_H
@@ -0,0 +1,192 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Parker-Lord Inertial Device Driver Implementation File
+//
+// Copyright (c) 2017, Brian Bingham
+// Copyright (c) 2020, Parker Hannifin Corp
+// This code is licensed under MIT license (see LICENSE file for details)
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Fuzzes the parsing bytes from the main port go through before they reach the publishers: the connection, the MIP parser,
+// and the extraction of every data field the publishers have callbacks for.
+// The main device is adopted the same way it is when the driver takes over from a running driver, on one end of a socket pair that stands in for the port,
+// so it is set up without sending a single command. Each input is written to the other end of the pair and parsed the same way the main port timer does.
+// Built with the stub ROS layer in ros_stub, so it does not need ROS. See README.md for how to build and run it
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <vector>
+#include <initializer_list>
+
+#include "mip/definitions/data_shared.hpp"
+
+#include "microstrain_inertial_driver_common/utils/mip/ros_mip_device_main.h"
+
+#include "fuzz_utils.h"
+#include "mip_mutator.h"
+
+#ifndef MICROSTRAIN_ROS_STUB
+#error "Build the MIP parser harness with fuzz/ros_stub before the include directory"
+#endif
+
+// Base rate given to every descriptor set of the device
+constexpr uint16_t FUZZ_BASE_RATE = 1000;
+
+// Time to let pass after every input. Longer than the parse timeout, so a packet one input leaves incomplete is dropped before the next one
+constexpr double INPUT_GAP_SECS = 2.0;
+
+/**
+ * Receives every data field the publishers have a callback for, after the MIP SDK extracted it
+ */
+class FieldSink
+{
+ public:
+  /**
+   * \brief Registers a callback for a data field on the device
+   * \tparam DataField The data field to extract
+   * \param device The device to register the callback on
+   * \param descriptor_set The descriptor set to receive the field from
+   */
+  template<typename DataField>
+  void registerField(mip::DeviceInterface* device, const uint8_t descriptor_set = DataField::DESCRIPTOR_SET)
+  {
+    handlers_.push_back(std::make_shared<mip::C::mip_dispatch_handler>());
+    device->registerDataCallback<DataField, FieldSink, &FieldSink::handle<DataField>>(*handlers_.back(), this, descriptor_set);
+  }
+
+  /**
+   * \brief Registers the same fields the publishers register callbacks for
+   * \param device The device to register the callbacks on
+   */
+  void registerPublisherFields(mip::DeviceInterface* device)
+  {
+    using namespace mip;  // NOLINT(build/namespaces)
+    for (const uint8_t descriptor_set : std::initializer_list<uint8_t>{data_sensor::DESCRIPTOR_SET, data_gnss::DESCRIPTOR_SET, data_gnss::MIP_GNSS1_DATA_DESC_SET, data_gnss::MIP_GNSS2_DATA_DESC_SET, data_gnss::MIP_GNSS3_DATA_DESC_SET, data_filter::DESCRIPTOR_SET})
+    {
+      registerField<data_shared::EventSource>(device, descriptor_set);
+      registerField<data_shared::Ticks>(device, descriptor_set);
+      registerField<data_shared::DeltaTicks>(device, descriptor_set);
+      registerField<data_shared::GpsTimestamp>(device, descriptor_set);
+      registerField<data_shared::DeltaTime>(device, descriptor_set);
+      registerField<data_shared::ReferenceTimestamp>(device, descriptor_set);
+      registerField<data_shared::ReferenceTimeDelta>(device, descriptor_set);
+    }
+    registerField<data_sensor::GpsTimestamp>(device);
+    registerField<data_gnss::GpsTime>(device);
+    registerField<data_filter::Timestamp>(device);
+
+    registerField<data_sensor::ScaledAccel>(device);
+    registerField<data_sensor::ScaledGyro>(device);
+    registerField<data_sensor::DeltaTheta>(device);
+    registerField<data_sensor::DeltaVelocity>(device);
+    registerField<data_sensor::CompQuaternion>(device);
+    registerField<data_sensor::ScaledMag>(device);
+    registerField<data_sensor::ScaledPressure>(device);
+    registerField<data_sensor::OdometerData>(device);
+    registerField<data_sensor::OverrangeStatus>(device);
+    registerField<data_sensor::TemperatureAbs>(device);
+
+    for (const uint8_t descriptor_set : std::initializer_list<uint8_t>{data_gnss::DESCRIPTOR_SET, data_gnss::MIP_GNSS1_DATA_DESC_SET, data_gnss::MIP_GNSS2_DATA_DESC_SET})
+    {
+      registerField<data_gnss::PosLlh>(device, descriptor_set);
+      registerField<data_gnss::VelNed>(device, descriptor_set);
+      registerField<data_gnss::PosEcef>(device, descriptor_set);
+      registerField<data_gnss::VelEcef>(device, descriptor_set);
+      registerField<data_gnss::FixInfo>(device, descriptor_set);
+      registerField<data_gnss::SbasInfo>(device, descriptor_set);
+      registerField<data_gnss::RfErrorDetection>(device, descriptor_set);
+      registerField<data_gnss::GpsTime>(device, descriptor_set);
+    }
+    registerField<data_gnss::RtkCorrectionsStatus>(device, data_gnss::MIP_GNSS3_DATA_DESC_SET);
+    registerField<data_gnss::BaseStationInfo>(device, data_gnss::MIP_GNSS3_DATA_DESC_SET);
+
+    registerField<data_filter::Status>(device);
+    registerField<data_filter::EcefPos>(device);
+    registerField<data_filter::EcefPosUncertainty>(device);
+    registerField<data_filter::PositionLlh>(device);
+    registerField<data_filter::PositionLlhUncertainty>(device);
+    registerField<data_filter::AttitudeQuaternion>(device);
+    registerField<data_filter::EulerAnglesUncertainty>(device);
+    registerField<data_filter::VelocityNed>(device);
+    registerField<data_filter::VelocityNedUncertainty>(device);
+    registerField<data_filter::EcefVel>(device);
+    registerField<data_filter::EcefVelUncertainty>(device);
+    registerField<data_filter::CompAngularRate>(device);
+    registerField<data_filter::CompAccel>(device);
+    registerField<data_filter::LinearAccel>(device);
+    registerField<data_filter::AidingMeasurementSummary>(device);
+    registerField<data_filter::GnssPosAidStatus>(device);
+    registerField<data_filter::MultiAntennaOffsetCorrection>(device);
+    registerField<data_filter::GnssDualAntennaStatus>(device);
+
+    registerField<data_system::BuiltInTest>(device);
+  }
+
+ private:
+  /**
+   * \brief Receives a field once it was extracted
+   */
+  template<typename DataField>
+  void handle(const DataField& field, const uint8_t descriptor_set, mip::Timestamp timestamp)
+  {
+    (void)field;
+    (void)descriptor_set;
+    (void)timestamp;
+    fields_++;
+  }
+
+  std::vector<std::shared_ptr<mip::C::mip_dispatch_handler>> handlers_;  /// Handlers of the registered callbacks. The SDK keeps pointers to them
+  size_t fields_ = 0;  /// Number of fields received
+};
+
+static RosNodeType node;
+static std::shared_ptr<microstrain::SteppingClock> fuzz_clock;
+static std::shared_ptr<microstrain::RosMipDeviceMain> device;
+static std::unique_ptr<FieldSink> field_sink;
+static int device_fd = -1;
+static int driver_fd = -1;
+
+extern "C" int LLVMFuzzerInitialize(int* argc, char*** argv)
+{
+  (void)argc;
+  (void)argv;
+
+  microstrain::HandoffState state;
+  strncpy(state.device_info.model_name, "3DM-GQ7", sizeof(state.device_info.model_name) - 1);
+  strncpy(state.device_info.serial_number, "fuzz", sizeof(state.device_info.serial_number) - 1);
+  state.device_info.firmware_version = 1000;
+  for (const uint8_t descriptor_set : DESCRIPTOR_SETS)
+  {
+    state.base_rates[descriptor_set] = FUZZ_BASE_RATE;
+    for (uint16_t field_descriptor = 1; field_descriptor <= UINT8_MAX; field_descriptor++)
+      state.supported_descriptors.push_back(static_cast<uint16_t>((descriptor_set << 8) | field_descriptor));
+  }
+
+  fuzz_clock = std::make_shared<microstrain::SteppingClock>();
+  device = std::make_shared<microstrain::RosMipDeviceMain>(&node, fuzz_clock);
+  field_sink = std::unique_ptr<FieldSink>(new FieldSink());
+  if (!microstrain::openFuzzPort(&device_fd, &driver_fd))
+    abort();
+  state.main_fd = driver_fd;
+  if (!device->adopt(&node, state))
+  {
+    fprintf(stderr, "Failed to adopt the fuzzing port\n");
+    abort();
+  }
+  field_sink->registerPublisherFields(&device->device());
+  return 0;
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size)
+{
+  if (!microstrain::feedFuzzPort(device_fd, driver_fd, data, size, []() { device->device().update(); }))
+    abort();
+
+  // Let the parser time out anything left incomplete, so it does not run into the next input
+  fuzz_clock->sleepFor(INPUT_GAP_SECS);
+  device->device().update();
+  return 0;
+}
@@ -0,0 +1,99 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Parker-Lord Inertial Device Driver Implementation File
+//
+// Copyright (c) 2017, Brian Bingham
+// Copyright (c) 2020, Parker Hannifin Corp
+// This code is licensed under MIT license (see LICENSE file for details)
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Fuzzes the NMEA extraction done on every read from a port the driver parses NMEA on.
+// Each input is written to a port the connection adopted, and read back in small pieces so sentences are split across reads.
+// Every sentence the connection extracts is checked to be framed and to have a valid checksum.
+// Built with the stub ROS layer in ros_stub, so it does not need ROS. See README.md for how to build and run it
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+#include "microstrain_inertial_driver_common/utils/build_profile.h"
+#include "microstrain_inertial_driver_common/utils/mip/ros_connection.h"
+
+#include "fuzz_utils.h"
+
+#ifndef MICROSTRAIN_ROS_STUB
+#error "Build the NMEA harness with fuzz/ros_stub before the include directory"
+#endif
+static_assert(microstrain::BuildFeatures::NMEA, "The connection only extracts NMEA when the driver is built with MICROSTRAIN_FEATURE_NMEA");
+
+// Number of bytes the connection reads at a time. Small, so most sentences are split across reads
+constexpr size_t READ_SIZE = 32;
+
+// Shortest sentence that can be extracted: a start character, the checksum delimiter, two checksum digits and the line ending
+constexpr size_t MIN_SENTENCE_SIZE = 6;
+
+static RosNodeType node;
+static std::shared_ptr<microstrain::SteppingClock> fuzz_clock;
+
+/**
+ * \brief Checks that an extracted sentence is what the driver will publish it as
+ * \param sentence The sentence to check
+ * \return true if the sentence starts with a start character, ends in a line ending, and its checksum matches
+ */
+static bool validSentence(const std::string& sentence)
+{
+  if (sentence.size() < MIN_SENTENCE_SIZE || (sentence[0] != '$' && sentence[0] != '!'))
+    return false;
+  if (sentence.compare(sentence.size() - 2, 2, "\r\n") != 0 || sentence[sentence.size() - 5] != '*')
+    return false;
+
+  uint8_t checksum = 0;
+  for (size_t i = 1; i < sentence.size() - 5; i++)
+    checksum ^= static_cast<uint8_t>(sentence[i]);
+  return checksum == static_cast<uint8_t>(std::stoi(sentence.substr(sentence.size() - 4, 2), nullptr, 16));
+}
+
+extern "C" int LLVMFuzzerInitialize(int* argc, char*** argv)
+{
+  (void)argc;
+  (void)argv;
+  fuzz_clock = std::make_shared<microstrain::SteppingClock>();
+  return 0;
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size)
+{
+  int device_fd, driver_fd;
+  if (!microstrain::openFuzzPort(&device_fd, &driver_fd))
+    abort();
+
+  // A new connection for every input, so partial sentences from one input do not end up in the next
+  {
+    microstrain::RosConnection connection(&node, fuzz_clock);
+    connection.adopt(driver_fd, "nmea_fuzzer", 115200);
+    connection.shouldParseNmea(true);
+
+    uint8_t buffer[READ_SIZE];
+    const bool fed = microstrain::feedFuzzPort(device_fd, driver_fd, data, size, [&]()
+    {
+      size_t count;
+      mip::Timestamp timestamp;
+      if (!connection.recvFromDevice(buffer, sizeof(buffer), 0, &count, &timestamp))
+        abort();
+    });
+    if (!fed)
+      abort();
+
+    for (const auto& nmea_msg : connection.nmeaMsgs())
+    {
+      if (!validSentence(nmea_msg.sentence))
+      {
+        fprintf(stderr, "Extracted an invalid NMEA sentence: %s\n", nmea_msg.sentence.c_str());
+        abort();
+      }
+    }
+  }
+  close(device_fd);
+  return 0;
+}
@@ -0,0 +1,107 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Parker-Lord Inertial Device Driver Implementation File
+//
+// Copyright (c) 2017, Brian Bingham
+// Copyright (c) 2020, Parker Hannifin Corp
+// This code is licensed under MIT license (see LICENSE file for details)
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Entry point for the harnesses when the compiler does not have libFuzzer. It runs each input it is given once, like libFuzzer does with -runs=0,
+// so the corpus can still be checked under the sanitizers and a crashing input can still be reproduced. Arguments that start with - are ignored,
+// so it takes the same command line as libFuzzer
+
+#include <dirent.h>
+#include <sys/stat.h>
+
+#include <cstdio>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <iterator>
+#include <algorithm>
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size);
+extern "C" __attribute__((weak)) int LLVMFuzzerInitialize(int* argc, char*** argv);
+
+/**
+ * \brief The custom mutators call this to have libFuzzer mutate part of an input. Nothing is mutated without libFuzzer, so it is never called
+ * \return size, since nothing was mutated
+ */
+extern "C" size_t LLVMFuzzerMutate(uint8_t* data, size_t size, size_t max_size)
+{
+  (void)data;
+  (void)max_size;
+  return size;
+}
+
+/**
+ * \brief Runs the harness on one input file
+ * \param path Path to the input
+ * \return true if the input could be read
+ */
+static bool runFile(const std::string& path)
+{
+  std::ifstream file(path, std::ios::binary);
+  if (!file.is_open())
+  {
+    fprintf(stderr, "Unable to open %s\n", path.c_str());
+    return false;
+  }
+  const std::vector<uint8_t> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+  fprintf(stderr, "Running %s (%zu bytes)\n", path.c_str(), data.size());
+  LLVMFuzzerTestOneInput(data.data(), data.size());
+  return true;
+}
+
+int main(int argc, char** argv)
+{
+  if (LLVMFuzzerInitialize != nullptr)
+    LLVMFuzzerInitialize(&argc, &argv);
+
+  bool read_all = true;
+  size_t inputs = 0;
+  for (int i = 1; i < argc; i++)
+  {
+    const std::string path = argv[i];
+    if (path.empty() || path[0] == '-')
+      continue;
+
+    // Directories are run in sorted order, so a run is the same every time
+    struct stat path_stat;
+    if (stat(path.c_str(), &path_stat) == 0 && S_ISDIR(path_stat.st_mode))
+    {
+      std::vector<std::string> entries;
+      DIR* dir = opendir(path.c_str());
+      if (dir == nullptr)
+      {
+        fprintf(stderr, "Unable to open %s\n", path.c_str());
+        read_all = false;
+        continue;
+      }
+      while (const dirent* entry = readdir(dir))
+      {
+        const std::string entry_path = path + "/" + entry->d_name;
+        struct stat entry_stat;
+        if (stat(entry_path.c_str(), &entry_stat) == 0 && S_ISREG(entry_stat.st_mode))
+          entries.push_back(entry_path);
+      }
+      closedir(dir);
+      std::sort(entries.begin(), entries.end());
+      for (const auto& entry : entries)
+      {
+        read_all &= runFile(entry);
+        inputs++;
+      }
+    }
+    else
+    {
+      read_all &= runFile(path);
+      inputs++;
+    }
+  }
+  fprintf(stderr, "Ran %zu inputs\n", inputs);
+  return read_all && inputs > 0 ? 0 : 1;
+}
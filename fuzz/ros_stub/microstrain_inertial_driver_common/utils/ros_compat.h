@@ -0,0 +1,193 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Parker-Lord Driver Definition File
+//
+// Copyright (c) 2017, Brian Bingham
+// Copyright (c) 2020, Parker Hannifin Corp
+//
+// This code is licensed under MIT license (see LICENSE file for details)
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Stand-in for include/microstrain_inertial_driver_common/utils/ros_compat.h, so the connection and the MIP parsing code can be fuzzed without ROS.
+// It is found before the real header by the harnesses that are built with it, and uses the same include guard so only one of them is ever included.
+// Only what the connection, the MIP devices, the clocks and the handoff code use is provided
+
+#ifndef MICROSTRAIN_INERTIAL_DRIVER_COMMON_UTILS_ROS_COMPAT_H
+#define MICROSTRAIN_INERTIAL_DRIVER_COMMON_UTILS_ROS_COMPAT_H
+
+#include <cstdio>
+#include <chrono>
+#include <string>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <cstdint>
+#include <type_traits>
+
+#define MICROSTRAIN_ROS_STUB 1
+
+/**
+ * Common Defines
+ */
+#ifndef M_PI
+#define M_PI (3.14159265358979323846)
+#endif
+
+// Version of the driver
+#ifndef MICROSTRAIN_DRIVER_VERSION
+#define MICROSTRAIN_DRIVER_VERSION "unknown"
+#endif
+
+namespace microstrain
+{
+
+constexpr auto GPS_LEAP_SECONDS = 18;
+
+constexpr auto GNSS1_ID = 0;
+constexpr auto GNSS2_ID = 1;
+constexpr auto NUM_GNSS = 2;
+};  // namespace microstrain
+
+/**
+ * Node that has no parameters. Every parameter read from it is its default
+ */
+struct RosNodeType
+{
+};
+
+/**
+ * Time with the same members as the ROS 2 time message
+ */
+struct RosTimeType
+{
+  int32_t sec = 0;
+  uint32_t nanosec = 0;
+};
+
+/**
+ * Header with the members the connection sets
+ */
+struct RosHeaderType
+{
+  RosTimeType stamp;
+  std::string frame_id;
+};
+
+/**
+ * NMEA sentence with the members the connection sets
+ */
+struct NMEASentenceMsg
+{
+  RosHeaderType header;
+  std::string sentence;
+};
+
+/**
+ * Rate that sleeps for its whole period, since there is no ROS clock to keep it in step with
+ */
+class RosRateType
+{
+ public:
+  explicit RosRateType(const double hz) : period_(hz > 0 ? 1.0 / hz : 0) {}
+
+  void sleep()
+  {
+    std::this_thread::sleep_for(std::chrono::duration<double>(period_));
+  }
+
+ private:
+  double period_;  /// Time to sleep for in seconds
+};
+
+// Only errors are logged, so the output is not flooded by every packet. The rest are still checked against their format strings
+#define MICROSTRAIN_STUB_LOG(LOG, ...) do { if (LOG) { fprintf(stderr, __VA_ARGS__); fprintf(stderr, "\n"); } } while (0)
+#define MICROSTRAIN_DEBUG(NODE, ...) MICROSTRAIN_STUB_LOG(false, __VA_ARGS__)
+#define MICROSTRAIN_INFO(NODE, ...) MICROSTRAIN_STUB_LOG(false, __VA_ARGS__)
+#define MICROSTRAIN_WARN(NODE, ...) MICROSTRAIN_STUB_LOG(false, __VA_ARGS__)
+#define MICROSTRAIN_ERROR(NODE, ...) MICROSTRAIN_STUB_LOG(true, __VA_ARGS__)
+#define MICROSTRAIN_FATAL(NODE, ...) MICROSTRAIN_STUB_LOG(true, __VA_ARGS__)
+
+/**
+ * \brief Checks whether the node is still running
+ * \return Always true, since there is nothing to shut the stub down
+ */
+inline bool rosOk()
+{
+  return true;
+}
+
+/**
+ * \brief Gets the current time from the system clock
+ * \param node Unused
+ * \return Current time
+ */
+inline RosTimeType rosTimeNow(RosNodeType* node)
+{
+  (void)node;
+  const int64_t nanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+  RosTimeType time;
+  time.sec = static_cast<int32_t>(nanoseconds / 1000000000);
+  time.nanosec = static_cast<uint32_t>(nanoseconds % 1000000000);
+  return time;
+}
+
+/**
+ * \brief Sets the time in seconds and nanoseconds to a time object
+ * \param time The time object to set the time on
+ * \param sec Number of seconds to set on the object
+ * \param nsec Number of nanoseconds to set on the object
+ */
+inline void setRosTime(RosTimeType* time, int32_t sec, int32_t nsec)
+{
+  time->sec = sec;
+  time->nanosec = nsec;
+}
+
+/**
+ * \brief Gets the seconds from a time object
+ * \param time_ref  The time object to extract the seconds from
+ * \return seconds from the time object
+ */
+inline int64_t getTimeRefSec(const RosTimeType& time_ref)
+{
+  return time_ref.sec;
+}
+
+/**
+ * \brief Gets the seconds and nanoseconds converted to seconds as a double
+ * \param time_ref  The time object to extract the time from
+ * \return seconds combined with nanoseconds from the time object
+*/
+inline double getTimeRefSecs(const RosTimeType& time_ref)
+{
+  return static_cast<double>(time_ref.sec) + static_cast<double>(time_ref.nanosec) / 1000000000.0;
+}
+
+/**
+ * \brief Gets the seconds and nanoseconds combined into nanoseconds
+ * \param time_ref  The time object to extract the time from
+ * \return nanoseconds from the time object
+*/
+inline int64_t getTimeRefNanoseconds(const RosTimeType& time_ref)
+{
+  return static_cast<int64_t>(time_ref.sec) * 1000000000 + static_cast<int64_t>(time_ref.nanosec);
+}
+
+/**
+ * \brief Reads a parameter. The stub node has no parameters, so this is always the default
+ * \tparam ConfigType  The type of the parameter
+ * \param node  Unused
+ * \param param_name  Unused
+ * \param param_val  Variable to store the default in
+ * \param default_val  The default value of the parameter
+ */
+template <class ConfigType>
+void getParam(RosNodeType* node, const std::string& param_name, ConfigType& param_val, const ConfigType& default_val)
+{
+  (void)node;
+  (void)param_name;
+  param_val = default_val;
+}
+
+#endif  // MICROSTRAIN_INERTIAL_DRIVER_COMMON_UTILS_ROS_COMPAT_H
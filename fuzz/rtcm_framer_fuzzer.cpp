@@ -0,0 +1,109 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Parker-Lord Inertial Device Driver Implementation File
+//
+// Copyright (c) 2017, Brian Bingham
+// Copyright (c) 2020, Parker Hannifin Corp
+// This code is licensed under MIT license (see LICENSE file for details)
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Fuzzes the RTCM framing the RTCM subscriber runs every message through before writing it to the aux port.
+// The first byte of an input picks the allowlist. The rest is split into RTCM messages, each one a length byte followed by up to that many bytes,
+// and the messages are given to the framer one at a time the same way the subscriber does.
+// Everything the framer forwards is checked to be whole frames, with a valid CRC and an allowed message type. See README.md for how to build and run it
+
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+#include <algorithm>
+
+#include "microstrain_inertial_driver_common/utils/rtcm_framer.h"
+
+// The framer does not use ROS, so leaks are worth reporting here
+extern "C" const char* __asan_default_options()
+{
+  return "detect_leaks=1:detect_stack_use_after_return=1:check_initialization_order=1:strict_init_order=1";
+}
+extern "C" const char* __ubsan_default_options()
+{
+  return "print_stacktrace=1:halt_on_error=1";
+}
+
+// Bits of the first byte of an input that pick the allowlist
+constexpr uint8_t OPTION_FILTER = 0x01;
+constexpr uint8_t OPTION_GLONASS = 0x02;
+constexpr uint8_t OPTION_GALILEO = 0x04;
+constexpr uint8_t OPTION_BEIDOU = 0x08;
+
+/**
+ * \brief Checks that forwarded data is nothing but whole, valid and allowed frames
+ * \param frames The data the framer forwarded for one message
+ * \param allowed Whether each message type is allowed, or empty if every message type is
+ * \return true if every frame is valid
+ */
+static bool validFrames(const std::vector<uint8_t>& frames, const std::vector<bool>& allowed)
+{
+  using microstrain::RtcmFramer;
+  size_t offset = 0;
+  while (offset < frames.size())
+  {
+    const uint8_t* frame = frames.data() + offset;
+    if (frames.size() - offset < RtcmFramer::HEADER_SIZE + RtcmFramer::CRC_SIZE || frame[0] != RtcmFramer::PREAMBLE || (frame[1] & 0xFC) != 0)
+      return false;
+    const size_t payload_size = (static_cast<size_t>(frame[1] & 0x03) << 8) | frame[2];
+    const size_t frame_size = RtcmFramer::HEADER_SIZE + payload_size + RtcmFramer::CRC_SIZE;
+    if (frames.size() - offset < frame_size)
+      return false;
+
+    const uint32_t crc = (static_cast<uint32_t>(frame[frame_size - 3]) << 16) | (static_cast<uint32_t>(frame[frame_size - 2]) << 8) | frame[frame_size - 1];
+    if (RtcmFramer::crc24q(frame, RtcmFramer::HEADER_SIZE + payload_size) != crc)
+      return false;
+    const uint16_t message_type = payload_size >= 2 ? static_cast<uint16_t>((frame[3] << 4) | (frame[4] >> 4)) : 0;
+    if (!allowed.empty() && !allowed[message_type])
+      return false;
+    offset += frame_size;
+  }
+  return true;
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size)
+{
+  if (size == 0)
+    return 0;
+
+  microstrain::RtcmFramer framer;
+  std::vector<bool> allowed;
+  const uint8_t options = data[0];
+  if (options & OPTION_FILTER)
+  {
+    const std::vector<uint16_t> message_types = microstrain::RtcmFramer::defaultMessageTypes(options & OPTION_GLONASS, options & OPTION_GALILEO, options & OPTION_BEIDOU);
+    framer.setAllowedMessageTypes(message_types);
+    allowed.resize(microstrain::RtcmFramer::NUM_MESSAGE_TYPES, false);
+    for (const uint16_t message_type : message_types)
+      allowed[message_type] = true;
+  }
+
+  // Reused between messages like the subscriber does, so stale frames would show up in the checks
+  std::vector<uint8_t> frames;
+  size_t received = 0, forwarded = 0;
+  size_t offset = 1;
+  while (offset < size)
+  {
+    const size_t message_size = std::min(static_cast<size_t>(data[offset]), size - offset - 1);
+    offset++;
+    frames.clear();
+    framer.process(data + offset, message_size, &frames);
+    offset += message_size;
+
+    received += message_size;
+    forwarded += frames.size();
+    if (!validFrames(frames, allowed) || forwarded > received)
+    {
+      fprintf(stderr, "Forwarded %lu bytes that are not whole, valid and allowed RTCM frames\n", static_cast<unsigned long>(frames.size()));
+      abort();
+    }
+  }
+  framer.toYaml();
+  return 0;
+}
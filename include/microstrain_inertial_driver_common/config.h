@@ -17,6 +17,9 @@
 #include <string>
 #include <vector>
 #include <memory>
+#include <atomic>
+#include <future>
+#include <chrono>
 #include <fstream>
 
 #include <GeographicLib/Geocentric.hpp>
@@ -24,9 +27,24 @@
 #include "mip/definitions/commands_filter.hpp"
 
 #include "microstrain_inertial_driver_common/utils/ros_compat.h"
+#include "microstrain_inertial_driver_common/utils/build_profile.h"
+#include "microstrain_inertial_driver_common/utils/clock.h"
 #include "microstrain_inertial_driver_common/utils/mip/ros_mip_device_main.h"
 #include "microstrain_inertial_driver_common/utils/mip/ros_mip_device_aux.h"
 #include "microstrain_inertial_driver_common/utils/mappings/mip_publisher_mapping.h"
+#include "microstrain_inertial_driver_common/utils/allan_variance.h"
+#include "microstrain_inertial_driver_common/utils/mag_calibrator.h"
+#include "microstrain_inertial_driver_common/utils/realtime.h"
+#include "microstrain_inertial_driver_common/utils/perf_profiler.h"
+#include "microstrain_inertial_driver_common/utils/memory_tracker.h"
+#include "microstrain_inertial_driver_common/utils/rtcm_framer.h"
+#include "microstrain_inertial_driver_common/utils/handoff.h"
+#include "microstrain_inertial_driver_common/utils/byte_proxy.h"
+#include "microstrain_inertial_driver_common/utils/dejitter_stage.h"
+#include "microstrain_inertial_driver_common/utils/aiding_callback_benchmark.h"
+#include "microstrain_inertial_driver_common/utils/mip/emulated_aiding_device.h"
+#include "microstrain_inertial_driver_common/utils/aiding_health.h"
+#include "microstrain_inertial_driver_common/utils/versioned_snapshot.h"
 
 namespace microstrain
 {
@@ -55,6 +73,22 @@ const std::vector<double> DEFAULT_MATRIX = { 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0,
 const std::vector<double> DEFAULT_VECTOR = { 0.0, 0.0, 0.0 };
 const std::vector<double> DEFAULT_QUATERNION = { 0.0, 0.0, 0.0, 0.0 };
 
+/**
+ * State learned from the device while running, shared between the publishers and services.
+ * Only holds plain data so that it can be published as a versioned snapshot
+ */
+struct RuntimeState
+{
+  mip::data_filter::FilterMode filter_state = static_cast<mip::data_filter::FilterMode>(0);  /// Last filter state reported by the device
+
+  // Transform between earth and map, may be configured at config time, or changed at runtime
+  bool map_to_earth_valid = false;  /// Whether the transform below is populated
+  uint32_t map_to_earth_revision = 0;  /// Incremented every time the transform changes, so the publishers know when to broadcast it
+  double map_to_earth_stamp = 0;  /// Time the transform was last changed in seconds
+  double map_to_earth_translation[3] = {0, 0, 0};  /// Position of the map origin in the earth frame in meters
+  double map_to_earth_rotation[4] = {0, 0, 0, 1};  /// Rotation between the earth and map frames as x, y, z, w
+};
+
 /**
  * Contains configuration information for the node, configures the device on startup
  *  This class holds the pointer to the MSCL device, so any communication to the device should be done through this class
@@ -84,6 +118,10 @@ public:
   bool debug_;
   bool device_setup_;
 
+  // Clock that everything read from the device is stamped with. Replaced with a virtual clock driven by the capture when replaying
+  std::string replay_file_;
+  std::shared_ptr<Clock> clock_;
+
   // Connection classes and metadata used to interact with the MIP device
   std::shared_ptr<RosMipDeviceMain> mip_device_;
   std::shared_ptr<RosMipDeviceAux> aux_device_;
@@ -144,13 +182,8 @@ public:
   // Configured static transforms
   TransformStampedMsg mount_to_frame_id_transform_;
 
-  // Cached filter state useful for determining state across services and publishers
-  mip::data_filter::FilterMode filter_state_ = static_cast<mip::data_filter::FilterMode>(0);
-
-  // Transform between earth and IMU, may be configured at config time, or changed at runtime
-  bool map_to_earth_transform_valid_ = false;
-  bool map_to_earth_transform_updated_ = false;
-  TransformStampedMsg map_to_earth_transform_;
+  // State learned from the device while running. Written while parsing, and read from the publishers and services without locks
+  VersionedSnapshot<RuntimeState> runtime_state_;
 
   // Subscriber settings
   bool subscribe_ext_time_;
@@ -168,6 +201,10 @@ public:
   bool rtk_dongle_enable_;
   bool ntrip_interface_enable_;
 
+  // RTCM filtering. The framer is shared between the subscribers and services, and only exists if filtering is enabled
+  bool rtcm_filter_enable_;
+  std::shared_ptr<RtcmFramer> rtcm_framer_;
+
   // Static covariance vectors
   std::vector<double> imu_linear_cov_;
   std::vector<double> imu_angular_cov_;
@@ -183,6 +220,9 @@ public:
   int filter_speed_lever_arm_source_;
   std::vector<float> filter_speed_lever_arm_;
 
+  // Amount of time to wait for all lever arm transforms to become available. 0 will wait forever
+  double lever_arm_transform_timeout_;
+
   // Raw data file parameters
   bool raw_file_enable_;
   bool raw_file_include_support_data_;
@@ -194,6 +234,109 @@ public:
   float nmea_max_rate_hz_;
   std::map<std::string, std::string> nmea_talker_id_to_frame_id_mapping_;
 
+  // Host NMEA generation parameters. These sentences are built by the driver from binary MIP data instead of being streamed from the device
+  std::string gnss_host_nmea_talker_id_[NUM_GNSS];
+  float gnss_host_nmea_gga_data_rate_[NUM_GNSS];
+  float gnss_host_nmea_rmc_data_rate_[NUM_GNSS];
+  float gnss_host_nmea_vtg_data_rate_[NUM_GNSS];
+  std::string filter_host_nmea_talker_id_;
+  float filter_host_nmea_gga_data_rate_;
+  float filter_host_nmea_rmc_data_rate_;
+  float filter_host_nmea_vtg_data_rate_;
+  bool host_nmea_aux_port_gga_;
+
+  // Windowed signal statistics parameters
+  bool signal_statistics_enable_;
+  double signal_statistics_window_;
+
+  // Vibration spectrum analysis parameters
+  bool vibration_analysis_enable_;
+  int32_t vibration_analysis_window_size_;
+  double vibration_analysis_overlap_;
+  std::vector<double> vibration_analysis_band_edges_;
+  double vibration_analysis_publish_rate_;
+
+  // Allan variance parameters. The engine is shared between the publishers that feed it and the services that read it
+  bool allan_variance_enable_;
+  int32_t allan_variance_num_octaves_;
+  std::shared_ptr<AllanVariance> allan_variance_;
+
+  // Magnetometer calibration parameters. The calibrator is shared between the publishers that feed it, the services that read and write it, and the node that writes it automatically
+  bool mag_calibration_enable_;
+  bool mag_calibration_dry_run_;
+  bool mag_calibration_auto_write_;
+  bool mag_calibration_save_;
+  std::shared_ptr<MagCalibrator> mag_calibrator_;
+
+  // Real time parameters
+  bool rt_enable_;
+  bool rt_lock_memory_;
+  int32_t rt_prefault_stack_size_;
+  int32_t rt_prefault_heap_size_;
+  std::string rt_scheduling_policy_;
+  int32_t rt_priority_;
+  bool rt_audit_;
+
+  // Performance counter parameters. The profiler is shared between the node, publishers and services, and survives reconnects
+  bool perf_counters_enable_;
+  std::shared_ptr<PerfProfiler> perf_profiler_;
+
+  // Memory tracking parameters
+  bool memory_tracking_enable_;
+  double memory_tracking_publish_rate_;
+
+  // GNSS integrity parameters
+  bool gnss_integrity_enable_;
+  int32_t gnss_integrity_upgrade_count_;
+  int32_t gnss_integrity_degrade_count_;
+  double gnss_integrity_corrections_stale_age_;
+  double gnss_integrity_heartbeat_period_;
+
+  // (ROS1 only) Number of messages to recycle per topic when publishing by shared pointer. 0 publishes by reference
+  int32_t publisher_pool_size_;
+
+  // (ROS2 only) Whether to serialize fixed layout messages directly instead of letting the middleware serialize them
+  bool direct_cdr_serialization_;
+
+  // Whether to publish messages as soon as their fields in a packet have been handled
+  bool early_publish_enable_;
+
+  // Whether to also publish the IMU and odometry expressed in the target frame
+  bool target_frame_variants_enable_;
+
+  // Handoff config. A running driver hands its open ports and state to a replacement started with the same configuration
+  bool handoff_enable_;
+  std::string handoff_socket_;
+  int32_t handoff_timeout_;
+  std::shared_ptr<HandoffState> handoff_state_;  // State received from the previous driver. Only set until the node has finished configuring
+  bool handoff_resumed_ = false;  // Whether the device was left streaming as the previous driver configured it
+  uint64_t config_hash_ = 0;  // Hash of the configuration this driver was started with, handed to a replacement so it can tell if it has to configure the device
+
+  // Proxy config. The proxy mirrors the main port to local clients, and is kept running across reconnects
+  bool proxy_enable_;
+  std::string proxy_socket_;
+  int32_t proxy_buffer_size_;
+  bool proxy_commands_enable_;
+  int32_t proxy_command_timeout_;
+  std::shared_ptr<ByteProxy> byte_proxy_;
+
+  // De-jitter config. The statistics are filled in by the publishers for each topic that is being de-jittered
+  std::vector<std::string> dejitter_topics_;
+  double dejitter_delay_;
+  std::map<std::string, std::shared_ptr<DejitterStatistics>> dejitter_statistics_;
+
+  // Aiding callback benchmark config. The benchmark is driven by the subscribers, and only runs once even if the driver reconnects
+  bool aiding_callback_benchmark_enable_;
+  std::vector<double> aiding_callback_benchmark_rates_;
+  double aiding_callback_benchmark_step_duration_;
+  double aiding_callback_benchmark_ack_latency_;
+  std::shared_ptr<AidingCallbackBenchmark> aiding_callback_benchmark_;
+  std::shared_ptr<EmulatedAidingDevice> aiding_callback_benchmark_device_;
+
+  // Aiding health config. The tracker is fed by the aiding measurement summaries, and pauses sources the filter keeps rejecting
+  bool aiding_health_enable_;
+  std::shared_ptr<AidingHealthTracker> aiding_health_;
+
 private:
   /**
    * \brief Connects to the inertial device and sets up communication
@@ -209,6 +352,11 @@ private:
    */
   bool setupDevice(RosNodeType* node);
 
+  /**
+   * \brief Asks a running driver for its ports the first time it is called, if handoff is enabled
+   */
+  void receiveHandoffState();
+
   /**
    * \brief Configures base settings on the intertial device (descriptor set 0x01)
    * \param node  The ROS node that contains configuration information. For ROS1 this is the private node handle ("~")
@@ -237,6 +385,34 @@ private:
    */
   bool configureFilter(RosNodeType* node);
 
+  /**
+   * \brief Configures the GNSS antenna offsets and speed lever arm on the device. Any lever arms that come from the tf tree will be written
+   *        in the order that their transforms become available
+   * \param node  The ROS node that contains configuration information. For ROS1 this is the private node handle ("~")
+   * \return true if configuration was successful and false if configuration failed
+   */
+  bool configureLeverArms(RosNodeType* node);
+
+  /**
+   * \brief Starts waiting in the background for every lever arm transform we will need from the tf tree.
+   *        All transforms share a single deadline, so a slow tf publisher does not delay the rest of the device configuration
+   */
+  void requestLeverArmTransforms();
+
+  /**
+   * \brief Stops any outstanding lever arm transform requests and waits for them to exit
+   */
+  void cancelLeverArmTransforms();
+
+  /**
+   * \brief Blocks until the transform between "frame_id_" and "target_frame_id" is available. Intended to be run on its own thread
+   * \param target_frame_id The frame ID to wait for
+   * \param deadline Time at which we will stop waiting for the transform. Ignored if lever_arm_transform_timeout_ is 0
+   * \param cancelled Flag that will be set if we should stop waiting for the transform
+   * \return true if the transform is available, false if the deadline was reached or we were cancelled
+   */
+  bool waitForLeverArmTransform(const std::string& target_frame_id, const std::chrono::steady_clock::time_point& deadline, std::shared_ptr<std::atomic<bool>> cancelled);
+
   /**
    * \brief Enables or disables a filter aiding measurement and handles if the aiding measurement is not supported by this particular device
    * \param aiding_source  The aiding measurement to enable or disable
@@ -273,6 +449,7 @@ private:
 
   /**
    * \brief Looks up the lever arm offset from the tf tree for a "target_frame_id" wrt the "frame_id_"
+   *        The transform must already be available. See waitForLeverArmTransform
    * \param target_frame_id The frame Id you want to lookup the transform of
    * \return The transform between the target_frame_id and frame_id_
    */
@@ -284,6 +461,13 @@ private:
   // TF2 buffer lookup class
   TransformBufferType transform_buffer_;
   TransformListenerType transform_listener_;
+
+  // Outstanding lever arm transform requests, keyed by the frame ID they are waiting for
+  std::shared_ptr<std::atomic<bool>> lever_arm_transforms_cancelled_;
+  std::map<std::string, std::shared_future<bool>> lever_arm_transform_futures_;
+
+  // Whether we have already asked for the ports of a running driver. Only done once, so reconnects open the ports as usual
+  bool handoff_attempted_ = false;
 };  // Config class
 
 }  // namespace microstrain
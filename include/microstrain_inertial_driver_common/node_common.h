@@ -15,6 +15,8 @@
 #include <stddef.h>
 #include <string>
 #include <vector>
+#include <atomic>
+#include <memory>
 #include <fstream>
 
 #include "mip/mip_logging.h"
@@ -23,6 +25,7 @@
 #include "microstrain_inertial_driver_common/publishers.h"
 #include "microstrain_inertial_driver_common/subscribers.h"
 #include "microstrain_inertial_driver_common/services.h"
+#include "microstrain_inertial_driver_common/utils/handoff.h"
 
 namespace microstrain
 {
@@ -82,6 +85,26 @@ protected:
    */
   bool shutdown();
 
+  /**
+   * \brief Applies the configured real time scheduling to the calling thread the first time it is called for a port
+   * \param configured Whether or not the thread for the port has already been configured. Will be set to true after the first call
+   * \param name Name of the port the thread services, used for logging
+   */
+  void configureRealtimeThread(bool* configured, const std::string& name);
+
+  /**
+   * \brief Logs any allocations made on the hot path of the calling thread since the last call. Only does anything if rt_audit is enabled
+   * \param name Name of the port the thread services, used for logging
+   */
+  void reportRealtimeViolations(const std::string& name);
+
+  /**
+   * \brief Hands the open ports and state of this driver to the replacement driver that connected to the handoff socket.
+   *        If the replacement accepts them, this driver stops parsing and shuts down without touching the device
+   * \return true if the replacement driver took over the ports
+   */
+  bool handOff();
+
   RosNodeType* node_;
   RosNodeType* config_node_;
   Config config_;
@@ -95,6 +118,24 @@ protected:
   RosTimerType aux_parsing_timer_;
 
   std::string aux_string_;
+
+  // Whether or not the real time scheduling has been applied to the threads parsing the ports
+  bool main_thread_realtime_configured_ = false;
+  bool aux_thread_realtime_configured_ = false;
+
+  // Whether or not we have tried to open the performance counters on the main port thread
+  bool perf_profiler_open_attempted_ = false;
+
+  // Last time in seconds the magnetometer calibration was checked against the thresholds, and whether it has been written automatically
+  double mag_calibration_last_check_ = 0;
+  bool mag_calibration_auto_written_ = false;
+
+  // Whether or not we have logged that the replayed capture is over
+  bool replay_finished_logged_ = false;
+
+  // Listens for a replacement driver if handoff is enabled, and whether we have already handed the ports to one
+  std::unique_ptr<HandoffServer> handoff_server_;
+  std::atomic<bool> handed_off_{false};
 };  // NodeCommon class
 
 }  // namespace microstrain
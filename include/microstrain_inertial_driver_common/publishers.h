@@ -12,16 +12,27 @@
 #define MICROSTRAIN_INERTIAL_DRIVER_COMMON_PUBLISHERS_H
 
 #include <map>
+#include <cmath>
 #include <memory>
 #include <vector>
 #include <string>
+#include <algorithm>
 
 #include <Eigen/Geometry>
 
 #include "mip/mip_all.hpp"
 
 #include "microstrain_inertial_driver_common/utils/ros_compat.h"
+#include "microstrain_inertial_driver_common/utils/imu_sample.h"
+#include "microstrain_inertial_driver_common/utils/build_profile.h"
+#include "microstrain_inertial_driver_common/utils/cdr_serializer.h"
 #include "microstrain_inertial_driver_common/utils/clock_bias_monitor.h"
+#include "microstrain_inertial_driver_common/utils/nmea_generator.h"
+#include "microstrain_inertial_driver_common/utils/gnss_integrity.h"
+#include "microstrain_inertial_driver_common/utils/windowed_statistics.h"
+#include "microstrain_inertial_driver_common/utils/vibration_analyzer.h"
+#include "microstrain_inertial_driver_common/utils/target_frame_transform.h"
+#include "microstrain_inertial_driver_common/utils/dejitter_stage.h"
 #include "microstrain_inertial_driver_common/config.h"
 
 namespace microstrain
@@ -68,12 +79,98 @@ public:
    */
   void publish();
 
+  /**
+   * \brief Saves the state estimated while publishing, so a replacement driver can continue from it
+   * \param state The state to populate with the relative position origin and clock bias
+   */
+  void saveHandoffState(HandoffState* state) const;
+
+  /**
+   * \brief Continues from the state estimated by the previous driver. Should be called after configure
+   * \param state The state received from the previous driver
+   */
+  void restoreHandoffState(const HandoffState& state);
+
+  /**
+   * Tracks the fields of a descriptor set that a message is built from, so the message can be published
+   * as soon as the last of those fields in a packet has been handled, instead of after the whole packet
+   */
+  class FieldTrigger
+  {
+   public:
+    virtual ~FieldTrigger() = default;
+
+    /**
+     * \brief Checks if the fields of the message are known, which is required to publish it early
+     * \return true if the message can be published early
+     */
+    bool hasRequiredFields() const
+    {
+      return !required_fields_.empty();
+    }
+
+    /**
+     * \brief Finds the last field of the message in a packet that is about to be handled
+     * \param packet The packet that is about to be handled
+     */
+    void armForPacket(const mip::PacketRef& packet)
+    {
+      armed_ = false;
+      if (packet.descriptorSet() != required_descriptor_set_)
+        return;
+      for (const mip::Field& field : packet)
+      {
+        if (std::find(required_fields_.begin(), required_fields_.end(), field.fieldDescriptor()) != required_fields_.end())
+        {
+          trigger_field_descriptor_ = field.fieldDescriptor();
+          armed_ = true;
+        }
+      }
+    }
+
+    /**
+     * \brief Publishes the message if the field that was just handled was the last field of the message in the packet
+     * \param field The field that was just handled
+     */
+    void handleField(const mip::Field& field)
+    {
+      if (armed_ && field.fieldDescriptor() == trigger_field_descriptor_ && field.descriptorSet() == required_descriptor_set_)
+      {
+        armed_ = false;
+        publishEarly();
+      }
+    }
+
+   protected:
+    /**
+     * \brief Sets the fields that the message is built from
+     * \param descriptor_set The descriptor set of the fields
+     * \param field_descriptors The field descriptors of the fields
+     */
+    void requireFields(const uint8_t descriptor_set, const std::vector<uint8_t>& field_descriptors)
+    {
+      required_descriptor_set_ = descriptor_set;
+      required_fields_ = field_descriptors;
+    }
+
+    /**
+     * \brief Publishes the message before the rest of the packet is handled
+     */
+    virtual void publishEarly() = 0;
+
+   private:
+    uint8_t required_descriptor_set_ = 0;  /// Descriptor set of the fields the message is built from
+    std::vector<uint8_t> required_fields_;  /// Field descriptors of the fields the message is built from
+    uint8_t trigger_field_descriptor_ = 0;  /// Last field of the message in the current packet
+    bool armed_ = false;  /// Whether the current packet contains any of the fields of the message
+  };
+
   /**
    * Wrapper for a publisher
    * @tparam MessageType The type of ROS message that this publisher will publish
    */
   template<typename MessageType>
-  class Publisher
+  class Publisher : public FieldTrigger
   {
    public:
     using SharedPtr = std::shared_ptr<Publisher<MessageType>>;
@@ -129,7 +226,23 @@ public:
     {
       data_rate_ = config->mip_publisher_mapping_->getDataRate(topic_);
       if (config->mip_publisher_mapping_->shouldPublish(topic_))
+      {
         configure(node);
+        setPublisherPoolSize(publisher_, config->publisher_pool_size_);
+        serialize_ = config->direct_cdr_serialization_ && CdrSerializer<MessageType>::SUPPORTED;
+        if (std::find(config->dejitter_topics_.begin(), config->dejitter_topics_.end(), topic_) != config->dejitter_topics_.end())
+          configureDejitter(node, config, DejitterSupported<MessageType>());
+
+        // Messages can only be published early if all of their fields arrive in the same packet
+        const std::vector<uint8_t> descriptor_sets = config->mip_publisher_mapping_->getDescriptorSets(topic_);
+        if (config->early_publish_enable_ && descriptor_sets.size() == 1)
+        {
+          std::vector<uint8_t> field_descriptors;
+          for (const auto& descriptor : config->mip_publisher_mapping_->getDescriptors(topic_))
+            field_descriptors.push_back(descriptor.field_descriptor);
+          requireFields(descriptor_sets[0], field_descriptors);
+        }
+      }
     }
 
     /**
@@ -164,9 +277,21 @@ public:
      */
     void publish()
     {
+      // If the message was already published as soon as its fields were handled, anything updated later in the packet waits for the next one
+      if (published_early_)
+      {
+        published_early_ = false;
+        updated_ = false;
+        return;
+      }
       if (publisher_ != nullptr && message_ != nullptr && updated_)
       {
-        publisher_->publish(*message_);
+        if (dejitter_ != nullptr)
+          dejitter_->push(*message_);
+        else if (serialize_)
+          publishSerialized(publisher_, &cdr_serializer_, *message_);
+        else
+          publishPooled(publisher_, *message_);
         updated_ = false;
       }
     }
@@ -178,7 +303,7 @@ public:
     void publish(const MessageType& msg)
     {
       if (publisher_ != nullptr)
-        publisher_->publish(msg);
+        publishPooled(publisher_, msg);
     }
 
     /**
@@ -225,17 +350,55 @@ public:
 
 
    private:
+    /**
+     * \brief Publishes the message before the rest of the packet is handled. publish will skip the message at the end of the packet
+     */
+    void publishEarly() override
+    {
+      if (!updated_)
+        return;
+      publish();
+      published_early_ = true;
+    }
+
+    /**
+     * \brief Releases the messages of this publisher at a fixed delay after their stamp instead of when they are published
+     * \param node The node to log on
+     * \param config Configuration object to read the delay from, and to save the statistics to
+     */
+    void configureDejitter(RosNodeType* node, Config* config, std::true_type)
+    {
+      // Enough room for twice the messages that can arrive within the delay
+      const size_t capacity = std::max(static_cast<size_t>(std::ceil(data_rate_ * config->dejitter_delay_ * 2)) + 2, static_cast<size_t>(4));
+      dejitter_ = std::unique_ptr<DejitterStage<MessageType>>(new DejitterStage<MessageType>(config->dejitter_delay_, capacity, [this](const MessageType& msg)
+      {
+        publishPooled(publisher_, msg);
+      }, config->clock_));
+      config->dejitter_statistics_[topic_] = dejitter_->statistics();
+      MICROSTRAIN_INFO(node, "Publishing %s %.1f ms after the message stamp, buffering up to %lu messages", topic_.c_str(), config->dejitter_delay_ * 1000, static_cast<unsigned long>(capacity));
+    }
+    void configureDejitter(RosNodeType* node, Config* config, std::false_type)
+    {
+      MICROSTRAIN_WARN(node, "Unable to de-jitter %s as its messages do not have a stamp", topic_.c_str());
+    }
+
     const std::string topic_;  /// The topic that this class will publish to
     float data_rate_;  /// The data rate in hertz that this topic is streamed at
     bool updated_;  /// Whether or not the message has been updated since the last iteration
+    bool published_early_ = false;  /// Whether the message was already published during the current packet
 
     typename RosPubType<MessageType>::MessageSharedPtr message_;  /// Pointer to a message that can be updated and published by this class
     typename RosPubType<MessageType>::SharedPtr publisher_;  /// Pointer to the ROS publisher that will do the actual publishing for this class
+
+    bool serialize_ = false;  /// Whether or not to serialize the message ourselves instead of letting the middleware do it
+    CdrSerializer<MessageType> cdr_serializer_;  /// Serializer with the precomputed layout of the message
+
+    std::unique_ptr<DejitterStage<MessageType>> dejitter_;  /// Releases the messages at a fixed delay after their stamp, if enabled for this topic. Must be destroyed before the publisher
   };
 
 
   // IMU Publishers
-  Publisher<ImuMsg>::SharedPtr                        imu_raw_pub_     = Publisher<ImuMsg>::initialize(IMU_DATA_RAW_TOPIC);
+  Publisher<ImuSample>::SharedPtr                     imu_raw_pub_     = Publisher<ImuSample>::initialize(IMU_DATA_RAW_TOPIC);
   Publisher<ImuMsg>::SharedPtr                        imu_pub_         = Publisher<ImuMsg>::initialize(IMU_DATA_TOPIC);
   Publisher<MagneticFieldMsg>::SharedPtr              mag_pub_         = Publisher<MagneticFieldMsg>::initialize(IMU_MAG_TOPIC);
   Publisher<FluidPressureMsg>::SharedPtr              pressure_pub_    = Publisher<FluidPressureMsg>::initialize(IMU_PRESSURE_TOPIC);
@@ -284,6 +447,23 @@ public:
   // NMEA sentence publisher
   Publisher<NMEASentenceMsg>::SharedPtr nmea_sentence_pub_ = Publisher<NMEASentenceMsg>::initialize(NMEA_SENTENCE_TOPIC);
 
+  // Windowed signal statistics publisher
+  Publisher<Float64MultiArrayMsg>::SharedPtr signal_statistics_pub_ = Publisher<Float64MultiArrayMsg>::initialize(SIGNAL_STATISTICS_TOPIC);
+
+  // Vibration spectrum analysis publisher
+  Publisher<Float64MultiArrayMsg>::SharedPtr vibration_analysis_pub_ = Publisher<Float64MultiArrayMsg>::initialize(VIBRATION_ANALYSIS_TOPIC);
+
+  // Per subsystem memory usage publisher
+  Publisher<Float64MultiArrayMsg>::SharedPtr memory_usage_pub_ = Publisher<Float64MultiArrayMsg>::initialize(MEMORY_USAGE_TOPIC);
+
+  // Per receiver GNSS integrity state publishers
+  Publisher<Float64MultiArrayMsg>::SharedPtrVec gnss_integrity_pub_ = Publisher<Float64MultiArrayMsg>::initializeVec({GNSS1_INTEGRITY_TOPIC, GNSS2_INTEGRITY_TOPIC});
+
+  // Publishers for the IMU and odometry expressed in the target frame
+  Publisher<ImuMsg>::SharedPtr      imu_target_pub_                   = Publisher<ImuMsg>::initialize(IMU_DATA_TARGET_TOPIC);
+  Publisher<OdometryMsg>::SharedPtr filter_odometry_earth_target_pub_ = Publisher<OdometryMsg>::initialize(FILTER_ODOMETRY_EARTH_TARGET_TOPIC);
+  Publisher<OdometryMsg>::SharedPtr filter_odometry_map_target_pub_   = Publisher<OdometryMsg>::initialize(FILTER_ODOMETRY_MAP_TARGET_TOPIC);
+
   // Transform Broadcasters
   StaticTransformBroadcasterType static_transform_broadcaster_ = nullptr;
   TransformBroadcasterType transform_broadcaster_ = nullptr;
@@ -294,6 +474,9 @@ public:
   bool imu_link_to_map_transform_translation_updated_ = false;
   bool imu_link_to_map_transform_attitude_updated_ = false;
 
+  // Revision of the map to earth transform in the runtime state that was last broadcast
+  uint32_t map_to_earth_revision_sent_ = 0;
+
   // Transforms that will be updated on each iteation
   tf2::Stamped<tf2::Transform> imu_link_to_earth_transform_tf_stamped_;
   tf2::Stamped<tf2::Transform> imu_link_to_map_transform_tf_stamped_;
@@ -303,6 +486,33 @@ public:
   TransformStampedMsg odometer_link_to_imu_link_transform_;
 
 private:
+  /**
+   * \brief Determines whether the filter has a full navigation solution, which is reported differently by each device family
+   * \return true if the filter is in full navigation mode
+   */
+  bool fullNav() const;
+
+  /**
+   * \brief Determines whether the filter had a full navigation solution in a snapshot of the runtime state
+   * \param state The runtime state to check
+   * \return true if the filter is in full navigation mode
+   */
+  bool fullNav(const RuntimeState& state) const;
+
+  /**
+   * \brief Builds the map to earth transform message from a snapshot of the runtime state
+   * \param state The runtime state containing the transform
+   * \return The transform between the earth and map frames
+   */
+  TransformStampedMsg mapToEarthTransform(const RuntimeState& state) const;
+
+  /**
+   * \brief Publishes a new map to earth transform in the runtime state, and marks it to be broadcast
+   * \param transform The transform between the earth and map frames
+   * \param stamp Time the transform changed in seconds
+   */
+  void storeMapToEarthTransform(const TransformMsg& transform, double stamp);
+
   /**
    * \brief Helper function to register a packet callback on this class
    * \tparam Callback The Callback function on this class to call when the data is received
@@ -321,6 +531,15 @@ private:
   template<class DataField, void (Publishers::*Callback)(const DataField&, uint8_t, mip::Timestamp)>
   void registerDataCallback(const uint8_t descriptor_set = DataField::DESCRIPTOR_SET);
 
+  /**
+   * \brief Helper function to register a field callback on this class
+   * \tparam Callback The Callback function on this class to call when the field is received
+   * \param descriptor_set The descriptor set of the field to listen for
+   * \param field_descriptor The field descriptor of the field to listen for
+   */
+  template<void (Publishers::*Callback)(const mip::Field&, mip::Timestamp)>
+  void registerFieldCallback(const uint8_t descriptor_set = mip::C::MIP_DISPATCH_ANY_DESCRIPTOR, const uint8_t field_descriptor = mip::C::MIP_DISPATCH_ANY_DESCRIPTOR);
+
   // Calbacks to handle shared data from the MIP device
   void handleSharedEventSource(const mip::data_shared::EventSource& event_source, const uint8_t descriptor_set, mip::Timestamp timestamp);
   void handleSharedTicks(const mip::data_shared::Ticks& ticks, const uint8_t descriptor_set, mip::Timestamp timestamp);
@@ -381,6 +600,20 @@ private:
   // Callbacks to handle system data from the device
   void handleSystemBuiltInTest(const mip::data_system::BuiltInTest& built_in_test, const uint8_t descriptor_set, mip::Timestamp timestamp);
 
+  /**
+   * \brief Called before the fields in a packet are processed. Only registered if performance counters or early publishing are enabled
+   * \param packet The packet that is about to be processed
+   * \param timestamp The timestamp of when the packet was received
+   */
+  void handleBeforePacket(const mip::PacketRef& packet, mip::Timestamp timestamp);
+
+  /**
+   * \brief Called after every handler of a field has processed it. Only registered if early publishing is enabled
+   * \param field The field that was processed
+   * \param timestamp The timestamp of when the packet was received
+   */
+  void handleAfterField(const mip::Field& field, mip::Timestamp timestamp);
+
   /**
    * \brief Called after a packet has been processed.
    * \param packet The packet that was processed
@@ -388,6 +621,43 @@ private:
   */
   void handleAfterPacket(const mip::PacketRef& packet, mip::Timestamp timestamp);
 
+  /**
+   * \brief Generates and publishes any host NMEA sentences that are due after a packet from the descriptor set was processed
+   * \param descriptor_set The descriptor set of the packet that was processed
+   * \param timestamp The timestamp of when the packet was received
+   */
+  void publishHostNmea(uint8_t descriptor_set, mip::Timestamp timestamp);
+
+  /**
+   * \brief Publishes the summary of the signal statistics if the current window has elapsed
+   * \param timestamp The timestamp of when the packet was received
+   */
+  void publishSignalStatistics(mip::Timestamp timestamp);
+
+  /**
+   * \brief Publishes the averaged vibration spectrum summary if it is due
+   * \param timestamp The timestamp of when the packet was received
+   */
+  void publishVibrationAnalysis(mip::Timestamp timestamp);
+
+  /**
+   * \brief Publishes the memory usage of each subsystem if it is due
+   * \param timestamp The timestamp of when the packet was received
+   */
+  void publishMemoryUsage(mip::Timestamp timestamp);
+
+  /**
+   * \brief Applies the GNSS status handled in this packet to the integrity state of each receiver, and publishes the states that changed or are due for a heartbeat
+   * \param descriptor_set The descriptor set of the packet, used to stamp the states
+   * \param timestamp The timestamp of when the packet was received
+   */
+  void publishGnssIntegrity(uint8_t descriptor_set, mip::Timestamp timestamp);
+
+  /**
+   * \brief Transforms the updated IMU and odometry messages into the target frame and publishes them. Must be called before the source messages are published
+   */
+  void publishTargetFrameVariants();
+
   /**
    * \brief Updates the microstrain header contained in all MIP specific custom messages
    * \param mip_header The header to update
@@ -416,6 +686,9 @@ private:
   // List of MIP dispatch handlers used to subscribe to data from the MIP SDK
   std::vector<std::shared_ptr<mip::C::mip_dispatch_handler>> mip_dispatch_handlers_;
 
+  // Publishers that publish as soon as their fields in a packet have been handled
+  std::vector<FieldTrigger*> early_publishers_;
+
   // Handles to the ROS node and the config
   RosNodeType* node_;
   Config* config_;
@@ -435,6 +708,10 @@ private:
   // Older philo devices do not support ECEF position, so we will need to convert from LLH to ECEF ourselves
   bool supports_filter_ecef_ = false;
 
+  // Device family, looked up once instead of comparing the model name on every packet
+  bool philo_device_ = false;
+  bool prospect_device_ = false;
+
   // Keep track of the filter state as the messages may override each other if we don't
   bool rtk_fixed_ = false;
   bool rtk_float_ = false;
@@ -453,6 +730,32 @@ private:
 
   // Clock model used to translate device time to ROS time for each descriptor set
   ClockBiasMonitor clock_bias_monitor_ = ClockBiasMonitor(0.99, 1.0);
+
+  // Builds NMEA sentences from binary data so the device does not have to stream them
+  NmeaGenerator gnss_nmea_generator_[NUM_GNSS];
+  NmeaGenerator filter_nmea_generator_;
+
+  // The filter does not output MSL height or satellite counts, so we borrow them from the GNSS receivers for the filter sentences
+  double geoid_separation_ = 0;
+  uint8_t gnss_num_sv_[NUM_GNSS] = {0, 0};
+
+  // Accumulates statistics for the signals summarized on the statistics topic, and the start of the current window in seconds
+  WindowedStatistics signal_statistics_;
+  double signal_statistics_window_start_ = -1;
+
+  // Computes the vibration spectrum of the raw IMU data on a background thread, and the last time the summary was published in seconds
+  std::unique_ptr<VibrationAnalyzer> vibration_analyzer_;
+  double vibration_analysis_last_publish_ = -1;
+
+  // Last time the memory usage was published in seconds, and the number of allocations made by each tag at that time
+  double memory_usage_last_publish_ = -1;
+  uint64_t memory_usage_last_allocations_[NUM_MEMORY_TAGS] = {};
+
+  // Integrity state of each GNSS receiver, built from the fix, SBAS, RF error detection and RTK corrections status
+  GnssIntegrity gnss_integrity_[NUM_GNSS];
+
+  // Rotation and lever arm from frame_id to target_frame_id, looked up once the transform is available
+  TargetFrameTransform target_frame_transform_;
 };
 
 template<void (Publishers::*Callback)(const mip::PacketRef&, mip::Timestamp)>
@@ -475,6 +778,16 @@ void Publishers::registerDataCallback(const uint8_t descriptor_set)
   config_->mip_device_->device().registerDataCallback<DataField, Publishers, Callback>(*(mip_dispatch_handlers_.back()), this, descriptor_set);
 }
 
+template<void (Publishers::*Callback)(const mip::Field&, mip::Timestamp)>
+void Publishers::registerFieldCallback(const uint8_t descriptor_set, const uint8_t field_descriptor)
+{
+  // Register a handler for the callback
+  mip_dispatch_handlers_.push_back(std::make_shared<mip::C::mip_dispatch_handler>());
+
+  // Pass to the MIP SDK
+  config_->mip_device_->device().registerFieldCallback<Publishers, Callback>(*(mip_dispatch_handlers_.back()), descriptor_set, field_descriptor, this);
+}
+
 }  // namespace microstrain
 
 #endif  // MICROSTRAIN_INERTIAL_DRIVER_COMMON_PUBLISHERS_H
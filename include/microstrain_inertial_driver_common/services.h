@@ -31,6 +31,21 @@ static constexpr auto MIP_3DM_DEVICE_SETTINGS_LOAD_SERVICE = "mip/three_dm/devic
 static constexpr auto MIP_3DM_GPIO_STATE_READ_SERVICE = "mip/three_dm/gpio_state/read";
 static constexpr auto MIP_3DM_GPIO_STATE_WRITE_SERVICE = "mip/three_dm/gpio_state/write";
 static constexpr auto MIP_FILTER_RESET_SERVICE = "mip/ekf/reset";
+static constexpr auto IMU_ALLAN_VARIANCE_READ_SERVICE = "imu/allan_variance/read";
+static constexpr auto IMU_ALLAN_VARIANCE_RESET_SERVICE = "imu/allan_variance/reset";
+static constexpr auto PERF_COUNTERS_READ_SERVICE = "perf_counters/read";
+static constexpr auto PERF_COUNTERS_RESET_SERVICE = "perf_counters/reset";
+static constexpr auto RTCM_STATISTICS_READ_SERVICE = "rtcm/statistics/read";
+static constexpr auto RTCM_STATISTICS_RESET_SERVICE = "rtcm/statistics/reset";
+static constexpr auto DEJITTER_STATISTICS_READ_SERVICE = "dejitter/statistics/read";
+static constexpr auto DEJITTER_STATISTICS_RESET_SERVICE = "dejitter/statistics/reset";
+static constexpr auto AIDING_CALLBACK_BENCHMARK_READ_SERVICE = "aiding/callback_benchmark/read";
+static constexpr auto AIDING_HEALTH_READ_SERVICE = "aiding/health/read";
+static constexpr auto AIDING_HEALTH_RESET_SERVICE = "aiding/health/reset";
+static constexpr auto MAG_CALIBRATION_READ_SERVICE = "mag/calibration/read";
+static constexpr auto MAG_CALIBRATION_WRITE_SERVICE = "mag/calibration/write";
+static constexpr auto MAG_CALIBRATION_FORCE_WRITE_SERVICE = "mag/calibration/force_write";
+static constexpr auto MAG_CALIBRATION_RESET_SERVICE = "mag/calibration/reset";
 
 /**
  * Contains service functions and service handles
@@ -56,6 +71,17 @@ public:
    */
   bool configure();
 
+  /**
+   * \brief Writes a magnetometer calibration fit to the device, combined with the calibration the device is currently applying.
+   *        If mag_calibration_dry_run is true, only logs what would have been written. The calibrator is reset after the write,
+   *        as the samples it has were corrected with the old calibration
+   * \param result The fit to write
+   * \param force Whether to write the fit even if it does not meet the thresholds
+   * \param message Will be populated with the values written and the coverage and fit error of the fit as YAML, or why they could not be written
+   * \return true if the calibration was written, or would have been written in a dry run
+   */
+  bool writeMagCalibration(const MagCalibrator::Result& result, bool force, std::string* message);
+
   // Service functions. Too many to document
   bool rawFileConfigMainRead(RawFileConfigReadSrv::Request& req, RawFileConfigReadSrv::Response& res);
   bool rawFileConfigMainWrite(RawFileConfigWriteSrv::Request& req, RawFileConfigWriteSrv::Response& res);
@@ -72,6 +98,28 @@ public:
 
   bool mipFilterReset(EmptySrv::Request& req, EmptySrv::Response& res);
 
+  bool imuAllanVarianceRead(TriggerSrv::Request& req, TriggerSrv::Response& res);
+  bool imuAllanVarianceReset(EmptySrv::Request& req, EmptySrv::Response& res);
+
+  bool perfCountersRead(TriggerSrv::Request& req, TriggerSrv::Response& res);
+  bool perfCountersReset(EmptySrv::Request& req, EmptySrv::Response& res);
+
+  bool rtcmStatisticsRead(TriggerSrv::Request& req, TriggerSrv::Response& res);
+  bool rtcmStatisticsReset(EmptySrv::Request& req, EmptySrv::Response& res);
+
+  bool dejitterStatisticsRead(TriggerSrv::Request& req, TriggerSrv::Response& res);
+  bool dejitterStatisticsReset(EmptySrv::Request& req, EmptySrv::Response& res);
+
+  bool aidingCallbackBenchmarkRead(TriggerSrv::Request& req, TriggerSrv::Response& res);
+
+  bool aidingHealthRead(TriggerSrv::Request& req, TriggerSrv::Response& res);
+  bool aidingHealthReset(EmptySrv::Request& req, EmptySrv::Response& res);
+
+  bool magCalibrationRead(TriggerSrv::Request& req, TriggerSrv::Response& res);
+  bool magCalibrationWrite(TriggerSrv::Request& req, TriggerSrv::Response& res);
+  bool magCalibrationForceWrite(TriggerSrv::Request& req, TriggerSrv::Response& res);
+  bool magCalibrationReset(EmptySrv::Request& req, EmptySrv::Response& res);
+
 private:
   /**
    * \brief Configures a non MIP command dependent service. This service will always be configured if this functions is called.
@@ -113,6 +161,26 @@ private:
   RosServiceType<Mip3dmGpioStateWriteSrv>::SharedPtr mip_3dm_gpio_state_write_service_;
 
   RosServiceType<EmptySrv>::SharedPtr mip_filter_reset_service_;
+
+  RosServiceType<TriggerSrv>::SharedPtr imu_allan_variance_read_service_;
+  RosServiceType<EmptySrv>::SharedPtr imu_allan_variance_reset_service_;
+
+  RosServiceType<TriggerSrv>::SharedPtr perf_counters_read_service_;
+  RosServiceType<EmptySrv>::SharedPtr perf_counters_reset_service_;
+
+  RosServiceType<TriggerSrv>::SharedPtr rtcm_statistics_read_service_;
+  RosServiceType<EmptySrv>::SharedPtr rtcm_statistics_reset_service_;
+
+  RosServiceType<TriggerSrv>::SharedPtr dejitter_statistics_read_service_;
+  RosServiceType<EmptySrv>::SharedPtr dejitter_statistics_reset_service_;
+  RosServiceType<TriggerSrv>::SharedPtr aiding_callback_benchmark_read_service_;
+  RosServiceType<TriggerSrv>::SharedPtr aiding_health_read_service_;
+  RosServiceType<EmptySrv>::SharedPtr aiding_health_reset_service_;
+
+  RosServiceType<TriggerSrv>::SharedPtr mag_calibration_read_service_;
+  RosServiceType<TriggerSrv>::SharedPtr mag_calibration_write_service_;
+  RosServiceType<TriggerSrv>::SharedPtr mag_calibration_force_write_service_;
+  RosServiceType<EmptySrv>::SharedPtr mag_calibration_reset_service_;
 };
 
 template<typename ServiceType>
@@ -13,12 +13,14 @@
 
 #include <array>
 #include <string>
+#include <vector>
 
 #include "microstrain_inertial_driver_common/utils/ros_compat.h"
 #include "microstrain_inertial_driver_common/utils/clock_bias_monitor.h"
 #include "microstrain_inertial_driver_common/config.h"
 
 #include "mip/definitions/commands_aiding.hpp"
+#include "mip/definitions/data_filter.hpp"
 
 namespace microstrain
 {
@@ -73,8 +75,8 @@ public:
   void externalPressureCallback(const FluidPressureMsg& fluid_pressure);
 
   /**
-   * \brief Accepts RTCM corrections from a ROS topic
-   * \param rtcm Message containing 
+   * \brief Accepts RTCM corrections from a ROS topic. If filtering is enabled, only valid frames of allowed message types are sent to the device
+   * \param rtcm Message containing the RTCM data
    */
   void rtcmCallback(const RTCMMsg& rtcm);
 
@@ -93,9 +95,26 @@ public:
   // RTCM subscriber
   RosSubType<RTCMMsg>::SharedPtr rtcm_sub_;
 
+  // Frames that passed the RTCM filter. Reused between messages to avoid allocating
+  std::vector<uint8_t> rtcm_frames_;
+
 private:
   uint8_t getSensorIdFromFrameId(const std::string& frame_id);
 
+  /**
+   * \brief Sends an aiding command to the device, unless the aiding health tracker has paused its source.
+   *        Commands from the aiding callback benchmark are sent to the emulated device instead, and their result and round trip latency are recorded
+   * \param command The aiding command to send
+   * \return The result of the command. A command that was not sent because its source is paused is reported as acknowledged
+   */
+  template<typename MipCommand>
+  mip::CmdResult sendAidingCommand(const MipCommand& command);
+
+  /**
+   * \brief Gives the aiding callback benchmark a function for each aiding command that sends a synthesized measurement through its callback
+   */
+  void configureAidingCallbackBenchmark();
+
   // Node Information
   RosNodeType* node_;
   Config* config_;
@@ -0,0 +1,164 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Parker-Lord Driver Definition File
+//
+// Copyright (c) 2017, Brian Bingham
+// Copyright (c) 2020, Parker Hannifin Corp
+//
+// This code is licensed under MIT license (see LICENSE file for details)
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef MICROSTRAIN_INERTIAL_DRIVER_COMMON_UTILS_AIDING_CALLBACK_BENCHMARK_H
+#define MICROSTRAIN_INERTIAL_DRIVER_COMMON_UTILS_AIDING_CALLBACK_BENCHMARK_H
+
+#include <mutex>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+#include <cstdint>
+#include <utility>
+#include <functional>
+#include <condition_variable>
+
+namespace microstrain
+{
+
+/**
+ * Measures the cost of the aiding callbacks by sending synthesized measurements through them at increasing rates.
+ * Each rate is held for a fixed duration, and for each step the number of commands the device accepted and the latency from
+ * sending each command to its reply are recorded. That latency covers building and encoding the command in the driver, plus the reply time of the device.
+ * The measurements are made up, so the callbacks are expected to send anything called from the benchmark thread to an emulated device instead of the real one.
+ * The emulated device runs in the driver process, so this says nothing about how aiding affects the data streamed from the real device
+ */
+class AidingCallbackBenchmark
+{
+ public:
+  using Sender = std::function<void()>;
+  using StepCallback = std::function<void(const std::string&)>;
+
+  /**
+   * \brief Constructor. Nothing is sent until start is called
+   * \param rates Rates in hertz to send each measurement at, in the order they are run
+   * \param step_duration How long to run each rate for in seconds
+   */
+  AidingCallbackBenchmark(const std::vector<double>& rates, double step_duration);
+  AidingCallbackBenchmark(const AidingCallbackBenchmark&) = delete;
+  AidingCallbackBenchmark& operator=(const AidingCallbackBenchmark&) = delete;
+
+  /**
+   * \brief Stops the benchmark
+   */
+  ~AidingCallbackBenchmark();
+
+  /**
+   * \brief Replaces the functions that send the measurements. Each one is called once per period of the current rate
+   * \param senders Name of each measurement, and a function that sends one synthesized measurement through its aiding callback
+   */
+  void setSenders(const std::vector<std::pair<std::string, Sender>>& senders);
+
+  /**
+   * \brief Starts running the steps from a background thread. The benchmark only runs once, so this does nothing after the first call
+   * \param step_callback Called from the background thread with a one line summary at the end of each step
+   */
+  void start(StepCallback step_callback);
+
+  /**
+   * \brief Stops the background thread. The step that was running is discarded
+   */
+  void stop();
+
+  /**
+   * \brief Checks if a step is running. Measurements are only recorded while a step is running
+   * \return true if a step is running
+   */
+  bool running() const;
+
+  /**
+   * \brief Checks if the calling thread is the one sending the synthesized measurements
+   * \return true if called from the benchmark thread
+   */
+  static bool onBenchmarkThread();
+
+  /**
+   * \brief Records the result of an aiding command sent to the device
+   * \param accepted Whether the device acknowledged the command
+   * \param latency Time between sending the command and receiving the reply in seconds
+   */
+  void recordCommand(bool accepted, double latency);
+
+  /**
+   * \brief Formats the results of every finished step as YAML
+   * \return The results as YAML
+   */
+  std::string toYaml() const;
+
+ private:
+  /**
+   * Percentiles of a set of latencies
+   */
+  struct Percentiles
+  {
+    uint64_t count = 0;  /// Number of latencies
+    double p50 = 0;  /// Median latency in seconds
+    double p90 = 0;  /// 90th percentile latency in seconds
+    double p99 = 0;  /// 99th percentile latency in seconds
+    double max = 0;  /// Largest latency in seconds
+  };
+
+  /**
+   * Results of running a single rate
+   */
+  struct Step
+  {
+    double rate = 0;  /// Rate each measurement was requested at in hertz
+    double duration = 0;  /// How long the step ran for in seconds
+    uint64_t sent = 0;  /// Number of aiding commands sent
+    uint64_t accepted = 0;  /// Number of aiding commands the device acknowledged
+    Percentiles command_latency;  /// Round trip latency of the aiding commands
+  };
+
+  /**
+   * \brief Runs every step, then exits. Runs on its own thread
+   */
+  void run();
+
+  /**
+   * \brief Computes the percentiles of a set of latencies. Reorders the latencies
+   * \param latencies The latencies in seconds
+   * \return The percentiles of the latencies
+   */
+  static Percentiles percentiles(std::vector<double>* latencies);
+
+  /**
+   * \brief Formats the results of a step as a single line
+   * \param step The step to format
+   * \return The summary of the step
+   */
+  static std::string summary(const Step& step);
+
+  const std::vector<double> rates_;  /// Rates in hertz to send each measurement at
+  const double step_duration_;  /// How long to run each rate for in seconds
+
+  std::mutex senders_mutex_;  /// Protects the senders, as they are replaced when the driver reactivates
+  std::vector<std::pair<std::string, Sender>> senders_;  /// Name of each measurement, and the function that sends it
+
+  std::atomic<bool> started_ = {false};  /// Whether the benchmark has been started
+  std::atomic<bool> recording_ = {false};  /// Whether a step is running
+  std::mutex stop_mutex_;  /// Protects the stop flag
+  std::condition_variable stop_condition_;  /// Wakes the benchmark thread when it is stopped
+  bool stop_ = false;  /// Whether the benchmark thread should exit
+  std::thread thread_;  /// Thread running the steps
+  StepCallback step_callback_;  /// Called at the end of each step
+
+  mutable std::mutex results_mutex_;  /// Protects the results and the step being recorded, as they are written from several threads
+  uint64_t sent_ = 0;  /// Number of aiding commands sent in the current step
+  uint64_t accepted_ = 0;  /// Number of aiding commands acknowledged in the current step
+  std::vector<double> command_latencies_;  /// Round trip latencies of the aiding commands in the current step
+  std::vector<Step> steps_;  /// Results of the finished steps
+};
+
+}  // namespace microstrain
+
+#endif  // MICROSTRAIN_INERTIAL_DRIVER_COMMON_UTILS_AIDING_CALLBACK_BENCHMARK_H
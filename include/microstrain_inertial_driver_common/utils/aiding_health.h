@@ -0,0 +1,163 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Parker-Lord Driver Definition File
+//
+// Copyright (c) 2017, Brian Bingham
+// Copyright (c) 2020, Parker Hannifin Corp
+//
+// This code is licensed under MIT license (see LICENSE file for details)
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef MICROSTRAIN_INERTIAL_DRIVER_COMMON_UTILS_AIDING_HEALTH_H
+#define MICROSTRAIN_INERTIAL_DRIVER_COMMON_UTILS_AIDING_HEALTH_H
+
+#include <map>
+#include <mutex>
+#include <string>
+#include <cstdint>
+#include <memory>
+#include <functional>
+
+#include "microstrain_inertial_driver_common/utils/clock.h"
+#include "microstrain_inertial_driver_common/utils/realtime.h"
+
+namespace microstrain
+{
+
+/**
+ * Tracks how the filter treats each external aiding source using the aiding measurement summaries it reports,
+ * and decides whether the driver should keep sending measurements from each source.
+ * A source the filter keeps rejecting is paused, and after the pause a few measurements are sent to probe whether the filter accepts it again.
+ * Every failed probe doubles the pause, up to a limit, and a successful probe resumes the source.
+ * Summaries are only judged while the filter is running, as a filter that is initializing rejects measurements it will accept once it converges,
+ * and the last active source of a measurement type is never paused, so the filter is never left without any source of that type.
+ */
+class AidingHealthTracker
+{
+ public:
+  using Logger = std::function<void(const std::string&)>;
+
+  /**
+   * Settings that control when a source is paused and resumed
+   */
+  struct Policy
+  {
+    uint32_t window = 20;  /// Number of summaries the ratios are averaged over
+    double pause_threshold = 0.2;  /// A source is paused when the fraction of its measurements used by the filter falls below this
+    double resume_threshold = 0.5;  /// A probe resumes the source if at least this fraction of the probe measurements were used
+    double pause_duration = 1.0;  /// How long the first pause lasts in seconds
+    double max_pause_duration = 30.0;  /// Longest a pause can grow to in seconds
+    uint32_t probe_count = 5;  /// Number of summaries to judge a probe on
+    double probe_timeout = 5.0;  /// If no summaries arrive this many seconds into a probe, the source is resumed
+  };
+
+  /**
+   * \brief Constructor
+   * \param policy Settings that control when a source is paused and resumed
+   * \param clock The clock the pauses and probes are timed with
+   * \param logger Called whenever a source is paused, probed or resumed
+   */
+  AidingHealthTracker(const Policy& policy, std::shared_ptr<Clock> clock, Logger logger);
+
+  /**
+   * \brief Records an aiding measurement summary reported by the filter
+   * \param type Type of the measurement the summary is for
+   * \param source Sensor ID of the measurement the summary is for
+   * \param used Whether the filter used the measurement
+   * \param residual_high Whether the filter reported the residual of the measurement as high
+   * \param sample_time_warning Whether the filter reported a problem with the time of the measurement
+   */
+  void recordSummary(uint8_t type, uint8_t source, bool used, bool residual_high, bool sample_time_warning);
+
+  /**
+   * \brief Tells the tracker whether the filter is running. Summaries are ignored while it is not, and every paused source is resumed when it stops,
+   *        so the filter has every measurement available while it initializes
+   * \param running Whether the filter reports a running state with a valid solution
+   */
+  void setFilterRunning(bool running);
+
+  /**
+   * \brief Checks whether a measurement from a source should be sent to the device
+   * \param type Type of the measurement
+   * \param source Sensor ID of the measurement
+   * \return false if the source is paused
+   */
+  bool shouldSend(uint8_t type, uint8_t source);
+
+  /**
+   * \brief Formats the ratios and state of every source as YAML
+   * \return The statistics as YAML
+   */
+  std::string toYaml() const;
+
+  /**
+   * \brief Clears the statistics, and resumes every source
+   */
+  void reset();
+
+ private:
+  /**
+   * Whether measurements from a source are being sent
+   */
+  enum class State
+  {
+    ACTIVE,  /// Measurements are sent
+    PAUSED,  /// Measurements are dropped until the pause ends
+    PROBING  /// Measurements are sent to check whether the filter accepts them again
+  };
+
+  /**
+   * Statistics and state of a single source
+   */
+  struct Source
+  {
+    State state = State::ACTIVE;  /// Whether measurements from this source are being sent
+    uint64_t summaries = 0;  /// Number of summaries received
+    uint64_t suppressed = 0;  /// Number of measurements not sent because the source was paused
+    uint64_t pauses = 0;  /// Number of times the source was paused
+    double used_ratio = 1;  /// Moving average of the fraction of measurements the filter used
+    double residual_warning_ratio = 0;  /// Moving average of the fraction of measurements with a high residual
+    double timing_warning_ratio = 0;  /// Moving average of the fraction of measurements with a sample time warning
+    double pause_duration = 0;  /// How long the current or next pause lasts in seconds
+    double state_time = 0;  /// Time the source entered its current state in seconds
+    uint32_t probe_summaries = 0;  /// Number of summaries received during the current probe
+    uint32_t probe_used = 0;  /// Number of measurements the filter used during the current probe
+  };
+
+  /**
+   * \brief Moves a source to a new state. Must be called with the mutex held
+   * \param key Key of the source
+   * \param source The source to move
+   * \param state The new state
+   * \param now The current time in seconds
+   * \return Message describing the change to log
+   */
+  std::string transition(uint16_t key, Source* source, State state, double now);
+
+  /**
+   * \brief Checks whether any other source of the same measurement type is active. Must be called with the mutex held
+   * \param key Key of the source
+   * \return true if another source with the same type is active
+   */
+  bool otherSourceActive(uint16_t key) const;
+
+  /**
+   * \brief Gets the name of a state
+   * \param state The state
+   * \return The name of the state
+   */
+  static const char* stateName(State state);
+
+  const Policy policy_;  /// Settings that control when a source is paused and resumed
+  std::shared_ptr<Clock> clock_;  /// The clock the pauses and probes are timed with
+  Logger logger_;  /// Called whenever a source changes state
+
+  mutable AuditedMutex mutex_;  /// Protects the sources, as summaries are recorded from the parsing thread and measurements are sent from the subscriber threads
+  std::map<uint16_t, Source> sources_;  /// Sources by type in the high byte and sensor ID in the low byte
+  bool filter_running_ = false;  /// Whether the filter reports a running state, so the summaries say something about the sources
+};
+
+}  // namespace microstrain
+
+#endif  // MICROSTRAIN_INERTIAL_DRIVER_COMMON_UTILS_AIDING_HEALTH_H
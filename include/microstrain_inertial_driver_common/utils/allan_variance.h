@@ -0,0 +1,123 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Parker-Lord Driver Definition File
+//
+// Copyright (c) 2017, Brian Bingham
+// Copyright (c) 2020, Parker Hannifin Corp
+//
+// This code is licensed under MIT license (see LICENSE file for details)
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef MICROSTRAIN_INERTIAL_DRIVER_COMMON_UTILS_ALLAN_VARIANCE_H
+#define MICROSTRAIN_INERTIAL_DRIVER_COMMON_UTILS_ALLAN_VARIANCE_H
+
+#include <mutex>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+#include "microstrain_inertial_driver_common/utils/realtime.h"
+
+namespace microstrain
+{
+
+/**
+ * Computes the Allan deviation of a set of signals at octave spaced cluster times while the data is streaming.
+ * Each octave only keeps the previous cluster and a partially complete cluster, so memory is logarithmic in the number of samples
+ * and the amortized cost of each sample is constant. The clusters do not overlap, which trades some confidence at long cluster times for bounded memory.
+ */
+class AllanVariance
+{
+ public:
+  // Order of the signals analyzed
+  static constexpr size_t SIGNAL_GYRO = 0;  // x, y, z
+  static constexpr size_t SIGNAL_ACCEL = 3;  // x, y, z
+  static constexpr size_t NUM_SIGNALS = 6;
+
+  /**
+   * Allan deviation at a single cluster time
+   */
+  struct Point
+  {
+    double tau;  /// Cluster time in seconds
+    double deviation;  /// Allan deviation at the cluster time
+    uint64_t num_differences;  /// Number of cluster differences used to compute the deviation. More differences means more confidence
+  };
+
+  /**
+   * Noise parameters fitted to the Allan deviation curve of a signal. Parameters that could not be fitted are NaN
+   */
+  struct NoiseParameters
+  {
+    double random_walk;  /// Angle or velocity random walk read from the -1/2 slope at a cluster time of 1 second
+    double bias_instability;  /// Bias instability read from the minimum of the curve
+    double rate_random_walk;  /// Rate or acceleration random walk read from the +1/2 slope at a cluster time of 3 seconds
+  };
+
+  /**
+   * \brief Constructor
+   * \param num_octaves Number of octave spaced cluster times to compute. The longest cluster will be 2^(num_octaves - 1) samples
+   */
+  explicit AllanVariance(const size_t num_octaves);
+
+  /**
+   * \brief Adds a rate sample for three consecutive signals
+   * \param first_signal Either SIGNAL_GYRO or SIGNAL_ACCEL
+   * \param x The sample for the x axis
+   * \param y The sample for the y axis
+   * \param z The sample for the z axis
+   * \param sample_period Time in seconds the samples were integrated over. Used to determine the cluster times
+   */
+  void add(const size_t first_signal, const double x, const double y, const double z, const double sample_period);
+
+  /**
+   * \brief Gets the Allan deviation curve for a signal. Only cluster times that have at least one difference are included
+   * \param signal The signal to get the curve for
+   * \return The curve ordered by increasing cluster time
+   */
+  std::vector<Point> curve(const size_t signal) const;
+
+  /**
+   * \brief Fits the standard noise parameters to an Allan deviation curve
+   * \param curve The curve to fit
+   * \return The fitted noise parameters
+   */
+  static NoiseParameters fit(const std::vector<Point>& curve);
+
+  /**
+   * \brief Formats the curves and noise parameters for every signal as YAML
+   * \return YAML document containing the curve and noise parameters for every signal
+   */
+  std::string toYaml() const;
+
+  /**
+   * \brief Discards all collected data and starts over
+   */
+  void reset();
+
+ private:
+  /**
+   * State of a single octave for a single signal
+   */
+  struct Octave
+  {
+    double partial_cluster = 0;  /// First half of the next cluster to pass to the next octave
+    bool has_partial_cluster = false;  /// Whether or not partial_cluster is valid
+    double previous_cluster = 0;  /// Average of the previous complete cluster at this octave
+    bool has_previous_cluster = false;  /// Whether or not previous_cluster is valid
+    double sum_squared_differences = 0;  /// Sum of the squared differences between consecutive clusters
+    uint64_t num_differences = 0;  /// Number of differences in sum_squared_differences
+  };
+
+  mutable AuditedMutex mutex_;  /// Allows the curve to be read while samples are being added from another thread
+  size_t num_octaves_;  /// Number of octaves for each signal
+  std::vector<std::vector<Octave>> octaves_;  /// Octave state for each signal
+  std::vector<double> total_time_;  /// Sum of the sample periods for each signal
+  std::vector<uint64_t> num_samples_;  /// Number of samples added for each signal
+};
+
+}  // namespace microstrain
+
+#endif  // MICROSTRAIN_INERTIAL_DRIVER_COMMON_UTILS_ALLAN_VARIANCE_H
@@ -0,0 +1,101 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Parker-Lord Driver Definition File
+//
+// Copyright (c) 2017, Brian Bingham
+// Copyright (c) 2020, Parker Hannifin Corp
+//
+// This code is licensed under MIT license (see LICENSE file for details)
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef MICROSTRAIN_INERTIAL_DRIVER_COMMON_UTILS_BUILD_PROFILE_H
+#define MICROSTRAIN_INERTIAL_DRIVER_COMMON_UTILS_BUILD_PROFILE_H
+
+/**
+ * Build profiles select which device families and features are compiled into the driver.
+ * Select one by setting MICROSTRAIN_BUILD_PROFILE to full, gq7 or cv7 when configuring a package that includes cmake/microstrain_inertial_driver_common.cmake,
+ * or by defining the MICROSTRAIN_BUILD_PROFILE macro to one of the values below, for example
+ *   add_compile_definitions(MICROSTRAIN_BUILD_PROFILE=MICROSTRAIN_BUILD_PROFILE_CV7)
+ * Individual features can also be turned on or off on top of the profile by defining the MICROSTRAIN_FEATURE_* macros to 0 or 1.
+ *
+ * Code for disabled features is guarded by the constexpr flags in BuildFeatures, so the branches fold away at compile time.
+ * The handlers that are no longer referenced are only removed from the binary if it is compiled with
+ *   -ffunction-sections -fdata-sections
+ * and linked with
+ *   -Wl,--gc-sections
+ * which the MICROSTRAIN_GC_SECTIONS option of the CMake fragment adds. Functions exported from a shared library are always kept, so the most is removed
+ * when the driver is linked into an executable, or built with hidden visibility
+ */
+#define MICROSTRAIN_BUILD_PROFILE_FULL 0  // Every supported device and feature
+#define MICROSTRAIN_BUILD_PROFILE_GQ7 1   // Prospect GNSS/INS devices such as the GQ7. Drops support for the GX5 and older families
+#define MICROSTRAIN_BUILD_PROFILE_CV7 2   // Prospect devices without a GNSS receiver such as the CV7-AHRS and CV7-INS. Drops GNSS, RTK, dual antenna, NMEA and GX5 support,
+                                          // but keeps external aiding, as that is how the CV7-INS is given position, velocity and heading
+
+#ifndef MICROSTRAIN_BUILD_PROFILE
+#define MICROSTRAIN_BUILD_PROFILE MICROSTRAIN_BUILD_PROFILE_FULL
+#endif
+
+#if MICROSTRAIN_BUILD_PROFILE == MICROSTRAIN_BUILD_PROFILE_FULL
+#define MICROSTRAIN_BUILD_PROFILE_NAME "full"
+#define MICROSTRAIN_BUILD_PROFILE_PHILO 1
+#define MICROSTRAIN_BUILD_PROFILE_GNSS 1
+#define MICROSTRAIN_BUILD_PROFILE_AIDING 1
+#elif MICROSTRAIN_BUILD_PROFILE == MICROSTRAIN_BUILD_PROFILE_GQ7
+#define MICROSTRAIN_BUILD_PROFILE_NAME "gq7"
+#define MICROSTRAIN_BUILD_PROFILE_PHILO 0
+#define MICROSTRAIN_BUILD_PROFILE_GNSS 1
+#define MICROSTRAIN_BUILD_PROFILE_AIDING 1
+#elif MICROSTRAIN_BUILD_PROFILE == MICROSTRAIN_BUILD_PROFILE_CV7
+#define MICROSTRAIN_BUILD_PROFILE_NAME "cv7"
+#define MICROSTRAIN_BUILD_PROFILE_PHILO 0
+#define MICROSTRAIN_BUILD_PROFILE_GNSS 0
+#define MICROSTRAIN_BUILD_PROFILE_AIDING 1
+#else
+#error "Unknown MICROSTRAIN_BUILD_PROFILE. Must be one of the MICROSTRAIN_BUILD_PROFILE_* values"
+#endif
+
+#ifndef MICROSTRAIN_FEATURE_PHILO
+#define MICROSTRAIN_FEATURE_PHILO MICROSTRAIN_BUILD_PROFILE_PHILO
+#endif
+#ifndef MICROSTRAIN_FEATURE_GNSS
+#define MICROSTRAIN_FEATURE_GNSS MICROSTRAIN_BUILD_PROFILE_GNSS
+#endif
+#ifndef MICROSTRAIN_FEATURE_RTK
+#define MICROSTRAIN_FEATURE_RTK MICROSTRAIN_FEATURE_GNSS
+#endif
+#ifndef MICROSTRAIN_FEATURE_DUAL_ANTENNA
+#define MICROSTRAIN_FEATURE_DUAL_ANTENNA MICROSTRAIN_FEATURE_GNSS
+#endif
+#ifndef MICROSTRAIN_FEATURE_NMEA
+#define MICROSTRAIN_FEATURE_NMEA MICROSTRAIN_FEATURE_GNSS
+#endif
+#ifndef MICROSTRAIN_FEATURE_AIDING
+#define MICROSTRAIN_FEATURE_AIDING MICROSTRAIN_BUILD_PROFILE_AIDING
+#endif
+#ifndef MICROSTRAIN_FEATURE_BUILT_IN_TEST
+#define MICROSTRAIN_FEATURE_BUILT_IN_TEST 1
+#endif
+
+namespace microstrain
+{
+
+/**
+ * Features compiled into this build of the driver. Use these instead of the macros, so that disabled code is still compiled and type checked
+ */
+struct BuildFeatures
+{
+  static constexpr auto PROFILE_NAME = MICROSTRAIN_BUILD_PROFILE_NAME;  /// Name of the profile the driver was built with
+
+  static constexpr bool PHILO = MICROSTRAIN_FEATURE_PHILO != 0;  /// GX5, CV5, CX5 and older devices, including their legacy timestamp fields and filter modes
+  static constexpr bool GNSS = MICROSTRAIN_FEATURE_GNSS != 0;  /// GNSS receiver data
+  static constexpr bool RTK = GNSS && MICROSTRAIN_FEATURE_RTK != 0;  /// RTK corrections status, and the NTRIP interface through the aux port
+  static constexpr bool DUAL_ANTENNA = GNSS && MICROSTRAIN_FEATURE_DUAL_ANTENNA != 0;  /// Dual antenna heading and antenna offset correction
+  static constexpr bool NMEA = MICROSTRAIN_FEATURE_NMEA != 0;  /// NMEA sentences parsed from the device or generated by the driver
+  static constexpr bool AIDING = MICROSTRAIN_FEATURE_AIDING != 0;  /// External aiding measurements subscribed to from ROS
+  static constexpr bool BUILT_IN_TEST = MICROSTRAIN_FEATURE_BUILT_IN_TEST != 0;  /// Continuous built in test data
+};
+
+}  // namespace microstrain
+
+#endif  // MICROSTRAIN_INERTIAL_DRIVER_COMMON_UTILS_BUILD_PROFILE_H
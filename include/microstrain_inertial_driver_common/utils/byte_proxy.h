@@ -0,0 +1,220 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Parker-Lord Driver Definition File
+//
+// Copyright (c) 2017, Brian Bingham
+// Copyright (c) 2020, Parker Hannifin Corp
+//
+// This code is licensed under MIT license (see LICENSE file for details)
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef MICROSTRAIN_INERTIAL_DRIVER_COMMON_UTILS_BYTE_PROXY_H
+#define MICROSTRAIN_INERTIAL_DRIVER_COMMON_UTILS_BYTE_PROXY_H
+
+#include <deque>
+#include <mutex>
+#include <memory>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+#include <cstdint>
+#include <functional>
+
+namespace microstrain
+{
+
+/**
+ * Mirrors the bytes read from a port to clients connected to a local Unix socket, so other tools can watch the device while the driver runs.
+ * Bytes are written once into a ring buffer, and each client is sent data out of the ring buffer from its own read position.
+ * Optionally forwards MIP packets from clients to the device, one command at a time. The reply to a forwarded command is only sent to the client that sent it,
+ * and commands from the driver and from clients are never outstanding at the same time, so neither can mistake the other's reply for its own.
+ * The driver is never made to wait. Its commands are queued while a command from a client is outstanding, and the proxy thread sends them once that command is answered.
+ * The driver keeps parsing what the device sends meanwhile, so if a client sends the very same command the driver is waiting to send, the driver may take the client's reply as its own
+ */
+class ByteProxy
+{
+ public:
+  using Sender = std::function<bool(const uint8_t*, size_t)>;
+
+  /**
+   * \brief Constructs the proxy. Nothing is mirrored until start is called
+   * \param buffer_size Size of the ring buffer in bytes. Rounded up to a power of two. Clients that fall further behind than half of this lose data
+   * \param commands_enable Whether to forward MIP packets written by clients to the device
+   * \param command_timeout_ms How long to wait for the reply to a forwarded command before forwarding the next one
+   */
+  ByteProxy(size_t buffer_size, bool commands_enable, int command_timeout_ms);
+  ByteProxy(const ByteProxy&) = delete;
+  ByteProxy& operator=(const ByteProxy&) = delete;
+
+  /**
+   * \brief Stops the proxy
+   */
+  ~ByteProxy();
+
+  /**
+   * \brief Starts listening for clients and serving them from a background thread. Any existing socket file at the path is replaced
+   * \param socket_path Path of the Unix socket clients connect to
+   * \param error Will be populated with the reason the proxy could not be started
+   * \return true if the proxy is running
+   */
+  bool start(const std::string& socket_path, std::string* error);
+
+  /**
+   * \brief Disconnects all clients, stops the background thread, and removes the socket file
+   */
+  void stop();
+
+  /**
+   * \brief Sets the function used to send commands from clients to the device
+   * \param sender Function that sends bytes to the device
+   */
+  void setSender(Sender sender);
+
+  /**
+   * \brief Mirrors bytes read from the device to the clients. Does not allocate or make any system calls, so can be called from the hot path
+   * \param data The bytes read from the device
+   * \param size Number of bytes in data
+   */
+  void write(const uint8_t* data, size_t size);
+
+  /**
+   * \brief Called by the driver before it sends a command to the device, and holds back commands from clients until the device has answered it.
+   *        Never blocks. If a command forwarded from a client is still waiting on its reply, the command is queued instead,
+   *        and sent by the proxy thread once the reply has been routed to the client or timed out
+   * \param data The MIP packet about to be sent
+   * \param size Number of bytes in data
+   * \return true if the driver should send the command now, false if the proxy took the command and will send it
+   */
+  bool beginDriverCommand(const uint8_t* data, size_t size);
+
+ private:
+  /**
+   * A client connected to the socket
+   */
+  struct Client
+  {
+    uint64_t id;  /// Identifies the client for as long as the proxy runs
+    int fd;  /// Socket of the client
+    uint64_t position;  /// Position in the stream of the next byte to send to the client
+    std::vector<uint8_t> command_buffer;  /// Bytes written by the client that have not yet formed a full MIP packet
+    size_t pending_commands;  /// Number of commands from the client waiting to be forwarded
+  };
+
+  /**
+   * A command from a client waiting to be forwarded
+   */
+  struct PendingCommand
+  {
+    uint64_t client_id;  /// Client that sent the command
+    std::vector<uint8_t> packet;  /// The command
+  };
+
+  /**
+   * A reply to a forwarded command. Only the client that sent the command is sent these bytes
+   */
+  struct RoutedReply
+  {
+    uint64_t client_id;  /// Client that sent the command
+    uint64_t start;  /// Position in the stream of the first byte of the reply
+    uint64_t end;  /// Position in the stream of the last byte of the reply plus one
+  };
+
+  /**
+   * \brief Accepts new clients, reads commands from them and sends them any new data until stopped. Runs on its own thread
+   */
+  void run();
+
+  /**
+   * \brief Sends as much of the new data as the client will accept without blocking
+   * \param client The client to send to
+   * \param end Position in the stream up to which data can be sent
+   * \return false if the client disconnected
+   */
+  bool flushClient(Client* client, uint64_t end);
+
+  /**
+   * \brief Copies bytes out of the ring buffer. The copy may be torn if the writer overwrote the bytes meanwhile, so check it with oldestIntactPosition
+   * \param position Position in the stream of the first byte to copy
+   * \param size Number of bytes to copy. Must not be larger than the ring buffer
+   * \param data Will be populated with the bytes
+   */
+  void copyOut(uint64_t position, size_t size, uint8_t* data) const;
+
+  /**
+   * \brief Gets the oldest position in the stream the writer has not started to overwrite. Bytes copied from before this position may be torn
+   * \return Position in the stream of the oldest byte that is still intact
+   */
+  uint64_t oldestIntactPosition() const;
+
+  /**
+   * \brief Reads bytes written by the client, and queues any complete MIP packets to be forwarded to the device
+   * \param client The client to read from
+   * \return false if the client disconnected
+   */
+  bool readClient(Client* client);
+
+  /**
+   * \brief Forwards the next queued command once the reply to the previous one has arrived or timed out
+   * \param end Position in the stream of the last byte written plus one
+   * \return Position in the stream up to which clients can be sent data. Bytes that may be the start of the reply to a forwarded command are held back
+   */
+  uint64_t updateCommands(uint64_t end);
+
+  /**
+   * \brief Starts waiting for the reply to a command. Must be called with command_mutex_ held
+   * \param client_id Client that sent the command, or DRIVER_CLIENT_ID for commands from the driver
+   * \param packet The command
+   */
+  void beginCommand(uint64_t client_id, const uint8_t* packet);
+
+  /**
+   * \brief Finds the first complete MIP packet with a valid checksum in a buffer
+   * \param buffer The bytes to search. Anything before the packet is removed
+   * \param packet Will be populated with the packet if one is found, and the packet is removed from the buffer
+   * \return true if a packet was found
+   */
+  static bool extractPacket(std::vector<uint8_t>* buffer, std::vector<uint8_t>* packet);
+
+  // The ring buffer is stored as atomic bytes, so a client falling behind can never race with the writer, only detect that it was overwritten
+  std::unique_ptr<std::atomic<uint8_t>[]> buffer_;  /// Ring buffer containing the most recent bytes read from the device
+  size_t capacity_;  /// Size of the ring buffer. Always a power of two
+  uint64_t mask_;  /// Size of the ring buffer minus one, used to convert stream positions into buffer offsets
+  std::atomic<uint64_t> write_position_ = {0};  /// Total number of bytes written to the ring buffer
+  std::atomic<uint64_t> write_reserve_position_ = {0};  /// Total number of bytes written to the ring buffer once the write in progress finishes
+  std::atomic<bool> running_ = {false};  /// Whether the proxy is running
+
+  bool commands_enable_;  /// Whether to forward MIP packets written by clients to the device
+  std::chrono::milliseconds command_timeout_;  /// How long to wait for the reply to a forwarded command
+
+  std::mutex sender_mutex_;  /// Protects the sender, as it is replaced when the driver reconnects
+  Sender sender_;  /// Sends bytes to the device
+
+  int listen_fd_ = -1;  /// Socket accepting clients
+  std::string socket_path_;  /// Path of the socket file
+  std::thread thread_;  /// Thread serving the clients
+
+  // Shared between the proxy thread and the driver sending its own commands
+  std::mutex command_mutex_;  /// Protects the outstanding command
+  bool command_outstanding_ = false;  /// Whether we are waiting for the reply to a command
+  uint64_t command_client_id_ = 0;  /// Client that sent the outstanding command, or DRIVER_CLIENT_ID if the driver sent it
+  uint8_t command_descriptor_set_ = 0;  /// Descriptor set of the outstanding command
+  uint8_t command_field_descriptor_ = 0;  /// Field descriptor of the outstanding command
+  std::chrono::steady_clock::time_point command_deadline_;  /// Time after which we stop waiting for the reply to the outstanding command
+  uint64_t reply_position_ = 0;  /// Position in the stream up to which we have searched for the reply
+  std::vector<uint8_t> reply_buffer_;  /// Bytes read from the device since the outstanding command was sent that may still contain the reply
+  std::deque<std::vector<uint8_t>> driver_commands_;  /// Commands from the driver waiting for a command from a client to be answered, sent before any other client command
+
+  // Everything below is only accessed from the proxy thread
+  std::vector<Client> clients_;  /// Connected clients
+  uint64_t next_client_id_ = 1;  /// Identifier given to the next client that connects
+  std::deque<PendingCommand> pending_commands_;  /// Commands from clients waiting to be forwarded
+  std::deque<RoutedReply> routed_replies_;  /// Replies that only the client that sent the command should be sent, oldest first
+  std::vector<uint8_t> staging_;  /// Bytes copied out of the ring buffer and checked to be intact before they are sent anywhere
+};
+
+}  // namespace microstrain
+
+#endif  // MICROSTRAIN_INERTIAL_DRIVER_COMMON_UTILS_BYTE_PROXY_H
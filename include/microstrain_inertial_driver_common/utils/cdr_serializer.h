@@ -0,0 +1,213 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Parker-Lord Driver Definition File
+//
+// Copyright (c) 2017, Brian Bingham
+// Copyright (c) 2020, Parker Hannifin Corp
+//
+// This code is licensed under MIT license (see LICENSE file for details)
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef MICROSTRAIN_INERTIAL_DRIVER_COMMON_UTILS_CDR_SERIALIZER_H
+#define MICROSTRAIN_INERTIAL_DRIVER_COMMON_UTILS_CDR_SERIALIZER_H
+
+#include <string>
+#include <memory>
+#include <cstdint>
+#include <cstddef>
+
+#include "microstrain_inertial_driver_common/utils/ros_compat.h"
+#include "microstrain_inertial_driver_common/utils/imu_sample.h"
+
+#if MICROSTRAIN_ROS_VERSION == 2
+#include "rclcpp/serialized_message.hpp"
+#endif
+
+namespace microstrain
+{
+
+/**
+ * Serializes messages to CDR without going through the middleware.
+ * Only messages with a fixed layout are supported, and only on ROS2. Every other message type uses this empty implementation
+ * \tparam MessageType The type of message to serialize
+ */
+template<typename MessageType>
+class CdrSerializer
+{
+ public:
+  static constexpr bool SUPPORTED = false;
+};
+
+#if MICROSTRAIN_ROS_VERSION == 2
+
+/**
+ * Precomputed layout of a serialized message made of a header, optionally a child frame ID, and a fixed number of doubles.
+ * The strings are only serialized again when they change, so most messages only need the stamp and the doubles to be written
+ */
+class CdrLayout
+{
+ public:
+  /**
+   * \brief Prepares the serialized message, and writes the stamp. The doubles must be written with put afterwards
+   * \param serialized_msg The serialized message to write to. Reused between calls
+   * \param header The header of the message
+   * \param child_frame_id The child frame ID of the message, or nullptr if the message does not have one
+   * \param num_doubles Number of doubles that will be written after the header
+   */
+  void begin(rclcpp::SerializedMessage* serialized_msg, const RosHeaderType& header, const std::string* child_frame_id, const size_t num_doubles);
+
+  /**
+   * \brief Writes the next double in the message
+   * \param value The value to write
+   */
+  void put(const double value);
+
+  /**
+   * \brief Writes the next doubles in the message from an array
+   * \param values The array to write
+   */
+  template<typename ArrayType>
+  void putArray(const ArrayType& values)
+  {
+    for (const double value : values)
+      put(value);
+  }
+
+ private:
+  uint8_t* buffer_ = nullptr;  /// Buffer of the serialized message being written
+  size_t cursor_ = 0;  /// Offset in the buffer of the next double to write
+
+  std::string frame_id_;  /// Frame ID the current layout was computed with
+  std::string child_frame_id_;  /// Child frame ID the current layout was computed with
+  bool has_child_frame_id_ = false;  /// Whether the current layout has a child frame ID
+  size_t num_doubles_ = 0;  /// Number of doubles the current layout was computed with
+  size_t body_offset_ = 0;  /// Offset in the buffer of the first double, or 0 if the layout has not been computed
+};
+
+/**
+ * Serializes IMU messages
+ */
+template<>
+class CdrSerializer<ImuMsg>
+{
+ public:
+  static constexpr bool SUPPORTED = true;
+  const rclcpp::SerializedMessage& serialize(const ImuMsg& msg);
+
+ private:
+  CdrLayout layout_;
+  rclcpp::SerializedMessage serialized_msg_;
+};
+
+/**
+ * Serializes raw IMU samples as IMU messages, without converting them to a message first
+ */
+template<>
+class CdrSerializer<ImuSample>
+{
+ public:
+  static constexpr bool SUPPORTED = true;
+  const rclcpp::SerializedMessage& serialize(const ImuSample& sample);
+
+ private:
+  CdrLayout layout_;
+  rclcpp::SerializedMessage serialized_msg_;
+};
+
+/**
+ * Serializes odometry messages
+ */
+template<>
+class CdrSerializer<OdometryMsg>
+{
+ public:
+  static constexpr bool SUPPORTED = true;
+  const rclcpp::SerializedMessage& serialize(const OdometryMsg& msg);
+
+ private:
+  CdrLayout layout_;
+  rclcpp::SerializedMessage serialized_msg_;
+};
+
+/**
+ * Serializes twist with covariance messages
+ */
+template<>
+class CdrSerializer<TwistWithCovarianceStampedMsg>
+{
+ public:
+  static constexpr bool SUPPORTED = true;
+  const rclcpp::SerializedMessage& serialize(const TwistWithCovarianceStampedMsg& msg);
+
+ private:
+  CdrLayout layout_;
+  rclcpp::SerializedMessage serialized_msg_;
+};
+
+/**
+ * \brief Checks if serialized messages can be published on a node. rclcpp can not publish serialized messages with intra process communication
+ * \param node The node that the publishers will be created on
+ * \return true if serialized messages can be published
+ */
+inline bool cdrSerializationSupported(RosNodeType* node)
+{
+  return !node->get_node_options().use_intra_process_comms();
+}
+
+/**
+ * \brief Serializes a message with a precomputed layout and publishes the serialized message
+ */
+template<typename PublisherType, typename MessageType>
+void publishSerialized(const std::shared_ptr<PublisherType>& publisher, CdrSerializer<MessageType>* serializer, const MessageType& msg, std::true_type)
+{
+  const rclcpp::SerializedMessage& serialized_msg = serializer->serialize(msg);
+#ifdef MICROSTRAIN_LIFECYCLE
+  // The lifecycle publisher hides the serialized overload, so check the activation ourselves and use the base publisher
+  if (publisher->is_activated())
+    publisher->rclcpp::Publisher<typename RosPublishedTypeOf<MessageType>::type>::publish(serialized_msg);
+#else
+  publisher->publish(serialized_msg);
+#endif
+}
+
+#else
+
+/**
+ * \brief Serialized messages are only supported on ROS2
+ * \param node Unused
+ * \return false
+ */
+inline bool cdrSerializationSupported(RosNodeType* node)
+{
+  (void)node;
+  return false;
+}
+
+#endif
+
+/**
+ * \brief Publishes messages that can not be serialized directly normally
+ */
+template<typename PublisherType, typename MessageType>
+void publishSerialized(const std::shared_ptr<PublisherType>& publisher, CdrSerializer<MessageType>* serializer, const MessageType& msg, std::false_type)
+{
+  (void)serializer;
+  publishPooled(publisher, msg);
+}
+
+/**
+ * \brief Publishes a message by serializing it directly if the message type supports it, and normally if it does not
+ * \param publisher The publisher to publish on
+ * \param serializer The serializer for the message type
+ * \param msg The message to publish
+ */
+template<typename PublisherType, typename MessageType>
+void publishSerialized(const std::shared_ptr<PublisherType>& publisher, CdrSerializer<MessageType>* serializer, const MessageType& msg)
+{
+  publishSerialized(publisher, serializer, msg, std::integral_constant<bool, CdrSerializer<MessageType>::SUPPORTED>());
+}
+
+}  // namespace microstrain
+
+#endif  // MICROSTRAIN_INERTIAL_DRIVER_COMMON_UTILS_CDR_SERIALIZER_H
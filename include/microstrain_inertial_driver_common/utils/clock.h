@@ -0,0 +1,111 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Parker-Lord Driver Definition File
+//
+// Copyright (c) 2017, Brian Bingham
+// Copyright (c) 2020, Parker Hannifin Corp
+//
+// This code is licensed under MIT license (see LICENSE file for details)
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef MICROSTRAIN_INERTIAL_DRIVER_COMMON_UTILS_CLOCK_H
+#define MICROSTRAIN_INERTIAL_DRIVER_COMMON_UTILS_CLOCK_H
+
+#include <atomic>
+#include <cstdint>
+
+#include "microstrain_inertial_driver_common/utils/ros_compat.h"
+
+namespace microstrain
+{
+
+/**
+ * Source of the time used to stamp data from the device and to wait between operations.
+ * Everything that ends up in a published message should read the time from here instead of from ROS or std::chrono,
+ * so that a recorded session can be replayed with exactly the same stamps
+ */
+class Clock
+{
+ public:
+  virtual ~Clock() = default;
+
+  /**
+   * \brief Gets the current time
+   * \return The current time as a ROS time
+   */
+  virtual RosTimeType rosNow() const = 0;
+
+  /**
+   * \brief Waits for some amount of time to pass on this clock
+   * \param seconds Number of seconds to wait
+   */
+  virtual void sleepFor(double seconds) = 0;
+
+  /**
+   * \brief Gets the current time in seconds
+   * \return The current time in seconds
+   */
+  double now() const
+  {
+    return getTimeRefSecs(rosNow());
+  }
+
+  /**
+   * \brief Gets the current time in nanoseconds
+   * \return The current time in nanoseconds
+   */
+  int64_t nowNanoseconds() const
+  {
+    return getTimeRefNanoseconds(rosNow());
+  }
+};
+
+/**
+ * Clock that reads the time from ROS, so it follows whatever time source the node was configured with
+ */
+class RosClock : public Clock
+{
+ public:
+  /**
+   * \brief Constructor
+   * \param node The node to read the time from
+   */
+  explicit RosClock(RosNodeType* node);
+
+  RosTimeType rosNow() const final;
+  void sleepFor(double seconds) final;
+
+ private:
+  RosNodeType* node_;  /// The node to read the time from
+};
+
+/**
+ * Clock that only moves when it is told to. Used when replaying a capture, where the time is the time each chunk of data was originally received.
+ * Waiting on this clock returns immediately after moving the time forward, so replay runs as fast as the data can be processed
+ */
+class VirtualClock : public Clock
+{
+ public:
+  /**
+   * \brief Constructor
+   * \param start_nanoseconds The time the clock starts at in nanoseconds
+   */
+  explicit VirtualClock(int64_t start_nanoseconds = 0);
+
+  RosTimeType rosNow() const final;
+  void sleepFor(double seconds) final;
+
+  /**
+   * \brief Moves the clock forward. The clock never moves backwards, so times before the current time are ignored
+   * \param nanoseconds The time to move the clock to in nanoseconds
+   */
+  void advanceTo(int64_t nanoseconds);
+
+ private:
+  std::atomic<int64_t> nanoseconds_;  /// The current time in nanoseconds
+};
+
+}  // namespace microstrain
+
+#endif  // MICROSTRAIN_INERTIAL_DRIVER_COMMON_UTILS_CLOCK_H
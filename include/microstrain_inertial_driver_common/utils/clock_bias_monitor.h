@@ -54,6 +54,12 @@ class ClockBiasMonitor
    */
   void reset();
 
+  /**
+   * \brief Starts from a bias estimate computed elsewhere, instead of averaging new measurements
+   * \param bias_estimate The bias estimate to start from
+   */
+  void restore(double bias_estimate);
+
  private:
   double weight_;  /// How much to weight the old bias estimate vs the new delta time. Closer to 1 means more weight on the old bias estimate
   double max_bias_estimate_;  /// Max bias estimate before resetting to the current delta time. Helps prevents jumps and outliers
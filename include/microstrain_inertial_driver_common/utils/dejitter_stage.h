@@ -0,0 +1,277 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Parker-Lord Driver Definition File
+//
+// Copyright (c) 2017, Brian Bingham
+// Copyright (c) 2020, Parker Hannifin Corp
+//
+// This code is licensed under MIT license (see LICENSE file for details)
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef MICROSTRAIN_INERTIAL_DRIVER_COMMON_UTILS_DEJITTER_STAGE_H
+#define MICROSTRAIN_INERTIAL_DRIVER_COMMON_UTILS_DEJITTER_STAGE_H
+
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <cstdint>
+#include <utility>
+#include <algorithm>
+#include <functional>
+#include <type_traits>
+#include <condition_variable>
+
+#include "microstrain_inertial_driver_common/utils/ros_compat.h"
+#include "microstrain_inertial_driver_common/utils/clock.h"
+#include "microstrain_inertial_driver_common/utils/realtime.h"
+
+namespace microstrain
+{
+
+/**
+ * Thread safe counters describing how well a de-jitter stage is keeping to its schedule
+ */
+class DejitterStatistics
+{
+ public:
+  /**
+   * \brief Constructor
+   * \param delay The delay after the message stamp that messages are released at in seconds
+   * \param capacity Number of messages that can be waiting to be released
+   */
+  DejitterStatistics(double delay, size_t capacity);
+
+  /**
+   * \brief Records a message that was released
+   * \param error How much later than scheduled the message was released in seconds
+   */
+  void recordRelease(double error);
+
+  /**
+   * \brief Records a message that arrived after it should have been released, so was released immediately
+   * \param lateness How late the message arrived in seconds
+   */
+  void recordMiss(double lateness);
+
+  /**
+   * \brief Records a message that was dropped because too many messages were waiting
+   */
+  void recordOverflow();
+
+  /**
+   * \brief Gets the number of misses and overflows since the last call
+   * \return The number of misses and overflows since the last call
+   */
+  uint64_t takeNewMisses();
+
+  /**
+   * \brief Formats the statistics as YAML
+   * \return The statistics as YAML
+   */
+  std::string toYaml() const;
+
+  /**
+   * \brief Clears the statistics
+   */
+  void reset();
+
+ private:
+  const double delay_;  /// The delay after the message stamp that messages are released at in seconds
+  const size_t capacity_;  /// Number of messages that can be waiting to be released
+
+  mutable AuditedMutex mutex_;  /// Protects the counters, as they are updated from the release thread and read from services
+  uint64_t released_ = 0;  /// Number of messages released on schedule or late
+  uint64_t missed_ = 0;  /// Number of messages that arrived after they should have been released
+  uint64_t dropped_ = 0;  /// Number of messages dropped because the buffer was full
+  uint64_t reported_misses_ = 0;  /// Number of misses and overflows already returned by takeNewMisses
+  double release_error_sum_ = 0;  /// Sum of the release errors, used to compute the mean
+  double release_error_max_ = 0;  /// Largest release error
+  double miss_lateness_max_ = 0;  /// Largest amount a message arrived after it should have been released
+};
+
+/**
+ * \brief Reduces the timer slack of the calling thread to the minimum, so sleeps end as close as possible to when they were asked to
+ */
+void setMinimumTimerSlack();
+
+/**
+ * Whether a message type has a header stamp that can be used to schedule it
+ */
+template<typename MessageType, typename = void>
+struct DejitterSupported : std::false_type {};
+template<typename MessageType>
+struct DejitterSupported<MessageType, decltype(void(std::declval<MessageType>().header.stamp))> : std::true_type {};
+
+/**
+ * Holds messages for a fixed delay after their stamp, and releases them from a dedicated thread,
+ * so that the time between messages matches the time between their stamps instead of when they were read from the device
+ * \tparam MessageType The type of message to delay. Must have a header
+ */
+template<typename MessageType>
+class DejitterStage
+{
+ public:
+  using Release = std::function<void(const MessageType&)>;
+
+  /**
+   * \brief Constructs the stage and starts the release thread
+   * \param delay The delay after the message stamp to release messages at in seconds
+   * \param capacity Number of messages that can be waiting to be released
+   * \param release Function that publishes a message when it is released. Called from the release thread
+   * \param clock The clock the message stamps are read from
+   */
+  DejitterStage(const double delay, const size_t capacity, Release release, std::shared_ptr<Clock> clock)
+    : delay_(delay), release_(release), clock_(clock), statistics_(std::make_shared<DejitterStatistics>(delay, capacity))
+  {
+    samples_.resize(capacity);
+    thread_ = std::thread(&DejitterStage::run, this);
+  }
+  DejitterStage(const DejitterStage&) = delete;
+  DejitterStage& operator=(const DejitterStage&) = delete;
+
+  /**
+   * \brief Stops the release thread. Messages that have not been released yet are dropped
+   */
+  ~DejitterStage()
+  {
+    {
+      std::lock_guard<AuditedMutex> lock(mutex_);
+      running_ = false;
+    }
+    condition_.notify_one();
+    if (thread_.joinable())
+      thread_.join();
+  }
+
+  /**
+   * \brief Queues a message to be released at its stamp plus the delay. Copies the message, so the caller can keep updating it
+   * \param message The message to queue
+   */
+  void push(const MessageType& message)
+  {
+    // Never hold a message for longer than the delay, even if its stamp is in the future
+    const double now = clock_->now();
+    const double release_time = std::min(stampSecs(message, DejitterSupported<MessageType>()) + delay_, now + delay_);
+    {
+      std::lock_guard<AuditedMutex> lock(mutex_);
+
+      // If the buffer is full, drop the oldest message to make room
+      if (count_ == samples_.size())
+      {
+        for (size_t i = 1; i < count_; i++)
+          std::swap(samples_[i - 1], samples_[i]);
+        count_--;
+        statistics_->recordOverflow();
+      }
+
+      // Keep the messages sorted by release time. Stamps are almost always in order, so this rarely moves anything
+      size_t index = count_++;
+      while (index > 0 && samples_[index - 1].release_time > release_time)
+      {
+        std::swap(samples_[index], samples_[index - 1]);
+        index--;
+      }
+      samples_[index].release_time = release_time;
+      samples_[index].message = message;
+
+      const double lateness = now - release_time;
+      if (lateness > 0)
+        statistics_->recordMiss(lateness);
+    }
+    condition_.notify_one();
+  }
+
+  /**
+   * \brief Gets the statistics of this stage
+   * \return The statistics of this stage
+   */
+  std::shared_ptr<DejitterStatistics> statistics() const
+  {
+    return statistics_;
+  }
+
+ private:
+  /**
+   * A message waiting to be released
+   */
+  struct Sample
+  {
+    double release_time = 0;  /// Time to release the message at in seconds since the epoch
+    MessageType message;  /// Copy of the message to release
+  };
+
+  /**
+   * \brief Releases messages as their release time arrives until the stage is destroyed
+   */
+  void run()
+  {
+    // Ask the kernel not to coalesce our wakeups with other timers, so we wake up as close as possible to the release time
+    setMinimumTimerSlack();
+
+    MessageType message;
+    std::unique_lock<AuditedMutex> lock(mutex_);
+    while (running_)
+    {
+      if (count_ == 0)
+      {
+        condition_.wait(lock);
+        continue;
+      }
+
+      // Wait until the earliest message is due, or something changes
+      const double release_time = samples_[0].release_time;
+      // The wait itself is on the steady clock. When replaying on a virtual clock, this only bounds how long we wait before checking again
+      const double wait = release_time - clock_->now();
+      if (wait > 0)
+      {
+        condition_.wait_for(lock, std::chrono::duration<double>(wait));
+        continue;
+      }
+
+      // Take the message out of the buffer, and publish it without holding the lock
+      std::swap(message, samples_[0].message);
+      for (size_t i = 1; i < count_; i++)
+        std::swap(samples_[i - 1], samples_[i]);
+      count_--;
+      lock.unlock();
+      release_(message);
+      statistics_->recordRelease(clock_->now() - release_time);
+      lock.lock();
+    }
+  }
+
+  /**
+   * \brief Gets the stamp of a message in seconds
+   * \param message The message to get the stamp of
+   * \return The stamp of the message in seconds
+   */
+  static double stampSecs(const MessageType& message, std::true_type)
+  {
+    return getTimeRefSecs(message.header.stamp);
+  }
+  static double stampSecs(const MessageType&, std::false_type)
+  {
+    return 0;
+  }
+
+  const double delay_;  /// The delay after the message stamp to release messages at in seconds
+  Release release_;  /// Publishes a message when it is released
+  std::shared_ptr<Clock> clock_;  /// The clock the message stamps are read from
+  std::shared_ptr<DejitterStatistics> statistics_;  /// Statistics of this stage
+
+  AuditedMutex mutex_;  /// Protects the buffer
+  std::condition_variable_any condition_;  /// Wakes the release thread when a message is queued or the stage is destroyed
+  std::vector<Sample> samples_;  /// Messages waiting to be released, sorted by release time
+  size_t count_ = 0;  /// Number of messages waiting to be released
+  bool running_ = true;  /// Whether the release thread should keep running
+  std::thread thread_;  /// Thread releasing the messages
+};
+
+}  // namespace microstrain
+
+#endif  // MICROSTRAIN_INERTIAL_DRIVER_COMMON_UTILS_DEJITTER_STAGE_H
@@ -0,0 +1,175 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Parker-Lord Driver Definition File
+//
+// Copyright (c) 2017, Brian Bingham
+// Copyright (c) 2020, Parker Hannifin Corp
+//
+// This code is licensed under MIT license (see LICENSE file for details)
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef MICROSTRAIN_INERTIAL_DRIVER_COMMON_UTILS_GNSS_INTEGRITY_H
+#define MICROSTRAIN_INERTIAL_DRIVER_COMMON_UTILS_GNSS_INTEGRITY_H
+
+#include <array>
+#include <cstdint>
+
+namespace microstrain
+{
+
+/**
+ * Combines the fix, SBAS, RF error detection and RTK corrections status of a single GNSS receiver into one integrity state.
+ * Each part of the state only changes after the receiver has reported the new value a number of times in a row,
+ * so a single noisy report does not cause a transition. Degradations can be accepted faster than recoveries.
+ */
+class GnssIntegrity
+{
+ public:
+  // Fix classes, ordered from worst to best
+  static constexpr uint8_t FIX_CLASS_NONE = 0;
+  static constexpr uint8_t FIX_CLASS_2D = 1;
+  static constexpr uint8_t FIX_CLASS_3D = 2;
+  static constexpr uint8_t FIX_CLASS_DIFFERENTIAL = 3;
+  static constexpr uint8_t FIX_CLASS_RTK_FLOAT = 4;
+  static constexpr uint8_t FIX_CLASS_RTK_FIXED = 5;
+
+  // Corrections states, ordered from worst to best
+  static constexpr uint8_t CORRECTIONS_NONE = 0;
+  static constexpr uint8_t CORRECTIONS_STALE = 1;
+  static constexpr uint8_t CORRECTIONS_FRESH = 2;
+
+  // Number of values in the state when it is flattened for publishing
+  static constexpr size_t NUM_FIELDS = 6;
+
+  /**
+   * Settings that control how quickly the state changes
+   */
+  struct Settings
+  {
+    uint32_t upgrade_count = 5;  /// Number of reports in a row required to accept a better value
+    uint32_t degrade_count = 1;  /// Number of reports in a row required to accept a worse value
+    double corrections_stale_age = 5.0;  /// Corrections older than this many seconds are stale. They are fresh again once younger than 80% of this
+    double heartbeat_period = 1.0;  /// The state is reported at least this often in seconds, even if it has not changed
+  };
+
+  /**
+   * Integrity state of a receiver
+   */
+  struct State
+  {
+    uint8_t fix_class = FIX_CLASS_NONE;  /// One of the FIX_CLASS_* values
+    uint8_t corrections = CORRECTIONS_NONE;  /// One of the CORRECTIONS_* values
+    double corrections_age = -1;  /// Age of the newest RTK corrections in seconds, or -1 if no corrections have been received
+    uint8_t jamming_state = 0;  /// Worst jamming state reported over all RF bands. Same values as mip::data_gnss::RfErrorDetection::JammingState
+    uint8_t spoofing_state = 0;  /// Worst spoofing state reported over all RF bands. Same values as mip::data_gnss::RfErrorDetection::SpoofingState
+    bool sbas_available = false;  /// Whether SBAS corrections are available
+  };
+
+  /**
+   * \brief Default Constructor. Uses the default settings
+   */
+  GnssIntegrity() = default;
+
+  /**
+   * \brief Constructor
+   * \param settings Settings that control how quickly the state changes
+   */
+  explicit GnssIntegrity(const Settings& settings);
+
+  /**
+   * \brief Records a fix reported by the receiver. Applied on the next call to evaluate
+   * \param fix_class One of the FIX_CLASS_* values
+   */
+  void updateFix(uint8_t fix_class);
+
+  /**
+   * \brief Records the RF error detection reported by the receiver for one band. Applied on the next call to evaluate
+   * \param rf_band The band the states are for
+   * \param jamming_state Jamming state of the band
+   * \param spoofing_state Spoofing state of the band
+   */
+  void updateRfBand(uint8_t rf_band, uint8_t jamming_state, uint8_t spoofing_state);
+
+  /**
+   * \brief Records the SBAS status reported by the receiver. Applied on the next call to evaluate
+   * \param available Whether SBAS corrections are available
+   */
+  void updateSbas(bool available);
+
+  /**
+   * \brief Records the age of the RTK corrections used by the receiver. Applied on the next call to evaluate
+   * \param age Age of the newest corrections in seconds, or a negative number if there are none
+   * \param now The current time in seconds
+   */
+  void updateCorrectionsAge(double age, double now);
+
+  /**
+   * \brief Applies the reports recorded since the last call, and decides whether the state should be reported
+   * \param now The current time in seconds
+   * \return true if the state changed or the heartbeat is due. Always false until the receiver has reported something
+   */
+  bool evaluate(double now);
+
+  /**
+   * \brief Gets the current state
+   * \return The current state
+   */
+  const State& state() const;
+
+  /**
+   * \brief Flattens the current state into fix class, corrections state, corrections age, jamming state, spoofing state and SBAS availability
+   * \param data Array of NUM_FIELDS values to populate
+   */
+  void toArray(double* data) const;
+
+  /**
+   * \brief Gets the name of one of the values toArray populates
+   * \param field Index of the value in the array
+   * \return Name of the value, or "unknown" if the index is out of range
+   */
+  static const char* fieldName(size_t field);
+
+ private:
+  /**
+   * A value that only changes once a different value has been reported enough times in a row
+   */
+  struct Debounced
+  {
+    uint8_t candidate = 0;  /// The value that has been reported in a row
+    uint32_t count = 0;  /// Number of times the candidate has been reported in a row
+    bool pending = false;  /// Whether a report has been recorded since the last evaluation
+    uint8_t reported = 0;  /// The value recorded since the last evaluation
+  };
+
+  /**
+   * \brief Applies the pending report of a value
+   * \param debounced The reports of the value
+   * \param value The current value, updated if the report has persisted for long enough
+   * \param higher_is_worse Whether larger values are degradations
+   * \return true if the value changed
+   */
+  bool debounce(Debounced* debounced, uint8_t* value, bool higher_is_worse);
+
+  static constexpr size_t NUM_RF_BANDS = 8;
+
+  Settings settings_;  /// Settings that control how quickly the state changes
+  State state_;  /// The current state
+
+  Debounced fix_class_;  /// Reports of the fix class
+  Debounced corrections_;  /// Reports of the corrections state
+  Debounced jamming_state_;  /// Reports of the worst jamming state
+  Debounced spoofing_state_;  /// Reports of the worst spoofing state
+  Debounced sbas_available_;  /// Reports of the SBAS availability
+
+  std::array<uint8_t, NUM_RF_BANDS> rf_band_jamming_state_ = {};  /// Latest jamming state of each band
+  std::array<uint8_t, NUM_RF_BANDS> rf_band_spoofing_state_ = {};  /// Latest spoofing state of each band
+
+  bool seen_ = false;  /// Whether the receiver has reported anything
+  double last_corrections_time_ = -1;  /// Last time the corrections age was reported in seconds
+  double last_report_time_ = -1;  /// Last time evaluate returned true in seconds
+};
+
+}  // namespace microstrain
+
+#endif  // MICROSTRAIN_INERTIAL_DRIVER_COMMON_UTILS_GNSS_INTEGRITY_H
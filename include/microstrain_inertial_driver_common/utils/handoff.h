@@ -0,0 +1,112 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Parker-Lord Driver Definition File
+//
+// Copyright (c) 2017, Brian Bingham
+// Copyright (c) 2020, Parker Hannifin Corp
+//
+// This code is licensed under MIT license (see LICENSE file for details)
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef MICROSTRAIN_INERTIAL_DRIVER_COMMON_UTILS_HANDOFF_H
+#define MICROSTRAIN_INERTIAL_DRIVER_COMMON_UTILS_HANDOFF_H
+
+#include <map>
+#include <string>
+#include <vector>
+#include <cstdint>
+
+#include "mip/definitions/commands_base.hpp"
+
+namespace microstrain
+{
+
+/**
+ * Everything a replacement driver needs to resume parsing a device that another driver already configured.
+ * The ports are passed as file descriptors, and everything else is what the driver would otherwise have to query from the device
+ */
+struct HandoffState
+{
+  int main_fd = -1;  /// Open main port
+  int aux_fd = -1;  /// Open aux port, or -1 if the aux port is not open
+
+  uint64_t stream_hash = 0;  /// Hash of the message formats streamed by the device
+  uint64_t config_hash = 0;  /// Hash of the configuration the driver was started with, which includes everything it applied to the device
+  mip::commands_base::BaseDeviceInfo device_info = {};
+  std::vector<uint16_t> supported_descriptors;
+  std::map<uint8_t, uint16_t> base_rates;
+  uint16_t max_external_frame_ids = 0;
+
+  bool map_to_earth_valid = false;  /// Whether the relative position origin below is populated
+  double map_to_earth_translation[3] = {0, 0, 0};
+  double map_to_earth_rotation[4] = {0, 0, 0, 1};  /// x, y, z, w
+
+  bool clock_bias_valid = false;  /// Whether the clock bias below is populated
+  double clock_bias = 0;  /// Bias between the GPS time of the device and the system time in seconds
+};
+
+/**
+ * Listens for a replacement driver on a Unix socket, and hands it the open ports and state of this driver
+ */
+class HandoffServer
+{
+ public:
+  HandoffServer() = default;
+  HandoffServer(const HandoffServer&) = delete;
+  HandoffServer& operator=(const HandoffServer&) = delete;
+
+  /**
+   * \brief Closes the sockets and removes the socket file
+   */
+  ~HandoffServer();
+
+  /**
+   * \brief Starts listening for a replacement driver. Any existing socket file at the path is replaced
+   * \param socket_path Path of the Unix socket to listen on
+   * \param error Will be populated with the reason the socket could not be created
+   * \return true if the socket is listening
+   */
+  bool listen(const std::string& socket_path, std::string* error);
+
+  /**
+   * \brief Checks without blocking whether a replacement driver has connected
+   * \return true if a replacement driver is waiting for the state
+   */
+  bool pending();
+
+  /**
+   * \brief Sends the state to the replacement driver that connected, and waits for it to acknowledge it
+   * \param state The state to send. The file descriptors stay open in this process
+   * \param timeout_ms How long to wait for the acknowledgement in milliseconds
+   * \param error Will be populated with the reason the handoff failed
+   * \return true if the replacement driver took over the ports. This process must not touch the device afterwards
+   */
+  bool send(const HandoffState& state, int timeout_ms, std::string* error);
+
+ private:
+  int listen_fd_ = -1;  /// Socket accepting connections
+  int client_fd_ = -1;  /// Socket of the replacement driver that connected, or -1 if none has
+  std::string socket_path_;  /// Path of the socket file, removed when this object is destroyed
+};
+
+/**
+ * \brief Asks a running driver for its ports and state
+ * \param socket_path Path of the Unix socket the running driver is listening on
+ * \param timeout_ms How long to wait for the running driver in milliseconds
+ * \param state Will be populated with the state of the running driver. The file descriptors are owned by the caller
+ * \param error Will be populated with the reason the state could not be received
+ * \return true if the state was received, and the running driver will no longer touch the device
+ */
+bool receiveHandoff(const std::string& socket_path, int timeout_ms, HandoffState* state, std::string* error);
+
+/**
+ * \brief Hashes the configuration of a driver, so a replacement can tell if it was started with the same configuration as the running driver
+ * \param config_text The configuration as text, as returned by getParamsText
+ * \return FNV-1a hash of the text
+ */
+uint64_t hashHandoffConfig(const std::string& config_text);
+
+}  // namespace microstrain
+
+#endif  // MICROSTRAIN_INERTIAL_DRIVER_COMMON_UTILS_HANDOFF_H
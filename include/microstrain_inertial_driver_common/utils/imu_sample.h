@@ -0,0 +1,88 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Parker-Lord Driver Definition File
+//
+// Copyright (c) 2017, Brian Bingham
+// Copyright (c) 2020, Parker Hannifin Corp
+//
+// This code is licensed under MIT license (see LICENSE file for details)
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef MICROSTRAIN_INERTIAL_DRIVER_COMMON_UTILS_IMU_SAMPLE_H
+#define MICROSTRAIN_INERTIAL_DRIVER_COMMON_UTILS_IMU_SAMPLE_H
+
+#include <array>
+#include <memory>
+
+#include "microstrain_inertial_driver_common/utils/ros_compat.h"
+
+namespace microstrain
+{
+
+/**
+ * Compact native representation of a raw IMU sample. Published as an ImuMsg, but consumers in the same process
+ * can receive this type directly on distros that support type adaptation
+ */
+struct ImuSample
+{
+  /**
+   * Covariances do not change between samples, so they are shared instead of copied with every sample
+   */
+  struct Covariance
+  {
+    std::array<double, 9> angular_velocity = {};
+    std::array<double, 9> linear_acceleration = {};
+  };
+
+  RosHeaderType header;
+  Vector3Msg angular_velocity;
+  Vector3Msg linear_acceleration;
+  std::shared_ptr<const Covariance> covariance;  /// May be nullptr, in which case the covariances are published as 0
+};
+
+template<>
+struct RosMessageTypeOf<ImuSample>
+{
+  using type = ImuMsg;
+};
+
+/**
+ * \brief Converts a raw IMU sample into the ROS message it is published as
+ * \param sample The sample to convert
+ * \param imu_msg The message to populate
+ */
+void toRosMessage(const ImuSample& sample, ImuMsg* imu_msg);
+
+/**
+ * \brief Converts a ROS message into a raw IMU sample
+ * \param imu_msg The message to convert
+ * \param sample The sample to populate
+ */
+void fromRosMessage(const ImuMsg& imu_msg, ImuSample* sample);
+
+}  // namespace microstrain
+
+#ifdef MICROSTRAIN_TYPE_ADAPTATION
+template<>
+struct rclcpp::TypeAdapter<microstrain::ImuSample, microstrain::ImuMsg>
+{
+  using is_specialized = std::true_type;
+  using custom_type = microstrain::ImuSample;
+  using ros_message_type = microstrain::ImuMsg;
+
+  static void convert_to_ros_message(const custom_type& source, ros_message_type& destination)
+  {
+    microstrain::toRosMessage(source, &destination);
+  }
+
+  static void convert_to_custom(const ros_message_type& source, custom_type& destination)
+  {
+    microstrain::fromRosMessage(source, &destination);
+  }
+};
+
+RCLCPP_USING_CUSTOM_TYPE_AS_ROS_MESSAGE_TYPE(microstrain::ImuSample, microstrain::ImuMsg);
+#endif
+
+#endif  // MICROSTRAIN_INERTIAL_DRIVER_COMMON_UTILS_IMU_SAMPLE_H
@@ -0,0 +1,137 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Parker-Lord Driver Definition File
+//
+// Copyright (c) 2017, Brian Bingham
+// Copyright (c) 2020, Parker Hannifin Corp
+//
+// This code is licensed under MIT license (see LICENSE file for details)
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef MICROSTRAIN_INERTIAL_DRIVER_COMMON_UTILS_MAG_CALIBRATOR_H
+#define MICROSTRAIN_INERTIAL_DRIVER_COMMON_UTILS_MAG_CALIBRATOR_H
+
+#include <array>
+#include <mutex>
+#include <string>
+#include <cstdint>
+#include <cstddef>
+
+#include "microstrain_inertial_driver_common/utils/realtime.h"
+
+namespace microstrain
+{
+
+/**
+ * Fits an ellipsoid to streaming magnetometer samples to estimate the hard iron offset and soft iron matrix.
+ * Only the sums needed for a least squares fit of the general ellipsoid are kept, so memory is constant no matter how many samples are added.
+ * Also tracks which directions of the field have been seen, as the fit is only trustworthy once the sensor has been rotated through most orientations.
+ * The corrections are applied as corrected = soft_iron * (measured - hard_iron), the same way the device applies its own calibration.
+ */
+class MagCalibrator
+{
+ public:
+  // Number of bands of equal area the sphere of directions is split into from -z to +z, and the number of sectors around z in each band
+  static constexpr size_t NUM_COVERAGE_BANDS = 6;
+  static constexpr size_t NUM_COVERAGE_SECTORS = 12;
+
+  /**
+   * Thresholds the fit must meet before it is written to the device, unless the write is forced
+   */
+  struct Thresholds
+  {
+    uint64_t min_samples = 500;  /// Number of samples that must have been added
+    double min_coverage = 0.6;  /// Fraction of the directions that must have been seen
+    double max_fit_error = 0.02;  /// Largest allowed RMS error of the corrected field strength, as a fraction of the field strength
+  };
+
+  /**
+   * Result of fitting the samples added so far
+   */
+  struct Result
+  {
+    bool valid = false;  /// Whether the samples describe an ellipsoid. The other values are meaningless if false
+    uint64_t samples = 0;  /// Number of samples the fit was made from
+    double coverage = 0;  /// Fraction of the directions that have been seen
+    double fit_error = 0;  /// RMS error of the corrected field strength, as a fraction of the field strength
+    double field_strength = 0;  /// Strength of the corrected field in the same units as the samples
+    double hard_iron[3] = {0, 0, 0};  /// Hard iron offset in the same units as the samples
+    double soft_iron[9] = {1, 0, 0, 0, 1, 0, 0, 0, 1};  /// Soft iron matrix in row major order
+  };
+
+  /**
+   * \brief Constructor
+   * \param thresholds Thresholds the fit must meet before it is written to the device, unless the write is forced
+   */
+  explicit MagCalibrator(const Thresholds& thresholds);
+
+  /**
+   * \brief Adds a magnetometer sample
+   * \param x The x axis of the sample
+   * \param y The y axis of the sample
+   * \param z The z axis of the sample
+   */
+  void add(double x, double y, double z);
+
+  /**
+   * \brief Fits an ellipsoid to the samples added so far. Directions are only counted towards the coverage once a fit has found the hard iron offset,
+   *        and the coverage starts over whenever a fit moves the offset noticeably
+   * \return The result of the fit
+   */
+  Result fit();
+
+  /**
+   * \brief Checks whether a fit is good enough to write to the device
+   * \param result The fit to check
+   * \return true if the fit is valid and meets all of the thresholds
+   */
+  bool meetsThresholds(const Result& result) const;
+
+  /**
+   * \brief Gets the thresholds a fit must meet before it is written to the device
+   * \return The thresholds
+   */
+  const Thresholds& thresholds() const;
+
+  /**
+   * \brief Combines a fit made from data that had already been corrected with the calibration it was corrected with
+   * \param current_hard_iron Hard iron offset the data was corrected with
+   * \param current_soft_iron Soft iron matrix the data was corrected with in row major order
+   * \param result Fit made from the corrected data
+   * \param hard_iron Will be populated with the hard iron offset that corrects the uncorrected data
+   * \param soft_iron Will be populated with the soft iron matrix that corrects the uncorrected data in row major order
+   * \return false if the current soft iron matrix can not be inverted
+   */
+  static bool compose(const float current_hard_iron[3], const float current_soft_iron[9], const Result& result, float hard_iron[3], float soft_iron[9]);
+
+  /**
+   * \brief Formats a fit as YAML
+   * \param result The fit to format
+   * \return The fit as YAML
+   */
+  std::string toYaml(const Result& result) const;
+
+  /**
+   * \brief Discards all samples and starts over
+   */
+  void reset();
+
+ private:
+  static constexpr size_t NUM_TERMS = 9;
+  static constexpr size_t NUM_COVERAGE_BINS = NUM_COVERAGE_BANDS * NUM_COVERAGE_SECTORS;
+
+  const Thresholds thresholds_;  /// Thresholds the fit must meet before it is written to the device, unless the write is forced
+
+  mutable AuditedMutex mutex_;  /// Allows the fit to be made from another thread while samples are being added
+  std::array<double, NUM_TERMS * NUM_TERMS> normal_matrix_ = {};  /// Sum of the outer products of the terms of each sample
+  std::array<double, NUM_TERMS> normal_vector_ = {};  /// Sum of the terms of each sample
+  uint64_t samples_ = 0;  /// Number of samples added
+  std::array<bool, NUM_COVERAGE_BINS> coverage_ = {};  /// Whether a sample has been seen in each direction
+  double coverage_center_[3] = {0, 0, 0};  /// Point the directions are measured from. The hard iron offset of the fit that last moved it
+  bool coverage_centered_ = false;  /// Whether a fit has set the point the directions are measured from
+};
+
+}  // namespace microstrain
+
+#endif  // MICROSTRAIN_INERTIAL_DRIVER_COMMON_UTILS_MAG_CALIBRATOR_H
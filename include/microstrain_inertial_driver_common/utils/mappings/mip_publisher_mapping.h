@@ -77,6 +77,16 @@ static constexpr auto MIP_SYSTEM_BUILT_IN_TEST_TOPIC = "mip/system/built_in_test
 
 static constexpr auto NMEA_SENTENCE_TOPIC = "nmea";
 
+static constexpr auto SIGNAL_STATISTICS_TOPIC = "statistics";
+static constexpr auto VIBRATION_ANALYSIS_TOPIC = "imu/vibration";
+static constexpr auto MEMORY_USAGE_TOPIC = "memory";
+static constexpr auto GNSS1_INTEGRITY_TOPIC = "gnss_1/integrity";
+static constexpr auto GNSS2_INTEGRITY_TOPIC = "gnss_2/integrity";
+
+static constexpr auto IMU_DATA_TARGET_TOPIC = "imu/data_target";
+static constexpr auto FILTER_ODOMETRY_EARTH_TARGET_TOPIC = "ekf/odometry_earth_target";
+static constexpr auto FILTER_ODOMETRY_MAP_TARGET_TOPIC = "ekf/odometry_map_target";
+
 // Some other constants
 static constexpr float FIELD_DATA_RATE_USE_DATA_CLASS = -1;
 static constexpr float DATA_CLASS_DATA_RATE_DO_NOT_STREAM = 0;
@@ -121,9 +131,22 @@ class MipPublisherMapping
   /**
    * \brief Configures the data rates associated with the topics. Updates the map with a data rate for each topic
    * \param config_node  ROS node to read the config from
+   * \param write_to_device  Whether to write the message formats to the device. If false, writeMessageFormats should be called later if the device is not already streaming them
    * \return True if the configuration was successful, false otherwise
    */
-  bool configure(RosNodeType* config_node);
+  bool configure(RosNodeType* config_node, bool write_to_device = true);
+
+  /**
+   * \brief Writes the message format of each descriptor set to the device and enables the streams. Will only write valid information if called after "configure"
+   * \return True if the message formats were written, false otherwise
+   */
+  bool writeMessageFormats();
+
+  /**
+   * \brief Hashes the message formats that will be streamed. Will only return a valid number if called after "configure"
+   * \return Hash of the descriptor sets, field descriptors and decimations that will be streamed
+   */
+  uint64_t streamHash() const;
 
   /**
    * \brief Gets the data classes (descriptor sets) that are used by the topic. Will only return the data classes supported by the device passed into the constructor
@@ -170,7 +193,13 @@ class MipPublisherMapping
   // Static mappings for topics. Note that this map contains all possible topics regardless of what the device supports
   static const std::map<std::string, FieldWrapper::SharedPtrVec> static_topic_to_mip_type_mapping_;  /// Mapping between topics and MIP types which can be used to lookup the descriptor set and field descriptors for a topic.
   static const std::map<std::string, std::string> static_topic_to_data_rate_config_key_mapping_;  /// Mapping between topics and the keys in the config used to configure their data rates
+  static const std::vector<std::string> static_latency_critical_topics_;  /// Topics whose fields are streamed first in each packet when publishing early, most critical first
  private:
+  /**
+   * \brief Orders the streamed fields of each descriptor set so that the fields of the latency critical topics come first in each packet
+   */
+  void orderDescriptorsByLatency();
+
   /**
    * \brief Streams the desired descriptor for all descriptor sets that support it at the highest rate of the descriptor sets.
    * \tparam MipType The type of MIP field to stream for all descriptor sets
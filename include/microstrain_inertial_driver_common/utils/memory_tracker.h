@@ -0,0 +1,107 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Parker-Lord Driver Definition File
+//
+// Copyright (c) 2017, Brian Bingham
+// Copyright (c) 2020, Parker Hannifin Corp
+//
+// This code is licensed under MIT license (see LICENSE file for details)
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef MICROSTRAIN_INERTIAL_DRIVER_COMMON_UTILS_MEMORY_TRACKER_H
+#define MICROSTRAIN_INERTIAL_DRIVER_COMMON_UTILS_MEMORY_TRACKER_H
+
+#include <cstdint>
+#include <cstddef>
+
+namespace microstrain
+{
+
+/**
+ * Subsystems that heap allocations can be attributed to
+ */
+enum MemoryTag
+{
+  MEMORY_TAG_OTHER = 0,  /// Anything allocated outside of a tagged scope, including ROS and the MIP SDK
+  MEMORY_TAG_CONNECTION,  /// Reading from and writing to the device
+  MEMORY_TAG_PUBLISHERS,  /// Parsing data from the device and populating and publishing messages
+  MEMORY_TAG_SUBSCRIBERS,  /// Handling messages received from other nodes
+  MEMORY_TAG_SERVICES,  /// Handling service requests
+  MEMORY_TAG_TF,  /// Creating the transform buffers, listeners and broadcasters, and looking up and broadcasting transforms
+  MEMORY_TAG_RECORDING,  /// Writing binary data to the raw file
+  MEMORY_TAG_LOGGING,  /// Formatting log messages from the MIP SDK
+  NUM_MEMORY_TAGS
+};
+
+/**
+ * Attributes heap allocations to the subsystem that made them.
+ * Only functional if the library was built with MICROSTRAIN_MEMORY_TRACKING defined, as that replaces the global allocation functions.
+ */
+class MemoryTracker
+{
+ public:
+  /**
+   * Attributes allocations made by the calling thread to a tag for the lifetime of this object. Scopes can be nested
+   */
+  class Scope
+  {
+   public:
+    explicit Scope(const MemoryTag tag);
+    ~Scope();
+
+    Scope(const Scope&) = delete;
+    Scope& operator=(const Scope&) = delete;
+
+   private:
+    MemoryTag previous_tag_;
+  };
+
+  /**
+   * Memory usage of a single tag
+   */
+  struct Usage
+  {
+    uint64_t live_bytes = 0;  /// Bytes allocated with this tag that have not been freed yet
+    uint64_t peak_bytes = 0;  /// Largest value live_bytes has ever had
+    uint64_t allocations = 0;  /// Total number of allocations made with this tag
+  };
+
+  /**
+   * \brief Checks if the library was built with memory tracking
+   * \return true if allocations are being tracked
+   */
+  static bool supported();
+
+  /**
+   * \brief Gets the current usage of a tag
+   * \param tag The tag to get the usage of
+   * \return Usage of the tag
+   */
+  static Usage usage(const MemoryTag tag);
+
+  /**
+   * \brief Gets a printable name for a tag
+   * \param tag The tag to get the name of
+   * \return Name of the tag
+   */
+  static const char* tagName(const MemoryTag tag);
+
+  /**
+   * \brief Allocates memory and attributes it to the tag of the calling thread. Used by the global allocation functions
+   * \param size Number of bytes to allocate
+   * \param alignment Alignment of the memory. Must be a power of two. Memory is aligned the same as malloc if this is smaller
+   * \return Pointer to the memory, or nullptr if the allocation failed
+   */
+  static void* allocate(const size_t size, const size_t alignment = alignof(std::max_align_t));
+
+  /**
+   * \brief Frees memory returned by allocate and removes it from the tag it was allocated with
+   * \param ptr Pointer returned by allocate. May be nullptr
+   */
+  static void deallocate(void* ptr);
+};
+
+}  // namespace microstrain
+
+#endif  // MICROSTRAIN_INERTIAL_DRIVER_COMMON_UTILS_MEMORY_TRACKER_H
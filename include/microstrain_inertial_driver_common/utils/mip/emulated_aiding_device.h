@@ -0,0 +1,97 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Parker-Lord Driver Definition File
+//
+// Copyright (c) 2017, Brian Bingham
+// Copyright (c) 2020, Parker Hannifin Corp
+//
+// This code is licensed under MIT license (see LICENSE file for details)
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef MICROSTRAIN_INERTIAL_DRIVER_COMMON_UTILS_MIP_EMULATED_AIDING_DEVICE_H
+#define MICROSTRAIN_INERTIAL_DRIVER_COMMON_UTILS_MIP_EMULATED_AIDING_DEVICE_H
+
+#include <deque>
+#include <mutex>
+#include <chrono>
+#include <vector>
+#include <cstdint>
+#include <condition_variable>
+
+#include "mip/mip_device.hpp"
+
+namespace microstrain
+{
+
+/**
+ * Connection to a device that does not exist. Every MIP command sent to it is acknowledged after a fixed latency,
+ * so the aiding path can be exercised at any rate without sending made up measurements to a real navigation filter
+ */
+class EmulatedAidingConnection : public mip::Connection
+{
+ public:
+  /**
+   * \brief Constructor
+   * \param ack_latency Time in seconds between receiving a command and acknowledging it
+   */
+  explicit EmulatedAidingConnection(double ack_latency);
+
+  // Implemented in order to satisfy the requirements for the MIP connection
+  bool isConnected() const final;
+  bool connect() final;
+  bool disconnect() final;
+  bool sendToDevice(const uint8_t* data, size_t length) final;
+  bool recvFromDevice(uint8_t* buffer, size_t max_length, mip::Timeout wait_time, size_t* count_out, mip::Timestamp* timestamp_out) final;
+  const char* interfaceName() const final;
+  uint32_t parameter() const final;
+
+ private:
+  /**
+   * A reply waiting for its latency to pass
+   */
+  struct Reply
+  {
+    std::chrono::steady_clock::time_point due;  /// Time the reply is read back
+    std::vector<uint8_t> packet;  /// The reply
+  };
+
+  const std::chrono::steady_clock::duration ack_latency_;  /// Time between receiving a command and acknowledging it
+
+  std::mutex mutex_;  /// Protects the replies, as commands may be sent from another thread than the one waiting on the replies
+  std::condition_variable condition_;  /// Notified when a reply is queued
+  std::deque<Reply> replies_;  /// Replies that have not been read yet, oldest first
+};
+
+/**
+ * MIP device interface talking to an EmulatedAidingConnection
+ */
+class EmulatedAidingDevice
+{
+ public:
+  /**
+   * \brief Constructor
+   * \param ack_latency Time in seconds between receiving a command and acknowledging it
+   */
+  explicit EmulatedAidingDevice(double ack_latency);
+  EmulatedAidingDevice(const EmulatedAidingDevice&) = delete;
+  EmulatedAidingDevice& operator=(const EmulatedAidingDevice&) = delete;
+
+  /**
+   * \brief Gets the device interface to send commands to the emulated device with
+   * \return Reference to the device interface
+   */
+  mip::DeviceInterface& device()
+  {
+    return device_;
+  }
+
+ private:
+  EmulatedAidingConnection connection_;  /// Connection to the emulated device
+  uint8_t buffer_[1024];  /// Buffer to use for the MIP device
+  mip::DeviceInterface device_;  /// Device interface talking to the connection
+};
+
+}  // namespace microstrain
+
+#endif  // MICROSTRAIN_INERTIAL_DRIVER_COMMON_UTILS_MIP_EMULATED_AIDING_DEVICE_H
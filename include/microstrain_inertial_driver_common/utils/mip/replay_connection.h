@@ -0,0 +1,86 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Parker-Lord Driver Definition File
+//
+// Copyright (c) 2017, Brian Bingham
+// Copyright (c) 2020, Parker Hannifin Corp
+//
+// This code is licensed under MIT license (see LICENSE file for details)
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef MICROSTRAIN_INERTIAL_DRIVER_COMMON_UTILS_MIP_REPLAY_CONNECTION_H
+#define MICROSTRAIN_INERTIAL_DRIVER_COMMON_UTILS_MIP_REPLAY_CONNECTION_H
+
+#include <memory>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <ostream>
+
+#include "mip/mip_device.hpp"
+
+#include "microstrain_inertial_driver_common/utils/clock.h"
+
+namespace microstrain
+{
+
+/**
+ * Connection that reads back a timed capture instead of talking to a device.
+ * A timed capture is a sequence of records, one for every chunk of data read from the device, each made of
+ * the time the chunk arrived as a signed 64 bit count of nanoseconds, the size of the chunk as an unsigned 32 bit integer, and the chunk itself.
+ * Integers are stored in the byte order of the machine that recorded the capture.
+ * Every chunk moves the virtual clock to the time it originally arrived, so everything stamped from the clock gets the same stamp it got when it was recorded.
+ * Anything sent to the device is dropped, since the replies are already in the capture
+ */
+class ReplayConnection : public mip::Connection
+{
+ public:
+  /**
+   * \brief Constructor
+   * \param path Path to the timed capture to read
+   * \param clock The clock to move as chunks are read
+   */
+  ReplayConnection(const std::string& path, std::shared_ptr<VirtualClock> clock);
+
+  /**
+   * \brief Appends a chunk of data to a timed capture
+   * \param stream The capture to append to
+   * \param arrival_nanoseconds The time the chunk arrived in nanoseconds
+   * \param data The chunk of data
+   * \param length Number of bytes in the chunk
+   * \return true if the chunk was written
+   */
+  static bool writeRecord(std::ostream* stream, int64_t arrival_nanoseconds, const uint8_t* data, size_t length);
+
+  /**
+   * \brief Gets whether every chunk in the capture has been read
+   * \return true if the end of the capture was reached
+   */
+  bool finished() const
+  {
+    return finished_;
+  }
+
+  // Implemented in order to satisfy the requirements for the MIP connection
+  bool isConnected() const final;
+  bool connect() final;
+  bool disconnect() final;
+  bool sendToDevice(const uint8_t* data, size_t length) final;
+  bool recvFromDevice(uint8_t* buffer, size_t max_length, mip::Timeout wait_time, size_t* count_out, mip::Timestamp* timestamp_out) final;
+  const char* interfaceName() const final;
+  uint32_t parameter() const final;
+
+ private:
+  std::string path_;  /// Path to the timed capture to read
+  std::shared_ptr<VirtualClock> clock_;  /// The clock to move as chunks are read
+  std::ifstream file_;  /// The open capture
+
+  std::vector<uint8_t> chunk_;  /// The chunk being read, in case it did not fit in the buffer it was read into
+  size_t chunk_offset_ = 0;  /// Number of bytes of the chunk that have already been read
+  bool finished_ = false;  /// Whether the end of the capture was reached
+};
+
+}  // namespace microstrain
+
+#endif  // MICROSTRAIN_INERTIAL_DRIVER_COMMON_UTILS_MIP_REPLAY_CONNECTION_H
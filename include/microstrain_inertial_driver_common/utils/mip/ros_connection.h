@@ -12,14 +12,20 @@
 #ifndef MICROSTRAIN_INERTIAL_DRIVER_COMMON_UTILS_MIP_ROS_CONNECTION_H
 #define MICROSTRAIN_INERTIAL_DRIVER_COMMON_UTILS_MIP_ROS_CONNECTION_H
 
+#include <mutex>
 #include <vector>
 #include <string>
 #include <memory>
 #include <fstream>
 
 #include "mip/mip_device.hpp"
+#include "mip/definitions/commands_base.hpp"
 
 #include "microstrain_inertial_driver_common/utils/ros_compat.h"
+#include "microstrain_inertial_driver_common/utils/clock.h"
+#include "microstrain_inertial_driver_common/utils/byte_proxy.h"
+#include "microstrain_inertial_driver_common/utils/mip/serial_fd_connection.h"
+#include "microstrain_inertial_driver_common/utils/mip/replay_connection.h"
 
 namespace microstrain
 {
@@ -36,8 +42,14 @@ class RosConnection : public mip::Connection
   /**
    * \brief Constructs the ROS connection given a reference to the node that initialized it.
    * \param node Reference to the node that is initializing the connection
+   * \param clock Clock used to stamp the data read from the device
    */
-  explicit RosConnection(RosNodeType* node);
+  RosConnection(RosNodeType* node, std::shared_ptr<Clock> clock);
+
+  /**
+   * \brief Stops the proxy from sending through this connection
+   */
+  ~RosConnection();
 
   /**
    * \brief Tests if the connection is connected
@@ -66,6 +78,36 @@ class RosConnection : public mip::Connection
    */
   bool connect(RosNodeType* config_node, const std::string& port, const int32_t baudrate);
 
+  /**
+   * \brief Uses a port that was already opened by another driver instead of opening it. The port settings are not modified
+   * \param fd The file descriptor of the open port. This object takes ownership of it
+   * \param port The serial port the descriptor refers to
+   * \param baudrate The baudrate the port was opened at
+   * \return true if the connection was successful and false otherwise
+   */
+  bool adopt(int fd, const std::string& port, const int32_t baudrate);
+
+  /**
+   * \brief Reads a timed capture instead of connecting to a device. Everything sent to the device is dropped
+   * \param replay_file_path Path to the timed capture to read
+   * \param clock The clock to move to the time each chunk of the capture arrived. Should be the same clock this connection was constructed with
+   * \return true if the capture was opened and false otherwise
+   */
+  bool replay(const std::string& replay_file_path, std::shared_ptr<VirtualClock> clock);
+
+  /**
+   * \brief Gets whether a replayed capture has been read to the end
+   * \return true if this connection is replaying a capture and has read all of it
+   */
+  bool replayFinished() const;
+
+  /**
+   * \brief Starts saving everything read from the device along with the time it arrived, so that it can be replayed later
+   * \param timed_capture_file_path Path to save the timed capture to
+   * \return true if the capture file was opened and false otherwise
+   */
+  bool startTimedCapture(const std::string& timed_capture_file_path);
+
   /**
    * \brief Configures the RosConnection object. This should be called after connect
    * \param config_node Reference to a ROS node object that contains configuration information
@@ -74,6 +116,20 @@ class RosConnection : public mip::Connection
    */
   bool configure(RosNodeType* config_node, RosMipDevice* device);
 
+  /**
+   * \brief Configures the RosConnection object without communicating with the device. This should be called after connect or adopt
+   * \param config_node Reference to a ROS node object that contains configuration information
+   * \param device_info Device info that was already read from the device
+   * \return true if the configuration was successful and false otherwise
+   */
+  bool configure(RosNodeType* config_node, const mip::commands_base::BaseDeviceInfo& device_info);
+
+  /**
+   * \brief Gets the file descriptor of the open port, so it can be handed to another driver
+   * \return The file descriptor, or -1 if the port is not open or the connection does not expose it
+   */
+  int fd() const;
+
   /**
    * \brief Gets whether or not this connection is parsing NMEA
    * \return Whether or not this connection is parsing NMEA
@@ -124,6 +180,12 @@ class RosConnection : public mip::Connection
    */
   bool updateRecordingState(const bool should_record, const std::string& record_file_path);
 
+  /**
+   * \brief Mirrors everything read by this connection to the proxy, and lets the proxy send commands through this connection
+   * \param proxy The proxy to mirror to, or nullptr to stop mirroring
+   */
+  void proxy(std::shared_ptr<ByteProxy> proxy);
+
   // Implemented in order to satisfy the requirements for the MIP connection
   bool sendToDevice(const uint8_t* data, size_t length) final;
   bool recvFromDevice(uint8_t* buffer, size_t max_length, mip::Timeout timeout, size_t* count_out, mip::Timestamp* timestamp_out) final;
@@ -138,17 +200,32 @@ class RosConnection : public mip::Connection
    */
   void extractNmea(const uint8_t* data, size_t data_len);
 
+  /**
+   * \brief Sends bytes to the device without waiting on commands from proxy clients. Used by the proxy itself to forward them
+   * \param data The bytes to send
+   * \param length Number of bytes in data
+   * \return true if the bytes were sent
+   */
+  bool send(const uint8_t* data, size_t length);
+
   RosNodeType* node_;  /// Reference to the ROS node that created this connection
+  std::shared_ptr<Clock> clock_;  /// Clock used to stamp the data read from the device
 
+  std::unique_ptr<SerialFdConnection> fd_connection_;  /// Connection that exposes the port, used when the port may be handed off. Wrapped by connection_
+  std::unique_ptr<ReplayConnection> replay_connection_;  /// Connection that reads a timed capture, used when replaying. Wrapped by connection_
   std::unique_ptr<mip::Connection> connection_;  /// Connection object used to actually interact with the device
   mip::Timeout parse_timeout_;  /// Parse timeout given the type of connection configured
   mip::Timeout base_reply_timeout_;  /// Base reply timeout given the type of connection configured
 
-  bool should_record_;  /// Whether or not we should record binary data on this connection
+  bool should_record_ = false;  /// Whether or not we should record binary data on this connection
   std::string record_file_path_;  /// The path to where data will be recorded
   std::ofstream record_file_;  /// The file that the binary data should be recorded to
+  std::ofstream timed_capture_file_;  /// The file that the binary data and the time it arrived should be recorded to, if a timed capture was started
+
+  std::shared_ptr<ByteProxy> proxy_;  /// Proxy that data read from the device is mirrored to, if enabled
+  std::mutex send_mutex_;  /// Keeps commands sent by the driver and by proxy clients from interleaving
 
-  bool should_parse_nmea_;  /// Whether or not we should attempt to parse and extract NMEA sentences on this connection
+  bool should_parse_nmea_ = false;  /// Whether or not we should attempt to parse and extract NMEA sentences on this connection
   std::string nmea_string_;  /// Cached data read from the port, used to extraxt NMEA messages
   std::vector<NMEASentenceMsg> nmea_msgs_;  /// List of NMEA messages received by this connection
 };
@@ -38,8 +38,9 @@ class RosMipDevice
   /**
    * \brief Initializes the device with a reference to the ROS node
    * \param node The node that this device was initialized with
+   * \param clock Clock used to stamp the data read from the device and to wait for the device
    */
-  explicit RosMipDevice(RosNodeType* node);
+  RosMipDevice(RosNodeType* node, std::shared_ptr<Clock> clock);
 
   /**
    * \brief Pure virtual configure function
@@ -159,6 +160,7 @@ class RosMipDevice
   static void fixMipString(char* str, const size_t str_len);
 
   RosNodeType* node_;  /// Reference to the ROS node that created this object
+  std::shared_ptr<Clock> clock_;  /// Clock used to stamp the data read from the device and to wait for the device
 
   std::shared_ptr<RosConnection> connection_;  // Pointer to the MIP connection
   std::unique_ptr<::mip::DeviceInterface> device_;  // Pointer to the device. Public so that functions that do not need to be wrapped can be called directly
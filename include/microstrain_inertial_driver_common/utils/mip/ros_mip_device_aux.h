@@ -36,6 +36,15 @@ class RosMipDeviceAux : public RosMipDevice
    * \param config_node ROS node with configuration options used to configure the aux connection
    */
   bool configure(RosNodeType* config_node) final;
+
+  /**
+   * \brief Configures the aux device connection using a port handed off by another driver. Nothing is sent to the device
+   * \param config_node ROS node with configuration options used to configure the aux connection
+   * \param fd The file descriptor of the open aux port. This object takes ownership of it
+   * \param device_info Device info read from the main port, used to name the raw file
+   * \return true if the connection was configured
+   */
+  bool adopt(RosNodeType* config_node, int fd, const mip::commands_base::BaseDeviceInfo& device_info);
 };
 
 }  // namespace microstrain
@@ -22,6 +22,7 @@
 #include "mip/definitions/commands_base.hpp"
 #include "mip/definitions/commands_3dm.hpp"
 
+#include "microstrain_inertial_driver_common/utils/handoff.h"
 #include "microstrain_inertial_driver_common/utils/mip/ros_mip_device.h"
 
 namespace microstrain
@@ -41,6 +42,21 @@ class RosMipDeviceMain : public RosMipDevice
    */
   bool configure(RosNodeType* config_node) final;
 
+  /**
+   * \brief Configures the main device connection using a port and state handed off by another driver.
+   *        Nothing is sent to the device, so it keeps streaming while we take over
+   * \param config_node ROS node with configuration options used to configure the main connection
+   * \param state State received from the previous driver
+   * \return true if the connection was configured
+   */
+  bool adopt(RosNodeType* config_node, const HandoffState& state);
+
+  /**
+   * \brief Saves the information this object read from the device, so another driver can adopt it
+   * \param state The state to populate. The file descriptors and stream hash are not touched
+   */
+  void saveHandoffState(HandoffState* state) const;
+
   /**
    * \brief Forces the device to idle. It is possible for us to drop the response to the first setToIdle command.
    *        To solve the problem, we send the command multiple times with an interval in between until we get a success response
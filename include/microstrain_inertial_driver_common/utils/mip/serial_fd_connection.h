@@ -0,0 +1,75 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Parker-Lord Driver Definition File
+//
+// Copyright (c) 2017, Brian Bingham
+// Copyright (c) 2020, Parker Hannifin Corp
+//
+// This code is licensed under MIT license (see LICENSE file for details)
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef MICROSTRAIN_INERTIAL_DRIVER_COMMON_UTILS_MIP_SERIAL_FD_CONNECTION_H
+#define MICROSTRAIN_INERTIAL_DRIVER_COMMON_UTILS_MIP_SERIAL_FD_CONNECTION_H
+
+#include <string>
+
+#include "mip/mip_device.hpp"
+
+namespace microstrain
+{
+
+/**
+ * Serial connection that exposes its file descriptor, so that an open port can be handed to another process.
+ * Can either open the port itself, or adopt a descriptor that was opened and configured by someone else
+ */
+class SerialFdConnection : public mip::Connection
+{
+ public:
+  /**
+   * \brief Constructs a connection that will open the port when connect is called
+   * \param port The serial port to open
+   * \param baudrate The baudrate to open the serial port at
+   */
+  SerialFdConnection(const std::string& port, uint32_t baudrate);
+
+  /**
+   * \brief Constructs a connection from a port that is already open. The port settings are not modified
+   * \param fd The file descriptor of the open port. This object takes ownership of it
+   * \param port The serial port the descriptor refers to. Used if the port has to be reopened
+   * \param baudrate The baudrate the port was opened at
+   */
+  SerialFdConnection(int fd, const std::string& port, uint32_t baudrate);
+
+  /**
+   * \brief Closes the port if it is open
+   */
+  ~SerialFdConnection() override;
+
+  /**
+   * \brief Gets the file descriptor of the open port
+   * \return The file descriptor, or -1 if the port is not open
+   */
+  int fd() const
+  {
+    return fd_;
+  }
+
+  // Implemented in order to satisfy the requirements for the MIP connection
+  bool isConnected() const final;
+  bool connect() final;
+  bool disconnect() final;
+  bool sendToDevice(const uint8_t* data, size_t length) final;
+  bool recvFromDevice(uint8_t* buffer, size_t max_length, mip::Timeout wait_time, size_t* count_out, mip::Timestamp* timestamp_out) final;
+  const char* interfaceName() const final;
+  uint32_t parameter() const final;
+
+ private:
+  int fd_ = -1;  /// File descriptor of the open port, or -1 if the port is not open
+  std::string port_;  /// The serial port to open
+  uint32_t baudrate_;  /// The baudrate to open the serial port at
+};
+
+}  // namespace microstrain
+
+#endif  // MICROSTRAIN_INERTIAL_DRIVER_COMMON_UTILS_MIP_SERIAL_FD_CONNECTION_H
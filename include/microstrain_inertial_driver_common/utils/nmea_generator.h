@@ -0,0 +1,146 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Parker-Lord Driver Definition File
+//
+// Copyright (c) 2017, Brian Bingham
+// Copyright (c) 2020, Parker Hannifin Corp
+//
+// This code is licensed under MIT license (see LICENSE file for details)
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef MICROSTRAIN_INERTIAL_DRIVER_COMMON_UTILS_NMEA_GENERATOR_H
+#define MICROSTRAIN_INERTIAL_DRIVER_COMMON_UTILS_NMEA_GENERATOR_H
+
+#include <string>
+#include <vector>
+
+#include "mip/mip_all.hpp"
+
+namespace microstrain
+{
+
+/**
+ * Builds NMEA sentences on the host from data that has already been decoded from binary MIP packets
+ */
+class NmeaGenerator
+{
+ public:
+  // GGA fix quality values. The RMC and VTG mode indicators are derived from these
+  static constexpr uint8_t FIX_QUALITY_INVALID = 0;
+  static constexpr uint8_t FIX_QUALITY_GNSS = 1;
+  static constexpr uint8_t FIX_QUALITY_DGNSS = 2;
+  static constexpr uint8_t FIX_QUALITY_RTK_FIXED = 4;
+  static constexpr uint8_t FIX_QUALITY_RTK_FLOAT = 5;
+  static constexpr uint8_t FIX_QUALITY_ESTIMATED = 6;
+
+  /**
+   * \brief Default Constructor. Will not generate any sentences
+   */
+  NmeaGenerator() = default;
+
+  /**
+   * \brief Constructor
+   * \param talker_id Two character talker ID to prefix all sentences with (GN, GP, GA, GL)
+   * \param gga_rate_hz Rate in hertz to generate GGA sentences at. 0 disables the sentence
+   * \param rmc_rate_hz Rate in hertz to generate RMC sentences at. 0 disables the sentence
+   * \param vtg_rate_hz Rate in hertz to generate VTG sentences at. 0 disables the sentence
+   */
+  NmeaGenerator(const std::string& talker_id, const float gga_rate_hz, const float rmc_rate_hz, const float vtg_rate_hz);
+
+  /**
+   * \brief Checks if this generator will ever produce a sentence
+   * \return true if at least one sentence has a non-zero rate
+   */
+  bool enabled() const;
+
+  /**
+   * \brief Updates the position that will be used in the next sentences
+   * \param latitude Latitude in degrees
+   * \param longitude Longitude in degrees
+   * \param msl_height Height above mean sea level in meters
+   * \param geoid_separation Height of the geoid above the ellipsoid in meters
+   */
+  void updatePosition(const double latitude, const double longitude, const double msl_height, const double geoid_separation);
+
+  /**
+   * \brief Updates the velocity that will be used in the next sentences
+   * \param north North velocity in meters per second
+   * \param east East velocity in meters per second
+   */
+  void updateVelocity(const double north, const double east);
+
+  /**
+   * \brief Updates the fix information that will be used in the next sentences
+   * \param quality One of the FIX_QUALITY_* values
+   * \param num_sv Number of satellites used in the solution
+   */
+  void updateFix(const uint8_t quality, const uint8_t num_sv);
+
+  /**
+   * \brief Generates every sentence that is due at the provided GPS time
+   * \param gps_timestamp GPS time of the data used to build the sentences
+   * \param gga_sentence Optional output that will be set to the GGA sentence if one was generated
+   * \return List of complete sentences including the checksum and line ending
+   */
+  std::vector<std::string> generate(const mip::data_shared::GpsTimestamp& gps_timestamp, std::string* gga_sentence = nullptr);
+
+  /**
+   * \brief Computes the NMEA checksum of a sentence body
+   * \param body Everything between the '$' and the '*'
+   * \return XOR of every character in the body
+   */
+  static uint8_t checksum(const std::string& body);
+
+  /**
+   * \brief Wraps a sentence body in the start delimiter, checksum and line ending
+   * \param body Everything between the '$' and the '*'
+   * \return Complete NMEA sentence
+   */
+  static std::string finalize(const std::string& body);
+
+ private:
+  /**
+   * \brief Checks if a sentence is due, and if so, saves the time it was generated at
+   * \param rate_hz Rate the sentence should be generated at
+   * \param last_time Time the sentence was last generated. Will be updated if the sentence is due
+   * \param time Current GPS time in seconds
+   * \return true if the sentence should be generated
+   */
+  static bool due(const float rate_hz, double* last_time, const double time);
+
+  std::string gga(const std::string& time_str) const;
+  std::string rmc(const std::string& time_str, const std::string& date_str) const;
+  std::string vtg() const;
+
+  char modeIndicator() const;
+  double speedOverGround() const;
+  double courseOverGround() const;
+
+  std::string talker_id_;  /// Talker ID to prefix all sentences with
+
+  float gga_rate_hz_ = 0;  /// Rate to generate GGA sentences at
+  float rmc_rate_hz_ = 0;  /// Rate to generate RMC sentences at
+  float vtg_rate_hz_ = 0;  /// Rate to generate VTG sentences at
+
+  double last_gga_time_ = -1;  /// GPS time in seconds of the last GGA sentence
+  double last_rmc_time_ = -1;  /// GPS time in seconds of the last RMC sentence
+  double last_vtg_time_ = -1;  /// GPS time in seconds of the last VTG sentence
+
+  bool has_position_ = false;  /// Whether or not a position has been received
+  double latitude_ = 0;
+  double longitude_ = 0;
+  double msl_height_ = 0;
+  double geoid_separation_ = 0;
+
+  bool has_velocity_ = false;  /// Whether or not a velocity has been received
+  double north_velocity_ = 0;
+  double east_velocity_ = 0;
+
+  uint8_t quality_ = FIX_QUALITY_INVALID;
+  uint8_t num_sv_ = 0;
+};
+
+}  // namespace microstrain
+
+#endif  // MICROSTRAIN_INERTIAL_DRIVER_COMMON_UTILS_NMEA_GENERATOR_H
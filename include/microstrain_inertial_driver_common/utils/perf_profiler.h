@@ -0,0 +1,144 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Parker-Lord Driver Definition File
+//
+// Copyright (c) 2017, Brian Bingham
+// Copyright (c) 2020, Parker Hannifin Corp
+//
+// This code is licensed under MIT license (see LICENSE file for details)
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef MICROSTRAIN_INERTIAL_DRIVER_COMMON_UTILS_PERF_PROFILER_H
+#define MICROSTRAIN_INERTIAL_DRIVER_COMMON_UTILS_PERF_PROFILER_H
+
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <string>
+#include <cstdint>
+#include <cstddef>
+
+namespace microstrain
+{
+
+/**
+ * Samples hardware performance counters around stages of the parsing pipeline using perf_event_open.
+ * The counters only measure the thread that opened them, so calls from any other thread are ignored.
+ * When the kernel multiplexes the counters with other events, the counts are scaled up by how long the counters were actually running,
+ * and the samples that were scaled are reported, as those counts are estimates.
+ */
+class PerfProfiler
+{
+ public:
+  /**
+   * Stages of the pipeline that can be measured
+   */
+  enum Stage
+  {
+    STAGE_UPDATE = 0,  /// Entire update of the device. Includes reading, framing, dispatching, handling and publishing
+    STAGE_HANDLERS,  /// Dispatching the fields of a single packet to their handlers
+    STAGE_PUBLISH,  /// Publishing the messages updated by a single packet
+    NUM_STAGES
+  };
+
+  // Counters sampled for each stage
+  static constexpr size_t COUNTER_INSTRUCTIONS = 0;
+  static constexpr size_t COUNTER_CYCLES = 1;
+  static constexpr size_t COUNTER_CACHE_MISSES = 2;
+  static constexpr size_t COUNTER_BRANCH_MISSES = 3;
+  static constexpr size_t NUM_COUNTERS = 4;
+
+  // Descriptor set to use for stages that are not specific to a descriptor set
+  static constexpr uint8_t DESCRIPTOR_SET_ALL = 0;
+
+  PerfProfiler() = default;
+
+  /**
+   * \brief Destructor. Closes the counters
+   */
+  ~PerfProfiler();
+
+  PerfProfiler(const PerfProfiler&) = delete;
+  PerfProfiler& operator=(const PerfProfiler&) = delete;
+
+  /**
+   * \brief Opens the counters for the calling thread. Only this thread will be measured
+   * \param error Populated with the reason if the counters could not be opened
+   * \return true if at least the instruction counter could be opened
+   */
+  bool open(std::string* error);
+
+  /**
+   * \brief Starts measuring a stage
+   * \param stage The stage to start measuring
+   */
+  void begin(const Stage stage);
+
+  /**
+   * \brief Stops measuring a stage and adds the result to the totals
+   * \param stage The stage to stop measuring
+   * \param descriptor_set Descriptor set the stage processed, or DESCRIPTOR_SET_ALL
+   */
+  void end(const Stage stage, const uint8_t descriptor_set = DESCRIPTOR_SET_ALL);
+
+  /**
+   * \brief Formats the average counters for every stage and descriptor set that was measured as YAML
+   * \return YAML document containing the results
+   */
+  std::string toYaml() const;
+
+  /**
+   * \brief Clears the totals
+   */
+  void reset();
+
+ private:
+  /**
+   * Accumulated counters for a single stage and descriptor set
+   */
+  struct Totals
+  {
+    uint64_t samples = 0;  /// Number of times the stage was measured
+    uint64_t multiplexed_samples = 0;  /// Number of those measurements where the counters only ran for part of the stage, and were scaled
+    uint64_t unscheduled_samples = 0;  /// Number of times the stage ran while the counters were not running at all. Not included in the samples
+    double counters[NUM_COUNTERS] = {};  /// Sum of each counter over every measurement
+  };
+
+  /**
+   * Values of the counters at one point in time
+   */
+  struct Reading
+  {
+    uint64_t time_enabled = 0;  /// Nanoseconds the counters have been enabled for
+    uint64_t time_running = 0;  /// Nanoseconds the counters have actually been counting for. Less than time_enabled if they were multiplexed
+    uint64_t counters[NUM_COUNTERS] = {};  /// Value of each counter. Counters that are not open are 0
+  };
+
+  /**
+   * \brief Reads the current value of every open counter
+   * \param reading Will be filled with the counter values and times
+   * \return true if the counters could be read
+   */
+  bool read(Reading* reading) const;
+
+  /**
+   * \brief Checks if the calling thread is the thread being measured
+   * \return true if the counters are open and belong to the calling thread
+   */
+  bool measuring() const;
+
+  mutable std::mutex mutex_;  /// Protects the file descriptors while they are opened, and the totals, as both are read from another thread
+  int group_fd_ = -1;  /// File descriptor of the group leader
+  int fds_[NUM_COUNTERS] = {-1, -1, -1, -1};  /// File descriptor for each counter, or -1 if it could not be opened
+  size_t num_open_ = 0;  /// Number of counters in the group
+  std::atomic<std::thread::id> thread_id_ = {std::thread::id()};  /// Thread the counters were opened on. Only set once they are all open
+
+  Reading begin_readings_[NUM_STAGES];  /// Counter values when each stage began. Only used by the measured thread
+
+  Totals totals_[NUM_STAGES][256];  /// Totals for each stage and descriptor set
+};
+
+}  // namespace microstrain
+
+#endif  // MICROSTRAIN_INERTIAL_DRIVER_COMMON_UTILS_PERF_PROFILER_H
@@ -0,0 +1,177 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Parker-Lord Driver Definition File
+//
+// Copyright (c) 2017, Brian Bingham
+// Copyright (c) 2020, Parker Hannifin Corp
+//
+// This code is licensed under MIT license (see LICENSE file for details)
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef MICROSTRAIN_INERTIAL_DRIVER_COMMON_UTILS_REALTIME_H
+#define MICROSTRAIN_INERTIAL_DRIVER_COMMON_UTILS_REALTIME_H
+
+#include <mutex>
+#include <string>
+#include <cstdint>
+#include <cstddef>
+
+// On glibc the audit also replaces malloc, calloc and realloc, as glibc exports the originals for the replacements to forward to.
+// Not under AddressSanitizer, which replaces them itself
+#if defined(__has_feature)
+#if __has_feature(address_sanitizer)
+#define MICROSTRAIN_ADDRESS_SANITIZER
+#endif
+#endif
+#if defined(__SANITIZE_ADDRESS__)
+#define MICROSTRAIN_ADDRESS_SANITIZER
+#endif
+#if defined(MICROSTRAIN_RT_AUDIT) && defined(__linux__) && defined(__GLIBC__) && !defined(MICROSTRAIN_ADDRESS_SANITIZER)
+#define MICROSTRAIN_RT_AUDIT_MALLOC
+#endif
+
+namespace microstrain
+{
+
+static constexpr auto RT_SCHEDULING_POLICY_OTHER = "other";
+static constexpr auto RT_SCHEDULING_POLICY_FIFO = "fifo";
+static constexpr auto RT_SCHEDULING_POLICY_RR = "rr";
+
+/**
+ * Helpers to prepare the process and its threads for real time operation.
+ * All functions return false and populate the error string if the operation is not supported or fails
+ */
+class Realtime
+{
+ public:
+  /**
+   * \brief Locks all current and future pages of the process into memory, and stops the heap from returning memory to the OS
+   * \param error Populated with the reason if locking fails
+   * \return true if memory was locked
+   */
+  static bool lockMemory(std::string* error);
+
+  /**
+   * \brief Touches the requested amount of stack on the calling thread so the pages are resident before the thread needs them
+   * \param size Number of bytes of stack to prefault. Clamped to maxPrefaultStackSize
+   */
+  static void prefaultStack(const size_t size);
+
+  /**
+   * \brief Gets the most stack prefaultStack will touch. This is the stack size limit of the process, less room for the frames already on the stack
+   * \return Largest number of bytes of stack that can be prefaulted
+   */
+  static size_t maxPrefaultStackSize();
+
+  /**
+   * \brief Allocates and touches the requested amount of heap, then releases it. Combined with lockMemory, the released memory stays resident
+   *        so later allocations up to this size do not page fault
+   * \param size Number of bytes of heap to prefault
+   */
+  static void prefaultHeap(const size_t size);
+
+  /**
+   * \brief Applies a scheduling policy and priority to the calling thread
+   * \param policy One of the RT_SCHEDULING_POLICY_* values
+   * \param priority Priority to use with the policy. Ignored for RT_SCHEDULING_POLICY_OTHER
+   * \param error Populated with the reason if the scheduling could not be applied
+   * \return true if the scheduling was applied
+   */
+  static bool setThreadScheduling(const std::string& policy, const int priority, std::string* error);
+};
+
+/**
+ * Detects heap allocations and lock contention on the hot path of the calling thread.
+ * Allocations are only detected if the library was built with MICROSTRAIN_RT_AUDIT defined, as that replaces the global allocation functions.
+ * Only the functions named by auditedFunctions are replaced, so memory from anything else, such as posix_memalign or mmap, is not detected.
+ * Contention is detected on any AuditedMutex regardless of how the library was built.
+ */
+class RealtimeAudit
+{
+ public:
+  /**
+   * Marks the calling thread as being on the hot path for the lifetime of this object
+   */
+  class Scope
+  {
+   public:
+    Scope();
+    ~Scope();
+
+    Scope(const Scope&) = delete;
+    Scope& operator=(const Scope&) = delete;
+  };
+
+  /**
+   * \brief Checks if the library was built with allocation auditing
+   * \return true if allocations on the hot path can be detected
+   */
+  static bool supported();
+
+  /**
+   * \brief Names the allocation functions that are audited in this build
+   * \return Comma separated names of the audited functions, or an empty string if allocations are not audited
+   */
+  static const char* auditedFunctions();
+
+  /**
+   * \brief Gets the number of allocations made on the hot path of the calling thread since the last call, and resets the count
+   * \param call_site Populated with the symbolized stack of the first allocation since the last call, if there was one
+   * \return Number of allocations made on the hot path since the last call
+   */
+  static uint64_t takeViolations(std::string* call_site);
+
+  /**
+   * \brief Records an allocation if the calling thread is on the hot path. Called by the global allocation functions
+   */
+  static void recordAllocation();
+
+  /**
+   * \brief Gets the number of times the calling thread had to wait for an AuditedMutex on the hot path since the last call, and resets the count
+   * \return Number of contended locks on the hot path since the last call
+   */
+  static uint64_t takeContentions();
+
+  /**
+   * \brief Records a contended lock if the calling thread is on the hot path. Called by AuditedMutex
+   */
+  static void recordContention();
+};
+
+/**
+ * Mutex for data shared with the hot path. Tries to take the lock without blocking first, and if another thread holds it,
+ * records the contention with RealtimeAudit before blocking. Satisfies the Lockable requirements, so it works with std::lock_guard and std::unique_lock
+ */
+class AuditedMutex
+{
+ public:
+  AuditedMutex() = default;
+  AuditedMutex(const AuditedMutex&) = delete;
+  AuditedMutex& operator=(const AuditedMutex&) = delete;
+
+  void lock()
+  {
+    if (mutex_.try_lock())
+      return;
+    RealtimeAudit::recordContention();
+    mutex_.lock();
+  }
+
+  bool try_lock()
+  {
+    return mutex_.try_lock();
+  }
+
+  void unlock()
+  {
+    mutex_.unlock();
+  }
+
+ private:
+  std::mutex mutex_;  /// The mutex that is actually locked
+};
+
+}  // namespace microstrain
+
+#endif  // MICROSTRAIN_INERTIAL_DRIVER_COMMON_UTILS_REALTIME_H
@@ -18,6 +18,7 @@
 #include <string>
 #include <memory>
 #include <vector>
+#include <type_traits>
 
 /**
  * Common Defines
@@ -46,6 +47,7 @@ constexpr auto NUM_GNSS = 2;
  */
 #if MICROSTRAIN_ROS_VERSION == 1
 #include "ros/ros.h"
+#include <boost/make_shared.hpp>
 
 #include "tf2_ros/buffer.h"
 #include "tf2_ros/buffer_interface.h"
@@ -67,6 +69,7 @@ constexpr auto NUM_GNSS = 2;
 #include "nav_msgs/Odometry.h"
 #include "std_msgs/Int8.h"
 #include "std_msgs/Int16MultiArray.h"
+#include "std_msgs/Float64MultiArray.h"
 #include "std_msgs/MultiArrayLayout.h"
 #include "std_msgs/Bool.h"
 #include "std_msgs/String.h"
@@ -107,6 +110,12 @@ constexpr auto NUM_GNSS = 2;
 #elif MICROSTRAIN_ROS_VERSION == 2
 #include "rclcpp/rclcpp.hpp"
 
+// Type adaptation (REP-2007) is only available in humble and newer
+#if MICROSTRAIN_ROLLING == 1 || MICROSTRAIN_HUMBLE == 1
+#define MICROSTRAIN_TYPE_ADAPTATION 1
+#include "rclcpp/type_adapter.hpp"
+#endif
+
 #ifdef MICROSTRAIN_LIFECYCLE
 #include "rclcpp_lifecycle/lifecycle_node.hpp"
 #include "rclcpp_lifecycle/lifecycle_publisher.hpp"
@@ -133,6 +142,7 @@ constexpr auto NUM_GNSS = 2;
 #include "nav_msgs/msg/odometry.hpp"
 #include "std_msgs/msg/int8.hpp"
 #include "std_msgs/msg/int16_multi_array.hpp"
+#include "std_msgs/msg/float64_multi_array.hpp"
 #include "std_msgs/msg/multi_array_layout.hpp"
 #include "std_srvs/srv/empty.hpp"
 #include "std_srvs/srv/trigger.hpp"
@@ -192,6 +202,27 @@ inline ::ros::Time toMsg(const ::ros::Time& time)
 
 namespace microstrain
 {
+/**
+ * \brief ROS message that a type used by the driver is published as. Native types should specialize this, and provide an overload of toRosMessage
+ * \tparam MessageType The type used by the driver
+ */
+template<typename MessageType>
+struct RosMessageTypeOf
+{
+  using type = MessageType;
+};
+
+/**
+ * \brief Converts a type used by the driver into the ROS message it is published as. Types that are already ROS messages are copied as is
+ * \param msg The message to convert
+ * \param ros_msg The ROS message to populate
+ */
+template<typename MessageType>
+void toRosMessage(const MessageType& msg, MessageType* ros_msg)
+{
+  *ros_msg = msg;
+}
+
 /**
  * ROS1 Defines
  */
@@ -206,13 +237,95 @@ class RosPubType : public ::ros::Publisher
  public:
   using MessageSharedPtr = std::shared_ptr<MessageType>;
   using SharedPtr = std::shared_ptr<RosPubType<MessageType>>;
+  using RosMessageType = typename RosMessageTypeOf<MessageType>::type;
 
   explicit RosPubType(const ::ros::Publisher& rhs) : ::ros::Publisher(rhs) {}
 
   void on_activate() { (void)0; }
   void on_deactivate() { (void)0; }
+
+  /**
+   * \brief Sets how many messages publishPooled can recycle. 0 disables pooling and publishes by reference
+   * \param pool_size Maximum number of messages to keep in the pool
+   */
+  void setPoolSize(const size_t pool_size)
+  {
+    pool_size_ = pool_size;
+    pool_.reserve(pool_size);
+  }
+
+  /**
+   * \brief Publishes a copy of the message by shared pointer, so subscribers in the same process (nodelets) receive it without being copied or serialized.
+   *        Copies are recycled once no subscriber holds on to them anymore, so they do not have to be allocated for every message
+   * \param msg The message to publish
+   */
+  void publishPooled(const MessageType& msg)
+  {
+    if (pool_size_ == 0)
+    {
+      publishByReference(msg);
+      return;
+    }
+
+    // Only we hold a reference to a message once every subscriber is done with it, so it is safe to overwrite
+    for (auto& pooled_msg : pool_)
+    {
+      if (pooled_msg.unique())
+      {
+        toRosMessage(msg, pooled_msg.get());
+        this->publish(pooled_msg);
+        return;
+      }
+    }
+
+    // If every pooled message is still in use, grow the pool until it is full, and then fall back to a message that is not recycled
+    auto new_msg = boost::make_shared<RosMessageType>();
+    toRosMessage(msg, new_msg.get());
+    if (pool_.size() < pool_size_)
+      pool_.push_back(new_msg);
+    this->publish(new_msg);
+  }
+
+ private:
+  void publishByReference(const RosMessageType& msg)
+  {
+    this->publish(msg);
+  }
+
+  template<typename NativeType>
+  void publishByReference(const NativeType& msg)
+  {
+    RosMessageType ros_msg;
+    toRosMessage(msg, &ros_msg);
+    this->publish(ros_msg);
+  }
+
+  size_t pool_size_ = 0;  /// Maximum number of messages to recycle
+  std::vector<boost::shared_ptr<RosMessageType>> pool_;  /// Messages that have been published and can be reused once subscribers release them
 };
 
+/**
+ * \brief Sets how many messages a publisher can recycle when publishing by shared pointer
+ * \param publisher The publisher to configure
+ * \param pool_size Maximum number of messages to keep in the pool. 0 publishes by reference
+ */
+template<typename MessageType>
+void setPublisherPoolSize(const std::shared_ptr<RosPubType<MessageType>>& publisher, const size_t pool_size)
+{
+  publisher->setPoolSize(pool_size);
+}
+
+/**
+ * \brief Publishes a message, converting it to its ROS message and recycling it from the publisher's pool if the pool is enabled
+ * \param publisher The publisher to publish on
+ * \param msg The message to publish
+ */
+template<typename MessageType>
+void publishPooled(const std::shared_ptr<RosPubType<MessageType>>& publisher, const MessageType& msg)
+{
+  publisher->publishPooled(msg);
+}
+
 template<typename MessageType>
 class RosSubType : public ::ros::Subscriber
 {
@@ -249,12 +362,14 @@ using ImuMsg = ::sensor_msgs::Imu;
 using NavSatFixMsg = ::sensor_msgs::NavSatFix;
 using FluidPressureMsg = ::sensor_msgs::FluidPressure;
 using QuaternionMsg = ::geometry_msgs::Quaternion;
+using Vector3Msg = ::geometry_msgs::Vector3;
 using TwistStampedMsg = ::geometry_msgs::TwistStamped;
 using PoseWithCovarianceStampedMsg = ::geometry_msgs::PoseWithCovarianceStamped;
 using TwistWithCovarianceStampedMsg = ::geometry_msgs::TwistWithCovarianceStamped;
 using MagneticFieldMsg = ::sensor_msgs::MagneticField;
 using TimeReferenceMsg = ::sensor_msgs::TimeReference;
 using NMEASentenceMsg = ::nmea_msgs::Sentence;
+using Float64MultiArrayMsg = ::std_msgs::Float64MultiArray;
 
 using HumanReadableStatusMsg = ::microstrain_inertial_msgs::HumanReadableStatus;
 
@@ -273,6 +388,7 @@ using MipFilterGnssDualAntennaStatusMsg = ::microstrain_inertial_msgs::MipFilter
 using MipSystemBuiltInTestMsg = ::microstrain_inertial_msgs::MipSystemBuiltInTest;
 
 using TransformStampedMsg = ::geometry_msgs::TransformStamped;
+using TransformMsg = ::geometry_msgs::Transform;
 
 // ROS1 TF types
 using TransformBufferType = std::shared_ptr<::tf2_ros::Buffer>;
@@ -372,6 +488,16 @@ inline double getTimeRefSecs(const ros::Time& time_ref)
   return static_cast<double>(time_ref.sec) + static_cast<double>(time_ref.nsec) / 1000000000.0;
 }
 
+/**
+ * \brief Gets the seconds and nanoseconds combined into nanoseconds, without the rounding of converting to a double
+ * \param time_ref  The ros time object to extract the time from
+ * \return nanoseconds from the ros time object
+*/
+inline int64_t getTimeRefNanoseconds(const ros::Time& time_ref)
+{
+  return static_cast<int64_t>(time_ref.sec) * 1000000000 + static_cast<int64_t>(time_ref.nsec);
+}
+
 
 /**
  * \brief Sets the sequence number on a ROS header. This is only useful in ROS1 as ROS2 removed the seq member
@@ -397,6 +523,19 @@ void getParam(RosNodeType* node, const std::string& param_name, ConfigType& para
   node->param<ConfigType>(param_name, param_val, default_val);
 }
 
+/**
+ * \brief Gets the configuration the node was started with as text, so two nodes started with the same configuration get the same text
+ * \param node  The ROS node to get the configuration of. This should be the private node handle ("~")
+ * \return Every parameter in the namespace of the node, sorted by name
+ */
+inline std::string getParamsText(RosNodeType* node)
+{
+  XmlRpc::XmlRpcValue params;
+  if (!node->getParam(node->getNamespace(), params))
+    return "";
+  return params.toXml();
+}
+
 template <class ConfigType>
 void setParam(RosNodeType* node, const std::string& param_name, const ConfigType& param_val)
 {
@@ -445,7 +584,7 @@ template <class MessageType>
 typename RosPubType<MessageType>::SharedPtr createPublisher(RosNodeType* node, const std::string& topic,
                                                    const uint32_t queue_size)
 {
-  return std::make_shared<RosPubType<MessageType>>(node->template advertise<MessageType>(topic, queue_size));
+  return std::make_shared<RosPubType<MessageType>>(node->template advertise<typename RosMessageTypeOf<MessageType>::type>(topic, queue_size));
 }
 
 /**
@@ -513,6 +652,14 @@ inline void stopTimer(RosTimerType timer)
   timer->stop();
 }
 
+/**
+ * \brief Asks ROS to shut down the process once the current callback returns
+ */
+inline void requestShutdown()
+{
+  ::ros::requestShutdown();
+}
+
 /**
  * ROS2 Defines
  */
@@ -529,11 +676,26 @@ using RosTimerType = ::rclcpp::TimerBase::SharedPtr;
 using RosRateType = ::rclcpp::Rate;
 using RosHeaderType = ::std_msgs::msg::Header;
 
+/**
+ * \brief Type that rclcpp publishes for a type used by the driver. With type adaptation, rclcpp publishes native types directly
+ *        and only converts them when there is a subscriber outside of the process. Otherwise, they are converted before publishing
+ * \tparam MessageType The type used by the driver
+ */
+template<typename MessageType>
+struct RosPublishedTypeOf
+{
+#ifdef MICROSTRAIN_TYPE_ADAPTATION
+  using type = MessageType;
+#else
+  using type = typename RosMessageTypeOf<MessageType>::type;
+#endif
+};
+
 template<typename MessageType>
 #ifdef MICROSTRAIN_LIFECYCLE
-using RosBasePubType = ::rclcpp_lifecycle::LifecyclePublisher<MessageType>;
+using RosBasePubType = ::rclcpp_lifecycle::LifecyclePublisher<typename RosPublishedTypeOf<MessageType>::type>;
 #else
-using RosBasePubType = ::rclcpp::Publisher<MessageType>;
+using RosBasePubType = ::rclcpp::Publisher<typename RosPublishedTypeOf<MessageType>::type>;
 #endif
 
 /**
@@ -569,12 +731,14 @@ using ImuMsg = ::sensor_msgs::msg::Imu;
 using NavSatFixMsg = ::sensor_msgs::msg::NavSatFix;
 using FluidPressureMsg = ::sensor_msgs::msg::FluidPressure;
 using QuaternionMsg = ::geometry_msgs::msg::Quaternion;
+using Vector3Msg = ::geometry_msgs::msg::Vector3;
 using TwistStampedMsg = ::geometry_msgs::msg::TwistStamped;
 using PoseWithCovarianceStampedMsg = ::geometry_msgs::msg::PoseWithCovarianceStamped;
 using TwistWithCovarianceStampedMsg = ::geometry_msgs::msg::TwistWithCovarianceStamped;
 using MagneticFieldMsg = ::sensor_msgs::msg::MagneticField;
 using TimeReferenceMsg = ::sensor_msgs::msg::TimeReference;
 using NMEASentenceMsg = ::nmea_msgs::msg::Sentence;
+using Float64MultiArrayMsg = ::std_msgs::msg::Float64MultiArray;
 
 using HumanReadableStatusMsg = ::microstrain_inertial_msgs::msg::HumanReadableStatus;
 
@@ -593,6 +757,7 @@ using MipFilterGnssDualAntennaStatusMsg = ::microstrain_inertial_msgs::msg::MipF
 using MipSystemBuiltInTestMsg = ::microstrain_inertial_msgs::msg::MipSystemBuiltInTest;
 
 using TransformStampedMsg = ::geometry_msgs::msg::TransformStamped;
+using TransformMsg = ::geometry_msgs::msg::Transform;
 
 // ROS2 Transform Broadcaster
 using TransformBufferType = std::shared_ptr<::tf2_ros::Buffer>;
@@ -697,6 +862,16 @@ inline double getTimeRefSecs(const builtin_interfaces::msg::Time& time_ref)
   return static_cast<double>(time_ref.sec) + static_cast<double>(time_ref.nanosec) / 1000000000.0;
 }
 
+/**
+ * \brief Gets the seconds and nanoseconds combined into nanoseconds, without the rounding of converting to a double
+ * \param time_ref  The ros time object to extract the time from
+ * \return nanoseconds from the ros time object
+*/
+inline int64_t getTimeRefNanoseconds(const builtin_interfaces::msg::Time& time_ref)
+{
+  return static_cast<int64_t>(time_ref.sec) * 1000000000 + static_cast<int64_t>(time_ref.nanosec);
+}
+
 /**
  * \brief Sets the sequence number on a ROS header. This is only useful in ROS1 as ROS2 removed the seq member
  * \param header  The header to set the sequence number on
@@ -732,6 +907,20 @@ void getParam(RosNodeType* node, const std::string& param_name, ConfigType& para
   }
 }
 
+/**
+ * \brief Gets the configuration the node was started with as text, so two nodes started with the same configuration get the same text.
+ *        Parameters are declared as they are read, so only the overrides the node was started with are used, not the declared parameters
+ * \param node  The ROS node to get the configuration of
+ * \return Every parameter the node was started with, sorted by name
+ */
+inline std::string getParamsText(RosNodeType* node)
+{
+  std::string text;
+  for (const auto& parameter : node->get_node_parameters_interface()->get_parameter_overrides())
+    text += parameter.first + "=" + rclcpp::to_string(parameter.second) + "\n";
+  return text;
+}
+
 template <class ConfigType>
 void setParam(RosNodeType* node, const std::string& param_name, const ConfigType& param_val)
 {
@@ -787,11 +976,11 @@ inline TransformBroadcasterType createTransformBroadcaster(RosNodeType* node)
  */
 #ifdef MICROSTRAIN_LIFECYCLE
 template <class MessageType>
-typename ::rclcpp_lifecycle::LifecyclePublisher<MessageType>::SharedPtr createPublisher(RosNodeType* node,
-                                                                                       const std::string& topic,
-                                                                                       const uint32_t qos)
+typename RosPubType<MessageType>::SharedPtr createPublisher(RosNodeType* node,
+                                                            const std::string& topic,
+                                                            const uint32_t qos)
 {
-  return node->template create_publisher<MessageType>(topic, qos);
+  return node->template create_publisher<typename RosPublishedTypeOf<MessageType>::type>(topic, qos);
 }
 #else
 template <class MessageType>
@@ -799,11 +988,54 @@ typename RosPubType<MessageType>::SharedPtr createPublisher(RosNodeType* node,
                                                             const std::string& topic,
                                                             const uint32_t qos)
 {
-  auto base_pub = node->template create_publisher<MessageType>(topic, qos);
+  auto base_pub = node->template create_publisher<typename RosPublishedTypeOf<MessageType>::type>(topic, qos);
   return std::make_shared<RosPubType<MessageType>>(*base_pub);
 }
 #endif
 
+/**
+ * \brief Compatibility for the ROS1 message pool. ROS2 handles intra process communication itself, so this does nothing
+ * \param publisher The publisher to configure
+ * \param pool_size Unused
+ */
+template<typename PublisherType>
+void setPublisherPoolSize(const std::shared_ptr<PublisherType>& publisher, const size_t pool_size)
+{
+  (void)publisher;
+  (void)pool_size;
+}
+
+/**
+ * \brief Publishes a message that rclcpp can publish directly
+ */
+template<typename PublisherType, typename MessageType>
+void publishConverted(PublisherType* publisher, const MessageType& msg, std::true_type)
+{
+  publisher->publish(msg);
+}
+
+/**
+ * \brief Publishes a native type on a distro without type adaptation by converting it to its ROS message first
+ */
+template<typename PublisherType, typename MessageType>
+void publishConverted(PublisherType* publisher, const MessageType& msg, std::false_type)
+{
+  typename RosMessageTypeOf<MessageType>::type ros_msg;
+  toRosMessage(msg, &ros_msg);
+  publisher->publish(ros_msg);
+}
+
+/**
+ * \brief Publishes a message. Compatible with the ROS1 message pool
+ * \param publisher The publisher to publish on
+ * \param msg The message to publish
+ */
+template<typename PublisherType, typename MessageType>
+void publishPooled(const std::shared_ptr<PublisherType>& publisher, const MessageType& msg)
+{
+  publishConverted(publisher.get(), msg, std::is_same<MessageType, typename RosPublishedTypeOf<MessageType>::type>());
+}
+
 /**
  * \brief Creates a ROS subscriber
  * \tparam MessageType  The type of message that this subscriber will listen to
@@ -875,6 +1107,14 @@ inline void stopTimer(RosTimerType timer)
   timer->cancel();
 }
 
+/**
+ * \brief Asks ROS to shut down the process once the current callback returns
+ */
+inline void requestShutdown()
+{
+  ::rclcpp::shutdown();
+}
+
 #else
 #error "Unsupported ROS version. -DMICROSTRAIN_ROS_VERSION must be set to 1 or 2"
 #endif
@@ -0,0 +1,108 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Parker-Lord Driver Definition File
+//
+// Copyright (c) 2017, Brian Bingham
+// Copyright (c) 2020, Parker Hannifin Corp
+//
+// This code is licensed under MIT license (see LICENSE file for details)
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef MICROSTRAIN_INERTIAL_DRIVER_COMMON_UTILS_RTCM_FRAMER_H
+#define MICROSTRAIN_INERTIAL_DRIVER_COMMON_UTILS_RTCM_FRAMER_H
+
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+namespace microstrain
+{
+
+/**
+ * Splits a stream of RTCM3 data into frames, validates them with CRC-24Q, and only keeps the message types in an allowlist.
+ * Frames may be split across, or packed into, any number of calls to process. Keeps byte statistics for each message type
+ */
+class RtcmFramer
+{
+ public:
+  static constexpr uint8_t PREAMBLE = 0xD3;
+  static constexpr size_t HEADER_SIZE = 3;
+  static constexpr size_t CRC_SIZE = 3;
+  static constexpr size_t MAX_PAYLOAD_SIZE = 1023;
+  static constexpr size_t NUM_MESSAGE_TYPES = 4096;
+
+  /**
+   * Counters for a single message type
+   */
+  struct TypeStatistics
+  {
+    uint64_t frames = 0;  /// Number of valid frames that were forwarded
+    uint64_t bytes = 0;  /// Number of bytes that were forwarded, including the header and CRC
+    uint64_t dropped_frames = 0;  /// Number of valid frames that were dropped because the type is not allowed
+    uint64_t dropped_bytes = 0;  /// Number of bytes that were dropped because the type is not allowed
+  };
+
+  /**
+   * \brief Default constructor. Allows every message type
+   */
+  RtcmFramer() = default;
+
+  /**
+   * \brief Sets the message types that will be forwarded
+   * \param message_types The message types to forward. If empty, every message type is forwarded
+   */
+  void setAllowedMessageTypes(const std::vector<uint16_t>& message_types);
+
+  /**
+   * \brief Adds data to the stream, and appends every complete, valid, and allowed frame to frames
+   * \param data The data to add
+   * \param size Number of bytes in data
+   * \param frames Vector to append the frames to
+   */
+  void process(const uint8_t* data, size_t size, std::vector<uint8_t>* frames);
+
+  /**
+   * \brief Formats the statistics as YAML
+   * \return The statistics of each message type that has been received, and the number of bytes that could not be framed
+   */
+  std::string toYaml() const;
+
+  /**
+   * \brief Clears the statistics. Does not affect partially received frames
+   */
+  void reset();
+
+  /**
+   * \brief Computes the CRC-24Q used by RTCM3
+   * \param data The data to compute the CRC of
+   * \param size Number of bytes in data
+   * \return The 24 bit CRC
+   */
+  static uint32_t crc24q(const uint8_t* data, size_t size);
+
+  /**
+   * \brief Builds the allowlist for the constellations enabled on the receiver
+   * \param glonass_enable Whether GLONASS is enabled
+   * \param galileo_enable Whether Galileo is enabled
+   * \param beidou_enable Whether BeiDou is enabled
+   * \return The station messages, and the observation and ephemeris messages of the enabled constellations. GPS is always enabled
+   */
+  static std::vector<uint16_t> defaultMessageTypes(bool glonass_enable, bool galileo_enable, bool beidou_enable);
+
+ private:
+  std::vector<uint8_t> buffer_;  /// Data that has been received but not yet framed
+  std::vector<bool> allowed_;  /// Whether each message type is allowed, or empty if every message type is allowed
+
+  mutable std::mutex statistics_mutex_;
+  std::map<uint16_t, TypeStatistics> type_statistics_;
+  uint64_t crc_failures_ = 0;  /// Number of frames that failed CRC validation
+  uint64_t discarded_bytes_ = 0;  /// Number of bytes skipped while looking for the start of a frame
+};
+
+}  // namespace microstrain
+
+#endif  // MICROSTRAIN_INERTIAL_DRIVER_COMMON_UTILS_RTCM_FRAMER_H
@@ -0,0 +1,88 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Parker-Lord Driver Definition File
+//
+// Copyright (c) 2017, Brian Bingham
+// Copyright (c) 2020, Parker Hannifin Corp
+//
+// This code is licensed under MIT license (see LICENSE file for details)
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef MICROSTRAIN_INERTIAL_DRIVER_COMMON_UTILS_TARGET_FRAME_TRANSFORM_H
+#define MICROSTRAIN_INERTIAL_DRIVER_COMMON_UTILS_TARGET_FRAME_TRANSFORM_H
+
+#include "microstrain_inertial_driver_common/utils/ros_compat.h"
+
+namespace microstrain
+{
+
+/**
+ * Re-expresses IMU and odometry messages in a rigidly attached target frame.
+ * The rotation and lever arm are computed once from the transform between the frames, so each message only needs a few
+ * small matrix multiplies instead of a TF lookup. Linear quantities are moved from the origin of the source frame to the
+ * origin of the target frame using the angular rate, and for acceleration, the angular acceleration
+ */
+class TargetFrameTransform
+{
+ public:
+  /**
+   * \brief Precomputes the rotation and lever arm between the frames
+   * \param frame_to_target_transform Transform that takes points in the source frame into the target frame
+   */
+  void set(const tf2::Transform& frame_to_target_transform);
+
+  /**
+   * \brief Forgets the transform, and the angular rate used to estimate angular acceleration
+   */
+  void reset();
+
+  /**
+   * \brief Checks if the transform has been set
+   * \return true if messages can be transformed
+   */
+  bool valid() const
+  {
+    return valid_;
+  }
+
+  /**
+   * \brief Transforms an IMU message into the target frame. The orientation is only transformed if the message contains one
+   * \param imu_msg The message in the source frame
+   * \param target_imu_msg The message to populate. The frame ID is not modified
+   */
+  void transformImu(const ImuMsg& imu_msg, ImuMsg* target_imu_msg);
+
+  /**
+   * \brief Transforms an odometry message so that the child frame is the target frame. The pose covariance is kept as is
+   * \param odometry_msg The message with the source frame as its child frame
+   * \param target_odometry_msg The message to populate. The frame IDs are not modified
+   */
+  void transformOdometry(const OdometryMsg& odometry_msg, OdometryMsg* target_odometry_msg) const;
+
+ private:
+  /**
+   * \brief Rotates a 3x3 block of a row major covariance matrix into the target frame
+   * \param covariance The covariance matrix to read the block from
+   * \param target_covariance The covariance matrix to write the rotated block to
+   * \param stride Number of elements in each row of the covariance matrices
+   * \param row Index of the first row of the block
+   * \param column Index of the first column of the block
+   */
+  void rotateCovariance(const double* covariance, double* target_covariance, size_t stride, size_t row, size_t column) const;
+
+  bool valid_ = false;  /// Whether the transform has been set
+
+  tf2::Matrix3x3 rotation_;  /// Rotates vectors from the source frame into the target frame
+  tf2::Quaternion target_to_frame_rotation_;  /// Rotation of the target frame relative to the source frame
+  tf2::Vector3 lever_arm_;  /// Position of the origin of the target frame in the source frame
+  bool has_lever_arm_ = false;  /// Whether the frames have different origins
+
+  bool has_previous_angular_velocity_ = false;  /// Whether the previous angular rate can be used to estimate angular acceleration
+  tf2::Vector3 previous_angular_velocity_;  /// Angular rate of the previous IMU message in the source frame
+  double previous_stamp_ = 0;  /// Stamp of the previous IMU message in seconds
+};
+
+}  // namespace microstrain
+
+#endif  // MICROSTRAIN_INERTIAL_DRIVER_COMMON_UTILS_TARGET_FRAME_TRANSFORM_H
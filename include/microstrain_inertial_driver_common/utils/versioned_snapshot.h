@@ -0,0 +1,148 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Parker-Lord Driver Definition File
+//
+// Copyright (c) 2017, Brian Bingham
+// Copyright (c) 2020, Parker Hannifin Corp
+//
+// This code is licensed under MIT license (see LICENSE file for details)
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef MICROSTRAIN_INERTIAL_DRIVER_COMMON_UTILS_VERSIONED_SNAPSHOT_H
+#define MICROSTRAIN_INERTIAL_DRIVER_COMMON_UTILS_VERSIONED_SNAPSHOT_H
+
+#include <array>
+#include <atomic>
+#include <thread>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+namespace microstrain
+{
+
+/**
+ * Holds a value that is written by one thread and read by others without locks, using a sequence lock.
+ * Readers copy the value and retry if a writer published a new version while they were copying, so they always see a consistent value.
+ * Writers are serialized with each other, and a new version becomes visible to readers all at once.
+ * The value is stored as atomic words, so there are no data races even while a reader is retrying.
+ * \tparam ValueType The type of value to hold. Must be trivially copyable
+ */
+template<typename ValueType>
+class VersionedSnapshot
+{
+  static_assert(std::is_trivially_copyable<ValueType>::value, "VersionedSnapshot can only hold trivially copyable types");
+
+ public:
+  /**
+   * \brief Constructs the snapshot holding a default constructed value
+   */
+  VersionedSnapshot()
+  {
+    store(ValueType());
+  }
+
+  /**
+   * \brief Constructs the snapshot holding a value
+   * \param value The initial value
+   */
+  explicit VersionedSnapshot(const ValueType& value)
+  {
+    store(value);
+  }
+
+  /**
+   * \brief Copies the current value of another snapshot as a new version. The other snapshot may be written to while it is copied
+   * \param other The snapshot to copy
+   */
+  VersionedSnapshot(const VersionedSnapshot& other)
+  {
+    store(other.load());
+  }
+  VersionedSnapshot& operator=(const VersionedSnapshot& other)
+  {
+    store(other.load());
+    return *this;
+  }
+
+  /**
+   * \brief Reads a consistent copy of the current value. Never blocks writers
+   * \param version Will be populated with the version of the value that was read if not null. Incremented every time a writer publishes
+   * \return A copy of the current value
+   */
+  ValueType load(uint64_t* version = nullptr) const
+  {
+    uint64_t words[NUM_WORDS];
+    uint64_t sequence;
+    while (true)
+    {
+      sequence = sequence_.load(std::memory_order_acquire);
+      if (sequence & 1)
+      {
+        std::this_thread::yield();
+        continue;
+      }
+      for (size_t i = 0; i < NUM_WORDS; i++)
+        words[i] = words_[i].load(std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_acquire);
+      if (sequence_.load(std::memory_order_relaxed) == sequence)
+        break;
+    }
+
+    if (version != nullptr)
+      *version = sequence / 2;
+    ValueType value;
+    memcpy(&value, words, sizeof(value));
+    return value;
+  }
+
+  /**
+   * \brief Replaces the value and publishes it as a new version
+   * \param value The new value
+   */
+  void store(const ValueType& value)
+  {
+    update([&value](ValueType* current) { *current = value; });
+  }
+
+  /**
+   * \brief Modifies the value and publishes the result as a new version. Other writers wait until this one is done
+   * \param modify Function that is given the current value to modify. Should be short, as readers spin while it runs
+   */
+  template<typename Modify>
+  void update(Modify modify)
+  {
+    // Take the write side by moving the sequence to an odd number
+    uint64_t sequence = sequence_.load(std::memory_order_relaxed);
+    while ((sequence & 1) || !sequence_.compare_exchange_weak(sequence, sequence + 1, std::memory_order_acquire, std::memory_order_relaxed))
+    {
+      std::this_thread::yield();
+      sequence = sequence_.load(std::memory_order_relaxed);
+    }
+    std::atomic_thread_fence(std::memory_order_release);
+
+    // Only writers change the words, so they can be read without checking the sequence here
+    uint64_t words[NUM_WORDS];
+    for (size_t i = 0; i < NUM_WORDS; i++)
+      words[i] = words_[i].load(std::memory_order_relaxed);
+    ValueType value;
+    memcpy(&value, words, sizeof(value));
+    modify(&value);
+    memcpy(words, &value, sizeof(value));
+    for (size_t i = 0; i < NUM_WORDS; i++)
+      words_[i].store(words[i], std::memory_order_relaxed);
+
+    sequence_.store(sequence + 2, std::memory_order_release);
+  }
+
+ private:
+  static constexpr size_t NUM_WORDS = (sizeof(ValueType) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+
+  std::atomic<uint64_t> sequence_ = {0};  /// Twice the version, plus one while a writer is publishing
+  std::array<std::atomic<uint64_t>, NUM_WORDS> words_ = {};  /// The value, split into words that can be copied atomically
+};
+
+}  // namespace microstrain
+
+#endif  // MICROSTRAIN_INERTIAL_DRIVER_COMMON_UTILS_VERSIONED_SNAPSHOT_H
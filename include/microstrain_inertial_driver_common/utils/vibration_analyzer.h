@@ -0,0 +1,143 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Parker-Lord Driver Definition File
+//
+// Copyright (c) 2017, Brian Bingham
+// Copyright (c) 2020, Parker Hannifin Corp
+//
+// This code is licensed under MIT license (see LICENSE file for details)
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef MICROSTRAIN_INERTIAL_DRIVER_COMMON_UTILS_VIBRATION_ANALYZER_H
+#define MICROSTRAIN_INERTIAL_DRIVER_COMMON_UTILS_VIBRATION_ANALYZER_H
+
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <complex>
+#include <cstddef>
+#include <condition_variable>
+
+#include "microstrain_inertial_driver_common/utils/realtime.h"
+
+namespace microstrain
+{
+
+/**
+ * Estimates the power spectral density of the accel and gyro axes using Welch's method.
+ * Samples are collected into overlapping segments on the caller's thread, and the FFTs are run on a low priority worker thread
+ * so that the analysis does not delay the processing of data from the device.
+ */
+class VibrationAnalyzer
+{
+ public:
+  // Order of the signals analyzed
+  static constexpr size_t SIGNAL_ACCEL = 0;  // x, y, z
+  static constexpr size_t SIGNAL_GYRO = 3;  // x, y, z
+  static constexpr size_t NUM_SIGNALS = 6;
+
+  /**
+   * \brief Constructor
+   * \param sample_rate Rate in hertz that samples will be added at
+   * \param window_size Number of samples in each segment. Must be a power of two
+   * \param overlap Fraction of each segment that is shared with the next segment. Must be in the range [0, 1)
+   * \param band_edges Ascending list of frequencies in hertz. Energy will be reported for each band between consecutive edges
+   */
+  VibrationAnalyzer(const double sample_rate, const size_t window_size, const double overlap, const std::vector<double>& band_edges);
+
+  /**
+   * \brief Destructor. Stops the worker thread
+   */
+  ~VibrationAnalyzer();
+
+  VibrationAnalyzer(const VibrationAnalyzer&) = delete;
+  VibrationAnalyzer& operator=(const VibrationAnalyzer&) = delete;
+
+  /**
+   * \brief Starts the worker thread that computes the spectra
+   */
+  void start();
+
+  /**
+   * \brief Stops the worker thread. Any segments that have not been processed are discarded
+   */
+  void stop();
+
+  /**
+   * \brief Adds a sample for three consecutive signals
+   * \param first_signal Either SIGNAL_ACCEL or SIGNAL_GYRO
+   * \param x The sample for the x axis
+   * \param y The sample for the y axis
+   * \param z The sample for the z axis
+   */
+  void add(const size_t first_signal, const double x, const double y, const double z);
+
+  /**
+   * \brief Gets the number of values reported for each signal in the summary
+   * \return The number of bands plus two for the peak frequency and peak power
+   */
+  size_t numColumns() const;
+
+  /**
+   * \brief Averages the spectra computed since the last summary, and starts a new average
+   * \param summary Will be resized to NUM_SIGNALS * numColumns() and filled with the energy in each band, followed by the peak frequency in hertz
+   *                and the power spectral density at the peak, ordered by signal. Signals without any complete segments will be NaN
+   */
+  void summarize(std::vector<double>* summary);
+
+ private:
+  /**
+   * \brief A segment of samples waiting to be processed by the worker thread
+   */
+  struct Segment
+  {
+    size_t signal;  /// Index of the signal the samples belong to
+    std::vector<double> samples;  /// Samples in the segment
+  };
+
+  /**
+   * \brief Runs on the worker thread, and computes the periodogram of each segment as it becomes available
+   */
+  void run();
+
+  /**
+   * \brief Computes the one sided periodogram of a segment, and adds it to the running sum for its signal
+   * \param segment The segment to process
+   */
+  void processSegment(const Segment& segment);
+
+  /**
+   * \brief In place iterative radix-2 FFT using the precomputed twiddle factors and bit reversal table
+   * \param data Data to transform. Must be window_size_ elements long
+   */
+  void fft(std::vector<std::complex<double>>* data) const;
+
+  double sample_rate_;  /// Rate in hertz that samples are added at
+  size_t window_size_;  /// Number of samples in each segment
+  size_t hop_size_;  /// Number of new samples required before the next segment is complete
+  std::vector<double> band_edges_;  /// Edges of the bands to report energy for
+
+  std::vector<double> window_;  /// Hann window applied to each segment
+  double window_power_;  /// Sum of the squares of the window, used to normalize the periodogram
+  std::vector<std::complex<double>> twiddles_;  /// Precomputed twiddle factors for the FFT
+  std::vector<size_t> bit_reversal_;  /// Precomputed bit reversed indices for the FFT
+
+  std::vector<std::vector<double>> pending_;  /// Samples collected for the next segment of each signal. Only accessed by the caller's thread
+
+  AuditedMutex queue_mutex_;  /// Protects queue_ and running_
+  std::condition_variable_any queue_condition_;  /// Notifies the worker thread when a segment is available or it should stop
+  std::deque<Segment> queue_;  /// Complete segments waiting to be processed
+  std::vector<std::vector<double>> free_samples_;  /// Sample buffers the worker is done with, reused so completing a segment does not allocate
+  bool running_ = false;  /// Whether or not the worker thread should keep running
+  std::thread worker_;  /// Worker thread computing the spectra
+
+  std::mutex psd_mutex_;  /// Protects psd_sum_ and psd_count_
+  std::vector<std::vector<double>> psd_sum_;  /// Sum of the periodograms computed for each signal since the last summary
+  std::vector<size_t> psd_count_;  /// Number of periodograms in psd_sum_ for each signal
+};
+
+}  // namespace microstrain
+
+#endif  // MICROSTRAIN_INERTIAL_DRIVER_COMMON_UTILS_VIBRATION_ANALYZER_H
@@ -0,0 +1,89 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Parker-Lord Driver Definition File
+//
+// Copyright (c) 2017, Brian Bingham
+// Copyright (c) 2020, Parker Hannifin Corp
+//
+// This code is licensed under MIT license (see LICENSE file for details)
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef MICROSTRAIN_INERTIAL_DRIVER_COMMON_UTILS_WINDOWED_STATISTICS_H
+#define MICROSTRAIN_INERTIAL_DRIVER_COMMON_UTILS_WINDOWED_STATISTICS_H
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+namespace microstrain
+{
+
+/**
+ * Accumulates min, max, mean, RMS and variance for a fixed set of signals over a window of samples.
+ * Each statistic is stored in its own contiguous array so that updating several signals at once touches sequential memory.
+ */
+class WindowedStatistics
+{
+ public:
+  // Order of the statistics for each signal in the summary
+  static constexpr size_t STATISTIC_MIN = 0;
+  static constexpr size_t STATISTIC_MAX = 1;
+  static constexpr size_t STATISTIC_MEAN = 2;
+  static constexpr size_t STATISTIC_RMS = 3;
+  static constexpr size_t STATISTIC_VARIANCE = 4;
+  static constexpr size_t NUM_STATISTICS = 5;
+
+  /**
+   * \brief Constructor
+   * \param num_signals Number of signals to accumulate statistics for. Samples for signals outside of this range are ignored,
+   *                    so a default constructed object can be used when statistics are not needed
+   */
+  explicit WindowedStatistics(const size_t num_signals = 0);
+
+  /**
+   * \brief Adds a sample for a single signal
+   * \param signal Index of the signal to add the sample to
+   * \param value The sample
+   */
+  void add(const size_t signal, const double value);
+
+  /**
+   * \brief Adds a sample for three consecutive signals, useful for the axes of a vector
+   * \param first_signal Index of the signal the x value belongs to. The y and z values will be added to the next two signals
+   * \param x The sample for the first signal
+   * \param y The sample for the second signal
+   * \param z The sample for the third signal
+   */
+  void add(const size_t first_signal, const double x, const double y, const double z);
+
+  /**
+   * \brief Gets the number of signals this object was configured with
+   * \return The number of signals
+   */
+  size_t numSignals() const;
+
+  /**
+   * \brief Computes the statistics for the current window, and starts a new window
+   * \param summary Will be resized to numSignals() * NUM_STATISTICS and filled with the statistics for each signal, ordered by signal.
+   *                Signals that did not receive any samples in the window will be NaN
+   */
+  void summarize(std::vector<double>* summary);
+
+  /**
+   * \brief Clears all accumulated samples
+   */
+  void reset();
+
+ private:
+  std::vector<uint64_t> count_;  /// Number of samples received for each signal in this window
+  std::vector<double> shift_;  /// First sample received for each signal. Subtracted from every sample to avoid cancellation when computing the variance
+  std::vector<double> min_;  /// Minimum sample for each signal
+  std::vector<double> max_;  /// Maximum sample for each signal
+  std::vector<double> sum_;  /// Sum of the shifted samples for each signal
+  std::vector<double> sum_squares_;  /// Sum of the squares of the shifted samples for each signal
+};
+
+}  // namespace microstrain
+
+#endif  // MICROSTRAIN_INERTIAL_DRIVER_COMMON_UTILS_WINDOWED_STATISTICS_H
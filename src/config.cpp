@@ -9,11 +9,15 @@
 /////////////////////////////////////////////////////////////////////////////////////////////////////
 
 #include <errno.h>
+#include <unistd.h>
 #include <tuple>
 #include <vector>
 #include <string>
 #include <memory>
+#include <thread>
+#include <utility>
 #include <algorithm>
+#include <functional>
 
 #include <GeographicLib/Geocentric.hpp>
 
@@ -29,6 +33,7 @@
 #include "mip/extras/recording_connection.hpp"
 
 #include "microstrain_inertial_driver_common/utils/mappings/mip_mapping.h"
+#include "microstrain_inertial_driver_common/utils/cdr_serializer.h"
 #include "microstrain_inertial_driver_common/config.h"
 
 namespace microstrain
@@ -37,8 +42,10 @@ namespace microstrain
 Config::Config(RosNodeType* node) : node_(node)
 {
   nmea_max_rate_hz_ = 0;
+  clock_ = std::make_shared<RosClock>(node_);
 
   // Initialize the transform buffer and listener ahead of time
+  MemoryTracker::Scope tf_memory_scope(MEMORY_TAG_TF);
   transform_buffer_ = createTransformBuffer(node_);
   transform_listener_ = createTransformListener(transform_buffer_);
 }
@@ -65,6 +72,11 @@ bool Config::configure(RosNodeType* node)
   getParam<bool>(node, "debug", debug_, false);
   getParam<bool>(node, "device_setup", device_setup_, true);
 
+  // Replay. Keep the virtual clock across reconfigures so time does not jump back to the start of the capture
+  getParam<std::string>(node, "replay_file", replay_file_, "");
+  if (!replay_file_.empty() && std::dynamic_pointer_cast<VirtualClock>(clock_) == nullptr)
+    clock_ = std::make_shared<VirtualClock>();
+
   // Reconnect
   getParam<int>(node, "reconnect_attempts", reconnect_attempts_, 0);
   getParam<bool>(node, "configure_after_reconnect", configure_after_reconnect_, true);
@@ -104,7 +116,7 @@ bool Config::configure(RosNodeType* node)
     return false;
   }
 
-  mount_to_frame_id_transform_.header.stamp = rosTimeNow(node);
+  mount_to_frame_id_transform_.header.stamp = clock_->rosNow();
   mount_to_frame_id_transform_.header.frame_id = mount_frame_id_;
   mount_to_frame_id_transform_.child_frame_id = frame_id_;
   mount_to_frame_id_transform_.transform.translation.x = mount_to_frame_id_transform_vec[0];
@@ -136,6 +148,48 @@ bool Config::configure(RosNodeType* node)
   getParam<bool>(node, "rtk_dongle_enable", rtk_dongle_enable_, true);
   getParam<bool>(node, "ntrip_interface_enable", ntrip_interface_enable_, false);
   rtk_dongle_enable_ = rtk_dongle_enable_ || ntrip_interface_enable_;  // If the NTRIP interface is enabled, we will enable the RTK interface
+  if (!replay_file_.empty() && ntrip_interface_enable_)
+  {
+    MICROSTRAIN_ERROR(node, "ntrip_interface_enable can not be used while replaying a timed capture, as only the main port is captured");
+    return false;
+  }
+  if (!BuildFeatures::RTK && ntrip_interface_enable_)
+  {
+    MICROSTRAIN_WARN(node_, "Ignoring ntrip_interface_enable as RTK support is not included in the %s build profile", BuildFeatures::PROFILE_NAME);
+    ntrip_interface_enable_ = false;
+  }
+
+  // RTCM filtering
+  getParam<bool>(node, "rtcm_filter_enable", rtcm_filter_enable_, false);
+  if (ntrip_interface_enable_ && rtcm_filter_enable_)
+  {
+    std::vector<uint16_t> rtcm_filter_message_types;
+    getUint16ArrayParam(node, "rtcm_filter_message_types", rtcm_filter_message_types, std::vector<uint16_t>());
+    if (rtcm_filter_message_types.empty())
+    {
+      // Only forward the messages the receiver will use with the constellations it is configured to track
+      bool gnss_glonass_enable, gnss_galileo_enable, gnss_beidou_enable;
+      getParam<bool>(node, "gnss_glonass_enable", gnss_glonass_enable, true);
+      getParam<bool>(node, "gnss_galileo_enable", gnss_galileo_enable, true);
+      getParam<bool>(node, "gnss_beidou_enable", gnss_beidou_enable, true);
+      rtcm_filter_message_types = RtcmFramer::defaultMessageTypes(gnss_glonass_enable, gnss_galileo_enable, gnss_beidou_enable);
+    }
+    for (const uint16_t message_type : rtcm_filter_message_types)
+    {
+      if (message_type >= RtcmFramer::NUM_MESSAGE_TYPES)
+      {
+        MICROSTRAIN_ERROR(node_, "Invalid RTCM message type %u in rtcm_filter_message_types. Message types must be less than %lu", message_type, RtcmFramer::NUM_MESSAGE_TYPES);
+        return false;
+      }
+    }
+    if (rtcm_framer_ == nullptr)
+      rtcm_framer_ = std::make_shared<RtcmFramer>();
+    rtcm_framer_->setAllowedMessageTypes(rtcm_filter_message_types);
+  }
+  else
+  {
+    rtcm_framer_ = nullptr;
+  }
 
   // FILTER
   std::vector<double> filter_speed_lever_arm_double(3, 0.0);
@@ -158,6 +212,7 @@ bool Config::configure(RosNodeType* node)
   getParam<int>(node, "filter_speed_lever_arm_source", filter_speed_lever_arm_source_, OFFSET_SOURCE_MANUAL);
   getParam<std::vector<double>>(node, "filter_speed_lever_arm", filter_speed_lever_arm_double, DEFAULT_VECTOR);
   filter_speed_lever_arm_ = std::vector<float>(filter_speed_lever_arm_double.begin(), filter_speed_lever_arm_double.end());
+  getParam<double>(node, "lever_arm_transform_timeout", lever_arm_transform_timeout_, 0.0);
 
   // Subscribers
   getParam<bool>(node, "subscribe_ext_time", subscribe_ext_time_, false);
@@ -170,10 +225,218 @@ bool Config::configure(RosNodeType* node)
   getParam<bool>(node, "subscribe_ext_heading_enu", subscribe_ext_heading_enu_, false);
   getParam<bool>(node, "subscribe_ext_mag", subscribe_ext_mag_, false);
   getParam<bool>(node, "subscribe_ext_pressure", subscribe_ext_pressure_, false);
+  if (!BuildFeatures::AIDING && (subscribe_ext_time_ || subscribe_ext_fix_ || subscribe_ext_vel_ned_ || subscribe_ext_vel_enu_ || subscribe_ext_vel_ecef_ || subscribe_ext_vel_body_ ||
+      subscribe_ext_heading_ned_ || subscribe_ext_heading_enu_ || subscribe_ext_mag_ || subscribe_ext_pressure_))
+    MICROSTRAIN_WARN(node_, "Ignoring the subscribe_ext_* parameters as external aiding is not included in the %s build profile", BuildFeatures::PROFILE_NAME);
+
+  // Aiding callback benchmark
+  getParam<bool>(node, "aiding_callback_benchmark_enable", aiding_callback_benchmark_enable_, false);
+  getParam<std::vector<double>>(node, "aiding_callback_benchmark_rates", aiding_callback_benchmark_rates_, {1, 5, 10, 25, 50, 100});
+  getParam<double>(node, "aiding_callback_benchmark_step_duration", aiding_callback_benchmark_step_duration_, 10.0);
+  getParam<double>(node, "aiding_callback_benchmark_ack_latency", aiding_callback_benchmark_ack_latency_, 5.0);
+  if (aiding_callback_benchmark_enable_ && !BuildFeatures::AIDING)
+  {
+    MICROSTRAIN_WARN(node_, "Ignoring aiding_callback_benchmark_enable as external aiding is not included in the %s build profile", BuildFeatures::PROFILE_NAME);
+  }
+  else if (aiding_callback_benchmark_enable_)
+  {
+    if (aiding_callback_benchmark_step_duration_ <= 0 || aiding_callback_benchmark_ack_latency_ < 0)
+    {
+      MICROSTRAIN_ERROR(node_, "aiding_callback_benchmark_step_duration must be greater than 0, and aiding_callback_benchmark_ack_latency must not be negative");
+      return false;
+    }
+    if (aiding_callback_benchmark_ == nullptr)
+    {
+      aiding_callback_benchmark_ = std::make_shared<AidingCallbackBenchmark>(aiding_callback_benchmark_rates_, aiding_callback_benchmark_step_duration_);
+      aiding_callback_benchmark_device_ = std::make_shared<EmulatedAidingDevice>(aiding_callback_benchmark_ack_latency_ / 1000.0);
+    }
+  }
+
+  // Aiding health
+  AidingHealthTracker::Policy aiding_health_policy;
+  int32_t aiding_health_window, aiding_health_probe_count;
+  getParam<bool>(node, "aiding_health_enable", aiding_health_enable_, false);
+  getParam<int32_t>(node, "aiding_health_window", aiding_health_window, 20);
+  getParam<double>(node, "aiding_health_pause_threshold", aiding_health_policy.pause_threshold, 0.2);
+  getParam<double>(node, "aiding_health_resume_threshold", aiding_health_policy.resume_threshold, 0.5);
+  getParam<double>(node, "aiding_health_pause_duration", aiding_health_policy.pause_duration, 1.0);
+  getParam<double>(node, "aiding_health_max_pause_duration", aiding_health_policy.max_pause_duration, 30.0);
+  getParam<int32_t>(node, "aiding_health_probe_count", aiding_health_probe_count, 5);
+  if (aiding_health_enable_ && BuildFeatures::AIDING)
+  {
+    if (aiding_health_window <= 0 || aiding_health_probe_count <= 0 || aiding_health_policy.pause_duration <= 0 || aiding_health_policy.max_pause_duration < aiding_health_policy.pause_duration)
+    {
+      MICROSTRAIN_ERROR(node_, "aiding_health_window, aiding_health_probe_count and aiding_health_pause_duration must be greater than 0, and aiding_health_max_pause_duration must not be less than aiding_health_pause_duration");
+      return false;
+    }
+    aiding_health_policy.window = aiding_health_window;
+    aiding_health_policy.probe_count = aiding_health_probe_count;
+    if (aiding_health_ == nullptr)
+    {
+      // The tracker is shared by every copy of this config object, so only hold on to the node
+      RosNodeType* logger_node = node_;
+      aiding_health_ = std::make_shared<AidingHealthTracker>(aiding_health_policy, clock_, [logger_node](const std::string& message)
+      {
+        MICROSTRAIN_INFO(logger_node, "%s", message.c_str());
+      });
+    }
+  }
 
   // NMEA streaming
   getParam<bool>(node, "nmea_message_allow_duplicate_talker_ids", nmea_message_allow_duplicate_talker_ids_, false);
 
+  // Host NMEA generation
+  int32_t gnss1_nmea_talker_id, gnss2_nmea_talker_id, filter_nmea_talker_id;
+  getParam<int32_t>(node, "gnss1_nmea_talker_id", gnss1_nmea_talker_id, 1);
+  getParam<int32_t>(node, "gnss2_nmea_talker_id", gnss2_nmea_talker_id, 2);
+  getParam<int32_t>(node, "filter_nmea_talker_id", filter_nmea_talker_id, 3);
+  gnss_host_nmea_talker_id_[GNSS1_ID] = MipMapping::nmeaFormatTalkerIdString(static_cast<mip::commands_3dm::NmeaMessage::TalkerID>(gnss1_nmea_talker_id));
+  gnss_host_nmea_talker_id_[GNSS2_ID] = MipMapping::nmeaFormatTalkerIdString(static_cast<mip::commands_3dm::NmeaMessage::TalkerID>(gnss2_nmea_talker_id));
+  filter_host_nmea_talker_id_ = MipMapping::nmeaFormatTalkerIdString(static_cast<mip::commands_3dm::NmeaMessage::TalkerID>(filter_nmea_talker_id));
+  getParamFloat(node, "gnss1_host_nmea_gga_data_rate", gnss_host_nmea_gga_data_rate_[GNSS1_ID], 0);
+  getParamFloat(node, "gnss1_host_nmea_rmc_data_rate", gnss_host_nmea_rmc_data_rate_[GNSS1_ID], 0);
+  getParamFloat(node, "gnss1_host_nmea_vtg_data_rate", gnss_host_nmea_vtg_data_rate_[GNSS1_ID], 0);
+  getParamFloat(node, "gnss2_host_nmea_gga_data_rate", gnss_host_nmea_gga_data_rate_[GNSS2_ID], 0);
+  getParamFloat(node, "gnss2_host_nmea_rmc_data_rate", gnss_host_nmea_rmc_data_rate_[GNSS2_ID], 0);
+  getParamFloat(node, "gnss2_host_nmea_vtg_data_rate", gnss_host_nmea_vtg_data_rate_[GNSS2_ID], 0);
+  getParamFloat(node, "filter_host_nmea_gga_data_rate", filter_host_nmea_gga_data_rate_, 0);
+  getParamFloat(node, "filter_host_nmea_rmc_data_rate", filter_host_nmea_rmc_data_rate_, 0);
+  getParamFloat(node, "filter_host_nmea_vtg_data_rate", filter_host_nmea_vtg_data_rate_, 0);
+  getParam<bool>(node, "host_nmea_aux_port_gga", host_nmea_aux_port_gga_, false);
+
+  // Windowed signal statistics
+  getParam<bool>(node, "signal_statistics_enable", signal_statistics_enable_, false);
+  getParam<double>(node, "signal_statistics_window", signal_statistics_window_, 1.0);
+
+  // Vibration spectrum analysis
+  getParam<bool>(node, "vibration_analysis_enable", vibration_analysis_enable_, false);
+  getParam<int32_t>(node, "vibration_analysis_window_size", vibration_analysis_window_size_, 256);
+  getParam<double>(node, "vibration_analysis_overlap", vibration_analysis_overlap_, 0.5);
+  getParam<std::vector<double>>(node, "vibration_analysis_band_edges", vibration_analysis_band_edges_, {0.0, 10.0, 50.0, 100.0, 200.0});
+  getParam<double>(node, "vibration_analysis_publish_rate", vibration_analysis_publish_rate_, 1.0);
+
+  // Allan variance
+  getParam<bool>(node, "allan_variance_enable", allan_variance_enable_, false);
+  getParam<int32_t>(node, "allan_variance_num_octaves", allan_variance_num_octaves_, 24);
+  if (allan_variance_enable_)
+  {
+    if (allan_variance_num_octaves_ < 1 || allan_variance_num_octaves_ > 48)
+    {
+      MICROSTRAIN_ERROR(node_, "Invalid allan_variance_num_octaves %d. The number of octaves must be between 1 and 48", allan_variance_num_octaves_);
+      return false;
+    }
+    allan_variance_ = std::make_shared<AllanVariance>(allan_variance_num_octaves_);
+  }
+
+  // Magnetometer calibration
+  int32_t mag_calibration_min_samples;
+  MagCalibrator::Thresholds mag_calibration_thresholds;
+  getParam<bool>(node, "mag_calibration_enable", mag_calibration_enable_, false);
+  getParam<bool>(node, "mag_calibration_dry_run", mag_calibration_dry_run_, false);
+  getParam<bool>(node, "mag_calibration_auto_write", mag_calibration_auto_write_, false);
+  getParam<bool>(node, "mag_calibration_save", mag_calibration_save_, false);
+  getParam<int32_t>(node, "mag_calibration_min_samples", mag_calibration_min_samples, 500);
+  getParam<double>(node, "mag_calibration_min_coverage", mag_calibration_thresholds.min_coverage, 0.6);
+  getParam<double>(node, "mag_calibration_max_fit_error", mag_calibration_thresholds.max_fit_error, 0.02);
+  if (mag_calibration_enable_)
+  {
+    if (mag_calibration_min_samples < 9 || mag_calibration_thresholds.min_coverage < 0 || mag_calibration_thresholds.min_coverage > 1 || mag_calibration_thresholds.max_fit_error <= 0)
+    {
+      MICROSTRAIN_ERROR(node_, "Invalid mag calibration thresholds. mag_calibration_min_samples must be at least 9, mag_calibration_min_coverage must be between 0 and 1, and mag_calibration_max_fit_error must be greater than 0");
+      return false;
+    }
+    mag_calibration_thresholds.min_samples = mag_calibration_min_samples;
+    mag_calibrator_ = std::make_shared<MagCalibrator>(mag_calibration_thresholds);
+  }
+
+  // Real time
+  getParam<bool>(node, "rt_enable", rt_enable_, false);
+  getParam<bool>(node, "rt_lock_memory", rt_lock_memory_, true);
+  getParam<int32_t>(node, "rt_prefault_stack_size", rt_prefault_stack_size_, 524288);
+  getParam<int32_t>(node, "rt_prefault_heap_size", rt_prefault_heap_size_, 16777216);
+  getParam<std::string>(node, "rt_scheduling_policy", rt_scheduling_policy_, RT_SCHEDULING_POLICY_FIFO);
+  getParam<int32_t>(node, "rt_priority", rt_priority_, 80);
+  getParam<bool>(node, "rt_audit", rt_audit_, false);
+  if (rt_enable_ && (rt_prefault_stack_size_ < 0 || static_cast<size_t>(rt_prefault_stack_size_) > Realtime::maxPrefaultStackSize()))
+  {
+    MICROSTRAIN_ERROR(node_, "rt_prefault_stack_size must be between 0 and %lu bytes, the stack size limit of the process less room for the frames already on the stack",
+      static_cast<unsigned long>(Realtime::maxPrefaultStackSize()));
+    return false;
+  }
+  if (rt_enable_ && rt_prefault_heap_size_ < 0)
+  {
+    MICROSTRAIN_ERROR(node_, "rt_prefault_heap_size must not be negative");
+    return false;
+  }
+
+  // Performance counters
+  getParam<bool>(node, "perf_counters_enable", perf_counters_enable_, false);
+  if (perf_counters_enable_ && perf_profiler_ == nullptr)
+    perf_profiler_ = std::make_shared<PerfProfiler>();
+
+  // Memory tracking
+  getParam<bool>(node, "memory_tracking_enable", memory_tracking_enable_, false);
+  getParam<double>(node, "memory_tracking_publish_rate", memory_tracking_publish_rate_, 1.0);
+
+  // GNSS integrity
+  getParam<bool>(node, "gnss_integrity_enable", gnss_integrity_enable_, false);
+  getParam<int32_t>(node, "gnss_integrity_upgrade_count", gnss_integrity_upgrade_count_, 5);
+  getParam<int32_t>(node, "gnss_integrity_degrade_count", gnss_integrity_degrade_count_, 1);
+  getParam<double>(node, "gnss_integrity_corrections_stale_age", gnss_integrity_corrections_stale_age_, 5.0);
+  getParam<double>(node, "gnss_integrity_heartbeat_period", gnss_integrity_heartbeat_period_, 1.0);
+
+  // Publisher pooling
+  getParam<int32_t>(node, "publisher_pool_size", publisher_pool_size_, 0);
+  if (publisher_pool_size_ < 0)
+  {
+    MICROSTRAIN_ERROR(node_, "Invalid publisher_pool_size %d. The pool size must not be negative", publisher_pool_size_);
+    return false;
+  }
+
+  // Direct serialization
+  getParam<bool>(node, "direct_cdr_serialization", direct_cdr_serialization_, false);
+  if (direct_cdr_serialization_ && !cdrSerializationSupported(node_))
+  {
+    MICROSTRAIN_WARN(node_, "direct_cdr_serialization is only supported on ROS2 when intra process communication is disabled. Messages will be serialized by the middleware");
+    direct_cdr_serialization_ = false;
+  }
+
+  // Early publishing
+  getParam<bool>(node, "early_publish_enable", early_publish_enable_, false);
+
+  // Target frame variants
+  getParam<bool>(node, "target_frame_variants_enable", target_frame_variants_enable_, false);
+
+  // Handoff
+  getParam<bool>(node, "handoff_enable", handoff_enable_, false);
+  getParam<std::string>(node, "handoff_socket", handoff_socket_, "/tmp/microstrain_inertial_driver_handoff.sock");
+  getParam<int32_t>(node, "handoff_timeout", handoff_timeout_, 1000);
+
+  // Proxy
+  getParam<bool>(node, "proxy_enable", proxy_enable_, false);
+  getParam<std::string>(node, "proxy_socket", proxy_socket_, "/tmp/microstrain_inertial_driver_proxy.sock");
+  getParam<int32_t>(node, "proxy_buffer_size", proxy_buffer_size_, 1048576);
+  getParam<bool>(node, "proxy_commands_enable", proxy_commands_enable_, false);
+  getParam<int32_t>(node, "proxy_command_timeout", proxy_command_timeout_, 1000);
+  if (proxy_buffer_size_ <= 0)
+  {
+    MICROSTRAIN_ERROR(node_, "proxy_buffer_size must be greater than 0");
+    return false;
+  }
+
+  // De-jitter
+  getParam<std::vector<std::string>>(node, "dejitter_topics", dejitter_topics_, {});
+  getParam<double>(node, "dejitter_delay", dejitter_delay_, 0.02);
+  if (!dejitter_topics_.empty() && dejitter_delay_ <= 0)
+  {
+    MICROSTRAIN_ERROR(node_, "dejitter_delay must be greater than 0");
+    return false;
+  }
+  for (auto& topic : dejitter_topics_)
+    if (!topic.empty() && topic.front() == '/')
+      topic.erase(0, 1);
+  dejitter_statistics_.clear();
+
   // Raw data file save
   getParam<bool>(node, "raw_file_enable", raw_file_enable_, false);
   getParam<bool>(node, "raw_file_include_support_data", raw_file_include_support_data_, false);
@@ -185,6 +448,9 @@ bool Config::configure(RosNodeType* node)
   // Log the driver version if it was built properly
   MICROSTRAIN_INFO(node_, "Running microstrain_inertial_driver version: %s", MICROSTRAIN_DRIVER_VERSION);
 
+  // Log the build profile, as it determines which devices and features are supported
+  MICROSTRAIN_INFO(node_, "Built with the %s profile", BuildFeatures::PROFILE_NAME);
+
   // Log the MIP SDK version
   MICROSTRAIN_INFO(node_, "Using MIP SDK version: %s", MIP_SDK_VERSION_FULL);
 
@@ -208,26 +474,90 @@ bool Config::configure(RosNodeType* node)
 
 bool Config::connectDevice(RosNodeType* node)
 {
+  // If another driver is running, take over its ports instead of opening them
+  handoff_resumed_ = false;
+  receiveHandoffState();
+
   // Open the device interface
-  mip_device_ = std::make_shared<RosMipDeviceMain>(node_);
-  if (!mip_device_->configure(node))
+  mip_device_ = std::make_shared<RosMipDeviceMain>(node_, clock_);
+  if (handoff_state_ != nullptr)
+  {
+    if (!mip_device_->adopt(node, *handoff_state_))
+      return false;
+  }
+  else if (!mip_device_->configure(node))
+  {
     return false;
+  }
+
+  // Mirror the main port to anyone connected to the proxy
+  if (proxy_enable_)
+  {
+    if (byte_proxy_ == nullptr)
+    {
+      std::string error;
+      byte_proxy_ = std::make_shared<ByteProxy>(proxy_buffer_size_, proxy_commands_enable_, proxy_command_timeout_);
+      if (!byte_proxy_->start(proxy_socket_, &error))
+      {
+        MICROSTRAIN_ERROR(node_, "Failed to start the proxy on %s: %s", proxy_socket_.c_str(), error.c_str());
+        byte_proxy_.reset();
+        return false;
+      }
+      MICROSTRAIN_INFO(node_, "Mirroring the main port to clients of %s", proxy_socket_.c_str());
+    }
+    mip_device_->connection()->proxy(byte_proxy_);
+  }
 
   // Connect the aux port
   if (ntrip_interface_enable_)
   {
-    aux_device_ = std::make_shared<RosMipDeviceAux>(node_);
-    if (!aux_device_->configure(node))
+    aux_device_ = std::make_shared<RosMipDeviceAux>(node_, clock_);
+    if (handoff_state_ != nullptr && handoff_state_->aux_fd >= 0)
+    {
+      if (!aux_device_->adopt(node, handoff_state_->aux_fd, mip_device_->device_info_))
+      {
+        MICROSTRAIN_ERROR(node_, "Failed to use aux port handed off by the previous driver");
+        return false;
+      }
+    }
+    else if (!aux_device_->configure(node))
     {
       MICROSTRAIN_ERROR(node_, "Failed to open aux port");
       return false;
     }
     aux_device_->connection()->shouldParseNmea(ntrip_interface_enable_);
   }
+  else if (handoff_state_ != nullptr && handoff_state_->aux_fd >= 0)
+  {
+    close(handoff_state_->aux_fd);
+  }
+
+  // The connections own the ports now
+  if (handoff_state_ != nullptr)
+    handoff_state_->main_fd = handoff_state_->aux_fd = -1;
 
   return true;
 }
 
+void Config::receiveHandoffState()
+{
+  if (!handoff_enable_ || handoff_attempted_)
+    return;
+  handoff_attempted_ = true;
+
+  std::string error;
+  const auto start = std::chrono::steady_clock::now();
+  auto state = std::make_shared<HandoffState>();
+  if (!receiveHandoff(handoff_socket_, handoff_timeout_, state.get(), &error))
+  {
+    MICROSTRAIN_INFO(node_, "Not taking over from a running driver: %s", error.c_str());
+    return;
+  }
+  const auto elapsed_ms = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+  MICROSTRAIN_INFO(node_, "Took over the ports of the running driver in %ld ms", static_cast<long>(elapsed_ms));
+  handoff_state_ = state;
+}
+
 bool Config::setupDevice(RosNodeType* node)
 {
   // Read the config used by this section
@@ -241,9 +571,34 @@ bool Config::setupDevice(RosNodeType* node)
   // Configure the device to stream data using the topic mapping
   MICROSTRAIN_DEBUG(node_, "Setting up data streams");
   mip_publisher_mapping_ = std::make_shared<MipPublisherMapping>(node_, mip_device_);
-  if (!mip_publisher_mapping_->configure(node))
+  if (!mip_publisher_mapping_->configure(node, handoff_state_ == nullptr))
     return false;
 
+  // If we took over from a running driver, the device is already streaming. Only leave it alone if we were started with the same configuration,
+  // as that covers every setting the previous driver applied to the device, not just the data streams
+  config_hash_ = hashHandoffConfig(getParamsText(node));
+  if (handoff_state_ != nullptr)
+  {
+    const bool same_streams = mip_publisher_mapping_->streamHash() == handoff_state_->stream_hash;
+    const bool same_config = config_hash_ == handoff_state_->config_hash;
+    if (same_streams && same_config)
+    {
+      MICROSTRAIN_INFO(node_, "Configuration matches the previous driver, so the device will be left as it was configured");
+      handoff_resumed_ = true;
+    }
+    else
+    {
+      MICROSTRAIN_WARN(node_, "%s from the previous driver, so the device will be reconfigured", same_config ? "Data streams differ" : "Configuration differs");
+      if (!(mip_cmd_result = mip_device_->forceIdle()))
+      {
+        MICROSTRAIN_MIP_SDK_ERROR(node_, mip_cmd_result, "Unable to set device to idle");
+        return false;
+      }
+      if (!mip_publisher_mapping_->writeMessageFormats())
+        return false;
+    }
+  }
+
   // If the device has no way of obtaining a global position, disable global transform mode
   if (tf_mode_ == TF_MODE_GLOBAL && !mip_device_->supportsDescriptor(mip::data_filter::DESCRIPTOR_SET, mip::data_filter::EcefPos::FIELD_DESCRIPTOR) && !mip_device_->supportsDescriptor(mip::data_filter::DESCRIPTOR_SET, mip::data_filter::PositionLlh::FIELD_DESCRIPTOR))
   {
@@ -252,14 +607,19 @@ bool Config::setupDevice(RosNodeType* node)
   }
 
   // Send commands to the device to configure it
-  if (device_setup_)
+  if (device_setup_ && !handoff_resumed_)
   {
     MICROSTRAIN_DEBUG(node_, "Configuring device");
+    requestLeverArmTransforms();
     if (!configureBase(node) ||
         !configure3DM(node) ||
         !configureGNSS(node) ||
-        !configureFilter(node))
+        !configureFilter(node) ||
+        !configureLeverArms(node))
+    {
+      cancelLeverArmTransforms();
       return false;
+    }
 
     // Save the settings to the device, if enabled
     if (save_settings)
@@ -806,74 +1166,6 @@ bool Config::configureFilter(RosNodeType* node)
     MICROSTRAIN_INFO(node_, "Note: Device does not support the declination source command.");
   }
 
-  // If either antenna offset is configured with the transform selector, lookup the transform in the tf tree
-  for (int i = 0; i < NUM_GNSS; i++)
-  {
-    if (gnss_antenna_offset_source_[i] == OFFSET_SOURCE_TRANSFORM)
-    {
-      // Override the antenna offset with the result from the transform tree
-      const tf2::Transform& gnss_antenna_to_microstrain_vehicle_transform_tf = lookupLeverArmOffsetInMicrostrainVehicleFrame(gnss_frame_id_[i]);
-      gnss_antenna_offset_[i][0] = gnss_antenna_to_microstrain_vehicle_transform_tf.getOrigin().x();
-      gnss_antenna_offset_[i][1] = gnss_antenna_to_microstrain_vehicle_transform_tf.getOrigin().y();
-      gnss_antenna_offset_[i][2] = gnss_antenna_to_microstrain_vehicle_transform_tf.getOrigin().z();
-    }
-  }
-
-  // GNSS 1/2 antenna offsets
-  if (mip_device_->supportsDescriptor(descriptor_set, mip::commands_filter::CMD_ANTENNA_OFFSET))
-  {
-    if (gnss_antenna_offset_source_[GNSS1_ID] != OFFSET_SOURCE_OFF)
-    {
-      MICROSTRAIN_INFO(node_, "Setting single antenna offset to [%f, %f, %f]",
-          gnss_antenna_offset_[GNSS1_ID][0], gnss_antenna_offset_[GNSS1_ID][1], gnss_antenna_offset_[GNSS1_ID][2]);
-      if (!(mip_cmd_result = mip::commands_filter::writeAntennaOffset(*mip_device_, gnss_antenna_offset_[GNSS1_ID].data())))
-      {
-        MICROSTRAIN_MIP_SDK_ERROR(node_, mip_cmd_result, "Cound not set single antenna offset");
-        return false;
-      }
-    }
-    else
-    {
-      MICROSTRAIN_INFO(node_, "Not configuring single antenna offset because gnss1_antenna_offset_source is %d", OFFSET_SOURCE_OFF);
-    }
-  }
-  else if (mip_device_->supportsDescriptor(descriptor_set, mip::commands_filter::CMD_MULTI_ANTENNA_OFFSET))
-  {
-    if (gnss_antenna_offset_source_[GNSS1_ID] != OFFSET_SOURCE_OFF)
-    {
-      MICROSTRAIN_INFO(node_, "Setting GNSS1 antenna offset to [%f, %f, %f]",
-          gnss_antenna_offset_[GNSS1_ID][0], gnss_antenna_offset_[GNSS1_ID][1], gnss_antenna_offset_[GNSS1_ID][2]);
-      if (!(mip_cmd_result = mip::commands_filter::writeMultiAntennaOffset(*mip_device_, GNSS1_ID + 1, gnss_antenna_offset_[GNSS1_ID].data())))
-      {
-        MICROSTRAIN_MIP_SDK_ERROR(node_, mip_cmd_result, "Could not set multi antenna offset for GNSS1");
-        return false;
-      }
-    }
-    else
-    {
-      MICROSTRAIN_INFO(node_, "Not configuring GNSS1 antenna offset because gnss1_antenna_offset_source is %d", OFFSET_SOURCE_OFF);
-    }
-
-    if (gnss_antenna_offset_source_[GNSS2_ID] != OFFSET_SOURCE_OFF)
-    {
-      MICROSTRAIN_INFO(node_, "Setting GNSS2 antenna offset to [%f, %f, %f]",
-          gnss_antenna_offset_[GNSS2_ID][0], gnss_antenna_offset_[GNSS2_ID][1], gnss_antenna_offset_[GNSS2_ID][2]);
-      if (!(mip_cmd_result = mip::commands_filter::writeMultiAntennaOffset(*mip_device_, GNSS2_ID + 1, gnss_antenna_offset_[GNSS2_ID].data())))
-      {
-        MICROSTRAIN_MIP_SDK_ERROR(node_, mip_cmd_result, "Could not set multi antenna offset for GNSS2");
-        return false;
-      }
-    }
-    else
-    {
-      MICROSTRAIN_INFO(node_, "Not configuring GNSS2 antenna offset because gnss2_antenna_offset_source is %d", OFFSET_SOURCE_OFF);
-    }
-  }
-  else
-  {
-    MICROSTRAIN_INFO(node_, "Note: Device does not support GNSS antenna offsets");
-  }
-
   // Set dynamics mode
   if (mip_device_->supportsDescriptor(descriptor_set, mip::commands_filter::CMD_VEHICLE_DYNAMICS_MODE))
   {
@@ -980,31 +1272,6 @@ bool Config::configureFilter(RosNodeType* node)
     MICROSTRAIN_INFO(node_, "Note: The device does not support the filter aiding command.");
   }
 
-  // Set the filter speed lever arm
-  if (mip_device_->supportsDescriptor(descriptor_set, mip::commands_filter::CMD_SPEED_LEVER_ARM))
-  {
-    if (filter_speed_lever_arm_source_ == OFFSET_SOURCE_TRANSFORM)
-    {
-      const auto& odometer_to_microstrain_vehicle_transform_tf = lookupLeverArmOffsetInMicrostrainVehicleFrame(odometer_frame_id_);
-      filter_speed_lever_arm_[0] = odometer_to_microstrain_vehicle_transform_tf.getOrigin().x();
-      filter_speed_lever_arm_[1] = odometer_to_microstrain_vehicle_transform_tf.getOrigin().y();
-      filter_speed_lever_arm_[2] = odometer_to_microstrain_vehicle_transform_tf.getOrigin().z();
-    }
-    if (filter_speed_lever_arm_source_ != OFFSET_SOURCE_OFF)
-    {
-      MICROSTRAIN_INFO(node_, "Setting speed lever arm to: [%f, %f, %f]", filter_speed_lever_arm_[0], filter_speed_lever_arm_[1], filter_speed_lever_arm_[2]);
-      if (!(mip_cmd_result = mip::commands_filter::writeSpeedLeverArm(*mip_device_, 1, filter_speed_lever_arm_.data())))
-      {
-        MICROSTRAIN_MIP_SDK_ERROR(node_, mip_cmd_result, "Failed to configure speed lever arm");
-        return false;
-      }
-    }
-  }
-  else
-  {
-    MICROSTRAIN_INFO(node_, "Note: The device does not support the filter speed lever arm command.");
-  }
-
   // Set the wheeled vehicle constraint
   if (mip_device_->supportsDescriptor(descriptor_set, mip::commands_filter::CMD_VEHICLE_CONSTRAINT_CONTROL))
   {
@@ -1213,6 +1480,228 @@ bool Config::configureFilter(RosNodeType* node)
   return true;
 }
 
+bool Config::configureLeverArms(RosNodeType* node)
+{
+  mip::CmdResult mip_cmd_result;
+  const uint8_t descriptor_set = mip::commands_filter::DESCRIPTOR_SET;
+
+  // Each lever arm that should be written to the device, along with the frame ID we need from the tf tree before writing it (empty if no transform is needed)
+  std::vector<std::pair<std::string, std::function<bool()>>> pending_lever_arms;
+
+  // GNSS 1/2 antenna offsets
+  if (mip_device_->supportsDescriptor(descriptor_set, mip::commands_filter::CMD_ANTENNA_OFFSET))
+  {
+    if (gnss_antenna_offset_source_[GNSS1_ID] != OFFSET_SOURCE_OFF)
+    {
+      const std::string target_frame_id = gnss_antenna_offset_source_[GNSS1_ID] == OFFSET_SOURCE_TRANSFORM ? gnss_frame_id_[GNSS1_ID] : "";
+      pending_lever_arms.emplace_back(target_frame_id, [this, target_frame_id, &mip_cmd_result]()
+      {
+        // Override the antenna offset with the result from the transform tree
+        if (!target_frame_id.empty())
+        {
+          const tf2::Transform& gnss_antenna_to_microstrain_vehicle_transform_tf = lookupLeverArmOffsetInMicrostrainVehicleFrame(target_frame_id);
+          gnss_antenna_offset_[GNSS1_ID][0] = gnss_antenna_to_microstrain_vehicle_transform_tf.getOrigin().x();
+          gnss_antenna_offset_[GNSS1_ID][1] = gnss_antenna_to_microstrain_vehicle_transform_tf.getOrigin().y();
+          gnss_antenna_offset_[GNSS1_ID][2] = gnss_antenna_to_microstrain_vehicle_transform_tf.getOrigin().z();
+        }
+
+        MICROSTRAIN_INFO(node_, "Setting single antenna offset to [%f, %f, %f]",
+            gnss_antenna_offset_[GNSS1_ID][0], gnss_antenna_offset_[GNSS1_ID][1], gnss_antenna_offset_[GNSS1_ID][2]);
+        if (!(mip_cmd_result = mip::commands_filter::writeAntennaOffset(*mip_device_, gnss_antenna_offset_[GNSS1_ID].data())))
+        {
+          MICROSTRAIN_MIP_SDK_ERROR(node_, mip_cmd_result, "Cound not set single antenna offset");
+          return false;
+        }
+        return true;
+      });
+    }
+    else
+    {
+      MICROSTRAIN_INFO(node_, "Not configuring single antenna offset because gnss1_antenna_offset_source is %d", OFFSET_SOURCE_OFF);
+    }
+  }
+  else if (mip_device_->supportsDescriptor(descriptor_set, mip::commands_filter::CMD_MULTI_ANTENNA_OFFSET))
+  {
+    for (int i = 0; i < NUM_GNSS; i++)
+    {
+      if (gnss_antenna_offset_source_[i] != OFFSET_SOURCE_OFF)
+      {
+        const std::string target_frame_id = gnss_antenna_offset_source_[i] == OFFSET_SOURCE_TRANSFORM ? gnss_frame_id_[i] : "";
+        pending_lever_arms.emplace_back(target_frame_id, [this, i, target_frame_id, &mip_cmd_result]()
+        {
+          // Override the antenna offset with the result from the transform tree
+          if (!target_frame_id.empty())
+          {
+            const tf2::Transform& gnss_antenna_to_microstrain_vehicle_transform_tf = lookupLeverArmOffsetInMicrostrainVehicleFrame(target_frame_id);
+            gnss_antenna_offset_[i][0] = gnss_antenna_to_microstrain_vehicle_transform_tf.getOrigin().x();
+            gnss_antenna_offset_[i][1] = gnss_antenna_to_microstrain_vehicle_transform_tf.getOrigin().y();
+            gnss_antenna_offset_[i][2] = gnss_antenna_to_microstrain_vehicle_transform_tf.getOrigin().z();
+          }
+
+          MICROSTRAIN_INFO(node_, "Setting GNSS%d antenna offset to [%f, %f, %f]",
+              i + 1, gnss_antenna_offset_[i][0], gnss_antenna_offset_[i][1], gnss_antenna_offset_[i][2]);
+          if (!(mip_cmd_result = mip::commands_filter::writeMultiAntennaOffset(*mip_device_, i + 1, gnss_antenna_offset_[i].data())))
+          {
+            MICROSTRAIN_ERROR(node_, "Could not set multi antenna offset for GNSS%d", i + 1);
+            MICROSTRAIN_MIP_SDK_ERROR(node_, mip_cmd_result, "Failed to write multi antenna offset");
+            return false;
+          }
+          return true;
+        });
+      }
+      else
+      {
+        MICROSTRAIN_INFO(node_, "Not configuring GNSS%d antenna offset because gnss%d_antenna_offset_source is %d", i + 1, i + 1, OFFSET_SOURCE_OFF);
+      }
+    }
+  }
+  else
+  {
+    MICROSTRAIN_INFO(node_, "Note: Device does not support GNSS antenna offsets");
+  }
+
+  // Set the filter speed lever arm
+  if (mip_device_->supportsDescriptor(descriptor_set, mip::commands_filter::CMD_SPEED_LEVER_ARM))
+  {
+    if (filter_speed_lever_arm_source_ != OFFSET_SOURCE_OFF)
+    {
+      const std::string target_frame_id = filter_speed_lever_arm_source_ == OFFSET_SOURCE_TRANSFORM ? odometer_frame_id_ : "";
+      pending_lever_arms.emplace_back(target_frame_id, [this, target_frame_id, &mip_cmd_result]()
+      {
+        if (!target_frame_id.empty())
+        {
+          const auto& odometer_to_microstrain_vehicle_transform_tf = lookupLeverArmOffsetInMicrostrainVehicleFrame(target_frame_id);
+          filter_speed_lever_arm_[0] = odometer_to_microstrain_vehicle_transform_tf.getOrigin().x();
+          filter_speed_lever_arm_[1] = odometer_to_microstrain_vehicle_transform_tf.getOrigin().y();
+          filter_speed_lever_arm_[2] = odometer_to_microstrain_vehicle_transform_tf.getOrigin().z();
+        }
+
+        MICROSTRAIN_INFO(node_, "Setting speed lever arm to: [%f, %f, %f]", filter_speed_lever_arm_[0], filter_speed_lever_arm_[1], filter_speed_lever_arm_[2]);
+        if (!(mip_cmd_result = mip::commands_filter::writeSpeedLeverArm(*mip_device_, 1, filter_speed_lever_arm_.data())))
+        {
+          MICROSTRAIN_MIP_SDK_ERROR(node_, mip_cmd_result, "Failed to configure speed lever arm");
+          return false;
+        }
+        return true;
+      });
+    }
+  }
+  else
+  {
+    MICROSTRAIN_INFO(node_, "Note: The device does not support the filter speed lever arm command.");
+  }
+
+  // Write the lever arms in the order that their transforms become available. The transforms were requested before the rest of the configuration started, so most of the time they will all be ready
+  while (!pending_lever_arms.empty())
+  {
+    for (auto pending_lever_arm_iter = pending_lever_arms.begin(); pending_lever_arm_iter != pending_lever_arms.end();)
+    {
+      const std::string& target_frame_id = pending_lever_arm_iter->first;
+      if (!target_frame_id.empty())
+      {
+        const auto& transform_future_iter = lever_arm_transform_futures_.find(target_frame_id);
+        if (transform_future_iter == lever_arm_transform_futures_.end())
+        {
+          MICROSTRAIN_ERROR(node_, "Transform from %s to %s was never requested", frame_id_.c_str(), target_frame_id.c_str());
+          return false;
+        }
+        if (transform_future_iter->second.wait_for(std::chrono::milliseconds(0)) != std::future_status::ready)
+        {
+          ++pending_lever_arm_iter;
+          continue;
+        }
+        if (!transform_future_iter->second.get())
+        {
+          MICROSTRAIN_ERROR(node_, "Unable to configure lever arm for %s because the transform to %s was not found", target_frame_id.c_str(), frame_id_.c_str());
+          return false;
+        }
+      }
+
+      if (!pending_lever_arm_iter->second())
+        return false;
+      pending_lever_arm_iter = pending_lever_arms.erase(pending_lever_arm_iter);
+    }
+
+    if (!pending_lever_arms.empty())
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+
+  // Any remaining requests are no longer needed
+  cancelLeverArmTransforms();
+  return true;
+}
+
+void Config::requestLeverArmTransforms()
+{
+  // Every request shares the same deadline and cancellation flag
+  const auto deadline = std::chrono::steady_clock::now() + std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(lever_arm_transform_timeout_));
+  lever_arm_transforms_cancelled_ = std::make_shared<std::atomic<bool>>(false);
+
+  // Only request the frames that configureLeverArms will actually wait for
+  const uint8_t descriptor_set = mip::commands_filter::DESCRIPTOR_SET;
+  std::vector<std::string> target_frame_ids;
+  if (mip_device_->supportsDescriptor(descriptor_set, mip::commands_filter::CMD_ANTENNA_OFFSET))
+  {
+    if (gnss_antenna_offset_source_[GNSS1_ID] == OFFSET_SOURCE_TRANSFORM)
+      target_frame_ids.push_back(gnss_frame_id_[GNSS1_ID]);
+  }
+  else if (mip_device_->supportsDescriptor(descriptor_set, mip::commands_filter::CMD_MULTI_ANTENNA_OFFSET))
+  {
+    for (int i = 0; i < NUM_GNSS; i++)
+      if (gnss_antenna_offset_source_[i] == OFFSET_SOURCE_TRANSFORM)
+        target_frame_ids.push_back(gnss_frame_id_[i]);
+  }
+  if (mip_device_->supportsDescriptor(descriptor_set, mip::commands_filter::CMD_SPEED_LEVER_ARM) && filter_speed_lever_arm_source_ == OFFSET_SOURCE_TRANSFORM)
+    target_frame_ids.push_back(odometer_frame_id_);
+
+  // Start waiting for all of the transforms at once
+  for (const std::string& target_frame_id : target_frame_ids)
+  {
+    if (lever_arm_transform_futures_.find(target_frame_id) != lever_arm_transform_futures_.end())
+      continue;
+
+    MICROSTRAIN_DEBUG(node_, "Requesting transform from %s to %s", frame_id_.c_str(), target_frame_id.c_str());
+    lever_arm_transform_futures_[target_frame_id] = std::async(std::launch::async, &Config::waitForLeverArmTransform, this, target_frame_id, deadline, lever_arm_transforms_cancelled_).share();
+  }
+}
+
+void Config::cancelLeverArmTransforms()
+{
+  if (lever_arm_transforms_cancelled_ != nullptr)
+    *lever_arm_transforms_cancelled_ = true;
+  for (const auto& lever_arm_transform_future : lever_arm_transform_futures_)
+    lever_arm_transform_future.second.wait();
+  lever_arm_transform_futures_.clear();
+}
+
+bool Config::waitForLeverArmTransform(const std::string& target_frame_id, const std::chrono::steady_clock::time_point& deadline, std::shared_ptr<std::atomic<bool>> cancelled)
+{
+  // Wait in short increments so that we can stop when cancelled, timed out, or shutdown
+  std::string tf_error_string;
+  RosTimeType frame_time; setRosTime(&frame_time, 0, 0);
+  constexpr int32_t seconds_between_warnings = 2;
+  auto next_warning_time = std::chrono::steady_clock::now() + std::chrono::seconds(seconds_between_warnings);
+  while (!transform_buffer_->canTransform(frame_id_, target_frame_id, frame_time, RosDurationType(0, 100000000), &tf_error_string))
+  {
+    if (!rosOk() || *cancelled)
+      return false;
+
+    const auto now = std::chrono::steady_clock::now();
+    if (lever_arm_transform_timeout_ > 0 && now >= deadline)
+    {
+      MICROSTRAIN_ERROR(node_, "Timed out after %f seconds waiting for transform from %s to %s, tf error: %s", lever_arm_transform_timeout_, frame_id_.c_str(), target_frame_id.c_str(), tf_error_string.c_str());
+      return false;
+    }
+    if (now >= next_warning_time)
+    {
+      MICROSTRAIN_WARN(node_, "Timed out waiting for transform from %s to %s, tf error: %s", frame_id_.c_str(), target_frame_id.c_str(), tf_error_string.c_str());
+      next_warning_time = now + std::chrono::seconds(seconds_between_warnings);
+    }
+  }
+  MICROSTRAIN_DEBUG(node_, "Found transform from %s to %s", frame_id_.c_str(), target_frame_id.c_str());
+  return true;
+}
+
 bool Config::configureFilterAidingMeasurement(const mip::commands_filter::AidingMeasurementEnable::AidingSource aiding_source, const bool enable)
 {
   // Find the name of the aiding measurement so we can log some info about it
@@ -1365,14 +1854,8 @@ bool Config::populateNmeaMessageFormat(RosNodeType* config_node, const std::stri
 
 tf2::Transform Config::lookupLeverArmOffsetInMicrostrainVehicleFrame(const std::string& target_frame_id)
 {
-  // Wait until we can find the transform for the requested frame id
-  std::string tf_error_string;
+  // The transform was already waited for by waitForLeverArmTransform, so we can look it up directly
   RosTimeType frame_time; setRosTime(&frame_time, 0, 0);
-  constexpr int32_t seconds_to_wait = 2;
-  while (!transform_buffer_->canTransform(frame_id_, target_frame_id, frame_time, RosDurationType(seconds_to_wait, 0), &tf_error_string) && rosOk())
-  {
-    MICROSTRAIN_WARN(node_, "Timed out waiting for transform from %s to %s, tf error: %s", frame_id_.c_str(), target_frame_id.c_str(), tf_error_string.c_str());
-  }
 
   // If not using the enu frame, this can be plugged directly into the device, otherwise rotate it from the ROS body frame to our body frame
   tf2::Transform target_frame_to_microstrain_vehicle_frame_transform_tf;
@@ -22,6 +22,8 @@ constexpr auto NMEA_MAX_LENGTH = 82;
 
 void logCallbackProxy(void* user, mip_log_level level, const char* fmt, va_list args)
 {
+  MemoryTracker::Scope memory_scope(MEMORY_TAG_LOGGING);
+
   // Convert the varargs into a string
   std::string log_str;
   va_list args_copy;
@@ -44,8 +46,47 @@ void logCallbackProxy(void* user, mip_log_level level, const char* fmt, va_list
 
 void NodeCommon::parseAndPublishMain()
 {
+  configureRealtimeThread(&main_thread_realtime_configured_, "main");
+
+  // Once the ports belong to another driver we must not read from them
+  if (handed_off_)
+    return;
+  if (handoff_server_ != nullptr && handoff_server_->pending() && handOff())
+    return;
+
+  // Counters only measure the thread that opens them, so open them from the thread that parses the main port
+  if (config_.perf_profiler_ != nullptr && !perf_profiler_open_attempted_)
+  {
+    perf_profiler_open_attempted_ = true;
+    std::string error;
+    if (!config_.perf_profiler_->open(&error))
+      MICROSTRAIN_ERROR(node_, "Failed to open performance counters: %s", error.c_str());
+  }
+
   // This should receive all packets, populate ROS messages and publish them as well
-  if (!config_.mip_device_->device().update())
+  // When replaying, keep reading instead of waiting for the next tick, but stop after a second of the capture so the other timers still get to run
+  bool updated;
+  const auto replay_connection = config_.mip_device_->connection();
+  const bool replaying = !config_.replay_file_.empty() && replay_connection != nullptr;
+  {
+    RealtimeAudit::Scope hot_path;
+    MemoryTracker::Scope memory_scope(MEMORY_TAG_PUBLISHERS);
+    if (config_.perf_profiler_ != nullptr)
+      config_.perf_profiler_->begin(PerfProfiler::STAGE_UPDATE);
+    const double replay_tick_end = config_.clock_->now() + 1.0;
+    do
+    {
+      updated = config_.mip_device_->device().update();
+    } while (updated && replaying && !replay_connection->replayFinished() && config_.clock_->now() < replay_tick_end);
+    if (config_.perf_profiler_ != nullptr)
+      config_.perf_profiler_->end(PerfProfiler::STAGE_UPDATE);
+  }
+  if (replaying && replay_connection->replayFinished() && !replay_finished_logged_)
+  {
+    replay_finished_logged_ = true;
+    MICROSTRAIN_INFO(node_, "Finished replaying timed capture <%s>", config_.replay_file_.c_str());
+  }
+  if (!updated)
   {
     MICROSTRAIN_ERROR(node_, "Unable to update device");
 
@@ -78,7 +119,7 @@ void NodeCommon::parseAndPublishMain()
       }
 
       // Wait between attempts
-      std::this_thread::sleep_for(std::chrono::seconds(5));
+      config_.clock_->sleepFor(5.0);
     }
 
     if (!reconnected)
@@ -87,9 +128,29 @@ void NodeCommon::parseAndPublishMain()
     }
   }
 
+  // Fit the magnetometer data regularly, as directions only count towards the coverage once a fit has found the hard iron offset,
+  // and write the calibration once it is good enough if asked to. Fitting is too slow to do after every packet, so only fit once a second
+  if (config_.mag_calibrator_ != nullptr)
+  {
+    const double now = config_.clock_->now();
+    if (now - mag_calibration_last_check_ >= 1.0)
+    {
+      mag_calibration_last_check_ = now;
+      const MagCalibrator::Result result = config_.mag_calibrator_->fit();
+      if (config_.mag_calibration_auto_write_ && !mag_calibration_auto_written_ && config_.mag_calibrator_->meetsThresholds(result))
+      {
+        std::string message;
+        mag_calibration_auto_written_ = true;
+        if (!services_.writeMagCalibration(result, false, &message))
+          MICROSTRAIN_ERROR(node_, "Failed to automatically write the magnetometer calibration: %s", message.c_str());
+      }
+    }
+  }
+
   // Publish the NMEA messages
+  RealtimeAudit::Scope hot_path;
   const auto connection = config_.mip_device_->connection();
-  if (connection != nullptr)
+  if (BuildFeatures::NMEA && connection != nullptr)
   {
     if (connection->shouldParseNmea())
     {
@@ -105,16 +166,23 @@ void NodeCommon::parseAndPublishMain()
       }
     }
   }
+  reportRealtimeViolations("main");
 }
 
 void NodeCommon::parseAndPublishAux()
 {
+  configureRealtimeThread(&aux_thread_realtime_configured_, "aux");
+  if (handed_off_)
+    return;
+  RealtimeAudit::Scope hot_path;
+  MemoryTracker::Scope memory_scope(MEMORY_TAG_PUBLISHERS);
+
   // This should receive all packets and populate NMEA messages
   config_.aux_device_->device().update();
 
   // Publish the NMEA messages
   const auto connection = config_.aux_device_->connection();
-  if (connection != nullptr)
+  if (BuildFeatures::NMEA && connection != nullptr)
   {
     if (connection->shouldParseNmea())
     {
@@ -126,6 +194,7 @@ void NodeCommon::parseAndPublishAux()
       }
     }
   }
+  reportRealtimeViolations("aux");
 }
 
 void NodeCommon::logCallback(const mip_log_level level, const std::string& log_str)
@@ -189,6 +258,13 @@ bool NodeCommon::configure(RosNodeType* config_node)
     return false;
   }
 
+  // Continue from where the previous driver left off. The state is only needed once
+  if (config_.handoff_state_ != nullptr)
+  {
+    publishers_.restoreHandoffState(*config_.handoff_state_);
+    config_.handoff_state_.reset();
+  }
+
   // Determine loop rate as 2*(max update rate), but abs. max of 1kHz
   const int max_rate = std::max({config_.nmea_max_rate_hz_, config_.mip_publisher_mapping_->getMaxDataRate()});
   timer_update_rate_hz_ = std::min(2 * max_rate, 2000);
@@ -199,9 +275,57 @@ bool NodeCommon::configure(RosNodeType* config_node)
   // Save the config node for later
   config_node_ = config_node;
 
+  // Lock and prefault memory now that everything that allocates at startup has been created
+  if (config_.rt_enable_)
+  {
+    std::string error;
+    if (config_.rt_lock_memory_ && !Realtime::lockMemory(&error))
+    {
+      MICROSTRAIN_ERROR(node_, "Failed to lock memory: %s", error.c_str());
+      return false;
+    }
+    Realtime::prefaultStack(config_.rt_prefault_stack_size_);
+    Realtime::prefaultHeap(config_.rt_prefault_heap_size_);
+    MICROSTRAIN_INFO(node_, "Real time mode enabled");
+  }
+  if (config_.rt_audit_ && !RealtimeAudit::supported())
+    MICROSTRAIN_WARN(node_, "rt_audit is enabled, but the driver was not built with MICROSTRAIN_RT_AUDIT. Allocations will not be reported");
+  else if (config_.rt_audit_)
+    MICROSTRAIN_INFO(node_, "Auditing allocations made with %s on the hot path. Memory from any other allocation function, or from mmap, is not reported", RealtimeAudit::auditedFunctions());
+
   return true;
 }
 
+void NodeCommon::configureRealtimeThread(bool* configured, const std::string& name)
+{
+  if (*configured || !config_.rt_enable_)
+    return;
+  *configured = true;
+
+  // The scheduling is applied to whichever thread the ROS timer runs this port on, so it has to be done from the thread itself
+  std::string error;
+  if (!Realtime::setThreadScheduling(config_.rt_scheduling_policy_, config_.rt_priority_, &error))
+    MICROSTRAIN_ERROR(node_, "Failed to apply real time scheduling to the %s port thread: %s", name.c_str(), error.c_str());
+  else
+    MICROSTRAIN_INFO(node_, "Applied '%s' scheduling with priority %d to the %s port thread", config_.rt_scheduling_policy_.c_str(), config_.rt_priority_, name.c_str());
+  Realtime::prefaultStack(config_.rt_prefault_stack_size_);
+}
+
+void NodeCommon::reportRealtimeViolations(const std::string& name)
+{
+  if (!config_.rt_audit_)
+    return;
+
+  std::string call_site;
+  const uint64_t violations = RealtimeAudit::takeViolations(&call_site);
+  if (violations > 0)
+    MICROSTRAIN_WARN_THROTTLE(node_, 1, "%lu allocations with %s on the %s port hot path. First allocation made from:%s", static_cast<unsigned long>(violations), RealtimeAudit::auditedFunctions(), name.c_str(), call_site.c_str());
+
+  const uint64_t contentions = RealtimeAudit::takeContentions();
+  if (contentions > 0)
+    MICROSTRAIN_WARN_THROTTLE(node_, 1, "%lu contended locks on the %s port hot path", static_cast<unsigned long>(contentions), name.c_str());
+}
+
 bool NodeCommon::activate()
 {
   if (!node_)
@@ -223,14 +347,43 @@ bool NodeCommon::activate()
     return false;
   }
 
-  // Resume the device
+  // Resume the device, unless the previous driver left it streaming
   mip::CmdResult mip_cmd_result;
-  MICROSTRAIN_INFO(node_, "Resuming the device data streams");
-  if (!(mip_cmd_result = mip::commands_base::resume(*(config_.mip_device_))))
+  if (config_.handoff_resumed_)
   {
-    MICROSTRAIN_ERROR(node_, "Failed to resume device data streams");
-    MICROSTRAIN_ERROR(node_, "Error(%d): %s", mip_cmd_result.value, mip_cmd_result.name());
-    return false;
+    MICROSTRAIN_INFO(node_, "Device data streams were left running by the previous driver");
+  }
+  else
+  {
+    MICROSTRAIN_INFO(node_, "Resuming the device data streams");
+    if (!(mip_cmd_result = mip::commands_base::resume(*(config_.mip_device_))))
+    {
+      MICROSTRAIN_ERROR(node_, "Failed to resume device data streams");
+      MICROSTRAIN_ERROR(node_, "Error(%d): %s", mip_cmd_result.value, mip_cmd_result.name());
+      return false;
+    }
+  }
+
+  // Now that we are streaming, let a replacement driver take over from us
+  if (config_.handoff_enable_ && handoff_server_ == nullptr)
+  {
+    std::string error;
+    handoff_server_ = std::unique_ptr<HandoffServer>(new HandoffServer());
+    if (!handoff_server_->listen(config_.handoff_socket_, &error))
+    {
+      MICROSTRAIN_ERROR(node_, "Failed to listen for a replacement driver on %s: %s", config_.handoff_socket_.c_str(), error.c_str());
+      handoff_server_.reset();
+    }
+  }
+
+  // Start sending aiding measurements now that the subscribers are set up
+  if (config_.aiding_callback_benchmark_ != nullptr)
+  {
+    MICROSTRAIN_INFO(node_, "Starting the aiding callback benchmark");
+    config_.aiding_callback_benchmark_->start([this](const std::string& summary)
+    {
+      MICROSTRAIN_INFO(node_, "Aiding callback benchmark %s", summary.c_str());
+    });
   }
 
   MICROSTRAIN_INFO(node_, "Node activated");
@@ -245,6 +398,10 @@ bool NodeCommon::deactivate()
   if (aux_parsing_timer_ != nullptr)
     stopTimer(aux_parsing_timer_);
 
+  // The device belongs to the replacement driver, so leave it streaming
+  if (handed_off_)
+    return true;
+
   // Set the device to idle
   mip::CmdResult mip_cmd_result;
   MICROSTRAIN_INFO(node_, "Forcing the device to idle");
@@ -260,12 +417,59 @@ bool NodeCommon::deactivate()
   return true;
 }
 
+bool NodeCommon::handOff()
+{
+  HandoffState state;
+  state.main_fd = config_.mip_device_->connection()->fd();
+  if (config_.aux_device_ != nullptr && config_.aux_device_->connection() != nullptr)
+    state.aux_fd = config_.aux_device_->connection()->fd();
+  if (state.main_fd < 0)
+  {
+    MICROSTRAIN_ERROR(node_, "A replacement driver connected, but the main port was not opened with handoff_enable, so it can not be handed off");
+    handoff_server_.reset();
+    return false;
+  }
+  state.stream_hash = config_.mip_publisher_mapping_->streamHash();
+  state.config_hash = config_.config_hash_;
+  config_.mip_device_->saveHandoffState(&state);
+  publishers_.saveHandoffState(&state);
+
+  std::string error;
+  if (!handoff_server_->send(state, config_.handoff_timeout_, &error))
+  {
+    MICROSTRAIN_ERROR(node_, "Failed to hand off to the replacement driver: %s", error.c_str());
+    return false;
+  }
+
+  // Close our copies of the ports. The replacement driver has its own, so the device is not affected
+  MICROSTRAIN_INFO(node_, "Handed off the device to the replacement driver. Shutting down");
+  handed_off_ = true;
+  if (main_parsing_timer_ != nullptr)
+    stopTimer(main_parsing_timer_);
+  if (aux_parsing_timer_ != nullptr)
+    stopTimer(aux_parsing_timer_);
+  config_.mip_device_->disconnect();
+  if (config_.aux_device_ != nullptr)
+    config_.aux_device_->disconnect();
+  handoff_server_.reset();
+  requestShutdown();
+  return true;
+}
+
 bool NodeCommon::shutdown()
 {
   // Reset the timers
   main_parsing_timer_.reset();
   aux_parsing_timer_.reset();
 
+  // Report the performance counters one last time
+  if (config_.perf_profiler_ != nullptr)
+    MICROSTRAIN_INFO(node_, "Performance counters:\n%s", config_.perf_profiler_->toYaml().c_str());
+
+  // The benchmark calls into the subscribers and the device, so it has to stop before either goes away
+  if (config_.aiding_callback_benchmark_ != nullptr)
+    config_.aiding_callback_benchmark_->stop();
+
   // Disconnect the device
   if (config_.mip_device_)
     config_.mip_device_.reset();
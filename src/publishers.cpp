@@ -10,6 +10,7 @@
 
 #include <string>
 #include <algorithm>
+#include <iterator>
 
 #include "microstrain_inertial_driver_common/publishers.h"
 #include "microstrain_inertial_driver_common/utils/geo_utils.h"
@@ -68,6 +69,16 @@ void setRotationCovarianceOnCovariance(PoseWithCovarianceStampedMsg::_pose_type:
   (*covariance)[35] = rotation_covariance[8];
 }
 
+// Order of the signals summarized on the statistics topic
+constexpr size_t STATISTICS_ACCEL = 0;  // x, y, z
+constexpr size_t STATISTICS_GYRO = 3;  // x, y, z
+constexpr size_t STATISTICS_MAG = 6;  // x, y, z
+constexpr size_t STATISTICS_FILTER_POSITION_UNCERTAINTY = 9;  // north, east, down
+constexpr size_t STATISTICS_FILTER_VELOCITY_UNCERTAINTY = 12;  // north, east, down
+constexpr size_t STATISTICS_FILTER_ATTITUDE_UNCERTAINTY = 15;  // roll, pitch, yaw
+constexpr size_t STATISTICS_TEMPERATURE = 18;
+constexpr size_t NUM_STATISTICS_SIGNALS = 19;
+
 constexpr double gpsTimestampSecs(const mip::data_shared::GpsTimestamp& gps_timestamp)
 {
   return gps_timestamp.week_number * 604800 + gps_timestamp.tow;
@@ -77,12 +88,16 @@ Publishers::Publishers(RosNodeType* node, Config* config)
   : node_(node), config_(config)
 {
   // Initialize the transform buffer and listener ahead of time
+  MemoryTracker::Scope tf_memory_scope(MEMORY_TAG_TF);
   transform_buffer_ = createTransformBuffer(node_);
   transform_listener_ = createTransformListener(transform_buffer_);
 }
 
 bool Publishers::configure()
 {
+  philo_device_ = BuildFeatures::PHILO && RosMipDevice::isPhilo(config_->mip_device_->device_info_);
+  prospect_device_ = RosMipDevice::isProspect(config_->mip_device_->device_info_);
+
   imu_raw_pub_->configure(node_, config_);
   imu_pub_->configure(node_, config_);
   mag_pub_->configure(node_, config_);
@@ -129,9 +144,183 @@ bool Publishers::configure()
 
   const bool will_publish_nmea = (config_->mip_device_->connection() != nullptr && config_->mip_device_->connection()->shouldParseNmea()) ||
                                  (config_->aux_device_ != nullptr && config_->aux_device_->connection() != nullptr && config_->aux_device_->connection()->shouldParseNmea());
-  if (will_publish_nmea)
+
+  // Host NMEA generation. The talker IDs are shared with the device NMEA configuration
+  for (int i = 0; i < NUM_GNSS; i++)
+    gnss_nmea_generator_[i] = NmeaGenerator(config_->gnss_host_nmea_talker_id_[i], config_->gnss_host_nmea_gga_data_rate_[i], config_->gnss_host_nmea_rmc_data_rate_[i], config_->gnss_host_nmea_vtg_data_rate_[i]);
+  filter_nmea_generator_ = NmeaGenerator(config_->filter_host_nmea_talker_id_, config_->filter_host_nmea_gga_data_rate_, config_->filter_host_nmea_rmc_data_rate_, config_->filter_host_nmea_vtg_data_rate_);
+
+  // The talker ID is only used by a generator that will generate sentences, so it is not checked otherwise
+  const NmeaGenerator* generators[] = {&gnss_nmea_generator_[GNSS1_ID], &gnss_nmea_generator_[GNSS2_ID], &filter_nmea_generator_};
+  const std::string* talker_ids[] = {&config_->gnss_host_nmea_talker_id_[GNSS1_ID], &config_->gnss_host_nmea_talker_id_[GNSS2_ID], &config_->filter_host_nmea_talker_id_};
+  const char* talker_id_params[] = {"gnss1_nmea_talker_id", "gnss2_nmea_talker_id", "filter_nmea_talker_id"};
+  for (size_t i = 0; i < sizeof(generators) / sizeof(generators[0]); i++)
+  {
+    if (generators[i]->enabled() && talker_ids[i]->size() != 2)
+    {
+      MICROSTRAIN_ERROR(node_, "Invalid NMEA talker ID %s. Check the %s param", talker_ids[i]->c_str(), talker_id_params[i]);
+      return false;
+    }
+  }
+  const bool will_generate_nmea = gnss_nmea_generator_[GNSS1_ID].enabled() || gnss_nmea_generator_[GNSS2_ID].enabled() || filter_nmea_generator_.enabled();
+  if (config_->host_nmea_aux_port_gga_ && config_->aux_device_ == nullptr)
+    MICROSTRAIN_WARN(node_, "host_nmea_aux_port_gga is enabled, but the aux port is not open. Set ntrip_interface_enable to true to write GGA sentences to the aux port");
+
+  if (will_publish_nmea || will_generate_nmea)
     nmea_sentence_pub_->configure(node_);
 
+  // Windowed signal statistics. The layout is fixed, so it is only set up once
+  if (config_->signal_statistics_enable_)
+  {
+    if (config_->signal_statistics_window_ <= 0)
+    {
+      MICROSTRAIN_ERROR(node_, "Invalid signal_statistics_window %f. The window must be greater than 0 seconds", config_->signal_statistics_window_);
+      return false;
+    }
+    signal_statistics_ = WindowedStatistics(NUM_STATISTICS_SIGNALS);
+    signal_statistics_window_start_ = -1;
+    signal_statistics_pub_->configure(node_);
+
+    auto signal_statistics_msg = signal_statistics_pub_->getMessage();
+    signal_statistics_msg->layout.dim.resize(2);
+    signal_statistics_msg->layout.dim[0].label = "signal";
+    signal_statistics_msg->layout.dim[0].size = NUM_STATISTICS_SIGNALS;
+    signal_statistics_msg->layout.dim[0].stride = NUM_STATISTICS_SIGNALS * WindowedStatistics::NUM_STATISTICS;
+    signal_statistics_msg->layout.dim[1].label = "statistic";
+    signal_statistics_msg->layout.dim[1].size = WindowedStatistics::NUM_STATISTICS;
+    signal_statistics_msg->layout.dim[1].stride = WindowedStatistics::NUM_STATISTICS;
+    signal_statistics_msg->layout.data_offset = 0;
+  }
+
+  // Vibration spectrum analysis. Uses the same data as the raw IMU topic, so that must be streamed
+  if (config_->vibration_analysis_enable_)
+  {
+    const float sample_rate = imu_raw_pub_->dataRate();
+    const size_t window_size = config_->vibration_analysis_window_size_;
+    const std::vector<double>& band_edges = config_->vibration_analysis_band_edges_;
+    if (!imu_raw_pub_->configured() || sample_rate <= 0)
+    {
+      MICROSTRAIN_ERROR(node_, "vibration_analysis_enable is true, but %s is not being streamed. Set imu_data_raw_rate to a non-zero value", IMU_DATA_RAW_TOPIC);
+      return false;
+    }
+    if (config_->vibration_analysis_window_size_ < 16 || (window_size & (window_size - 1)) != 0)
+    {
+      MICROSTRAIN_ERROR(node_, "Invalid vibration_analysis_window_size %d. The window size must be a power of two and at least 16", config_->vibration_analysis_window_size_);
+      return false;
+    }
+    if (config_->vibration_analysis_overlap_ < 0 || config_->vibration_analysis_overlap_ >= 1)
+    {
+      MICROSTRAIN_ERROR(node_, "Invalid vibration_analysis_overlap %f. The overlap must be in the range [0, 1)", config_->vibration_analysis_overlap_);
+      return false;
+    }
+    if (band_edges.size() < 2 || !std::is_sorted(band_edges.begin(), band_edges.end()))
+    {
+      MICROSTRAIN_ERROR(node_, "Invalid vibration_analysis_band_edges. At least two ascending frequencies are required");
+      return false;
+    }
+    if (config_->vibration_analysis_publish_rate_ <= 0)
+    {
+      MICROSTRAIN_ERROR(node_, "Invalid vibration_analysis_publish_rate %f. The rate must be greater than 0", config_->vibration_analysis_publish_rate_);
+      return false;
+    }
+    if (band_edges.back() > sample_rate / 2)
+      MICROSTRAIN_WARN(node_, "vibration_analysis_band_edges extend past the nyquist frequency of %f hz. Bands above it will always be 0", sample_rate / 2);
+
+    vibration_analyzer_ = std::unique_ptr<VibrationAnalyzer>(new VibrationAnalyzer(sample_rate, window_size, config_->vibration_analysis_overlap_, band_edges));
+    vibration_analysis_last_publish_ = -1;
+    vibration_analysis_pub_->configure(node_);
+
+    auto vibration_analysis_msg = vibration_analysis_pub_->getMessage();
+    vibration_analysis_msg->layout.dim.resize(2);
+    vibration_analysis_msg->layout.dim[0].label = "signal";
+    vibration_analysis_msg->layout.dim[0].size = VibrationAnalyzer::NUM_SIGNALS;
+    vibration_analysis_msg->layout.dim[0].stride = VibrationAnalyzer::NUM_SIGNALS * vibration_analyzer_->numColumns();
+    vibration_analysis_msg->layout.dim[1].label = "band_energy_peak_frequency_peak_power";
+    vibration_analysis_msg->layout.dim[1].size = vibration_analyzer_->numColumns();
+    vibration_analysis_msg->layout.dim[1].stride = vibration_analyzer_->numColumns();
+    vibration_analysis_msg->layout.data_offset = 0;
+  }
+
+  // Memory usage of each subsystem
+  if (config_->memory_tracking_enable_)
+  {
+    if (!MemoryTracker::supported())
+    {
+      MICROSTRAIN_ERROR(node_, "memory_tracking_enable is true, but the driver was not built with MICROSTRAIN_MEMORY_TRACKING defined");
+      return false;
+    }
+    if (config_->memory_tracking_publish_rate_ <= 0)
+    {
+      MICROSTRAIN_ERROR(node_, "Invalid memory_tracking_publish_rate %f. The rate must be greater than 0", config_->memory_tracking_publish_rate_);
+      return false;
+    }
+    memory_usage_last_publish_ = -1;
+    memory_usage_pub_->configure(node_);
+
+    auto memory_usage_msg = memory_usage_pub_->getMessage();
+    memory_usage_msg->layout.dim.resize(2);
+    memory_usage_msg->layout.dim[0].label = "tag";
+    memory_usage_msg->layout.dim[0].size = NUM_MEMORY_TAGS;
+    memory_usage_msg->layout.dim[0].stride = NUM_MEMORY_TAGS * 3;
+    memory_usage_msg->layout.dim[1].label = "live_bytes_peak_bytes_allocations_per_second";
+    memory_usage_msg->layout.dim[1].size = 3;
+    memory_usage_msg->layout.dim[1].stride = 3;
+    memory_usage_msg->layout.data_offset = 0;
+    memory_usage_msg->data.resize(NUM_MEMORY_TAGS * 3);
+  }
+
+  // Integrity state of each GNSS receiver
+  if (config_->gnss_integrity_enable_)
+  {
+    if (config_->gnss_integrity_upgrade_count_ < 1 || config_->gnss_integrity_degrade_count_ < 1)
+    {
+      MICROSTRAIN_ERROR(node_, "Invalid gnss_integrity_upgrade_count %d or gnss_integrity_degrade_count %d. The counts must be at least 1", config_->gnss_integrity_upgrade_count_, config_->gnss_integrity_degrade_count_);
+      return false;
+    }
+    if (config_->gnss_integrity_corrections_stale_age_ <= 0 || config_->gnss_integrity_heartbeat_period_ <= 0)
+    {
+      MICROSTRAIN_ERROR(node_, "Invalid gnss_integrity_corrections_stale_age %f or gnss_integrity_heartbeat_period %f. Both must be greater than 0", config_->gnss_integrity_corrections_stale_age_, config_->gnss_integrity_heartbeat_period_);
+      return false;
+    }
+
+    GnssIntegrity::Settings gnss_integrity_settings;
+    gnss_integrity_settings.upgrade_count = config_->gnss_integrity_upgrade_count_;
+    gnss_integrity_settings.degrade_count = config_->gnss_integrity_degrade_count_;
+    gnss_integrity_settings.corrections_stale_age = config_->gnss_integrity_corrections_stale_age_;
+    gnss_integrity_settings.heartbeat_period = config_->gnss_integrity_heartbeat_period_;
+    for (size_t i = 0; i < NUM_GNSS; i++)
+    {
+      gnss_integrity_[i] = GnssIntegrity(gnss_integrity_settings);
+      gnss_integrity_pub_[i]->configure(node_);
+
+      // The message has no header, so the stamp is the first value. Every value gets a dimension of its own, so each one is labelled
+      auto gnss_integrity_msg = gnss_integrity_pub_[i]->getMessage();
+      gnss_integrity_msg->layout.dim.resize(1 + GnssIntegrity::NUM_FIELDS);
+      for (size_t field = 0; field < gnss_integrity_msg->layout.dim.size(); field++)
+      {
+        gnss_integrity_msg->layout.dim[field].label = field == 0 ? "stamp" : GnssIntegrity::fieldName(field - 1);
+        gnss_integrity_msg->layout.dim[field].size = 1;
+        gnss_integrity_msg->layout.dim[field].stride = 1;
+      }
+      gnss_integrity_msg->layout.data_offset = 0;
+      gnss_integrity_msg->data.resize(1 + GnssIntegrity::NUM_FIELDS);
+    }
+  }
+
+  // IMU and odometry in the target frame. Only published for the topics that are streamed
+  target_frame_transform_.reset();
+  if (config_->target_frame_variants_enable_)
+  {
+    if (config_->target_frame_id_ == config_->frame_id_)
+      MICROSTRAIN_WARN(node_, "target_frame_variants_enable is true, but target_frame_id is the same as frame_id. The target frame topics will be identical to the original topics");
+    if (imu_pub_->configured())
+      imu_target_pub_->configure(node_);
+    if (filter_odometry_earth_pub_->configured())
+      filter_odometry_earth_target_pub_->configure(node_);
+    if (filter_odometry_map_pub_->configured())
+      filter_odometry_map_target_pub_->configure(node_);
+  }
+
   // Frame ID configuration
   imu_raw_pub_->getMessage()->header.frame_id = config_->frame_id_;
   imu_pub_->getMessage()->header.frame_id = config_->frame_id_;
@@ -157,15 +346,20 @@ bool Publishers::configure()
   filter_odometry_map_pub_->getMessage()->child_frame_id = config_->frame_id_;
   filter_dual_antenna_heading_pub_->getMessage()->header.frame_id = config_->frame_id_;
 
-  config_->map_to_earth_transform_.header.frame_id = config_->earth_frame_id_;
-  config_->map_to_earth_transform_.child_frame_id = config_->map_frame_id_;
+  imu_target_pub_->getMessage()->header.frame_id = config_->target_frame_id_;
+  filter_odometry_earth_target_pub_->getMessage()->header.frame_id = config_->earth_frame_id_;
+  filter_odometry_earth_target_pub_->getMessage()->child_frame_id = config_->target_frame_id_;
+  filter_odometry_map_target_pub_->getMessage()->header.frame_id = config_->map_frame_id_;
+  filter_odometry_map_target_pub_->getMessage()->child_frame_id = config_->target_frame_id_;
 
   // Static covariance configuration
   auto imu_raw_msg = imu_raw_pub_->getMessage();
   auto imu_msg = imu_pub_->getMessage();
   auto mag_msg = mag_pub_->getMessage();
-  std::copy(config_->imu_linear_cov_.begin(), config_->imu_linear_cov_.end(), imu_raw_msg->linear_acceleration_covariance.begin());
-  std::copy(config_->imu_angular_cov_.begin(), config_->imu_angular_cov_.end(), imu_raw_msg->angular_velocity_covariance.begin());
+  auto imu_raw_covariance = std::make_shared<ImuSample::Covariance>();
+  std::copy(config_->imu_linear_cov_.begin(), config_->imu_linear_cov_.end(), imu_raw_covariance->linear_acceleration.begin());
+  std::copy(config_->imu_angular_cov_.begin(), config_->imu_angular_cov_.end(), imu_raw_covariance->angular_velocity.begin());
+  imu_raw_msg->covariance = imu_raw_covariance;
   std::copy(config_->imu_linear_cov_.begin(), config_->imu_linear_cov_.end(), imu_msg->linear_acceleration_covariance.begin());
   std::copy(config_->imu_angular_cov_.begin(), config_->imu_angular_cov_.end(), imu_msg->angular_velocity_covariance.begin());
   std::copy(config_->imu_orientation_cov_.begin(), config_->imu_orientation_cov_.end(), imu_msg->orientation_covariance.begin());
@@ -182,30 +376,33 @@ bool Publishers::configure()
   filter_human_readable_status_msg->device_info.serial_number = config_->mip_device_->device_info_.serial_number;
   filter_human_readable_status_msg->device_info.lot_number = config_->mip_device_->device_info_.lot_number;
   filter_human_readable_status_msg->device_info.device_options = config_->mip_device_->device_info_.device_options;
-  if (RosMipDevice::isPhilo(config_->mip_device_->device_info_))
+  if (philo_device_ || !BuildFeatures::DUAL_ANTENNA)
     filter_human_readable_status_msg->dual_antenna_fix_type = HumanReadableStatusMsg::UNSUPPORTED;
-  if (!config_->mip_device_->supportsDescriptorSet(mip::data_gnss::DESCRIPTOR_SET) && !config_->mip_device_->supportsDescriptorSet(mip::data_gnss::MIP_GNSS1_DATA_DESC_SET))
+  if (!BuildFeatures::GNSS || (!config_->mip_device_->supportsDescriptorSet(mip::data_gnss::DESCRIPTOR_SET) && !config_->mip_device_->supportsDescriptorSet(mip::data_gnss::MIP_GNSS1_DATA_DESC_SET)))
     filter_human_readable_status_msg->gnss_state = HumanReadableStatusMsg::UNSUPPORTED;
 
   // Transform broadcaster setup
-  static_transform_broadcaster_ = createStaticTransformBroadcaster(node_);
-  transform_broadcaster_ = createTransformBroadcaster(node_);
+  {
+    MemoryTracker::Scope tf_memory_scope(MEMORY_TAG_TF);
+    static_transform_broadcaster_ = createStaticTransformBroadcaster(node_);
+    transform_broadcaster_ = createTransformBroadcaster(node_);
+  }
 
   // If the source is manual, set up our transform here
   if (config_->filter_relative_pos_config_ && config_->filter_relative_pos_source_ == REL_POS_SOURCE_MANUAL)
   {
     // Set the translation from config
-    config_->map_to_earth_transform_.header.stamp = rosTimeNow(node_);
+    TransformMsg map_to_earth_transform;
     if (config_->filter_relative_pos_frame_ == REL_POS_FRAME_ECEF)
     {
-      config_->map_to_earth_transform_.transform.translation.x = config_->filter_relative_pos_ref_[0];
-      config_->map_to_earth_transform_.transform.translation.y = config_->filter_relative_pos_ref_[1];
-      config_->map_to_earth_transform_.transform.translation.z = config_->filter_relative_pos_ref_[2];
+      map_to_earth_transform.translation.x = config_->filter_relative_pos_ref_[0];
+      map_to_earth_transform.translation.y = config_->filter_relative_pos_ref_[1];
+      map_to_earth_transform.translation.z = config_->filter_relative_pos_ref_[2];
     }
     else if (config_->filter_relative_pos_frame_ == REL_POS_FRAME_LLH)
     {
       config_->geocentric_converter_.Forward(config_->filter_relative_pos_ref_[0], config_->filter_relative_pos_ref_[1], config_->filter_relative_pos_ref_[2],
-          config_->map_to_earth_transform_.transform.translation.x, config_->map_to_earth_transform_.transform.translation.y, config_->map_to_earth_transform_.transform.translation.z);
+          map_to_earth_transform.translation.x, map_to_earth_transform.translation.y, map_to_earth_transform.translation.z);
     }
     else
     {
@@ -215,14 +412,14 @@ bool Publishers::configure()
 
     // Determine the rotation from ECEF to NED/ENU for this position
     double lat, lon, alt;
-    config_->geocentric_converter_.Reverse(config_->map_to_earth_transform_.transform.translation.x, config_->map_to_earth_transform_.transform.translation.y, config_->map_to_earth_transform_.transform.translation.z, lat, lon, alt);
+    config_->geocentric_converter_.Reverse(map_to_earth_transform.translation.x, map_to_earth_transform.translation.y, map_to_earth_transform.translation.z, lat, lon, alt);
     if (config_->use_enu_frame_)
-      config_->map_to_earth_transform_.transform.rotation = tf2::toMsg(ecefToEnuTransformQuat(lat, lon));
+      map_to_earth_transform.rotation = tf2::toMsg(ecefToEnuTransformQuat(lat, lon));
     else
-      config_->map_to_earth_transform_.transform.rotation = tf2::toMsg(ecefToNedTransformQuat(lat, lon));
+      map_to_earth_transform.rotation = tf2::toMsg(ecefToNedTransformQuat(lat, lon));
 
     // Note that the data is valid so we can publish it on activate
-    config_->map_to_earth_transform_valid_ = true;
+    storeMapToEarthTransform(map_to_earth_transform, config_->clock_->now());
   }
 
   // Static antenna offsets
@@ -236,7 +433,7 @@ bool Publishers::configure()
       return false;
     }
     TransformStampedMsg& gnss_1_antenna_link_to_imu_link_transform = gnss_antenna_link_to_imu_link_transform_[GNSS1_ID];
-    gnss_1_antenna_link_to_imu_link_transform.header.stamp = rosTimeNow(node_);
+    gnss_1_antenna_link_to_imu_link_transform.header.stamp = config_->clock_->rosNow();
     gnss_1_antenna_link_to_imu_link_transform.header.frame_id = config_->frame_id_;
     gnss_1_antenna_link_to_imu_link_transform.child_frame_id = config_->gnss_frame_id_[GNSS1_ID];
     gnss_1_antenna_link_to_imu_link_transform.transform.rotation = tf2::toMsg(tf2::Quaternion::getIdentity());
@@ -266,7 +463,7 @@ bool Publishers::configure()
         return false;
       }
       TransformStampedMsg& gnss_x_antenna_link_to_imu_link_transform = gnss_antenna_link_to_imu_link_transform_[gnss_id];
-      gnss_x_antenna_link_to_imu_link_transform.header.stamp = rosTimeNow(node_);
+      gnss_x_antenna_link_to_imu_link_transform.header.stamp = config_->clock_->rosNow();
       gnss_x_antenna_link_to_imu_link_transform.header.frame_id = config_->frame_id_;
       gnss_x_antenna_link_to_imu_link_transform.child_frame_id = config_->gnss_frame_id_[gnss_id];
       gnss_x_antenna_link_to_imu_link_transform.transform.rotation = tf2::toMsg(tf2::Quaternion::getIdentity());
@@ -298,7 +495,7 @@ bool Publishers::configure()
       return false;
     }
 
-    odometer_link_to_imu_link_transform_.header.stamp = rosTimeNow(node_);
+    odometer_link_to_imu_link_transform_.header.stamp = config_->clock_->rosNow();
     odometer_link_to_imu_link_transform_.header.frame_id = config_->frame_id_;
     odometer_link_to_imu_link_transform_.child_frame_id = config_->odometer_frame_id_;
     odometer_link_to_imu_link_transform_.transform.rotation = tf2::toMsg(tf2::Quaternion::getIdentity());
@@ -334,9 +531,12 @@ bool Publishers::configure()
   }
 
   // Philo shared field callbacks
-  registerDataCallback<mip::data_sensor::GpsTimestamp, &Publishers::handleSensorGpsTimestamp>();
-  registerDataCallback<mip::data_gnss::GpsTime, &Publishers::handleGnssGpsTime>();
-  registerDataCallback<mip::data_filter::Timestamp, &Publishers::handleFilterTimestamp>();
+  if (BuildFeatures::PHILO)
+  {
+    registerDataCallback<mip::data_sensor::GpsTimestamp, &Publishers::handleSensorGpsTimestamp>();
+    registerDataCallback<mip::data_gnss::GpsTime, &Publishers::handleGnssGpsTime>();
+    registerDataCallback<mip::data_filter::Timestamp, &Publishers::handleFilterTimestamp>();
+  }
 
   // IMU callbacks
   registerDataCallback<mip::data_sensor::ScaledAccel, &Publishers::handleSensorScaledAccel>();
@@ -351,26 +551,32 @@ bool Publishers::configure()
   registerDataCallback<mip::data_sensor::TemperatureAbs, &Publishers::handleSensorTemperatureStatistics>();
 
   // GNSS1/2 callbacks
-  for (const uint8_t gnss_descriptor_set : std::initializer_list<uint8_t>{mip::data_gnss::DESCRIPTOR_SET, mip::data_gnss::MIP_GNSS1_DATA_DESC_SET, mip::data_gnss::MIP_GNSS2_DATA_DESC_SET})
+  if (BuildFeatures::GNSS)
   {
-    registerDataCallback<mip::data_gnss::PosLlh, &Publishers::handleGnssPosLlh>(gnss_descriptor_set);
-    registerDataCallback<mip::data_gnss::VelNed, &Publishers::handleGnssVelNed>(gnss_descriptor_set);
-    registerDataCallback<mip::data_gnss::PosEcef, &Publishers::handleGnssPosEcef>(gnss_descriptor_set);
-    registerDataCallback<mip::data_gnss::VelEcef, &Publishers::handleGnssVelEcef>(gnss_descriptor_set);
-    registerDataCallback<mip::data_gnss::FixInfo, &Publishers::handleGnssFixInfo>(gnss_descriptor_set);
-    registerDataCallback<mip::data_gnss::SbasInfo, &Publishers::handleGnssSbasInfo>(gnss_descriptor_set);
-    registerDataCallback<mip::data_gnss::RfErrorDetection, &Publishers::handleGnssRfErrorDetection>(gnss_descriptor_set);
-  }
+    for (const uint8_t gnss_descriptor_set : std::initializer_list<uint8_t>{mip::data_gnss::DESCRIPTOR_SET, mip::data_gnss::MIP_GNSS1_DATA_DESC_SET, mip::data_gnss::MIP_GNSS2_DATA_DESC_SET})
+    {
+      registerDataCallback<mip::data_gnss::PosLlh, &Publishers::handleGnssPosLlh>(gnss_descriptor_set);
+      registerDataCallback<mip::data_gnss::VelNed, &Publishers::handleGnssVelNed>(gnss_descriptor_set);
+      registerDataCallback<mip::data_gnss::PosEcef, &Publishers::handleGnssPosEcef>(gnss_descriptor_set);
+      registerDataCallback<mip::data_gnss::VelEcef, &Publishers::handleGnssVelEcef>(gnss_descriptor_set);
+      registerDataCallback<mip::data_gnss::FixInfo, &Publishers::handleGnssFixInfo>(gnss_descriptor_set);
+      registerDataCallback<mip::data_gnss::SbasInfo, &Publishers::handleGnssSbasInfo>(gnss_descriptor_set);
+      registerDataCallback<mip::data_gnss::RfErrorDetection, &Publishers::handleGnssRfErrorDetection>(gnss_descriptor_set);
+    }
 
-  // Note: It is important to make sure this is after the GNSS1/2 callbacks
-  for (const uint8_t gnss_descriptor_set : std::initializer_list<uint8_t>{mip::data_gnss::MIP_GNSS1_DATA_DESC_SET, mip::data_gnss::MIP_GNSS2_DATA_DESC_SET})
-  {
-    registerDataCallback<mip::data_gnss::GpsTime, &Publishers::handleGnssGpsTime>(gnss_descriptor_set);
+    // Note: It is important to make sure this is after the GNSS1/2 callbacks
+    for (const uint8_t gnss_descriptor_set : std::initializer_list<uint8_t>{mip::data_gnss::MIP_GNSS1_DATA_DESC_SET, mip::data_gnss::MIP_GNSS2_DATA_DESC_SET})
+    {
+      registerDataCallback<mip::data_gnss::GpsTime, &Publishers::handleGnssGpsTime>(gnss_descriptor_set);
+    }
   }
 
   // RTK callbacks
-  registerDataCallback<mip::data_gnss::RtkCorrectionsStatus, &Publishers::handleRtkCorrectionsStatus>(mip::data_gnss::MIP_GNSS3_DATA_DESC_SET);
-  registerDataCallback<mip::data_gnss::BaseStationInfo, &Publishers::handleRtkBaseStationInfo>(mip::data_gnss::MIP_GNSS3_DATA_DESC_SET);
+  if (BuildFeatures::RTK)
+  {
+    registerDataCallback<mip::data_gnss::RtkCorrectionsStatus, &Publishers::handleRtkCorrectionsStatus>(mip::data_gnss::MIP_GNSS3_DATA_DESC_SET);
+    registerDataCallback<mip::data_gnss::BaseStationInfo, &Publishers::handleRtkBaseStationInfo>(mip::data_gnss::MIP_GNSS3_DATA_DESC_SET);
+  }
 
   // Filter callbacks
   registerDataCallback<mip::data_filter::Status, &Publishers::handleFilterStatus>();
@@ -387,13 +593,47 @@ bool Publishers::configure()
   registerDataCallback<mip::data_filter::CompAngularRate, &Publishers::handleFilterCompAngularRate>();
   registerDataCallback<mip::data_filter::CompAccel, &Publishers::handleFilterCompAccel>();
   registerDataCallback<mip::data_filter::LinearAccel, &Publishers::handleFilterLinearAccel>();
-  registerDataCallback<mip::data_filter::GnssPosAidStatus, &Publishers::handleFilterGnssPosAidStatus>();
-  registerDataCallback<mip::data_filter::MultiAntennaOffsetCorrection, &Publishers::handleFilterMultiAntennaOffsetCorrection>();
-  registerDataCallback<mip::data_filter::GnssDualAntennaStatus, &Publishers::handleFilterGnssDualAntennaStatus>();
   registerDataCallback<mip::data_filter::AidingMeasurementSummary, &Publishers::handleFilterAidingMeasurementSummary>();
+  if (BuildFeatures::GNSS)
+    registerDataCallback<mip::data_filter::GnssPosAidStatus, &Publishers::handleFilterGnssPosAidStatus>();
+  if (BuildFeatures::DUAL_ANTENNA)
+  {
+    registerDataCallback<mip::data_filter::MultiAntennaOffsetCorrection, &Publishers::handleFilterMultiAntennaOffsetCorrection>();
+    registerDataCallback<mip::data_filter::GnssDualAntennaStatus, &Publishers::handleFilterGnssDualAntennaStatus>();
+  }
 
   // System callbacks
-  registerDataCallback<mip::data_system::BuiltInTest, &Publishers::handleSystemBuiltInTest>();
+  if (BuildFeatures::BUILT_IN_TEST)
+    registerDataCallback<mip::data_system::BuiltInTest, &Publishers::handleSystemBuiltInTest>();
+
+  // Messages built from the fields of a single descriptor set can be published as soon as their last field is handled.
+  // The IMU and odometry are still needed at the end of the packet to publish the target frame variants
+  early_publishers_.clear();
+  if (config_->early_publish_enable_)
+  {
+    std::vector<FieldTrigger*> candidates = {imu_raw_pub_.get(), mag_pub_.get(), pressure_pub_.get(), wheel_speed_pub_.get(),
+      filter_imu_pub_.get(), filter_llh_position_pub_.get(), filter_velocity_pub_.get(), filter_velocity_ecef_pub_.get(), filter_dual_antenna_heading_pub_.get()};
+    if (!config_->target_frame_variants_enable_)
+      candidates.insert(candidates.end(), {imu_pub_.get(), filter_odometry_earth_pub_.get(), filter_odometry_map_pub_.get()});
+    for (const auto& pub : gnss_llh_position_pub_) candidates.push_back(pub.get());
+    for (const auto& pub : gnss_velocity_pub_) candidates.push_back(pub.get());
+    for (const auto& pub : gnss_velocity_ecef_pub_) candidates.push_back(pub.get());
+    for (const auto& pub : gnss_odometry_pub_) candidates.push_back(pub.get());
+    for (const auto& pub : gnss_time_pub_) candidates.push_back(pub.get());
+    for (FieldTrigger* candidate : candidates)
+    {
+      if (candidate->hasRequiredFields())
+        early_publishers_.push_back(candidate);
+    }
+  }
+
+  // Runs after the handlers of every field, so it must be registered after the data callbacks
+  if (!early_publishers_.empty())
+    registerFieldCallback<&Publishers::handleAfterField>();
+
+  // Before packet callback, only needed to start measuring the handlers and find where each early message is complete
+  if (config_->perf_profiler_ != nullptr || !early_publishers_.empty())
+    registerPacketCallback<&Publishers::handleBeforePacket>(mip::C::MIP_DISPATCH_ANY_DESCRIPTOR, false);
 
   // After packet callback
   registerPacketCallback<&Publishers::handleAfterPacket>();
@@ -442,9 +682,27 @@ bool Publishers::activate()
 
   nmea_sentence_pub_->activate();
 
+  signal_statistics_pub_->activate();
+
+  vibration_analysis_pub_->activate();
+  if (vibration_analyzer_ != nullptr)
+    vibration_analyzer_->start();
+
+  memory_usage_pub_->activate();
+  for (const auto& pub : gnss_integrity_pub_) pub->activate();
+
+  imu_target_pub_->activate();
+  filter_odometry_earth_target_pub_->activate();
+  filter_odometry_map_target_pub_->activate();
+
   // Publish the static transforms
+  MemoryTracker::Scope tf_memory_scope(MEMORY_TAG_TF);
   if (config_->tf_mode_ != TF_MODE_OFF && config_->filter_relative_pos_config_ && config_->filter_relative_pos_source_ == REL_POS_SOURCE_MANUAL)
-    static_transform_broadcaster_->sendTransform(config_->map_to_earth_transform_);
+  {
+    const RuntimeState runtime_state = config_->runtime_state_.load();
+    static_transform_broadcaster_->sendTransform(mapToEarthTransform(runtime_state));
+    map_to_earth_revision_sent_ = runtime_state.map_to_earth_revision;
+  }
   if (config_->publish_mount_to_frame_id_transform_)
     static_transform_broadcaster_->sendTransform(config_->mount_to_frame_id_transform_);
 
@@ -501,6 +759,19 @@ bool Publishers::deactivate()
   mip_system_built_in_test_pub_->deactivate();
 
   nmea_sentence_pub_->deactivate();
+
+  signal_statistics_pub_->deactivate();
+
+  if (vibration_analyzer_ != nullptr)
+    vibration_analyzer_->stop();
+  vibration_analysis_pub_->deactivate();
+
+  memory_usage_pub_->deactivate();
+  for (const auto& pub : gnss_integrity_pub_) pub->deactivate();
+
+  imu_target_pub_->deactivate();
+  filter_odometry_earth_target_pub_->deactivate();
+  filter_odometry_map_target_pub_->deactivate();
   return true;
 }
 
@@ -509,17 +780,22 @@ void Publishers::publish()
   // This publish function will get called after each packet is processed.
   // For standard ROS messages this allows us to combine multiple MIP fields and then publish them
   // For custom ROS messages, the messages are published directly in the callbacks
+  publishTargetFrameVariants();
+
   imu_raw_pub_->publish();
   imu_pub_->publish();
   mag_pub_->publish();
   pressure_pub_->publish();
   wheel_speed_pub_->publish();
 
-  for (const auto& pub : gnss_llh_position_pub_) pub->publish();
-  for (const auto& pub : gnss_velocity_pub_) pub->publish();
-  for (const auto& pub : gnss_velocity_ecef_pub_) pub->publish();
-  for (const auto& pub : gnss_odometry_pub_) pub->publish();
-  for (const auto& pub : gnss_time_pub_) pub->publish();
+  if (BuildFeatures::GNSS)
+  {
+    for (const auto& pub : gnss_llh_position_pub_) pub->publish();
+    for (const auto& pub : gnss_velocity_pub_) pub->publish();
+    for (const auto& pub : gnss_velocity_ecef_pub_) pub->publish();
+    for (const auto& pub : gnss_odometry_pub_) pub->publish();
+    for (const auto& pub : gnss_time_pub_) pub->publish();
+  }
 
   filter_human_readable_status_pub_->publish();
   filter_imu_pub_->publish();
@@ -528,9 +804,19 @@ void Publishers::publish()
   filter_velocity_ecef_pub_->publish();
   filter_odometry_earth_pub_->publish();
   filter_odometry_map_pub_->publish();
-  filter_dual_antenna_heading_pub_->publish();
+  if (BuildFeatures::DUAL_ANTENNA)
+    filter_dual_antenna_heading_pub_->publish();
+
+  // Let the user know if any of the de-jittered topics could not keep their cadence
+  for (const auto& dejitter_statistics : config_->dejitter_statistics_)
+  {
+    const uint64_t misses = dejitter_statistics.second->takeNewMisses();
+    if (misses > 0)
+      MICROSTRAIN_WARN_THROTTLE(node_, 5, "%lu messages on %s were not published on schedule. Consider increasing dejitter_delay", static_cast<unsigned long>(misses), dejitter_statistics.first.c_str());
+  }
 
   // Publish the dynamic transforms after the messages have been filled out
+  MemoryTracker::Scope tf_memory_scope(MEMORY_TAG_TF);
   std::string tf_error_string;
   RosTimeType frame_time; setRosTime(&frame_time, 0, 0);
   if (config_->tf_mode_ == TF_MODE_GLOBAL && imu_link_to_earth_transform_translation_updated_ && imu_link_to_earth_transform_attitude_updated_)
@@ -589,12 +875,86 @@ void Publishers::publish()
 
   if (config_->tf_mode_ != TF_MODE_OFF)
   {
-    if (config_->map_to_earth_transform_updated_)
+    const RuntimeState runtime_state = config_->runtime_state_.load();
+    if (runtime_state.map_to_earth_valid && runtime_state.map_to_earth_revision != map_to_earth_revision_sent_)
     {
       // Send as a static transform since the transform should get updated pretty rarely
-      static_transform_broadcaster_->sendTransform(config_->map_to_earth_transform_);
-      config_->map_to_earth_transform_updated_ = false;
+      static_transform_broadcaster_->sendTransform(mapToEarthTransform(runtime_state));
+      map_to_earth_revision_sent_ = runtime_state.map_to_earth_revision;
+    }
+  }
+}
+
+void Publishers::saveHandoffState(HandoffState* state) const
+{
+  const RuntimeState runtime_state = config_->runtime_state_.load();
+  state->map_to_earth_valid = runtime_state.map_to_earth_valid;
+  if (state->map_to_earth_valid)
+  {
+    std::copy(std::begin(runtime_state.map_to_earth_translation), std::end(runtime_state.map_to_earth_translation), state->map_to_earth_translation);
+    std::copy(std::begin(runtime_state.map_to_earth_rotation), std::end(runtime_state.map_to_earth_rotation), state->map_to_earth_rotation);
+  }
+  state->clock_bias_valid = clock_bias_monitor_.hasBiasEstimate();
+  state->clock_bias = clock_bias_monitor_.getBiasEstimate();
+}
+
+void Publishers::restoreHandoffState(const HandoffState& state)
+{
+  // A manually configured origin was already set up in configure, and takes priority
+  if (state.map_to_earth_valid && !config_->runtime_state_.load().map_to_earth_valid)
+  {
+    TransformMsg transform;
+    transform.translation.x = state.map_to_earth_translation[0];
+    transform.translation.y = state.map_to_earth_translation[1];
+    transform.translation.z = state.map_to_earth_translation[2];
+    transform.rotation.x = state.map_to_earth_rotation[0];
+    transform.rotation.y = state.map_to_earth_rotation[1];
+    transform.rotation.z = state.map_to_earth_rotation[2];
+    transform.rotation.w = state.map_to_earth_rotation[3];
+    storeMapToEarthTransform(transform, config_->clock_->now());
+  }
+  if (state.clock_bias_valid)
+    clock_bias_monitor_.restore(state.clock_bias);
+}
+
+void Publishers::publishTargetFrameVariants()
+{
+  if (!config_->target_frame_variants_enable_)
+    return;
+  if (!imu_pub_->updated() && !filter_odometry_earth_pub_->updated() && !filter_odometry_map_pub_->updated())
+    return;
+
+  // The frames are rigidly attached, so the transform only needs to be looked up once
+  if (!target_frame_transform_.valid())
+  {
+    MemoryTracker::Scope tf_memory_scope(MEMORY_TAG_TF);
+    std::string tf_error_string;
+    RosTimeType frame_time; setRosTime(&frame_time, 0, 0);
+    if (!transform_buffer_->canTransform(config_->target_frame_id_, config_->frame_id_, frame_time, RosDurationType(0, 0), &tf_error_string))
+    {
+      MICROSTRAIN_WARN_THROTTLE(node_, 2, "Unable to lookup transform from %s to %s, so the target frame topics will not be published: %s", config_->target_frame_id_.c_str(), config_->frame_id_.c_str(), tf_error_string.c_str());
+      return;
     }
+    tf2::Transform imu_link_to_target_transform_tf;
+    const auto& imu_link_to_target_transform = transform_buffer_->lookupTransform(config_->target_frame_id_, config_->frame_id_, frame_time, RosDurationType(0, 0));
+    tf2::fromMsg(imu_link_to_target_transform.transform, imu_link_to_target_transform_tf);
+    target_frame_transform_.set(imu_link_to_target_transform_tf);
+  }
+
+  if (imu_pub_->updated() && imu_target_pub_->configured())
+  {
+    target_frame_transform_.transformImu(*imu_pub_->getMessage(), imu_target_pub_->getMessageToUpdate().get());
+    imu_target_pub_->publish();
+  }
+  if (filter_odometry_earth_pub_->updated() && filter_odometry_earth_target_pub_->configured())
+  {
+    target_frame_transform_.transformOdometry(*filter_odometry_earth_pub_->getMessage(), filter_odometry_earth_target_pub_->getMessageToUpdate().get());
+    filter_odometry_earth_target_pub_->publish();
+  }
+  if (filter_odometry_map_pub_->updated() && filter_odometry_map_target_pub_->configured())
+  {
+    target_frame_transform_.transformOdometry(*filter_odometry_map_pub_->getMessage(), filter_odometry_map_target_pub_->getMessageToUpdate().get());
+    filter_odometry_map_target_pub_->publish();
   }
 }
 
@@ -639,7 +999,7 @@ void Publishers::handleSharedGpsTimestamp(const mip::data_shared::GpsTimestamp&
       return;
   }
   auto gps_time_msg = gnss_time_pub_[gnss_index]->getMessageToUpdate();
-  gps_time_msg->header.stamp = rosTimeNow(node_);
+  gps_time_msg->header.stamp = config_->clock_->rosNow();
   setGpsTime(&gps_time_msg->time_ref, gps_timestamp);
 }
 
@@ -680,6 +1040,9 @@ void Publishers::handleSensorScaledAccel(const mip::data_sensor::ScaledAccel& sc
     imu_raw_msg->linear_acceleration.y *= -1.0;
     imu_raw_msg->linear_acceleration.z *= -1.0;
   }
+  signal_statistics_.add(STATISTICS_ACCEL, imu_raw_msg->linear_acceleration.x, imu_raw_msg->linear_acceleration.y, imu_raw_msg->linear_acceleration.z);
+  if (vibration_analyzer_ != nullptr)
+    vibration_analyzer_->add(VibrationAnalyzer::SIGNAL_ACCEL, imu_raw_msg->linear_acceleration.x, imu_raw_msg->linear_acceleration.y, imu_raw_msg->linear_acceleration.z);
 }
 
 void Publishers::handleSensorScaledGyro(const mip::data_sensor::ScaledGyro& scaled_gyro, const uint8_t descriptor_set, mip::Timestamp timestamp)
@@ -694,6 +1057,9 @@ void Publishers::handleSensorScaledGyro(const mip::data_sensor::ScaledGyro& scal
     imu_raw_msg->angular_velocity.y *= -1.0;
     imu_raw_msg->angular_velocity.z *= -1.0;
   }
+  signal_statistics_.add(STATISTICS_GYRO, imu_raw_msg->angular_velocity.x, imu_raw_msg->angular_velocity.y, imu_raw_msg->angular_velocity.z);
+  if (vibration_analyzer_ != nullptr)
+    vibration_analyzer_->add(VibrationAnalyzer::SIGNAL_GYRO, imu_raw_msg->angular_velocity.x, imu_raw_msg->angular_velocity.y, imu_raw_msg->angular_velocity.z);
 }
 
 void Publishers::handleSensorDeltaTheta(const mip::data_sensor::DeltaTheta& delta_theta, const uint8_t descriptor_set, mip::Timestamp timestamp)
@@ -716,6 +1082,8 @@ void Publishers::handleSensorDeltaTheta(const mip::data_sensor::DeltaTheta& delt
     imu_msg->angular_velocity.y *= -1.0;
     imu_msg->angular_velocity.z *= -1.0;
   }
+  if (config_->allan_variance_ != nullptr)
+    config_->allan_variance_->add(AllanVariance::SIGNAL_GYRO, imu_msg->angular_velocity.x, imu_msg->angular_velocity.y, imu_msg->angular_velocity.z, delta_time);
 }
 
 void Publishers::handleSensorDeltaVelocity(const mip::data_sensor::DeltaVelocity& delta_velocity, const uint8_t descriptor_set, mip::Timestamp timestamp)
@@ -737,6 +1105,8 @@ void Publishers::handleSensorDeltaVelocity(const mip::data_sensor::DeltaVelocity
     imu_msg->linear_acceleration.y *= -1.0;
     imu_msg->linear_acceleration.z *= -1.0;
   }
+  if (config_->allan_variance_ != nullptr)
+    config_->allan_variance_->add(AllanVariance::SIGNAL_ACCEL, imu_msg->linear_acceleration.x, imu_msg->linear_acceleration.y, imu_msg->linear_acceleration.z, delta_time);
 }
 
 void Publishers::handleSensorCompQuaternion(const mip::data_sensor::CompQuaternion& comp_quaternion, const uint8_t descriptor_set, mip::Timestamp timestamp)
@@ -768,6 +1138,11 @@ void Publishers::handleSensorScaledMag(const mip::data_sensor::ScaledMag& scaled
     mag_msg->magnetic_field.y *= -1.0;
     mag_msg->magnetic_field.z *= -1.0;
   }
+  signal_statistics_.add(STATISTICS_MAG, mag_msg->magnetic_field.x, mag_msg->magnetic_field.y, mag_msg->magnetic_field.z);
+
+  // The device calibration is in the sensor frame and in gauss, so calibrate with the data as the device reported it
+  if (config_->mag_calibrator_ != nullptr)
+    config_->mag_calibrator_->add(scaled_mag.scaled_mag[0], scaled_mag.scaled_mag[1], scaled_mag.scaled_mag[2]);
 }
 
 void Publishers::handleSensorScaledPressure(const mip::data_sensor::ScaledPressure& scaled_pressure, const uint8_t descriptor_set, mip::Timestamp timestamp)
@@ -819,6 +1194,7 @@ void Publishers::handleSensorTemperatureStatistics(const mip::data_sensor::Tempe
   mip_sensor_temperature_statistics_msg->max_temp = temperature_statistics.max_temp;
   mip_sensor_temperature_statistics_msg->mean_temp = temperature_statistics.mean_temp;
   mip_sensor_temperature_statistics_pub_->publish(*mip_sensor_temperature_statistics_msg);
+  signal_statistics_.add(STATISTICS_TEMPERATURE, temperature_statistics.mean_temp);
 }
 
 void Publishers::handleGnssGpsTime(const mip::data_gnss::GpsTime& gps_time, const uint8_t descriptor_set, mip::Timestamp timestamp)
@@ -845,7 +1221,7 @@ void Publishers::handleGnssGpsTime(const mip::data_gnss::GpsTime& gps_time, cons
       return;
   }
   auto gps_time_msg = gnss_time_pub_[gnss_index]->getMessageToUpdate();
-  gps_time_msg->header.stamp = rosTimeNow(node_);
+  gps_time_msg->header.stamp = config_->clock_->rosNow();
   setGpsTime(&gps_time_msg->time_ref, stored_timestamp);
 }
 
@@ -865,6 +1241,10 @@ void Publishers::handleGnssPosLlh(const mip::data_gnss::PosLlh& pos_llh, const u
   gnss_llh_position_msg->position_covariance[0] = pow(pos_llh.horizontal_accuracy, 2);
   gnss_llh_position_msg->position_covariance[4] = pow(pos_llh.horizontal_accuracy, 2);
   gnss_llh_position_msg->position_covariance[8] = pow(pos_llh.vertical_accuracy, 2);
+
+  // Host NMEA
+  geoid_separation_ = pos_llh.ellipsoid_height - pos_llh.msl_height;
+  gnss_nmea_generator_[gnss_index].updatePosition(pos_llh.latitude, pos_llh.longitude, pos_llh.msl_height, geoid_separation_);
 }
 
 void Publishers::handleGnssVelNed(const mip::data_gnss::VelNed& vel_ned, const uint8_t descriptor_set, mip::Timestamp timestamp)
@@ -934,6 +1314,9 @@ void Publishers::handleGnssVelNed(const mip::data_gnss::VelNed& vel_ned, const u
     gnss_odometry_msg->twist.twist.linear.z = imu_velocity_in_microstrain_vehicle_frame.getZ();
   }
   gnss_odometry_msg->twist.covariance = gnss_velocity_msg->twist.covariance;
+
+  // Host NMEA
+  gnss_nmea_generator_[gnss_index].updateVelocity(vel_ned.v[0], vel_ned.v[1]);
 }
 
 void Publishers::handleGnssPosEcef(const mip::data_gnss::PosEcef& pos_ecef, const uint8_t descriptor_set, mip::Timestamp timestamp)
@@ -988,6 +1371,40 @@ void Publishers::handleGnssFixInfo(const mip::data_gnss::FixInfo& fix_info, cons
     gnss_llh_position_msg->status.status = NavSatFixMsg::_status_type::STATUS_FIX;
   else
     gnss_llh_position_msg->status.status = NavSatFixMsg::_status_type::STATUS_NO_FIX;
+
+  // Host NMEA
+  uint8_t nmea_fix_quality;
+  if (fix_info.fix_type == mip::data_gnss::FixInfo::FixType::FIX_RTK_FIXED)
+    nmea_fix_quality = NmeaGenerator::FIX_QUALITY_RTK_FIXED;
+  else if (fix_info.fix_type == mip::data_gnss::FixInfo::FixType::FIX_RTK_FLOAT)
+    nmea_fix_quality = NmeaGenerator::FIX_QUALITY_RTK_FLOAT;
+  else if (fix_info.fix_type != mip::data_gnss::FixInfo::FixType::FIX_3D && fix_info.fix_type != mip::data_gnss::FixInfo::FixType::FIX_2D)
+    nmea_fix_quality = NmeaGenerator::FIX_QUALITY_INVALID;
+  else if (fix_info.fix_flags.sbasUsed() || fix_info.fix_flags.dgnssUsed())
+    nmea_fix_quality = NmeaGenerator::FIX_QUALITY_DGNSS;
+  else
+    nmea_fix_quality = NmeaGenerator::FIX_QUALITY_GNSS;
+  gnss_num_sv_[gnss_index] = fix_info.num_sv;
+  gnss_nmea_generator_[gnss_index].updateFix(nmea_fix_quality, fix_info.num_sv);
+
+  // Integrity state
+  if (gnss_integrity_pub_[gnss_index]->configured())
+  {
+    uint8_t fix_class;
+    if (fix_info.fix_type == mip::data_gnss::FixInfo::FixType::FIX_RTK_FIXED)
+      fix_class = GnssIntegrity::FIX_CLASS_RTK_FIXED;
+    else if (fix_info.fix_type == mip::data_gnss::FixInfo::FixType::FIX_RTK_FLOAT)
+      fix_class = GnssIntegrity::FIX_CLASS_RTK_FLOAT;
+    else if (fix_info.fix_type != mip::data_gnss::FixInfo::FixType::FIX_3D && fix_info.fix_type != mip::data_gnss::FixInfo::FixType::FIX_2D)
+      fix_class = GnssIntegrity::FIX_CLASS_NONE;
+    else if (fix_info.fix_flags.sbasUsed() || fix_info.fix_flags.dgnssUsed())
+      fix_class = GnssIntegrity::FIX_CLASS_DIFFERENTIAL;
+    else if (fix_info.fix_type == mip::data_gnss::FixInfo::FixType::FIX_3D)
+      fix_class = GnssIntegrity::FIX_CLASS_3D;
+    else
+      fix_class = GnssIntegrity::FIX_CLASS_2D;
+    gnss_integrity_[gnss_index].updateFix(fix_class);
+  }
 }
 
 void Publishers::handleGnssRfErrorDetection(const mip::data_gnss::RfErrorDetection& rf_error_detection, const uint8_t descriptor_set, mip::Timestamp timestamp)
@@ -1013,6 +1430,10 @@ void Publishers::handleGnssRfErrorDetection(const mip::data_gnss::RfErrorDetecti
   mip_gnss_rf_error_detection_msg->jamming_state = static_cast<uint8_t>(rf_error_detection.jamming_state);
   mip_gnss_rf_error_detection_msg->spoofing_state = static_cast<uint8_t>(rf_error_detection.spoofing_state);
   mip_gnss_rf_error_detection_pub_[gnss_index]->publish(*mip_gnss_rf_error_detection_msg);
+
+  // Integrity state
+  if (gnss_integrity_pub_[gnss_index]->configured())
+    gnss_integrity_[gnss_index].updateRfBand(static_cast<uint8_t>(rf_error_detection.rf_band), static_cast<uint8_t>(rf_error_detection.jamming_state), static_cast<uint8_t>(rf_error_detection.spoofing_state));
 }
 
 void Publishers::handleGnssSbasInfo(const mip::data_gnss::SbasInfo& sbas_info, const uint8_t descriptor_set, mip::Timestamp timestamp)
@@ -1044,6 +1465,10 @@ void Publishers::handleGnssSbasInfo(const mip::data_gnss::SbasInfo& sbas_info, c
   mip_gnss_sbas_info_msg->sbas_status.integrity_available = sbas_info.sbas_status.integrityAvailable();
   mip_gnss_sbas_info_msg->sbas_status.test_mode = sbas_info.sbas_status.testMode();
   mip_gnss_sbas_info_pub_[gnss_index]->publish(*mip_gnss_sbas_info_msg);
+
+  // Integrity state
+  if (gnss_integrity_pub_[gnss_index]->configured())
+    gnss_integrity_[gnss_index].updateSbas(sbas_info.sbas_status.correctionsAvailable());
 }
 
 void Publishers::handleRtkCorrectionsStatus(const mip::data_gnss::RtkCorrectionsStatus& rtk_corrections_status, const uint8_t descriptor_set, mip::Timestamp timestamp)
@@ -1080,35 +1505,49 @@ void Publishers::handleRtkCorrectionsStatus(const mip::data_gnss::RtkCorrections
   mip_gnss_corrections_rtk_corrections_status_msg->galileo_correction_latency = rtk_corrections_status.galileo_correction_latency;
   mip_gnss_corrections_rtk_corrections_status_msg->beidou_correction_latency = rtk_corrections_status.beidou_correction_latency;
   mip_gnss_corrections_rtk_corrections_status_pub_->publish(*mip_gnss_corrections_rtk_corrections_status_msg);
+
+  // Integrity state. The corrections status is not tied to a receiver, so it applies to both. A latency of 0 means no corrections were received for that constellation
+  double corrections_age = -1;
+  for (const double latency : {rtk_corrections_status.gps_correction_latency, rtk_corrections_status.glonass_correction_latency, rtk_corrections_status.galileo_correction_latency, rtk_corrections_status.beidou_correction_latency})
+  {
+    if (latency > 0 && (corrections_age < 0 || latency < corrections_age))
+      corrections_age = latency;
+  }
+  for (size_t i = 0; i < NUM_GNSS; i++)
+  {
+    if (gnss_integrity_pub_[i]->configured())
+      gnss_integrity_[i].updateCorrectionsAge(corrections_age, timestamp / 1000.0);
+  }
 }
 
 void Publishers::handleRtkBaseStationInfo(const mip::data_gnss::BaseStationInfo& base_station_info, const uint8_t descriptor_set, mip::Timestamp timestamp)
 {
   // Only update the earth to map transform if it has changed
+  const RuntimeState runtime_state = config_->runtime_state_.load();
   const bool changed = (
-    base_station_info.ecef_pos[0] != config_->map_to_earth_transform_.transform.translation.x ||
-    base_station_info.ecef_pos[1] != config_->map_to_earth_transform_.transform.translation.y ||
-    base_station_info.ecef_pos[2] != config_->map_to_earth_transform_.transform.translation.z
+    base_station_info.ecef_pos[0] != runtime_state.map_to_earth_translation[0] ||
+    base_station_info.ecef_pos[1] != runtime_state.map_to_earth_translation[1] ||
+    base_station_info.ecef_pos[2] != runtime_state.map_to_earth_translation[2]
   );
   if (config_->filter_relative_pos_source_ == REL_POS_SOURCE_BASE_STATION && changed)
   {
-    updateHeaderTime(&(config_->map_to_earth_transform_.header), descriptor_set, timestamp);
-    config_->map_to_earth_transform_.transform.translation.x = base_station_info.ecef_pos[0];
-    config_->map_to_earth_transform_.transform.translation.y = base_station_info.ecef_pos[1];
-    config_->map_to_earth_transform_.transform.translation.z = base_station_info.ecef_pos[2];
+    TransformStampedMsg map_to_earth_transform;
+    updateHeaderTime(&(map_to_earth_transform.header), descriptor_set, timestamp);
+    map_to_earth_transform.transform.translation.x = base_station_info.ecef_pos[0];
+    map_to_earth_transform.transform.translation.y = base_station_info.ecef_pos[1];
+    map_to_earth_transform.transform.translation.z = base_station_info.ecef_pos[2];
 
     // Find the rotation between ECEF and the ENU/NED frame
     double lat, lon, alt;
-    config_->geocentric_converter_.Reverse(config_->map_to_earth_transform_.transform.translation.x, config_->map_to_earth_transform_.transform.translation.y, config_->map_to_earth_transform_.transform.translation.z, lat, lon, alt);
+    config_->geocentric_converter_.Reverse(base_station_info.ecef_pos[0], base_station_info.ecef_pos[1], base_station_info.ecef_pos[2], lat, lon, alt);
     if (config_->use_enu_frame_)
-      config_->map_to_earth_transform_.transform.rotation = tf2::toMsg(ecefToEnuTransformQuat(lat, lon));
+      map_to_earth_transform.transform.rotation = tf2::toMsg(ecefToEnuTransformQuat(lat, lon));
     else
-      config_->map_to_earth_transform_.transform.rotation = tf2::toMsg(ecefToNedTransformQuat(lat, lon));
+      map_to_earth_transform.transform.rotation = tf2::toMsg(ecefToNedTransformQuat(lat, lon));
 
     MICROSTRAIN_INFO_THROTTLE(node_, 10, "Base station info received, relative position will now be published relative to the following position");
     MICROSTRAIN_INFO_THROTTLE(node_, 10, "  LLH: [%f, %f, %f]", lat, lon, alt);
-    config_->map_to_earth_transform_valid_ = true;
-    config_->map_to_earth_transform_updated_ = true;
+    storeMapToEarthTransform(map_to_earth_transform.transform, getTimeRefSecs(map_to_earth_transform.header.stamp));
   }
 }
 
@@ -1126,8 +1565,12 @@ void Publishers::handleFilterStatus(const mip::data_filter::Status& status, cons
 {
   auto mip_filter_status_msg = mip_filter_status_pub_->getMessage();
   updateMipHeader(&(mip_filter_status_msg->header), descriptor_set, timestamp);
-  config_->filter_state_ = status.filter_state;
+  config_->runtime_state_.update([&status](RuntimeState* state) { state->filter_state = status.filter_state; });
   mip_filter_status_msg->filter_state = static_cast<uint16_t>(status.filter_state);
+
+  // Whether the filter rejects a measurement only says something about the source once the filter has a solution
+  if (config_->aiding_health_ != nullptr)
+    config_->aiding_health_->setFilterRunning(fullNav());
   mip_filter_status_msg->dynamics_mode = static_cast<uint16_t>(status.dynamics_mode);
 
   // Populate both the philo and prospect flags, it is up to the customer to determine which device they have
@@ -1166,7 +1609,7 @@ void Publishers::handleFilterStatus(const mip::data_filter::Status& status, cons
   auto filter_human_readable_status_msg = filter_human_readable_status_pub_->getMessageToUpdate();
   updateHeaderTime(&filter_human_readable_status_msg->header, descriptor_set, timestamp);
   filter_human_readable_status_msg->status_flags.clear();
-  if (RosMipDevice::isPhilo(config_->mip_device_->device_info_))  // Philo products
+  if (BuildFeatures::PHILO && philo_device_)  // Philo products
   {
     switch (status.filter_state)
     {
@@ -1218,7 +1661,7 @@ void Publishers::handleFilterStatus(const mip::data_filter::Status& status, cons
     if (status.status_flags.gx5RunMagSoftIronEstHighWarning())
       filter_human_readable_status_msg->status_flags.push_back(HumanReadableStatusMsg::STATUS_FLAGS_GX5_RUN_MAG_SOFT_IRON_EST_HIGH_WARNING);
   }
-  else if (RosMipDevice::isProspect(config_->mip_device_->device_info_))  // Prospect products
+  else if (prospect_device_)  // Prospect products
   {
     switch (status.filter_state)
     {
@@ -1286,12 +1729,8 @@ void Publishers::handleFilterEcefPos(const mip::data_filter::EcefPos& ecef_pos,
     imu_link_to_earth_transform_tf_stamped_.setOrigin(tf2::Vector3(ecef_pos.position_ecef[0], ecef_pos.position_ecef[1], ecef_pos.position_ecef[2]));
   }
   // If the earth to map transform is not valid and we entered full navigation mode, populate the transform with this position
-  const bool full_nav =
-  (
-    (RosMipDevice::isPhilo(config_->mip_device_->device_info_) && config_->filter_state_ == mip::data_filter::FilterMode::GX5_RUN_SOLUTION_VALID) ||
-    (RosMipDevice::isProspect(config_->mip_device_->device_info_) && config_->filter_state_ == mip::data_filter::FilterMode::FULL_NAV)
-  );
-  if (!config_->map_to_earth_transform_valid_ && config_->filter_relative_pos_source_ == REL_POS_SOURCE_AUTO && full_nav)
+  const RuntimeState runtime_state = config_->runtime_state_.load();
+  if (!runtime_state.map_to_earth_valid && config_->filter_relative_pos_source_ == REL_POS_SOURCE_AUTO && fullNav(runtime_state))
   {
     // Find the rotation between ECEF and NED/ENU for this position
     double lat, lon, alt;
@@ -1300,14 +1739,12 @@ void Publishers::handleFilterEcefPos(const mip::data_filter::EcefPos& ecef_pos,
       config_->use_enu_frame_ ? ecefToEnuTransform(lat, lon).inverse() : ecefToNedTransform(lat, lon).inverse(),
       tf2::Vector3(ecef_pos.position_ecef[0], ecef_pos.position_ecef[1], ecef_pos.position_ecef[2])
     );
-    config_->map_to_earth_transform_.header.stamp = rosTimeNow(node_);
-    config_->map_to_earth_transform_.transform = tf2::toMsg(map_to_earth_transform_tf);
+    const TransformMsg map_to_earth_transform = tf2::toMsg(map_to_earth_transform_tf);
 
     MICROSTRAIN_INFO(node_, "Full nav achieved. Relative position will be reported relative to the following position");
     MICROSTRAIN_INFO(node_, "  LLH: [%f, %f, %f]", lat, lon, alt);
-    MICROSTRAIN_INFO(node_, "  XYZW: [%f, %f, %f, %f]", config_->map_to_earth_transform_.transform.rotation.x, config_->map_to_earth_transform_.transform.rotation.y, config_->map_to_earth_transform_.transform.rotation.z, config_->map_to_earth_transform_.transform.rotation.w);
-    config_->map_to_earth_transform_valid_ = true;
-    config_->map_to_earth_transform_updated_ = true;
+    MICROSTRAIN_INFO(node_, "  XYZW: [%f, %f, %f, %f]", map_to_earth_transform.rotation.x, map_to_earth_transform.rotation.y, map_to_earth_transform.rotation.z, map_to_earth_transform.rotation.w);
+    storeMapToEarthTransform(map_to_earth_transform, config_->clock_->now());
   }
 
   // If the map odometry message is enabled and we have relative position configuration attempt to transform the global position to the map frame
@@ -1321,8 +1758,13 @@ void Publishers::handleFilterEcefPos(const mip::data_filter::EcefPos& ecef_pos,
     map_to_earth_transform.child_frame_id = config_->map_frame_id_ + "_UNPOPULATED";
     if (config_->filter_relative_pos_source_ == REL_POS_SOURCE_EXTERNAL && transform_buffer_->canTransform(config_->earth_frame_id_, config_->map_frame_id_, frame_time, RosDurationType(0, 0), &tf_error_string))
       map_to_earth_transform = transform_buffer_->lookupTransform(config_->earth_frame_id_, config_->map_frame_id_, frame_time);
-    else if (config_->filter_relative_pos_source_ != REL_POS_SOURCE_EXTERNAL && config_->map_to_earth_transform_valid_)
-      map_to_earth_transform = config_->map_to_earth_transform_;
+    else if (config_->filter_relative_pos_source_ != REL_POS_SOURCE_EXTERNAL)
+    {
+      // Reload the state, as the transform may have just been populated above
+      const RuntimeState current_state = config_->runtime_state_.load();
+      if (current_state.map_to_earth_valid)
+        map_to_earth_transform = mapToEarthTransform(current_state);
+    }
 
     // Check if we have a valid transform
     if (map_to_earth_transform.header.frame_id == config_->earth_frame_id_ && map_to_earth_transform.child_frame_id == config_->map_frame_id_)
@@ -1343,7 +1785,7 @@ void Publishers::handleFilterEcefPos(const mip::data_filter::EcefPos& ecef_pos,
       // Fill in the map to imu link transform if the data is valid
       if (ecef_pos.valid_flags == 1)
       {
-        imu_link_to_map_transform_tf_stamped_.stamp_ = tf2_ros::fromMsg(rosTimeNow(node_));
+        imu_link_to_map_transform_tf_stamped_.stamp_ = tf2_ros::fromMsg(config_->clock_->rosNow());
         imu_link_to_map_transform_tf_stamped_.setOrigin(imu_to_map_transform_tf.getOrigin());
         imu_link_to_map_transform_translation_updated_ = true;
       }
@@ -1380,6 +1822,9 @@ void Publishers::handleFilterPositionLlh(const mip::data_filter::PositionLlh& po
   filter_llh_position_msg->longitude = position_llh.longitude;
   filter_llh_position_msg->altitude = position_llh.ellipsoid_height;
 
+  // Host NMEA
+  filter_nmea_generator_.updatePosition(position_llh.latitude, position_llh.longitude, position_llh.ellipsoid_height - geoid_separation_, geoid_separation_);
+
   // If the device does not support ECEF, fill it out here, and call the callback ourselves
   if (!supports_filter_ecef_)
   {
@@ -1396,6 +1841,8 @@ void Publishers::handleFilterPositionLlhUncertainty(const mip::data_filter::Posi
   // If we have to rotate the covariance, it is easier to do when uncertaintty is in a covariance matrix.
   // NOTE: The rotation between the microstrain vehicle and ROS vehicle is essentially the same for covariance.
   //       Since all it does is negate the y and z axis, but that gets squared anyways.
+  signal_statistics_.add(STATISTICS_FILTER_POSITION_UNCERTAINTY, position_llh_uncertainty.north, position_llh_uncertainty.east, position_llh_uncertainty.down);
+
   const double n = pow(position_llh_uncertainty.north, 2);
   const double e = pow(position_llh_uncertainty.east, 2);
   const double d = pow(position_llh_uncertainty.down, 2);
@@ -1475,7 +1922,7 @@ void Publishers::handleFilterAttitudeQuaternion(const mip::data_filter::Attitude
     imu_link_to_earth_transform_tf_stamped_.setBasis(microstrain_vehicle_to_earth_transform_tf.getBasis());
     filter_odometry_earth_msg->pose.pose.orientation = tf2::toMsg(microstrain_vehicle_to_earth_transform_tf.getRotation());
   }
-  imu_link_to_earth_transform_tf_stamped_.stamp_ = tf2_ros::fromMsg(rosTimeNow(node_));
+  imu_link_to_earth_transform_tf_stamped_.stamp_ = tf2_ros::fromMsg(config_->clock_->rosNow());
   imu_link_to_earth_transform_attitude_updated_ = true;
 
   // Filtered IMU message
@@ -1499,7 +1946,7 @@ void Publishers::handleFilterAttitudeQuaternion(const mip::data_filter::Attitude
     filter_odometry_map_msg->pose.pose.orientation = tf2::toMsg(microstrain_vehicle_to_ned_transform_tf.getRotation());
     filter_imu_msg->orientation = tf2::toMsg(microstrain_vehicle_to_ned_transform_tf.getRotation());
   }
-  imu_link_to_map_transform_tf_stamped_.stamp_ = tf2_ros::fromMsg(rosTimeNow(node_));
+  imu_link_to_map_transform_tf_stamped_.stamp_ = tf2_ros::fromMsg(config_->clock_->rosNow());
   imu_link_to_map_transform_attitude_updated_ = true;
 }
 
@@ -1508,6 +1955,8 @@ void Publishers::handleFilterEulerAnglesUncertainty(const mip::data_filter::Eule
   // If we have to rotate the covariance, it is easier to do when uncertaintty is in a covariance matrix.
   // NOTE: The rotation between the microstrain vehicle and ROS vehicle is essentially the same for covariance.
   //       Since all it does is negate the y and z axis, but that gets squared anyways.
+  signal_statistics_.add(STATISTICS_FILTER_ATTITUDE_UNCERTAINTY, euler_angles_uncertainty.roll, euler_angles_uncertainty.pitch, euler_angles_uncertainty.yaw);
+
   const double r = pow(euler_angles_uncertainty.roll, 2);
   const double p = pow(euler_angles_uncertainty.pitch, 2);
   const double y = pow(euler_angles_uncertainty.yaw, 2);
@@ -1551,6 +2000,9 @@ void Publishers::handleFilterEulerAnglesUncertainty(const mip::data_filter::Eule
 
 void Publishers::handleFilterVelocityNed(const mip::data_filter::VelocityNed& velocity_ned, const uint8_t descriptor_set, mip::Timestamp timestamp)
 {
+  // Host NMEA
+  filter_nmea_generator_.updateVelocity(velocity_ned.north, velocity_ned.east);
+
   // Filter ENU velocity message
   auto filter_velocity_msg = filter_velocity_pub_->getMessageToUpdate();
   updateHeaderTime(&(filter_velocity_msg->header), descriptor_set, timestamp);
@@ -1595,6 +2047,8 @@ void Publishers::handleFilterVelocityNed(const mip::data_filter::VelocityNed& ve
 
 void Publishers::handleFilterVelocityNedUncertainty(const mip::data_filter::VelocityNedUncertainty& velocity_ned_uncertainty, const uint8_t descriptor_set, mip::Timestamp timestamp)
 {
+  signal_statistics_.add(STATISTICS_FILTER_VELOCITY_UNCERTAINTY, velocity_ned_uncertainty.north, velocity_ned_uncertainty.east, velocity_ned_uncertainty.down);
+
   // Filter ENU velocity message
   auto filter_velocity_msg = filter_velocity_pub_->getMessageToUpdate();
   updateHeaderTime(&(filter_velocity_msg->header), descriptor_set, timestamp);
@@ -1751,6 +2205,10 @@ void Publishers::handleFilterGnssPosAidStatus(const mip::data_filter::GnssPosAid
   mip_filter_gnss_position_aiding_status_msg->status.config_error = gnss_pos_aid_status.status.configError();
   mip_filter_gnss_position_aiding_status_pub_->publish(*mip_filter_gnss_position_aiding_status_msg);
 
+  // The receiver ID is used as an index below, so ignore any receiver we do not know about
+  if (gnss_pos_aid_status.receiver_id < 1 || gnss_pos_aid_status.receiver_id > NUM_GNSS)
+    return;
+
   // Filter fix message (not counted as updating)
   auto filter_llh_position_msg = filter_llh_position_pub_->getMessage();
 
@@ -1807,9 +2265,13 @@ void Publishers::handleFilterMultiAntennaOffsetCorrection(const mip::data_filter
   mip_filter_multi_antenna_offset_correction_msg->offset[2] = multi_antenna_offset_correction.offset[2];
   mip_filter_multi_antenna_offset_correction_pub_->publish(*mip_filter_multi_antenna_offset_correction_msg);
 
+  // The receiver ID is used as an index below, so ignore any receiver we do not know about
+  if (multi_antenna_offset_correction.receiver_id < 1 || multi_antenna_offset_correction.receiver_id > NUM_GNSS)
+    return;
+
   const tf2::Transform gnss_x_antenna_correction_to_microstrain_vehicle_tf(tf2::Quaternion::getIdentity(), tf2::Vector3(multi_antenna_offset_correction.offset[0], multi_antenna_offset_correction.offset[1], multi_antenna_offset_correction.offset[2]));
   TransformStampedMsg gnss_x_antenna_to_imu_link_transform = gnss_antenna_link_to_imu_link_transform_[multi_antenna_offset_correction.receiver_id - 1];
-  gnss_x_antenna_to_imu_link_transform.header.stamp = rosTimeNow(node_);
+  gnss_x_antenna_to_imu_link_transform.header.stamp = config_->clock_->rosNow();
   if (config_->use_enu_frame_)
   {
     const tf2::Transform gnss_x_antenna_correction_to_ros_vehicle_tf = config_->ros_vehicle_to_microstrain_vehicle_transform_tf_.inverse() * gnss_x_antenna_correction_to_microstrain_vehicle_tf;
@@ -1893,6 +2355,13 @@ void Publishers::handleFilterAidingMeasurementSummary(const mip::data_filter::Ai
   mip_filter_aiding_measurement_summary_msg->indicator.configuration_error = aiding_measurement_summary.indicator.configurationError();
   mip_filter_aiding_measurement_summary_msg->indicator.max_num_meas_exceeded = aiding_measurement_summary.indicator.maxNumMeasExceeded();
   mip_filter_aiding_measurement_summary_pub_->publish(*mip_filter_aiding_measurement_summary_msg);
+
+  // Let the subscribers know how the filter is treating the measurements they send. Summaries are ignored unless the filter is running
+  if (config_->aiding_health_ != nullptr && aiding_measurement_summary.indicator.enabled())
+  {
+    config_->aiding_health_->recordSummary(static_cast<uint8_t>(aiding_measurement_summary.type), aiding_measurement_summary.source,
+      aiding_measurement_summary.indicator.used(), aiding_measurement_summary.indicator.residualHighWarning(), aiding_measurement_summary.indicator.sampleTimeWarning());
+  }
 }
 
 void Publishers::handleSystemBuiltInTest(const mip::data_system::BuiltInTest& built_in_test, const uint8_t descriptor_set, mip::Timestamp timestamp)
@@ -2081,11 +2550,44 @@ void Publishers::handleSystemBuiltInTest(const mip::data_system::BuiltInTest& bu
   }
 }
 
+void Publishers::handleBeforePacket(const mip::PacketRef& packet, mip::Timestamp timestamp)
+{
+  if (config_->perf_profiler_ != nullptr)
+    config_->perf_profiler_->begin(PerfProfiler::STAGE_HANDLERS);
+  for (FieldTrigger* early_publisher : early_publishers_)
+    early_publisher->armForPacket(packet);
+}
+
+void Publishers::handleAfterField(const mip::Field& field, mip::Timestamp timestamp)
+{
+  for (FieldTrigger* early_publisher : early_publishers_)
+    early_publisher->handleField(field);
+}
+
 void Publishers::handleAfterPacket(const mip::PacketRef& packet, mip::Timestamp timestamp)
 {
+  if (config_->perf_profiler_ != nullptr)
+  {
+    config_->perf_profiler_->end(PerfProfiler::STAGE_HANDLERS, packet.descriptorSet());
+    config_->perf_profiler_->begin(PerfProfiler::STAGE_PUBLISH);
+  }
+
   // Publish all the messages that have been updated
   publish();
 
+  if (config_->perf_profiler_ != nullptr)
+    config_->perf_profiler_->end(PerfProfiler::STAGE_PUBLISH, packet.descriptorSet());
+
+  // Generate NMEA sentences before the filter state below is reset
+  if (BuildFeatures::NMEA)
+    publishHostNmea(packet.descriptorSet(), timestamp);
+
+  // Summarize the signal statistics if the window has elapsed
+  publishSignalStatistics(timestamp);
+  publishVibrationAnalysis(timestamp);
+  publishMemoryUsage(timestamp);
+  publishGnssIntegrity(packet.descriptorSet(), timestamp);
+
   // Reset some shared descriptors. These are unique to the packets, and we do not want to cache them past this packet
   if (event_source_mapping_.find(packet.descriptorSet()) != event_source_mapping_.end())
     event_source_mapping_[packet.descriptorSet()].trigger_id = 0;
@@ -2097,6 +2599,206 @@ void Publishers::handleAfterPacket(const mip::PacketRef& packet, mip::Timestamp
   has_fix_ = false;
 }
 
+bool Publishers::fullNav() const
+{
+  return fullNav(config_->runtime_state_.load());
+}
+
+bool Publishers::fullNav(const RuntimeState& state) const
+{
+  return (BuildFeatures::PHILO && philo_device_ && state.filter_state == mip::data_filter::FilterMode::GX5_RUN_SOLUTION_VALID) ||
+    (prospect_device_ && state.filter_state == mip::data_filter::FilterMode::FULL_NAV);
+}
+
+TransformStampedMsg Publishers::mapToEarthTransform(const RuntimeState& state) const
+{
+  TransformStampedMsg map_to_earth_transform;
+  map_to_earth_transform.header.frame_id = config_->earth_frame_id_;
+  map_to_earth_transform.child_frame_id = config_->map_frame_id_;
+  setRosTime(&map_to_earth_transform.header.stamp, state.map_to_earth_stamp);
+  map_to_earth_transform.transform.translation.x = state.map_to_earth_translation[0];
+  map_to_earth_transform.transform.translation.y = state.map_to_earth_translation[1];
+  map_to_earth_transform.transform.translation.z = state.map_to_earth_translation[2];
+  map_to_earth_transform.transform.rotation.x = state.map_to_earth_rotation[0];
+  map_to_earth_transform.transform.rotation.y = state.map_to_earth_rotation[1];
+  map_to_earth_transform.transform.rotation.z = state.map_to_earth_rotation[2];
+  map_to_earth_transform.transform.rotation.w = state.map_to_earth_rotation[3];
+  return map_to_earth_transform;
+}
+
+void Publishers::storeMapToEarthTransform(const TransformMsg& transform, const double stamp)
+{
+  config_->runtime_state_.update([&transform, stamp](RuntimeState* state)
+  {
+    state->map_to_earth_valid = true;
+    state->map_to_earth_revision++;
+    state->map_to_earth_stamp = stamp;
+    state->map_to_earth_translation[0] = transform.translation.x;
+    state->map_to_earth_translation[1] = transform.translation.y;
+    state->map_to_earth_translation[2] = transform.translation.z;
+    state->map_to_earth_rotation[0] = transform.rotation.x;
+    state->map_to_earth_rotation[1] = transform.rotation.y;
+    state->map_to_earth_rotation[2] = transform.rotation.z;
+    state->map_to_earth_rotation[3] = transform.rotation.w;
+  });
+}
+
+void Publishers::publishHostNmea(uint8_t descriptor_set, mip::Timestamp timestamp)
+{
+  // Find the generator for this descriptor set
+  NmeaGenerator* nmea_generator;
+  std::string frame_id;
+  switch (descriptor_set)
+  {
+    case mip::data_gnss::DESCRIPTOR_SET:
+    case mip::data_gnss::MIP_GNSS1_DATA_DESC_SET:
+      nmea_generator = &gnss_nmea_generator_[GNSS1_ID];
+      frame_id = config_->gnss_frame_id_[GNSS1_ID];
+      break;
+    case mip::data_gnss::MIP_GNSS2_DATA_DESC_SET:
+      nmea_generator = &gnss_nmea_generator_[GNSS2_ID];
+      frame_id = config_->gnss_frame_id_[GNSS2_ID];
+      break;
+    case mip::data_filter::DESCRIPTOR_SET:
+      nmea_generator = &filter_nmea_generator_;
+      frame_id = config_->frame_id_;
+      break;
+    default:
+      return;
+  }
+  if (!nmea_generator->enabled() || gps_timestamp_mapping_.find(descriptor_set) == gps_timestamp_mapping_.end())
+    return;
+
+  // The filter does not report a fix type, so determine it from the filter state and the GNSS aiding status
+  if (descriptor_set == mip::data_filter::DESCRIPTOR_SET)
+  {
+    const bool full_nav = fullNav();
+    const auto& gnss_state = filter_human_readable_status_pub_->getMessage()->gnss_state;
+    uint8_t nmea_fix_quality;
+    if (!full_nav)
+      nmea_fix_quality = NmeaGenerator::FIX_QUALITY_INVALID;
+    else if (gnss_state == HumanReadableStatusMsg::GNSS_STATE_RTK_FIXED)
+      nmea_fix_quality = NmeaGenerator::FIX_QUALITY_RTK_FIXED;
+    else if (gnss_state == HumanReadableStatusMsg::GNSS_STATE_RTK_FLOAT)
+      nmea_fix_quality = NmeaGenerator::FIX_QUALITY_RTK_FLOAT;
+    else if (gnss_state == HumanReadableStatusMsg::GNSS_STATE_SBAS)
+      nmea_fix_quality = NmeaGenerator::FIX_QUALITY_DGNSS;
+    else if (gnss_state == HumanReadableStatusMsg::GNSS_STATE_3D_FIX)
+      nmea_fix_quality = NmeaGenerator::FIX_QUALITY_GNSS;
+    else
+      nmea_fix_quality = NmeaGenerator::FIX_QUALITY_ESTIMATED;
+    nmea_generator->updateFix(nmea_fix_quality, std::max(gnss_num_sv_[GNSS1_ID], gnss_num_sv_[GNSS2_ID]));
+  }
+
+  std::string gga_sentence;
+  for (const auto& sentence : nmea_generator->generate(gps_timestamp_mapping_.at(descriptor_set), &gga_sentence))
+  {
+    NMEASentenceMsg nmea_sentence_msg;
+    updateHeaderTime(&(nmea_sentence_msg.header), descriptor_set, timestamp);
+    nmea_sentence_msg.header.frame_id = frame_id;
+    nmea_sentence_msg.sentence = sentence;
+    nmea_sentence_pub_->publish(nmea_sentence_msg);
+  }
+
+  // Optionally forward the GGA sentence to the aux port so it can be sent to an NTRIP caster
+  if (config_->host_nmea_aux_port_gga_ && config_->aux_device_ != nullptr && !gga_sentence.empty())
+  {
+    if (!config_->aux_device_->send(reinterpret_cast<const uint8_t*>(gga_sentence.data()), gga_sentence.size()))
+      MICROSTRAIN_ERROR_THROTTLE(node_, 1, "Failed to write GGA sentence to the aux port");
+  }
+}
+
+void Publishers::publishSignalStatistics(mip::Timestamp timestamp)
+{
+  if (!signal_statistics_pub_->configured())
+    return;
+
+  // The window is measured using the time the packets were received, so it does not depend on any one descriptor set
+  const double timestamp_secs = timestamp / 1000.0;
+  if (signal_statistics_window_start_ < 0 || timestamp_secs < signal_statistics_window_start_)
+  {
+    signal_statistics_window_start_ = timestamp_secs;
+    return;
+  }
+  if (timestamp_secs - signal_statistics_window_start_ < config_->signal_statistics_window_)
+    return;
+  signal_statistics_window_start_ = timestamp_secs;
+
+  auto signal_statistics_msg = signal_statistics_pub_->getMessage();
+  signal_statistics_.summarize(&(signal_statistics_msg->data));
+  signal_statistics_pub_->publish(*signal_statistics_msg);
+}
+
+void Publishers::publishVibrationAnalysis(mip::Timestamp timestamp)
+{
+  if (vibration_analyzer_ == nullptr)
+    return;
+
+  // The spectra are computed in the background, so this only averages whatever segments have been processed since the last summary
+  const double timestamp_secs = timestamp / 1000.0;
+  if (vibration_analysis_last_publish_ < 0 || timestamp_secs < vibration_analysis_last_publish_)
+  {
+    vibration_analysis_last_publish_ = timestamp_secs;
+    return;
+  }
+  if (timestamp_secs - vibration_analysis_last_publish_ < 1.0 / config_->vibration_analysis_publish_rate_)
+    return;
+  vibration_analysis_last_publish_ = timestamp_secs;
+
+  auto vibration_analysis_msg = vibration_analysis_pub_->getMessage();
+  vibration_analyzer_->summarize(&(vibration_analysis_msg->data));
+  vibration_analysis_pub_->publish(*vibration_analysis_msg);
+}
+
+void Publishers::publishMemoryUsage(mip::Timestamp timestamp)
+{
+  if (!memory_usage_pub_->configured())
+    return;
+
+  // The first call only starts the clock for the allocation rate
+  const double timestamp_secs = timestamp / 1000.0;
+  const double elapsed = timestamp_secs - memory_usage_last_publish_;
+  if (memory_usage_last_publish_ < 0 || elapsed < 0)
+  {
+    memory_usage_last_publish_ = timestamp_secs;
+    for (size_t tag = 0; tag < NUM_MEMORY_TAGS; tag++)
+      memory_usage_last_allocations_[tag] = MemoryTracker::usage(static_cast<MemoryTag>(tag)).allocations;
+    return;
+  }
+  if (elapsed < 1.0 / config_->memory_tracking_publish_rate_)
+    return;
+  memory_usage_last_publish_ = timestamp_secs;
+
+  auto memory_usage_msg = memory_usage_pub_->getMessage();
+  for (size_t tag = 0; tag < NUM_MEMORY_TAGS; tag++)
+  {
+    const MemoryTracker::Usage usage = MemoryTracker::usage(static_cast<MemoryTag>(tag));
+    memory_usage_msg->data[tag * 3 + 0] = static_cast<double>(usage.live_bytes);
+    memory_usage_msg->data[tag * 3 + 1] = static_cast<double>(usage.peak_bytes);
+    memory_usage_msg->data[tag * 3 + 2] = (usage.allocations - memory_usage_last_allocations_[tag]) / elapsed;
+    memory_usage_last_allocations_[tag] = usage.allocations;
+  }
+  memory_usage_pub_->publish(*memory_usage_msg);
+}
+
+void Publishers::publishGnssIntegrity(uint8_t descriptor_set, mip::Timestamp timestamp)
+{
+  const double timestamp_secs = timestamp / 1000.0;
+  for (size_t i = 0; i < NUM_GNSS; i++)
+  {
+    if (!gnss_integrity_pub_[i]->configured() || !gnss_integrity_[i].evaluate(timestamp_secs))
+      continue;
+
+    // Stamped the same way a header of the packet that changed the state would be
+    RosHeaderType header;
+    updateHeaderTime(&header, descriptor_set, timestamp);
+    auto gnss_integrity_msg = gnss_integrity_pub_[i]->getMessage();
+    gnss_integrity_msg->data[0] = getTimeRefSecs(header.stamp);
+    gnss_integrity_[i].toArray(gnss_integrity_msg->data.data() + 1);
+    gnss_integrity_pub_[i]->publish(*gnss_integrity_msg);
+  }
+}
+
 void Publishers::updateMipHeader(MipHeaderMsg* mip_header, uint8_t descriptor_set, mip::Timestamp timestamp, const mip::data_shared::GpsTimestamp* gps_timestamp)
 {
   // Update the ROS header with the ROS timestamp
@@ -8,9 +8,11 @@
 //
 /////////////////////////////////////////////////////////////////////////////////////////////////////
 
+#include <cstdio>
 #include <string>
 #include <memory>
 #include <iomanip>
+#include <sstream>
 
 #include "microstrain_inertial_driver_common/services.h"
 
@@ -49,11 +51,49 @@ bool Services::configure()
     mip_filter_reset_service_ = configureService<EmptySrv, Reset>(MIP_FILTER_RESET_SERVICE, &Services::mipFilterReset);
   }
 
+  // Setup the analysis services
+  if (config_->allan_variance_ != nullptr)
+  {
+    imu_allan_variance_read_service_ = configureService<TriggerSrv>(IMU_ALLAN_VARIANCE_READ_SERVICE, &Services::imuAllanVarianceRead);
+    imu_allan_variance_reset_service_ = configureService<EmptySrv>(IMU_ALLAN_VARIANCE_RESET_SERVICE, &Services::imuAllanVarianceReset);
+  }
+  if (config_->perf_profiler_ != nullptr)
+  {
+    perf_counters_read_service_ = configureService<TriggerSrv>(PERF_COUNTERS_READ_SERVICE, &Services::perfCountersRead);
+    perf_counters_reset_service_ = configureService<EmptySrv>(PERF_COUNTERS_RESET_SERVICE, &Services::perfCountersReset);
+  }
+  if (config_->rtcm_framer_ != nullptr)
+  {
+    rtcm_statistics_read_service_ = configureService<TriggerSrv>(RTCM_STATISTICS_READ_SERVICE, &Services::rtcmStatisticsRead);
+    rtcm_statistics_reset_service_ = configureService<EmptySrv>(RTCM_STATISTICS_RESET_SERVICE, &Services::rtcmStatisticsReset);
+  }
+  if (!config_->dejitter_statistics_.empty())
+  {
+    dejitter_statistics_read_service_ = configureService<TriggerSrv>(DEJITTER_STATISTICS_READ_SERVICE, &Services::dejitterStatisticsRead);
+    dejitter_statistics_reset_service_ = configureService<EmptySrv>(DEJITTER_STATISTICS_RESET_SERVICE, &Services::dejitterStatisticsReset);
+  }
+  if (config_->aiding_callback_benchmark_ != nullptr)
+    aiding_callback_benchmark_read_service_ = configureService<TriggerSrv>(AIDING_CALLBACK_BENCHMARK_READ_SERVICE, &Services::aidingCallbackBenchmarkRead);
+  if (config_->aiding_health_ != nullptr)
+  {
+    aiding_health_read_service_ = configureService<TriggerSrv>(AIDING_HEALTH_READ_SERVICE, &Services::aidingHealthRead);
+    aiding_health_reset_service_ = configureService<EmptySrv>(AIDING_HEALTH_RESET_SERVICE, &Services::aidingHealthReset);
+  }
+  if (config_->mag_calibrator_ != nullptr)
+  {
+    mag_calibration_read_service_ = configureService<TriggerSrv>(MAG_CALIBRATION_READ_SERVICE, &Services::magCalibrationRead);
+    mag_calibration_write_service_ = configureService<TriggerSrv>(MAG_CALIBRATION_WRITE_SERVICE, &Services::magCalibrationWrite);
+    mag_calibration_force_write_service_ = configureService<TriggerSrv>(MAG_CALIBRATION_FORCE_WRITE_SERVICE, &Services::magCalibrationForceWrite);
+    mag_calibration_reset_service_ = configureService<EmptySrv>(MAG_CALIBRATION_RESET_SERVICE, &Services::magCalibrationReset);
+  }
+
   return true;
 }
 
 bool Services::rawFileConfigMainRead(RawFileConfigReadSrv::Request& req, RawFileConfigReadSrv::Response& res)
 {
+  MemoryTracker::Scope memory_scope(MEMORY_TAG_SERVICES);
+
   // Make sure that the connection is initialized
   const auto connection = config_->mip_device_->connection();
   if (connection == nullptr)
@@ -67,6 +107,8 @@ bool Services::rawFileConfigMainRead(RawFileConfigReadSrv::Request& req, RawFile
 
 bool Services::rawFileConfigMainWrite(RawFileConfigWriteSrv::Request& req, RawFileConfigWriteSrv::Response& res)
 {
+  MemoryTracker::Scope memory_scope(MEMORY_TAG_SERVICES);
+
   // Make sure that the connection is initialized
   const auto connection = config_->mip_device_->connection();
   if (connection == nullptr)
@@ -112,6 +154,8 @@ bool Services::rawFileConfigMainWrite(RawFileConfigWriteSrv::Request& req, RawFi
 
 bool Services::rawFileConfigAuxRead(RawFileConfigReadSrv::Request& req, RawFileConfigReadSrv::Response& res)
 {
+  MemoryTracker::Scope memory_scope(MEMORY_TAG_SERVICES);
+
   // Make sure that the connection is initialized
   if (config_->aux_device_ == nullptr)
     return false;
@@ -127,6 +171,8 @@ bool Services::rawFileConfigAuxRead(RawFileConfigReadSrv::Request& req, RawFileC
 
 bool Services::rawFileConfigAuxWrite(RawFileConfigWriteSrv::Request& req, RawFileConfigWriteSrv::Response& res)
 {
+  MemoryTracker::Scope memory_scope(MEMORY_TAG_SERVICES);
+
   // Make sure that the connection is initialized
   if (config_->aux_device_ == nullptr)
     return false;
@@ -140,6 +186,8 @@ bool Services::rawFileConfigAuxWrite(RawFileConfigWriteSrv::Request& req, RawFil
 
 bool Services::mipBaseGetDeviceInformation(MipBaseGetDeviceInformationSrv::Request& req, MipBaseGetDeviceInformationSrv::Response& res)
 {
+  MemoryTracker::Scope memory_scope(MEMORY_TAG_SERVICES);
+
   MICROSTRAIN_DEBUG(node_, "Getting device information");
 
   const mip::CmdResult mip_cmd_result = config_->mip_device_->getDeviceInfo(&config_->mip_device_->device_info_);
@@ -169,6 +217,8 @@ bool Services::mipBaseGetDeviceInformation(MipBaseGetDeviceInformationSrv::Reque
 
 bool Services::mip3dmCaptureGyroBias(Mip3dmCaptureGyroBiasSrv::Request& req, Mip3dmCaptureGyroBiasSrv::Response& res)
 {
+  MemoryTracker::Scope memory_scope(MEMORY_TAG_SERVICES);
+
   const int32_t capture_timeout = 10000;
   MICROSTRAIN_DEBUG(node_, "Capturing gyro bias");
   MICROSTRAIN_WARN(node_, "Performing Gyro Bias capture. Device will pause publshing during this time period");
@@ -202,6 +252,8 @@ bool Services::mip3dmCaptureGyroBias(Mip3dmCaptureGyroBiasSrv::Request& req, Mip
 
 bool Services::mip3dmDeviceSettingsSave(EmptySrv::Request& req, EmptySrv::Response& res)
 {
+  MemoryTracker::Scope memory_scope(MEMORY_TAG_SERVICES);
+
   MICROSTRAIN_DEBUG(node_, "Saving device settings");
 
   // We need to change the timeout to allow for this longer command
@@ -222,6 +274,8 @@ bool Services::mip3dmDeviceSettingsSave(EmptySrv::Request& req, EmptySrv::Respon
 
 bool Services::mip3dmDeviceSettingsLoad(EmptySrv::Request& req, EmptySrv::Response& res)
 {
+  MemoryTracker::Scope memory_scope(MEMORY_TAG_SERVICES);
+
   MICROSTRAIN_DEBUG(node_, "Loading device settings");
 
   // We need to change the timeout to allow for this longer command
@@ -242,6 +296,8 @@ bool Services::mip3dmDeviceSettingsLoad(EmptySrv::Request& req, EmptySrv::Respon
 
 bool Services::mipFilterReset(EmptySrv::Request& req, EmptySrv::Response& res)
 {
+  MemoryTracker::Scope memory_scope(MEMORY_TAG_SERVICES);
+
   MICROSTRAIN_DEBUG(node_, "Resetting filter");
 
   const mip::CmdResult mip_cmd_result = mip::commands_filter::reset(*(config_->mip_device_));
@@ -253,8 +309,11 @@ bool Services::mipFilterReset(EmptySrv::Request& req, EmptySrv::Response& res)
   // If we are using auto relative position config, reset that flag
   if (config_->filter_relative_pos_source_ == REL_POS_SOURCE_AUTO)
   {
-    config_->map_to_earth_transform_valid_ = false;
-    config_->filter_state_ = static_cast<mip::data_filter::FilterMode>(0);
+    config_->runtime_state_.update([](RuntimeState* state)
+    {
+      state->map_to_earth_valid = false;
+      state->filter_state = static_cast<mip::data_filter::FilterMode>(0);
+    });
   }
 
   return !!mip_cmd_result;
@@ -262,6 +321,8 @@ bool Services::mipFilterReset(EmptySrv::Request& req, EmptySrv::Response& res)
 
 bool Services::mip3dmGpioStateRead(Mip3dmGpioStateReadSrv::Request& req, Mip3dmGpioStateReadSrv::Response& res)
 {
+  MemoryTracker::Scope memory_scope(MEMORY_TAG_SERVICES);
+
   MICROSTRAIN_DEBUG(node_, "Reading GPIO state for pin %u", req.pin);
 
   bool state;
@@ -276,6 +337,8 @@ bool Services::mip3dmGpioStateRead(Mip3dmGpioStateReadSrv::Request& req, Mip3dmG
 
 bool Services::mip3dmGpioStateWrite(Mip3dmGpioStateWriteSrv::Request& req, Mip3dmGpioStateWriteSrv::Response& res)
 {
+  MemoryTracker::Scope memory_scope(MEMORY_TAG_SERVICES);
+
   MICROSTRAIN_DEBUG(node_, "Writing GPIO state for pin %u", req.pin);
   MICROSTRAIN_DEBUG(node_, "  state = %d", req.state);
 
@@ -288,4 +351,261 @@ bool Services::mip3dmGpioStateWrite(Mip3dmGpioStateWriteSrv::Request& req, Mip3d
   return !!mip_cmd_result;
 }
 
+bool Services::imuAllanVarianceRead(TriggerSrv::Request& req, TriggerSrv::Response& res)
+{
+  MemoryTracker::Scope memory_scope(MEMORY_TAG_SERVICES);
+
+  if (config_->allan_variance_ == nullptr)
+    return false;
+
+  res.success = true;
+  res.message = config_->allan_variance_->toYaml();
+  return true;
+}
+
+bool Services::imuAllanVarianceReset(EmptySrv::Request& req, EmptySrv::Response& res)
+{
+  MemoryTracker::Scope memory_scope(MEMORY_TAG_SERVICES);
+
+  if (config_->allan_variance_ == nullptr)
+    return false;
+
+  MICROSTRAIN_INFO(node_, "Resetting Allan variance");
+  config_->allan_variance_->reset();
+  return true;
+}
+
+bool Services::perfCountersRead(TriggerSrv::Request& req, TriggerSrv::Response& res)
+{
+  MemoryTracker::Scope memory_scope(MEMORY_TAG_SERVICES);
+
+  if (config_->perf_profiler_ == nullptr)
+    return false;
+
+  res.success = true;
+  res.message = config_->perf_profiler_->toYaml();
+  return true;
+}
+
+bool Services::perfCountersReset(EmptySrv::Request& req, EmptySrv::Response& res)
+{
+  MemoryTracker::Scope memory_scope(MEMORY_TAG_SERVICES);
+
+  if (config_->perf_profiler_ == nullptr)
+    return false;
+
+  MICROSTRAIN_INFO(node_, "Resetting performance counters");
+  config_->perf_profiler_->reset();
+  return true;
+}
+
+bool Services::rtcmStatisticsRead(TriggerSrv::Request& req, TriggerSrv::Response& res)
+{
+  MemoryTracker::Scope memory_scope(MEMORY_TAG_SERVICES);
+
+  if (config_->rtcm_framer_ == nullptr)
+    return false;
+
+  res.success = true;
+  res.message = config_->rtcm_framer_->toYaml();
+  return true;
+}
+
+bool Services::rtcmStatisticsReset(EmptySrv::Request& req, EmptySrv::Response& res)
+{
+  MemoryTracker::Scope memory_scope(MEMORY_TAG_SERVICES);
+
+  if (config_->rtcm_framer_ == nullptr)
+    return false;
+
+  MICROSTRAIN_INFO(node_, "Resetting RTCM statistics");
+  config_->rtcm_framer_->reset();
+  return true;
+}
+
+bool Services::dejitterStatisticsRead(TriggerSrv::Request& req, TriggerSrv::Response& res)
+{
+  MemoryTracker::Scope memory_scope(MEMORY_TAG_SERVICES);
+
+  // Indent the statistics of each topic under the topic name
+  std::string yaml;
+  for (const auto& dejitter_statistics : config_->dejitter_statistics_)
+  {
+    yaml += dejitter_statistics.first + ":\n";
+    std::stringstream topic_yaml(dejitter_statistics.second->toYaml());
+    std::string line;
+    while (std::getline(topic_yaml, line))
+      yaml += "  " + line + "\n";
+  }
+  res.success = true;
+  res.message = yaml;
+  return true;
+}
+
+bool Services::dejitterStatisticsReset(EmptySrv::Request& req, EmptySrv::Response& res)
+{
+  MemoryTracker::Scope memory_scope(MEMORY_TAG_SERVICES);
+
+  MICROSTRAIN_INFO(node_, "Resetting de-jitter statistics");
+  for (const auto& dejitter_statistics : config_->dejitter_statistics_)
+    dejitter_statistics.second->reset();
+  return true;
+}
+
+bool Services::aidingCallbackBenchmarkRead(TriggerSrv::Request& req, TriggerSrv::Response& res)
+{
+  MemoryTracker::Scope memory_scope(MEMORY_TAG_SERVICES);
+  if (config_->aiding_callback_benchmark_ == nullptr)
+    return false;
+
+  res.success = true;
+  res.message = config_->aiding_callback_benchmark_->toYaml();
+  return true;
+}
+
+bool Services::aidingHealthRead(TriggerSrv::Request& req, TriggerSrv::Response& res)
+{
+  MemoryTracker::Scope memory_scope(MEMORY_TAG_SERVICES);
+  if (config_->aiding_health_ == nullptr)
+    return false;
+
+  res.success = true;
+  res.message = config_->aiding_health_->toYaml();
+  return true;
+}
+
+bool Services::aidingHealthReset(EmptySrv::Request& req, EmptySrv::Response& res)
+{
+  MemoryTracker::Scope memory_scope(MEMORY_TAG_SERVICES);
+  if (config_->aiding_health_ == nullptr)
+    return false;
+
+  MICROSTRAIN_INFO(node_, "Resetting aiding health, all aiding sources will be sent again");
+  config_->aiding_health_->reset();
+  return true;
+}
+
+bool Services::magCalibrationRead(TriggerSrv::Request& req, TriggerSrv::Response& res)
+{
+  MemoryTracker::Scope memory_scope(MEMORY_TAG_SERVICES);
+  if (config_->mag_calibrator_ == nullptr)
+    return false;
+
+  res.success = true;
+  res.message = config_->mag_calibrator_->toYaml(config_->mag_calibrator_->fit());
+  return true;
+}
+
+bool Services::magCalibrationWrite(TriggerSrv::Request& req, TriggerSrv::Response& res)
+{
+  MemoryTracker::Scope memory_scope(MEMORY_TAG_SERVICES);
+  if (config_->mag_calibrator_ == nullptr)
+    return false;
+
+  res.success = writeMagCalibration(config_->mag_calibrator_->fit(), false, &res.message);
+  return true;
+}
+
+bool Services::magCalibrationForceWrite(TriggerSrv::Request& req, TriggerSrv::Response& res)
+{
+  MemoryTracker::Scope memory_scope(MEMORY_TAG_SERVICES);
+  if (config_->mag_calibrator_ == nullptr)
+    return false;
+
+  // Writing before the thresholds are met has to be asked for explicitly, as the caller may know the data is good enough
+  res.success = writeMagCalibration(config_->mag_calibrator_->fit(), true, &res.message);
+  return true;
+}
+
+bool Services::magCalibrationReset(EmptySrv::Request& req, EmptySrv::Response& res)
+{
+  MemoryTracker::Scope memory_scope(MEMORY_TAG_SERVICES);
+  if (config_->mag_calibrator_ == nullptr)
+    return false;
+
+  MICROSTRAIN_INFO(node_, "Resetting magnetometer calibration");
+  config_->mag_calibrator_->reset();
+  return true;
+}
+
+bool Services::writeMagCalibration(const MagCalibrator::Result& result, const bool force, std::string* message)
+{
+  if (!result.valid)
+  {
+    *message = "error: The magnetometer samples do not describe an ellipsoid yet. Rotate the device through more orientations\n" + config_->mag_calibrator_->toYaml(result);
+    return false;
+  }
+  if (!force && !config_->mag_calibrator_->meetsThresholds(result))
+  {
+    *message = std::string("error: The fit does not meet the thresholds. Rotate the device through more orientations, or use ") + MAG_CALIBRATION_FORCE_WRITE_SERVICE +
+      " to write it anyway\n" + config_->mag_calibrator_->toYaml(result);
+    return false;
+  }
+
+  // The data the fit was made from was already corrected by the device, so combine the fit with the calibration the device is applying.
+  // In a dry run the device may be a replayed capture that can not answer commands, so the fit is reported as a correction to the current calibration
+  float current_hard_iron[3] = {0, 0, 0};
+  float current_soft_iron[9] = {1, 0, 0, 0, 1, 0, 0, 0, 1};
+  const bool dry_run = config_->mag_calibration_dry_run_;
+  mip::CmdResult mip_cmd_result;
+  if (!dry_run)
+  {
+    if (!config_->mip_device_->supportsDescriptor(mip::commands_3dm::DESCRIPTOR_SET, mip::commands_3dm::CMD_HARD_IRON_OFFSET) ||
+        !config_->mip_device_->supportsDescriptor(mip::commands_3dm::DESCRIPTOR_SET, mip::commands_3dm::CMD_SOFT_IRON_MATRIX))
+    {
+      *message = "The device does not support the hard iron offset and soft iron matrix commands";
+      return false;
+    }
+    if (!(mip_cmd_result = mip::commands_3dm::readMagHardIronOffset(*config_->mip_device_, current_hard_iron)) ||
+        !(mip_cmd_result = mip::commands_3dm::readMagSoftIronMatrix(*config_->mip_device_, current_soft_iron)))
+    {
+      MICROSTRAIN_MIP_SDK_ERROR(node_, mip_cmd_result, "Failed to read the current magnetometer calibration");
+      *message = "Failed to read the current magnetometer calibration";
+      return false;
+    }
+  }
+
+  float hard_iron[3];
+  float soft_iron[9];
+  if (!MagCalibrator::compose(current_hard_iron, current_soft_iron, result, hard_iron, soft_iron))
+  {
+    *message = "The soft iron matrix on the device can not be inverted";
+    return false;
+  }
+
+  char yaml[512];
+  snprintf(yaml, sizeof(yaml), "dry_run: %s\nhard_iron: [%f, %f, %f]\nsoft_iron: [%f, %f, %f, %f, %f, %f, %f, %f, %f]\n",
+    dry_run ? "true" : "false", hard_iron[0], hard_iron[1], hard_iron[2],
+    soft_iron[0], soft_iron[1], soft_iron[2], soft_iron[3], soft_iron[4], soft_iron[5], soft_iron[6], soft_iron[7], soft_iron[8]);
+  *message = yaml + config_->mag_calibrator_->toYaml(result);
+
+  MICROSTRAIN_INFO(node_, "%s magnetometer hard iron offset [%f, %f, %f] and soft iron matrix [ [%f, %f, %f], [%f, %f, %f], [%f, %f, %f] ] (coverage %.0f%%, fit error %.2f%%)",
+    dry_run ? "Dry run, would write" : "Writing", hard_iron[0], hard_iron[1], hard_iron[2],
+    soft_iron[0], soft_iron[1], soft_iron[2], soft_iron[3], soft_iron[4], soft_iron[5], soft_iron[6], soft_iron[7], soft_iron[8],
+    result.coverage * 100, result.fit_error * 100);
+  if (!dry_run)
+  {
+    if (!(mip_cmd_result = mip::commands_3dm::writeMagHardIronOffset(*config_->mip_device_, hard_iron)) ||
+        !(mip_cmd_result = mip::commands_3dm::writeMagSoftIronMatrix(*config_->mip_device_, soft_iron)))
+    {
+      MICROSTRAIN_MIP_SDK_ERROR(node_, mip_cmd_result, "Failed to write the magnetometer calibration");
+      *message = "Failed to write the magnetometer calibration";
+      return false;
+    }
+    if (config_->mag_calibration_save_)
+    {
+      if (!(mip_cmd_result = mip::commands_3dm::saveMagHardIronOffset(*config_->mip_device_)) ||
+          !(mip_cmd_result = mip::commands_3dm::saveMagSoftIronMatrix(*config_->mip_device_)))
+      {
+        MICROSTRAIN_MIP_SDK_ERROR(node_, mip_cmd_result, "Failed to save the magnetometer calibration");
+        *message = "Failed to save the magnetometer calibration";
+        return false;
+      }
+    }
+  }
+
+  config_->mag_calibrator_->reset();
+  return true;
+}
+
 }  // namespace microstrain
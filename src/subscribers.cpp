@@ -9,8 +9,11 @@
 /////////////////////////////////////////////////////////////////////////////////////////////////////
 
 #include <string>
+#include <chrono>
+#include <utility>
 
 #include "microstrain_inertial_driver_common/utils/geo_utils.h"
+#include "microstrain_inertial_driver_common/utils/mip/emulated_aiding_device.h"
 
 #include "microstrain_inertial_driver_common/subscribers.h"
 
@@ -20,10 +23,24 @@ namespace microstrain
 constexpr auto UTC_GPS_EPOCH_DUR = (315964800);
 constexpr auto SECS_PER_WEEK = (60L * 60 * 24 * 7);
 
+// Sensor ID used for every measurement sent to the emulated device by the aiding callback benchmark
+constexpr uint8_t AIDING_CALLBACK_BENCHMARK_SENSOR_ID = 1;
+
+// Type the filter reports in its aiding measurement summaries for the measurements sent by each aiding command
+template<typename MipCommand> struct AidingMeasurementType;
+template<> struct AidingMeasurementType<mip::commands_aiding::LlhPos> { static constexpr auto value = mip::data_filter::FilterAidingMeasurementType::AIDING_POS_LLH; };
+template<> struct AidingMeasurementType<mip::commands_aiding::NedVel> { static constexpr auto value = mip::data_filter::FilterAidingMeasurementType::AIDING_VEL_NED; };
+template<> struct AidingMeasurementType<mip::commands_aiding::EcefVel> { static constexpr auto value = mip::data_filter::FilterAidingMeasurementType::AIDING_VEL_ECEF; };
+template<> struct AidingMeasurementType<mip::commands_aiding::VehicleFixedFrameVelocity> { static constexpr auto value = mip::data_filter::FilterAidingMeasurementType::AIDING_VEL_BODY_FRAME; };
+template<> struct AidingMeasurementType<mip::commands_aiding::TrueHeading> { static constexpr auto value = mip::data_filter::FilterAidingMeasurementType::AIDING_HEADING_TRUE; };
+template<> struct AidingMeasurementType<mip::commands_aiding::MagneticField> { static constexpr auto value = mip::data_filter::FilterAidingMeasurementType::AIDING_MAGNETIC_FIELD; };
+template<> struct AidingMeasurementType<mip::commands_aiding::Pressure> { static constexpr auto value = mip::data_filter::FilterAidingMeasurementType::AIDING_PRESSURE; };
+
 Subscribers::Subscribers(RosNodeType* node, Config* config)
   : node_(node), config_(config)
 {
   // Initialize the transform buffer and listener ahead of time
+  MemoryTracker::Scope tf_memory_scope(MEMORY_TAG_TF);
   transform_buffer_ = createTransformBuffer(node_);
   transform_listener_ = createTransformListener(transform_buffer_);
 }
@@ -31,68 +48,136 @@ Subscribers::Subscribers(RosNodeType* node, Config* config)
 bool Subscribers::activate()
 {
   // Create a topic listener for external RTCM updates
-  if (config_->ntrip_interface_enable_)
+  if (BuildFeatures::RTK && config_->ntrip_interface_enable_)
   {
     rtcm_sub_ = createSubscriber<>(node_, RTCM_TOPIC, 1000, &Subscribers::rtcmCallback, this);
   }
 
   // Setup the external measurement subscribers
-  if (config_->subscribe_ext_time_ && config_->mip_device_->supportsDescriptor(mip::commands_base::DESCRIPTOR_SET, mip::commands_base::CMD_GPS_TIME_UPDATE))
+  if (BuildFeatures::AIDING && config_->subscribe_ext_time_ && config_->mip_device_->supportsDescriptor(mip::commands_base::DESCRIPTOR_SET, mip::commands_base::CMD_GPS_TIME_UPDATE))
   {
     MICROSTRAIN_INFO(node_, "Subscribing to %s for external time", EXT_TIME_TOPIC);
     external_time_sub_ = createSubscriber<>(node_, EXT_TIME_TOPIC, 1000, &Subscribers::externalTimeCallback, this);
   }
-  if (config_->subscribe_ext_fix_ && config_->mip_device_->supportsDescriptor(mip::commands_aiding::DESCRIPTOR_SET, mip::commands_aiding::CMD_POS_LLH))
+  if (BuildFeatures::AIDING && config_->subscribe_ext_fix_ && config_->mip_device_->supportsDescriptor(mip::commands_aiding::DESCRIPTOR_SET, mip::commands_aiding::CMD_POS_LLH))
   {
     MICROSTRAIN_INFO(node_, "Subscribing to %s for external GPS position", EXT_FIX_TOPIC);
     external_gnss_position_sub_ = createSubscriber<>(node_, EXT_FIX_TOPIC, 1000, &Subscribers::externalGnssPositionCallback, this);
   }
-  if (config_->subscribe_ext_vel_ned_ && config_->mip_device_->supportsDescriptor(mip::commands_aiding::DESCRIPTOR_SET, mip::commands_aiding::CMD_VEL_NED))
+  if (BuildFeatures::AIDING && config_->subscribe_ext_vel_ned_ && config_->mip_device_->supportsDescriptor(mip::commands_aiding::DESCRIPTOR_SET, mip::commands_aiding::CMD_VEL_NED))
   {
     MICROSTRAIN_INFO(node_, "Subscribing to %s for external GPS Velocity in the NED frame", EXT_VEL_NED_TOPIC);
     external_vel_ned_sub_ = createSubscriber<>(node_, EXT_VEL_NED_TOPIC, 1000, &Subscribers::externalVelNedCallback, this);
   }
-  if (config_->subscribe_ext_vel_enu_ && config_->mip_device_->supportsDescriptor(mip::commands_aiding::DESCRIPTOR_SET, mip::commands_aiding::CMD_VEL_NED))
+  if (BuildFeatures::AIDING && config_->subscribe_ext_vel_enu_ && config_->mip_device_->supportsDescriptor(mip::commands_aiding::DESCRIPTOR_SET, mip::commands_aiding::CMD_VEL_NED))
   {
     MICROSTRAIN_INFO(node_, "Subscribing to %s for external GPS Velocity in the ENU frame", EXT_VEL_ENU_TOPIC);
     external_vel_enu_sub_ = createSubscriber<>(node_, EXT_VEL_ENU_TOPIC, 1000, &Subscribers::externalVelEnuCallback, this);
   }
-  if (config_->subscribe_ext_vel_ecef_ && config_->mip_device_->supportsDescriptor(mip::commands_aiding::DESCRIPTOR_SET, mip::commands_aiding::CMD_VEL_ECEF))
+  if (BuildFeatures::AIDING && config_->subscribe_ext_vel_ecef_ && config_->mip_device_->supportsDescriptor(mip::commands_aiding::DESCRIPTOR_SET, mip::commands_aiding::CMD_VEL_ECEF))
   {
     MICROSTRAIN_INFO(node_, "Subscribing to %s for external GPS Velocity in the ECEF frame", EXT_VEL_ECEF_TOPIC);
     external_vel_ecef_sub_ = createSubscriber<>(node_, EXT_VEL_ECEF_TOPIC, 1000, &Subscribers::externalVelEcefCallback, this);
   }
-  if (config_->subscribe_ext_vel_body_ && config_->mip_device_->supportsDescriptor(mip::commands_aiding::DESCRIPTOR_SET, mip::commands_aiding::CMD_VEL_ODOM))
+  if (BuildFeatures::AIDING && config_->subscribe_ext_vel_body_ && config_->mip_device_->supportsDescriptor(mip::commands_aiding::DESCRIPTOR_SET, mip::commands_aiding::CMD_VEL_ODOM))
   {
     MICROSTRAIN_INFO(node_, "Subscribing to %s for external Velocity in the Body frame", EXT_VEL_BODY_TOPIC);
     external_vel_body_sub_ = createSubscriber<>(node_, EXT_VEL_BODY_TOPIC, 1000, &Subscribers::externalVelBodyCallback, this);
   }
-  if (config_->subscribe_ext_heading_ned_ && config_->mip_device_->supportsDescriptor(mip::commands_aiding::DESCRIPTOR_SET, mip::commands_aiding::CMD_HEADING_TRUE))
+  if (BuildFeatures::AIDING && config_->subscribe_ext_heading_ned_ && config_->mip_device_->supportsDescriptor(mip::commands_aiding::DESCRIPTOR_SET, mip::commands_aiding::CMD_HEADING_TRUE))
   {
     MICROSTRAIN_INFO(node_, "Subscribing to %s for external heading in the NED frame", EXT_HEADING_NED_TOPIC);
     external_heading_ned_sub_ = createSubscriber<>(node_, EXT_HEADING_NED_TOPIC, 1000, &Subscribers::externalHeadingNedCallback, this);
   }
-  if (config_->subscribe_ext_heading_enu_ && config_->mip_device_->supportsDescriptor(mip::commands_aiding::DESCRIPTOR_SET, mip::commands_aiding::CMD_HEADING_TRUE))
+  if (BuildFeatures::AIDING && config_->subscribe_ext_heading_enu_ && config_->mip_device_->supportsDescriptor(mip::commands_aiding::DESCRIPTOR_SET, mip::commands_aiding::CMD_HEADING_TRUE))
   {
     MICROSTRAIN_INFO(node_, "Subscribing to %s for external heading in the ENU frame", EXT_HEADING_ENU_TOPIC);
     external_heading_enu_sub_ = createSubscriber<>(node_, EXT_HEADING_ENU_TOPIC, 1000, &Subscribers::externalHeadingEnuCallback, this);
   }
-  if (config_->subscribe_ext_mag_ && config_->mip_device_->supportsDescriptor(mip::commands_aiding::DESCRIPTOR_SET, mip::commands_aiding::CMD_MAGNETIC_FIELD))
+  if (BuildFeatures::AIDING && config_->subscribe_ext_mag_ && config_->mip_device_->supportsDescriptor(mip::commands_aiding::DESCRIPTOR_SET, mip::commands_aiding::CMD_MAGNETIC_FIELD))
   {
     MICROSTRAIN_INFO(node_, "Subscribing to %s for external mag", EXT_MAG_TOPIC);
     external_mag_sub_ = createSubscriber(node_, EXT_MAG_TOPIC, 1000, &Subscribers::externalMagCallback, this);
   }
-  if (config_->subscribe_ext_pressure_ && config_->mip_device_->supportsDescriptor(mip::commands_aiding::DESCRIPTOR_SET, mip::commands_aiding::CMD_PRESSURE))
+  if (BuildFeatures::AIDING && config_->subscribe_ext_pressure_ && config_->mip_device_->supportsDescriptor(mip::commands_aiding::DESCRIPTOR_SET, mip::commands_aiding::CMD_PRESSURE))
   {
     MICROSTRAIN_INFO(node_, "Subscribing to %s for external pressure", EXT_PRESSURE_TOPIC);
     external_pressure_sub_ = createSubscriber(node_, EXT_PRESSURE_TOPIC, 1000, &Subscribers::externalPressureCallback, this);
   }
 
+  // Give the aiding callback benchmark the callbacks to drive
+  if (BuildFeatures::AIDING && config_->aiding_callback_benchmark_ != nullptr)
+    configureAidingCallbackBenchmark();
+
   return true;
 }
 
+template<typename MipCommand>
+mip::CmdResult Subscribers::sendAidingCommand(const MipCommand& command)
+{
+  // Measurements synthesized by the benchmark only ever go to the emulated device, so they can not reach the real filter
+  if (AidingCallbackBenchmark::onBenchmarkThread())
+  {
+    const auto start = std::chrono::steady_clock::now();
+    const mip::CmdResult mip_cmd_result = config_->aiding_callback_benchmark_device_->device().runCommand<MipCommand>(command);
+    config_->aiding_callback_benchmark_->recordCommand(static_cast<bool>(mip_cmd_result), std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+    return mip_cmd_result;
+  }
+
+  // Save the bandwidth and the device time for measurements the filter would not use anyways
+  if (config_->aiding_health_ != nullptr && !config_->aiding_health_->shouldSend(static_cast<uint8_t>(AidingMeasurementType<MipCommand>::value), command.frame_id))
+    return mip::CmdResult::fromAckNack(mip::CmdResult::ACK_OK);
+
+  return config_->mip_device_->device().runCommand<MipCommand>(command);
+}
+
+void Subscribers::configureAidingCallbackBenchmark()
+{
+  // Everything the benchmark sends goes to the emulated device, which accepts every aiding command, so every callback is driven.
+  // The values only have to be well formed, as they never reach a real filter
+  std::vector<std::pair<std::string, AidingCallbackBenchmark::Sender>> senders;
+  NavSatFixMsg fix;
+  fix.header.frame_id = config_->frame_id_;
+  fix.status.status = NavSatFixMsg::_status_type::STATUS_FIX;
+  fix.position_covariance_type = NavSatFixMsg::COVARIANCE_TYPE_DIAGONAL_KNOWN;
+  fix.position_covariance[0] = fix.position_covariance[4] = fix.position_covariance[8] = 1.0;
+  senders.emplace_back("llh_position", [this, fix]() { externalGnssPositionCallback(fix); });
+
+  TwistWithCovarianceStampedMsg vel;
+  vel.header.frame_id = config_->frame_id_;
+  vel.twist.covariance[0] = vel.twist.covariance[7] = vel.twist.covariance[14] = 0.01;
+  senders.emplace_back("velocity_ned", [this, vel]() { externalVelNedCallback(vel); });
+  senders.emplace_back("velocity_ecef", [this, vel]() { externalVelEcefCallback(vel); });
+  senders.emplace_back("velocity_body", [this, vel]() { externalVelBodyCallback(vel); });
+
+  PoseWithCovarianceStampedMsg heading;
+  heading.header.frame_id = config_->frame_id_;
+  heading.pose.pose.orientation.w = 1;
+  heading.pose.covariance[35] = 0.01;
+  senders.emplace_back("heading_ned", [this, heading]() { externalHeadingNedCallback(heading); });
+
+  MagneticFieldMsg mag;
+  mag.header.frame_id = config_->frame_id_;
+  mag.magnetic_field.x = 0.2;
+  mag.magnetic_field.z = 0.4;
+  mag.magnetic_field_covariance[0] = mag.magnetic_field_covariance[4] = mag.magnetic_field_covariance[8] = 0.01;
+  senders.emplace_back("mag", [this, mag]() { externalMagCallback(mag); });
+
+  FluidPressureMsg pressure;
+  pressure.header.frame_id = config_->frame_id_;
+  pressure.fluid_pressure = 10.1325;
+  pressure.variance = 0.01;
+  senders.emplace_back("pressure", [this, pressure]() { externalPressureCallback(pressure); });
+
+  for (const auto& sender : senders)
+    MICROSTRAIN_INFO(node_, "Aiding callback benchmark will send %s measurements", sender.first.c_str());
+  config_->aiding_callback_benchmark_->setSenders(senders);
+}
+
 void Subscribers::externalTimeCallback(const TimeReferenceMsg& time)
 {
+  MemoryTracker::Scope memory_scope(MEMORY_TAG_SUBSCRIBERS);
+
   // If the time is not within the first .25 of the top of the second, don't send it as it might cause an issue in processing
   double seconds = getTimeRefSecs(time.time_ref);
   if (seconds - round(seconds) >= 0.25)
@@ -117,6 +202,8 @@ void Subscribers::externalTimeCallback(const TimeReferenceMsg& time)
 
 void Subscribers::externalGnssPositionCallback(const NavSatFixMsg& fix)
 {
+  MemoryTracker::Scope memory_scope(MEMORY_TAG_SUBSCRIBERS);
+
   // Throw away messages that do not have a valid fix
   if (fix.status.status == NavSatFixMsg::_status_type::STATUS_NO_FIX)
   {
@@ -156,12 +243,14 @@ void Subscribers::externalGnssPositionCallback(const NavSatFixMsg& fix)
   llh_pos.uncertainty[2] = sqrt(fix.position_covariance[8]);
 
   mip::CmdResult mip_cmd_result;
-  if (!(mip_cmd_result = config_->mip_device_->device().runCommand<mip::commands_aiding::LlhPos>(llh_pos)))
+  if (!(mip_cmd_result = sendAidingCommand(llh_pos)))
     MICROSTRAIN_MIP_SDK_ERROR(node_, mip_cmd_result, "Failed to send aiding LLH position aiding command");
 }
 
 void Subscribers::externalVelNedCallback(const TwistWithCovarianceStampedMsg& vel)
 {
+  MemoryTracker::Scope memory_scope(MEMORY_TAG_SUBSCRIBERS);
+
   // Get the sensor ID from the frame ID
   mip::commands_aiding::NedVel ned_vel;
   ned_vel.time.reserved = 1;
@@ -190,12 +279,14 @@ void Subscribers::externalVelNedCallback(const TwistWithCovarianceStampedMsg& ve
   }
 
   mip::CmdResult mip_cmd_result;
-  if (!(mip_cmd_result = config_->mip_device_->device().runCommand<mip::commands_aiding::NedVel>(ned_vel)))
+  if (!(mip_cmd_result = sendAidingCommand(ned_vel)))
     MICROSTRAIN_MIP_SDK_ERROR(node_, mip_cmd_result, "Failed to send NED velocity aiding command");
 }
 
 void Subscribers::externalVelEnuCallback(const TwistWithCovarianceStampedMsg& vel)
 {
+  MemoryTracker::Scope memory_scope(MEMORY_TAG_SUBSCRIBERS);
+
   // Get the sensor ID from the frame ID
   mip::commands_aiding::NedVel ned_vel;
   ned_vel.time.reserved = 1;
@@ -224,12 +315,14 @@ void Subscribers::externalVelEnuCallback(const TwistWithCovarianceStampedMsg& ve
   }
 
   mip::CmdResult mip_cmd_result;
-  if (!(mip_cmd_result = config_->mip_device_->device().runCommand<mip::commands_aiding::NedVel>(ned_vel)))
+  if (!(mip_cmd_result = sendAidingCommand(ned_vel)))
     MICROSTRAIN_MIP_SDK_ERROR(node_, mip_cmd_result, "Failed to send ENU velocity aiding command");
 }
 
 void Subscribers::externalVelEcefCallback(const TwistWithCovarianceStampedMsg& vel)
 {
+  MemoryTracker::Scope memory_scope(MEMORY_TAG_SUBSCRIBERS);
+
   // Get the sensor ID from the frame ID
   mip::commands_aiding::EcefVel ecef_vel;
   ecef_vel.time.reserved = 1;
@@ -258,12 +351,14 @@ void Subscribers::externalVelEcefCallback(const TwistWithCovarianceStampedMsg& v
   }
 
   mip::CmdResult mip_cmd_result;
-  if (!(mip_cmd_result = config_->mip_device_->device().runCommand<mip::commands_aiding::EcefVel>(ecef_vel)))
+  if (!(mip_cmd_result = sendAidingCommand(ecef_vel)))
     MICROSTRAIN_MIP_SDK_ERROR(node_, mip_cmd_result, "Failed to send ECEF velocity aiding command");
 }
 
 void Subscribers::externalVelBodyCallback(const TwistWithCovarianceStampedMsg& vel)
 {
+  MemoryTracker::Scope memory_scope(MEMORY_TAG_SUBSCRIBERS);
+
   // Get the sensor ID from the frame ID
   mip::commands_aiding::VehicleFixedFrameVelocity vehicle_fixed_frame_velocity;
   vehicle_fixed_frame_velocity.time.reserved = 1;
@@ -292,12 +387,14 @@ void Subscribers::externalVelBodyCallback(const TwistWithCovarianceStampedMsg& v
   }
 
   mip::CmdResult mip_cmd_result;
-  if (!(mip_cmd_result = config_->mip_device_->device().runCommand<mip::commands_aiding::VehicleFixedFrameVelocity>(vehicle_fixed_frame_velocity)))
+  if (!(mip_cmd_result = sendAidingCommand(vehicle_fixed_frame_velocity)))
     MICROSTRAIN_MIP_SDK_ERROR(node_, mip_cmd_result, "Failed to send body frame velocity command");
 }
 
 void Subscribers::externalHeadingNedCallback(const PoseWithCovarianceStampedMsg& heading)
 {
+  MemoryTracker::Scope memory_scope(MEMORY_TAG_SUBSCRIBERS);
+
   // Fill out the time of the message
   mip::commands_aiding::TrueHeading true_heading;
   true_heading.time.reserved = 1;
@@ -325,12 +422,14 @@ void Subscribers::externalHeadingNedCallback(const PoseWithCovarianceStampedMsg&
   true_heading.uncertainty = sqrt(heading.pose.covariance[35]);
 
   mip::CmdResult mip_cmd_result;
-  if (!(mip_cmd_result = config_->mip_device_->device().runCommand<mip::commands_aiding::TrueHeading>(true_heading)))
+  if (!(mip_cmd_result = sendAidingCommand(true_heading)))
     MICROSTRAIN_MIP_SDK_ERROR(node_, mip_cmd_result, "Failed to send external heading command");
 }
 
 void Subscribers::externalHeadingEnuCallback(const PoseWithCovarianceStampedMsg& heading)
 {
+  MemoryTracker::Scope memory_scope(MEMORY_TAG_SUBSCRIBERS);
+
   // Fill out the time of the message
   mip::commands_aiding::TrueHeading true_heading;
   true_heading.time.reserved = 1;
@@ -359,12 +458,14 @@ void Subscribers::externalHeadingEnuCallback(const PoseWithCovarianceStampedMsg&
   true_heading.uncertainty = sqrt(heading.pose.covariance[35]);
 
   mip::CmdResult mip_cmd_result;
-  if (!(mip_cmd_result = config_->mip_device_->device().runCommand<mip::commands_aiding::TrueHeading>(true_heading)))
+  if (!(mip_cmd_result = sendAidingCommand(true_heading)))
     MICROSTRAIN_MIP_SDK_ERROR(node_, mip_cmd_result, "Failed to send external heading command");
 }
 
 void Subscribers::externalMagCallback(const MagneticFieldMsg& mag)
 {
+  MemoryTracker::Scope memory_scope(MEMORY_TAG_SUBSCRIBERS);
+
   // Fill out the time of the message
   mip::commands_aiding::MagneticField magnetic_field;
   magnetic_field.time.reserved = 1;
@@ -393,12 +494,14 @@ void Subscribers::externalMagCallback(const MagneticFieldMsg& mag)
   }
 
   mip::CmdResult mip_cmd_result;
-  if (!(mip_cmd_result = config_->mip_device_->device().runCommand<mip::commands_aiding::MagneticField>(magnetic_field)))
+  if (!(mip_cmd_result = sendAidingCommand(magnetic_field)))
     MICROSTRAIN_MIP_SDK_ERROR(node_, mip_cmd_result, "Failed to send magnetic field command");
 }
 
 void Subscribers::externalPressureCallback(const FluidPressureMsg& fluid_pressure)
 {
+  MemoryTracker::Scope memory_scope(MEMORY_TAG_SUBSCRIBERS);
+
   mip::commands_aiding::Pressure pressure;
   pressure.time.reserved = 1;
   pressure.time.timebase = mip::commands_aiding::Time::Timebase::TIME_OF_ARRIVAL;
@@ -418,19 +521,36 @@ void Subscribers::externalPressureCallback(const FluidPressureMsg& fluid_pressur
   pressure.uncertainty = sqrt(fluid_pressure.variance);
 
   mip::CmdResult mip_cmd_result;
-  if (!(mip_cmd_result = config_->mip_device_->device().runCommand<mip::commands_aiding::Pressure>(pressure)))
+  if (!(mip_cmd_result = sendAidingCommand(pressure)))
     MICROSTRAIN_MIP_SDK_ERROR(node_, mip_cmd_result, "Failed to send external pressure command");
 }
 
 void Subscribers::rtcmCallback(const RTCMMsg& rtcm)
 {
+  MemoryTracker::Scope memory_scope(MEMORY_TAG_SUBSCRIBERS);
+
   MICROSTRAIN_DEBUG(node_, "Received RTCM message of size %lu", rtcm.message.size());
   if (config_->aux_device_)
   {
-    if (!config_->aux_device_->send(rtcm.message.data(), rtcm.message.size()))
+    const uint8_t* data = rtcm.message.data();
+    size_t size = rtcm.message.size();
+    if (config_->rtcm_framer_ != nullptr)
+    {
+      rtcm_frames_.clear();
+      config_->rtcm_framer_->process(data, size, &rtcm_frames_);
+      if (rtcm_frames_.empty())
+      {
+        MICROSTRAIN_DEBUG(node_, "No complete RTCM frames of an allowed message type in message of size %lu", size);
+        return;
+      }
+      data = rtcm_frames_.data();
+      size = rtcm_frames_.size();
+    }
+
+    if (!config_->aux_device_->send(data, size))
       MICROSTRAIN_ERROR(node_, "Failed to write RTCM to device");
     else
-      MICROSTRAIN_DEBUG(node_, "Successfully wrote RTCM message of size %lu to aux port", rtcm.message.size());
+      MICROSTRAIN_DEBUG(node_, "Successfully wrote RTCM message of size %lu to aux port", size);
   }
   else
   {
@@ -440,6 +560,10 @@ void Subscribers::rtcmCallback(const RTCMMsg& rtcm)
 
 uint8_t Subscribers::getSensorIdFromFrameId(const std::string& frame_id)
 {
+  // The emulated device accepts any sensor ID, so the benchmark must not configure, or use up, one of the real device's
+  if (AidingCallbackBenchmark::onBenchmarkThread())
+    return AIDING_CALLBACK_BENCHMARK_SENSOR_ID;
+
   const auto& frame_id_iter = std::find(external_frame_ids_.begin(), external_frame_ids_.end(), frame_id);
   if (frame_id_iter != external_frame_ids_.end())
   {
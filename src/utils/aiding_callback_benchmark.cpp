@@ -0,0 +1,196 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Parker-Lord Inertial Device Driver Implementation File
+//
+// Copyright (c) 2017, Brian Bingham
+// Copyright (c) 2020, Parker Hannifin Corp
+// This code is licensed under MIT license (see LICENSE file for details)
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include <chrono>
+#include <cstdio>
+#include <sstream>
+#include <algorithm>
+
+#include "microstrain_inertial_driver_common/utils/aiding_callback_benchmark.h"
+
+namespace microstrain
+{
+
+// Limit on latencies kept per step, so a long step at a high rate can not grow the buffers forever
+constexpr size_t MAX_LATENCIES_PER_STEP = 100000;
+
+// Set on the benchmark thread, so the callbacks it drives know the measurements are synthesized
+static thread_local bool benchmark_thread = false;
+
+AidingCallbackBenchmark::AidingCallbackBenchmark(const std::vector<double>& rates, const double step_duration)
+  : rates_(rates), step_duration_(step_duration)
+{
+}
+
+AidingCallbackBenchmark::~AidingCallbackBenchmark()
+{
+  stop();
+}
+
+void AidingCallbackBenchmark::setSenders(const std::vector<std::pair<std::string, Sender>>& senders)
+{
+  std::lock_guard<std::mutex> lock(senders_mutex_);
+  senders_ = senders;
+}
+
+void AidingCallbackBenchmark::start(StepCallback step_callback)
+{
+  if (started_.exchange(true))
+    return;
+  step_callback_ = step_callback;
+  thread_ = std::thread(&AidingCallbackBenchmark::run, this);
+}
+
+void AidingCallbackBenchmark::stop()
+{
+  {
+    std::lock_guard<std::mutex> lock(stop_mutex_);
+    stop_ = true;
+  }
+  stop_condition_.notify_one();
+  if (thread_.joinable())
+    thread_.join();
+}
+
+bool AidingCallbackBenchmark::running() const
+{
+  return recording_.load(std::memory_order_relaxed);
+}
+
+bool AidingCallbackBenchmark::onBenchmarkThread()
+{
+  return benchmark_thread;
+}
+
+void AidingCallbackBenchmark::recordCommand(const bool accepted, const double latency)
+{
+  if (!running())
+    return;
+
+  std::lock_guard<std::mutex> lock(results_mutex_);
+  sent_++;
+  if (accepted)
+    accepted_++;
+  if (command_latencies_.size() < MAX_LATENCIES_PER_STEP)
+    command_latencies_.push_back(latency);
+}
+
+std::string AidingCallbackBenchmark::toYaml() const
+{
+  std::stringstream yaml;
+
+  std::lock_guard<std::mutex> lock(results_mutex_);
+  yaml << "step_duration: " << step_duration_ << "\n";
+  yaml << "running: " << (running() ? "true" : "false") << "\n";
+  yaml << "steps:\n";
+  for (const Step& step : steps_)
+  {
+    yaml << "  - rate: " << step.rate << "\n";
+    yaml << "    duration: " << step.duration << "\n";
+    yaml << "    sent: " << step.sent << "\n";
+    yaml << "    accepted: " << step.accepted << "\n";
+    yaml << "    accepted_per_second: " << (step.duration > 0 ? step.accepted / step.duration : 0) << "\n";
+    yaml << "    command_latency:\n";
+    yaml << "      count: " << step.command_latency.count << "\n";
+    yaml << "      p50: " << step.command_latency.p50 << "\n";
+    yaml << "      p90: " << step.command_latency.p90 << "\n";
+    yaml << "      p99: " << step.command_latency.p99 << "\n";
+    yaml << "      max: " << step.command_latency.max << "\n";
+  }
+  return yaml.str();
+}
+
+void AidingCallbackBenchmark::run()
+{
+  benchmark_thread = true;
+  for (const double rate : rates_)
+  {
+    if (rate <= 0)
+      continue;
+
+    {
+      std::lock_guard<std::mutex> lock(results_mutex_);
+      sent_ = 0;
+      accepted_ = 0;
+      command_latencies_.clear();
+    }
+    recording_ = true;
+
+    // Send every measurement once per period. The commands block until the device replies,
+    // so if the device can not keep up, send as fast as it allows instead of trying to catch up
+    const auto period = std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(1.0 / rate));
+    const auto step_start = std::chrono::steady_clock::now();
+    const auto step_end = step_start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(step_duration_));
+    auto next_send = step_start;
+    bool stopped = false;
+    while (!stopped && std::chrono::steady_clock::now() < step_end)
+    {
+      {
+        std::lock_guard<std::mutex> lock(senders_mutex_);
+        for (const auto& sender : senders_)
+          sender.second();
+      }
+
+      next_send += period;
+      const auto now = std::chrono::steady_clock::now();
+      if (next_send < now)
+        next_send = now;
+
+      std::unique_lock<std::mutex> lock(stop_mutex_);
+      stopped = stop_condition_.wait_until(lock, std::min(next_send, step_end), [this] { return stop_; });
+    }
+    recording_ = false;
+    if (stopped)
+      return;
+
+    Step step;
+    {
+      std::lock_guard<std::mutex> lock(results_mutex_);
+      step.rate = rate;
+      step.duration = std::chrono::duration<double>(std::chrono::steady_clock::now() - step_start).count();
+      step.sent = sent_;
+      step.accepted = accepted_;
+      step.command_latency = percentiles(&command_latencies_);
+      steps_.push_back(step);
+    }
+    if (step_callback_)
+      step_callback_(summary(step));
+  }
+}
+
+AidingCallbackBenchmark::Percentiles AidingCallbackBenchmark::percentiles(std::vector<double>* latencies)
+{
+  Percentiles result;
+  result.count = latencies->size();
+  if (latencies->empty())
+    return result;
+
+  std::sort(latencies->begin(), latencies->end());
+  const auto at = [latencies](const double percentile)
+  {
+    return (*latencies)[static_cast<size_t>(percentile * (latencies->size() - 1))];
+  };
+  result.p50 = at(0.50);
+  result.p90 = at(0.90);
+  result.p99 = at(0.99);
+  result.max = latencies->back();
+  return result;
+}
+
+std::string AidingCallbackBenchmark::summary(const Step& step)
+{
+  char line[256];
+  snprintf(line, sizeof(line), "%.1f Hz: %lu/%lu accepted (%.1f/s), command latency p50 %.2f ms p99 %.2f ms",
+    step.rate, static_cast<unsigned long>(step.accepted), static_cast<unsigned long>(step.sent), step.duration > 0 ? step.accepted / step.duration : 0,
+    step.command_latency.p50 * 1000, step.command_latency.p99 * 1000);
+  return line;
+}
+
+}  // namespace microstrain
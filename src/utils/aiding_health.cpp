@@ -0,0 +1,208 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Parker-Lord Inertial Device Driver Implementation File
+//
+// Copyright (c) 2017, Brian Bingham
+// Copyright (c) 2020, Parker Hannifin Corp
+// This code is licensed under MIT license (see LICENSE file for details)
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include <cstdio>
+#include <vector>
+#include <sstream>
+#include <algorithm>
+
+#include "microstrain_inertial_driver_common/utils/aiding_health.h"
+
+namespace microstrain
+{
+
+AidingHealthTracker::AidingHealthTracker(const Policy& policy, std::shared_ptr<Clock> clock, Logger logger)
+  : policy_(policy), clock_(clock), logger_(logger)
+{
+}
+
+void AidingHealthTracker::recordSummary(const uint8_t type, const uint8_t source_id, const bool used, const bool residual_high, const bool sample_time_warning)
+{
+  const uint16_t key = (static_cast<uint16_t>(type) << 8) | source_id;
+  const double now = clock_->now();
+  std::string message;
+  {
+    std::lock_guard<AuditedMutex> lock(mutex_);
+    if (!filter_running_)
+      return;
+
+    Source& source = sources_[key];
+    if (source.summaries++ == 0)
+      source.pause_duration = policy_.pause_duration;
+
+    // Ramp up the averaging until a full window has been seen, so the first few summaries count for more
+    const double weight = 1.0 / std::min<uint64_t>(source.summaries, std::max<uint32_t>(policy_.window, 1));
+    source.used_ratio += weight * ((used ? 1 : 0) - source.used_ratio);
+    source.residual_warning_ratio += weight * ((residual_high ? 1 : 0) - source.residual_warning_ratio);
+    source.timing_warning_ratio += weight * ((sample_time_warning ? 1 : 0) - source.timing_warning_ratio);
+
+    switch (source.state)
+    {
+      case State::ACTIVE:
+        // Wait for a full window so a few rejections while the filter converges do not pause the source
+        if (source.summaries >= policy_.window && source.used_ratio < policy_.pause_threshold && otherSourceActive(key))
+          message = transition(key, &source, State::PAUSED, now);
+        break;
+      case State::PROBING:
+        source.probe_summaries++;
+        if (used)
+          source.probe_used++;
+        if (source.probe_summaries >= policy_.probe_count)
+        {
+          if (source.probe_used >= policy_.resume_threshold * source.probe_summaries || !otherSourceActive(key))
+          {
+            source.used_ratio = static_cast<double>(source.probe_used) / source.probe_summaries;
+            source.pause_duration = policy_.pause_duration;
+            message = transition(key, &source, State::ACTIVE, now);
+          }
+          else
+          {
+            source.pause_duration = std::min(source.pause_duration * 2, policy_.max_pause_duration);
+            message = transition(key, &source, State::PAUSED, now);
+          }
+        }
+        break;
+      case State::PAUSED:
+        // Summaries for measurements sent before the pause can still arrive, and say nothing about the pause
+        break;
+    }
+  }
+  if (!message.empty() && logger_)
+    logger_(message);
+}
+
+void AidingHealthTracker::setFilterRunning(const bool running)
+{
+  std::vector<std::string> messages;
+  {
+    std::lock_guard<AuditedMutex> lock(mutex_);
+    if (running == filter_running_)
+      return;
+    filter_running_ = running;
+    if (!running)
+    {
+      for (auto& source_iter : sources_)
+      {
+        Source& source = source_iter.second;
+        if (source.state != State::ACTIVE)
+          messages.push_back(transition(source_iter.first, &source, State::ACTIVE, clock_->now()));
+        source.pause_duration = policy_.pause_duration;
+      }
+    }
+  }
+  if (logger_)
+    for (const std::string& message : messages)
+      logger_(message);
+}
+
+bool AidingHealthTracker::shouldSend(const uint8_t type, const uint8_t source_id)
+{
+  const uint16_t key = (static_cast<uint16_t>(type) << 8) | source_id;
+  bool send = true;
+  std::string message;
+  {
+    std::lock_guard<AuditedMutex> lock(mutex_);
+    const auto source_iter = sources_.find(key);
+    if (source_iter == sources_.end())
+      return true;
+
+    Source& source = source_iter->second;
+    const double now = clock_->now();
+    if (source.state == State::PAUSED && now - source.state_time >= source.pause_duration)
+      message = transition(key, &source, State::PROBING, now);
+    else if (source.state == State::PROBING && source.probe_summaries == 0 && now - source.state_time >= policy_.probe_timeout)
+      message = transition(key, &source, State::ACTIVE, now);
+
+    if (source.state == State::PAUSED)
+    {
+      source.suppressed++;
+      send = false;
+    }
+  }
+  if (!message.empty() && logger_)
+    logger_(message);
+  return send;
+}
+
+std::string AidingHealthTracker::toYaml() const
+{
+  std::stringstream yaml;
+
+  std::lock_guard<AuditedMutex> lock(mutex_);
+  for (const auto& source_iter : sources_)
+  {
+    const Source& source = source_iter.second;
+    yaml << "- type: " << (source_iter.first >> 8) << "\n";
+    yaml << "  source: " << (source_iter.first & 0xFF) << "\n";
+    yaml << "  state: " << stateName(source.state) << "\n";
+    yaml << "  summaries: " << source.summaries << "\n";
+    yaml << "  used_ratio: " << source.used_ratio << "\n";
+    yaml << "  residual_warning_ratio: " << source.residual_warning_ratio << "\n";
+    yaml << "  timing_warning_ratio: " << source.timing_warning_ratio << "\n";
+    yaml << "  pauses: " << source.pauses << "\n";
+    yaml << "  suppressed: " << source.suppressed << "\n";
+    yaml << "  pause_duration: " << source.pause_duration << "\n";
+  }
+  return yaml.str();
+}
+
+void AidingHealthTracker::reset()
+{
+  std::lock_guard<AuditedMutex> lock(mutex_);
+  sources_.clear();
+}
+
+std::string AidingHealthTracker::transition(const uint16_t key, Source* source, const State state, const double now)
+{
+  source->state = state;
+  source->state_time = now;
+  source->probe_summaries = 0;
+  source->probe_used = 0;
+  if (state == State::PAUSED)
+    source->pauses++;
+
+  char message[192];
+  switch (state)
+  {
+    case State::PAUSED:
+      snprintf(message, sizeof(message), "Pausing aiding measurement type %u from sensor %u for %.1f seconds, as the filter used only %.0f%% of them",
+        key >> 8, key & 0xFF, source->pause_duration, source->used_ratio * 100);
+      break;
+    case State::PROBING:
+      snprintf(message, sizeof(message), "Probing whether the filter accepts aiding measurement type %u from sensor %u again", key >> 8, key & 0xFF);
+      break;
+    default:
+      snprintf(message, sizeof(message), "Resuming aiding measurement type %u from sensor %u", key >> 8, key & 0xFF);
+      break;
+  }
+  return message;
+}
+
+bool AidingHealthTracker::otherSourceActive(const uint16_t key) const
+{
+  const uint16_t type_key = key & 0xFF00;
+  for (auto source_iter = sources_.lower_bound(type_key); source_iter != sources_.end() && (source_iter->first & 0xFF00) == type_key; ++source_iter)
+    if (source_iter->first != key && source_iter->second.state == State::ACTIVE)
+      return true;
+  return false;
+}
+
+const char* AidingHealthTracker::stateName(const State state)
+{
+  switch (state)
+  {
+    case State::ACTIVE: return "active";
+    case State::PAUSED: return "paused";
+    case State::PROBING: return "probing";
+    default: return "unknown";
+  }
+}
+
+}  // namespace microstrain
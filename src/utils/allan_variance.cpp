@@ -0,0 +1,182 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Parker-Lord Inertial Device Driver Implementation File
+//
+// Copyright (c) 2017, Brian Bingham
+// Copyright (c) 2020, Parker Hannifin Corp
+// This code is licensed under MIT license (see LICENSE file for details)
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include <cmath>
+#include <limits>
+#include <sstream>
+#include <algorithm>
+
+#include "microstrain_inertial_driver_common/utils/allan_variance.h"
+
+namespace microstrain
+{
+
+// Points with fewer differences than this are too noisy to fit the noise parameters to
+constexpr uint64_t MIN_DIFFERENCES_FOR_FIT = 8;
+
+// Only accept a segment of the curve as a noise term if its slope is within this much of the expected slope
+constexpr double MAX_SLOPE_ERROR = 0.25;
+
+// Ratio between the minimum of the Allan deviation and the bias instability, sqrt(2 * ln(2) / pi)
+constexpr double BIAS_INSTABILITY_SCALE = 0.664;
+
+/**
+ * \brief Finds the consecutive pair of points whose log-log slope is closest to the provided slope, and uses it to find the value of a line with that slope at a cluster time
+ * \param curve The Allan deviation curve
+ * \param slope The slope of the noise term in log-log space
+ * \param tau The cluster time to read the line at
+ * \return The deviation of the fitted line at tau, or NaN if no segment of the curve has a slope close enough
+ */
+static double fitSlope(const std::vector<AllanVariance::Point>& curve, const double slope, const double tau)
+{
+  double best_error = MAX_SLOPE_ERROR;
+  double best_intercept = std::numeric_limits<double>::quiet_NaN();
+  for (size_t i = 1; i < curve.size(); i++)
+  {
+    const AllanVariance::Point& a = curve[i - 1];
+    const AllanVariance::Point& b = curve[i];
+    if (a.num_differences < MIN_DIFFERENCES_FOR_FIT || b.num_differences < MIN_DIFFERENCES_FOR_FIT || a.deviation <= 0 || b.deviation <= 0)
+      continue;
+
+    const double segment_slope = (std::log(b.deviation) - std::log(a.deviation)) / (std::log(b.tau) - std::log(a.tau));
+    const double error = std::fabs(segment_slope - slope);
+    if (error <= best_error)
+    {
+      // Average the intercept of a line with the exact slope through both points
+      best_error = error;
+      best_intercept = 0.5 * ((std::log(a.deviation) - slope * std::log(a.tau)) + (std::log(b.deviation) - slope * std::log(b.tau)));
+    }
+  }
+  return std::exp(best_intercept + slope * std::log(tau));
+}
+
+AllanVariance::AllanVariance(const size_t num_octaves)
+  : num_octaves_(num_octaves), octaves_(NUM_SIGNALS, std::vector<Octave>(num_octaves)), total_time_(NUM_SIGNALS, 0), num_samples_(NUM_SIGNALS, 0)
+{
+}
+
+void AllanVariance::add(const size_t first_signal, const double x, const double y, const double z, const double sample_period)
+{
+  if (first_signal + 2 >= NUM_SIGNALS)
+    return;
+
+  std::lock_guard<AuditedMutex> lock(mutex_);
+  const double values[3] = {x, y, z};
+  for (size_t i = 0; i < 3; i++)
+  {
+    const size_t signal = first_signal + i;
+    total_time_[signal] += sample_period;
+    num_samples_[signal]++;
+
+    // Each sample is a cluster at the first octave. Every second cluster at an octave completes a cluster at the next octave
+    double cluster = values[i];
+    for (Octave& octave : octaves_[signal])
+    {
+      if (octave.has_previous_cluster)
+      {
+        const double difference = cluster - octave.previous_cluster;
+        octave.sum_squared_differences += difference * difference;
+        octave.num_differences++;
+      }
+      octave.previous_cluster = cluster;
+      octave.has_previous_cluster = true;
+
+      if (!octave.has_partial_cluster)
+      {
+        octave.partial_cluster = cluster;
+        octave.has_partial_cluster = true;
+        break;
+      }
+      cluster = 0.5 * (octave.partial_cluster + cluster);
+      octave.has_partial_cluster = false;
+    }
+  }
+}
+
+std::vector<AllanVariance::Point> AllanVariance::curve(const size_t signal) const
+{
+  std::vector<Point> points;
+  if (signal >= NUM_SIGNALS)
+    return points;
+
+  std::lock_guard<AuditedMutex> lock(mutex_);
+  if (num_samples_[signal] == 0)
+    return points;
+
+  const double sample_period = total_time_[signal] / num_samples_[signal];
+  for (size_t i = 0; i < num_octaves_; i++)
+  {
+    const Octave& octave = octaves_[signal][i];
+    if (octave.num_differences == 0)
+      break;
+    points.push_back({std::ldexp(sample_period, static_cast<int>(i)), std::sqrt(octave.sum_squared_differences / (2.0 * octave.num_differences)), octave.num_differences});
+  }
+  return points;
+}
+
+AllanVariance::NoiseParameters AllanVariance::fit(const std::vector<Point>& curve)
+{
+  NoiseParameters parameters;
+  parameters.random_walk = fitSlope(curve, -0.5, 1.0);
+  parameters.rate_random_walk = fitSlope(curve, 0.5, 3.0);
+
+  parameters.bias_instability = std::numeric_limits<double>::quiet_NaN();
+  for (const Point& point : curve)
+  {
+    if (point.num_differences < MIN_DIFFERENCES_FOR_FIT)
+      continue;
+    if (std::isnan(parameters.bias_instability) || point.deviation / BIAS_INSTABILITY_SCALE < parameters.bias_instability)
+      parameters.bias_instability = point.deviation / BIAS_INSTABILITY_SCALE;
+  }
+  return parameters;
+}
+
+std::string AllanVariance::toYaml() const
+{
+  static const char* signal_names[NUM_SIGNALS] = {"gyro_x", "gyro_y", "gyro_z", "accel_x", "accel_y", "accel_z"};
+
+  std::stringstream yaml;
+  yaml.precision(9);
+  for (size_t signal = 0; signal < NUM_SIGNALS; signal++)
+  {
+    const std::vector<Point> points = curve(signal);
+    const NoiseParameters parameters = fit(points);
+    yaml << signal_names[signal] << ":\n";
+    yaml << "  random_walk: " << parameters.random_walk << "\n";
+    yaml << "  bias_instability: " << parameters.bias_instability << "\n";
+    yaml << "  rate_random_walk: " << parameters.rate_random_walk << "\n";
+
+    std::stringstream tau, deviation, num_differences;
+    tau.precision(9);
+    deviation.precision(9);
+    for (size_t i = 0; i < points.size(); i++)
+    {
+      const char* separator = i == 0 ? "" : ", ";
+      tau << separator << points[i].tau;
+      deviation << separator << points[i].deviation;
+      num_differences << separator << points[i].num_differences;
+    }
+    yaml << "  tau: [" << tau.str() << "]\n";
+    yaml << "  deviation: [" << deviation.str() << "]\n";
+    yaml << "  num_differences: [" << num_differences.str() << "]\n";
+  }
+  return yaml.str();
+}
+
+void AllanVariance::reset()
+{
+  std::lock_guard<AuditedMutex> lock(mutex_);
+  for (auto& octaves : octaves_)
+    std::fill(octaves.begin(), octaves.end(), Octave());
+  std::fill(total_time_.begin(), total_time_.end(), 0);
+  std::fill(num_samples_.begin(), num_samples_.end(), 0);
+}
+
+}  // namespace microstrain
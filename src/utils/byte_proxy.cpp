@@ -0,0 +1,451 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Parker-Lord Inertial Device Driver Implementation File
+//
+// Copyright (c) 2017, Brian Bingham
+// Copyright (c) 2020, Parker Hannifin Corp
+// This code is licensed under MIT license (see LICENSE file for details)
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include <poll.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/un.h>
+#include <sys/socket.h>
+
+#include <cstring>
+#include <algorithm>
+
+#include "microstrain_inertial_driver_common/utils/byte_proxy.h"
+
+namespace microstrain
+{
+
+// How often the proxy thread checks for new data when no client has written anything
+constexpr int PROXY_POLL_PERIOD_MS = 5;
+
+// MIP packet layout
+constexpr uint8_t MIP_SYNC1 = 0x75;
+constexpr uint8_t MIP_SYNC2 = 0x65;
+constexpr size_t MIP_HEADER_SIZE = 4;
+constexpr size_t MIP_CHECKSUM_SIZE = 2;
+constexpr uint8_t MIP_REPLY_FIELD_DESCRIPTOR = 0xF1;
+
+// Limit on bytes a client can write without forming a packet, so a client writing garbage can not grow the buffer forever
+constexpr size_t MAX_COMMAND_BUFFER_SIZE = 4096;
+
+// Limit on commands from one client waiting to be forwarded, so one client can not flood the queue and starve the others. Commands past this are dropped
+constexpr size_t MAX_PENDING_COMMANDS_PER_CLIENT = 16;
+
+// Largest piece of data copied out of the ring buffer at a time before it is sent to a client
+constexpr size_t MAX_STAGING_SIZE = 65536;
+
+// Client ID used for commands sent by the driver itself. Clients are numbered from 1
+constexpr uint64_t DRIVER_CLIENT_ID = 0;
+
+ByteProxy::ByteProxy(const size_t buffer_size, const bool commands_enable, const int command_timeout_ms)
+  : commands_enable_(commands_enable), command_timeout_(command_timeout_ms)
+{
+  size_t capacity = 1024;
+  while (capacity < buffer_size)
+    capacity <<= 1;
+  buffer_.reset(new std::atomic<uint8_t>[capacity]);
+  capacity_ = capacity;
+  mask_ = capacity - 1;
+  staging_.resize(std::min(capacity, MAX_STAGING_SIZE));
+}
+
+ByteProxy::~ByteProxy()
+{
+  stop();
+}
+
+bool ByteProxy::start(const std::string& socket_path, std::string* error)
+{
+  struct sockaddr_un address;
+  memset(&address, 0, sizeof(address));
+  address.sun_family = AF_UNIX;
+  if (socket_path.empty() || socket_path.size() >= sizeof(address.sun_path))
+  {
+    *error = "Socket path must be between 1 and " + std::to_string(sizeof(address.sun_path) - 1) + " characters";
+    return false;
+  }
+  strncpy(address.sun_path, socket_path.c_str(), sizeof(address.sun_path) - 1);
+
+  listen_fd_ = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+  if (listen_fd_ < 0)
+  {
+    *error = std::string("socket: ") + strerror(errno);
+    return false;
+  }
+  unlink(socket_path.c_str());
+  if (bind(listen_fd_, reinterpret_cast<struct sockaddr*>(&address), sizeof(address)) != 0 || listen(listen_fd_, 8) != 0)
+  {
+    *error = std::string("bind: ") + strerror(errno);
+    close(listen_fd_);
+    listen_fd_ = -1;
+    return false;
+  }
+  socket_path_ = socket_path;
+
+  running_ = true;
+  thread_ = std::thread(&ByteProxy::run, this);
+  return true;
+}
+
+void ByteProxy::stop()
+{
+  running_ = false;
+  if (thread_.joinable())
+    thread_.join();
+  for (const Client& client : clients_)
+    close(client.fd);
+  clients_.clear();
+  pending_commands_.clear();
+  routed_replies_.clear();
+
+  // Nothing will send queued commands any more. The driver will time out waiting on their replies, the same as if the device had not answered
+  {
+    std::lock_guard<std::mutex> lock(command_mutex_);
+    command_outstanding_ = false;
+    driver_commands_.clear();
+  }
+
+  if (listen_fd_ >= 0)
+  {
+    close(listen_fd_);
+    unlink(socket_path_.c_str());
+    listen_fd_ = -1;
+  }
+}
+
+void ByteProxy::setSender(Sender sender)
+{
+  std::lock_guard<std::mutex> lock(sender_mutex_);
+  sender_ = sender;
+}
+
+void ByteProxy::write(const uint8_t* data, size_t size)
+{
+  if (!running_.load(std::memory_order_relaxed) || size == 0)
+    return;
+
+  // Only the last buffer worth of bytes can ever be read, so skip anything before that
+  const uint64_t start = write_position_.load(std::memory_order_relaxed);
+  const uint64_t end = start + size;
+  if (size > capacity_)
+  {
+    data += size - capacity_;
+    size = capacity_;
+  }
+
+  // Announce how far we are about to write before touching the buffer, so a reader that copied any of these bytes will see that its copy may be torn
+  write_reserve_position_.store(end, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  const size_t offset = (end - size) & mask_;
+  for (size_t i = 0; i < size; i++)
+    buffer_[(offset + i) & mask_].store(data[i], std::memory_order_relaxed);
+  write_position_.store(end, std::memory_order_release);
+}
+
+bool ByteProxy::beginDriverCommand(const uint8_t* data, const size_t size)
+{
+  if (!commands_enable_ || !running_ || size < MIP_HEADER_SIZE + 2)
+    return true;
+
+  // The reply to a client's command can only be found by the driver reading from the device, and that happens on the thread calling us,
+  // so rather than wait for it, leave the command for the proxy thread to send once the reply has been routed.
+  // Commands already queued go first, so the driver's commands reach the device in the order it sent them
+  std::lock_guard<std::mutex> lock(command_mutex_);
+  if ((command_outstanding_ && command_client_id_ != DRIVER_CLIENT_ID) || !driver_commands_.empty())
+  {
+    driver_commands_.emplace_back(data, data + size);
+    return false;
+  }
+  beginCommand(DRIVER_CLIENT_ID, data);
+  return true;
+}
+
+void ByteProxy::run()
+{
+  std::vector<struct pollfd> poll_fds;
+  while (running_)
+  {
+    // Wait for a new client, or data from an existing one
+    poll_fds.clear();
+    poll_fds.push_back({listen_fd_, POLLIN, 0});
+    for (const Client& client : clients_)
+      poll_fds.push_back({client.fd, POLLIN, 0});
+    poll(poll_fds.data(), poll_fds.size(), PROXY_POLL_PERIOD_MS);
+
+    // New clients start with the next byte read from the device
+    const uint64_t end = write_position_.load(std::memory_order_acquire);
+    if (poll_fds[0].revents & POLLIN)
+    {
+      int client_fd;
+      while ((client_fd = accept4(listen_fd_, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC)) >= 0)
+        clients_.push_back({next_client_id_++, client_fd, end, {}, 0});
+    }
+
+    // Read commands from the clients
+    for (size_t i = 0; i < clients_.size();)
+    {
+      const short revents = i + 1 < poll_fds.size() ? poll_fds[i + 1].revents : 0;
+      if ((revents & (POLLIN | POLLHUP | POLLERR)) && !readClient(&clients_[i]))
+      {
+        // Nobody is left to read the replies to its commands, so do not forward them
+        const uint64_t client_id = clients_[i].id;
+        pending_commands_.erase(std::remove_if(pending_commands_.begin(), pending_commands_.end(),
+            [client_id](const PendingCommand& command) { return command.client_id == client_id; }), pending_commands_.end());
+        close(clients_[i].fd);
+        clients_.erase(clients_.begin() + i);
+        poll_fds.erase(poll_fds.begin() + i + 1);
+      }
+      else
+      {
+        i++;
+      }
+    }
+
+    // Find replies before sending anything, so a reply is never sent to a client that did not ask for it
+    const uint64_t send_end = commands_enable_ ? updateCommands(end) : end;
+
+    // Send the clients anything new from the device
+    for (size_t i = 0; i < clients_.size();)
+    {
+      if (!flushClient(&clients_[i], send_end))
+      {
+        close(clients_[i].fd);
+        clients_.erase(clients_.begin() + i);
+      }
+      else
+      {
+        i++;
+      }
+    }
+
+    // Forget replies every client has moved past
+    uint64_t oldest_client_position = send_end;
+    for (const Client& client : clients_)
+      oldest_client_position = std::min(oldest_client_position, client.position);
+    while (!routed_replies_.empty() && routed_replies_.front().end <= oldest_client_position)
+      routed_replies_.pop_front();
+  }
+}
+
+bool ByteProxy::flushClient(Client* client, const uint64_t end)
+{
+  // If the client has fallen too far behind, the writer may be overwriting what we would send, so skip ahead
+  if (end > client->position && end - client->position > capacity_ / 2)
+    client->position = end;
+
+  while (client->position < end)
+  {
+    // Skip replies to commands from other clients, and stop short of the next one
+    size_t size = std::min(static_cast<size_t>(end - client->position), staging_.size());
+    for (const RoutedReply& reply : routed_replies_)
+    {
+      if (reply.client_id == client->id || reply.end <= client->position)
+        continue;
+      if (reply.start <= client->position)
+        client->position = reply.end;
+      else
+        size = std::min(size, static_cast<size_t>(reply.start - client->position));
+    }
+    if (client->position >= end)
+      break;
+    size = std::min(size, static_cast<size_t>(end - client->position));
+
+    // Copy the data out before sending it, and only send it if the writer did not start overwriting it while we were copying.
+    // If it did, the client fell too far behind, so throw the copy away and carry on from the newest data like any other client that fell behind
+    copyOut(client->position, size, staging_.data());
+    if (client->position < oldestIntactPosition())
+    {
+      client->position = std::max(end, oldestIntactPosition());
+      break;
+    }
+
+    const ssize_t count = send(client->fd, staging_.data(), size, MSG_NOSIGNAL | MSG_DONTWAIT);
+    if (count < 0)
+      return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+    client->position += count;
+    if (static_cast<size_t>(count) < size)
+      break;
+  }
+  return true;
+}
+
+void ByteProxy::copyOut(const uint64_t position, const size_t size, uint8_t* data) const
+{
+  for (size_t i = 0; i < size; i++)
+    data[i] = buffer_[(position + i) & mask_].load(std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_acquire);
+}
+
+uint64_t ByteProxy::oldestIntactPosition() const
+{
+  const uint64_t reserve_position = write_reserve_position_.load(std::memory_order_relaxed);
+  return reserve_position > capacity_ ? reserve_position - capacity_ : 0;
+}
+
+bool ByteProxy::readClient(Client* client)
+{
+  uint8_t data[1024];
+  while (true)
+  {
+    const ssize_t count = recv(client->fd, data, sizeof(data), MSG_DONTWAIT);
+    if (count == 0)
+      return false;
+    if (count < 0)
+      return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+
+    // Clients that are only watching are allowed to write, but it is ignored
+    if (!commands_enable_)
+      continue;
+    client->command_buffer.insert(client->command_buffer.end(), data, data + count);
+    std::vector<uint8_t> packet;
+    while (extractPacket(&client->command_buffer, &packet))
+    {
+      if (client->pending_commands >= MAX_PENDING_COMMANDS_PER_CLIENT)
+        continue;
+      pending_commands_.push_back({client->id, packet});
+      client->pending_commands++;
+    }
+    if (client->command_buffer.size() > MAX_COMMAND_BUFFER_SIZE)
+      client->command_buffer.clear();
+  }
+}
+
+uint64_t ByteProxy::updateCommands(const uint64_t end)
+{
+  std::unique_lock<std::mutex> lock(command_mutex_);
+
+  // Look through whatever the device sent since the command was sent for its reply
+  if (command_outstanding_)
+  {
+    if (end > reply_position_ && end - reply_position_ > capacity_ / 2)
+    {
+      reply_position_ = end - capacity_ / 2;
+      reply_buffer_.clear();
+    }
+    while (reply_position_ < end)
+    {
+      const size_t size = std::min(static_cast<size_t>(end - reply_position_), staging_.size());
+      copyOut(reply_position_, size, staging_.data());
+      if (reply_position_ < oldestIntactPosition())
+      {
+        reply_position_ = end;
+        reply_buffer_.clear();
+        break;
+      }
+      reply_buffer_.insert(reply_buffer_.end(), staging_.data(), staging_.data() + size);
+      reply_position_ += size;
+    }
+
+    std::vector<uint8_t> packet;
+    while (command_outstanding_ && extractPacket(&reply_buffer_, &packet))
+    {
+      if (packet[2] != command_descriptor_set_)
+        continue;
+      for (size_t field = MIP_HEADER_SIZE; field + 2 < packet.size() - MIP_CHECKSUM_SIZE && packet[field] >= 2; field += packet[field])
+      {
+        if (packet[field + 1] == MIP_REPLY_FIELD_DESCRIPTOR && packet[field + 2] == command_field_descriptor_)
+        {
+          // Only the client that sent the command gets the reply. The driver's replies are left for everyone, as before
+          const uint64_t packet_end = reply_position_ - reply_buffer_.size();
+          if (command_client_id_ != DRIVER_CLIENT_ID)
+            routed_replies_.push_back({command_client_id_, packet_end - packet.size(), packet_end});
+          command_outstanding_ = false;
+          break;
+        }
+      }
+    }
+    if (std::chrono::steady_clock::now() > command_deadline_)
+      command_outstanding_ = false;
+  }
+
+  // Commands the driver queued while a client's command was outstanding go before any other client command
+  while (!command_outstanding_ && !driver_commands_.empty())
+  {
+    const std::vector<uint8_t> packet = std::move(driver_commands_.front());
+    driver_commands_.pop_front();
+
+    std::lock_guard<std::mutex> sender_lock(sender_mutex_);
+    beginCommand(DRIVER_CLIENT_ID, packet.data());
+    if (!sender_ || !sender_(packet.data(), packet.size()))
+      command_outstanding_ = false;
+  }
+
+  // Forward the next command once the device has answered the previous one
+  if (!command_outstanding_ && !pending_commands_.empty())
+  {
+    const PendingCommand command = pending_commands_.front();
+    pending_commands_.pop_front();
+    for (Client& client : clients_)
+      if (client.id == command.client_id)
+        client.pending_commands--;
+
+    std::lock_guard<std::mutex> sender_lock(sender_mutex_);
+    beginCommand(command.client_id, command.packet.data());
+    if (!sender_ || !sender_(command.packet.data(), command.packet.size()))
+      command_outstanding_ = false;
+  }
+
+  // Until a command from a client is answered, hold back anything that may turn out to be the start of its reply
+  if (command_outstanding_ && command_client_id_ != DRIVER_CLIENT_ID)
+    return std::min(end, reply_position_ - reply_buffer_.size());
+  return end;
+}
+
+void ByteProxy::beginCommand(const uint64_t client_id, const uint8_t* packet)
+{
+  command_outstanding_ = true;
+  command_client_id_ = client_id;
+  command_descriptor_set_ = packet[2];
+  command_field_descriptor_ = packet[MIP_HEADER_SIZE + 1];
+  command_deadline_ = std::chrono::steady_clock::now() + command_timeout_;
+  reply_position_ = write_position_.load(std::memory_order_acquire);
+  reply_buffer_.clear();
+}
+
+bool ByteProxy::extractPacket(std::vector<uint8_t>* buffer, std::vector<uint8_t>* packet)
+{
+  size_t offset = 0;
+  bool found = false;
+  while (offset + MIP_HEADER_SIZE <= buffer->size())
+  {
+    const uint8_t* header = buffer->data() + offset;
+    if (header[0] != MIP_SYNC1 || header[1] != MIP_SYNC2)
+    {
+      offset++;
+      continue;
+    }
+
+    const size_t packet_size = MIP_HEADER_SIZE + header[3] + MIP_CHECKSUM_SIZE;
+    if (offset + packet_size > buffer->size())
+      break;
+
+    // Fletcher checksum over the header and payload
+    uint8_t checksum_msb = 0, checksum_lsb = 0;
+    for (size_t i = 0; i < packet_size - MIP_CHECKSUM_SIZE; i++)
+    {
+      checksum_msb += header[i];
+      checksum_lsb += checksum_msb;
+    }
+    if (header[3] < 2 || checksum_msb != header[packet_size - 2] || checksum_lsb != header[packet_size - 1])
+    {
+      offset++;
+      continue;
+    }
+
+    packet->assign(header, header + packet_size);
+    offset += packet_size;
+    found = true;
+    break;
+  }
+  buffer->erase(buffer->begin(), buffer->begin() + offset);
+  return found;
+}
+
+}  // namespace microstrain
@@ -0,0 +1,179 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Parker-Lord Inertial Device Driver Implementation File
+//
+// Copyright (c) 2017, Brian Bingham
+// Copyright (c) 2020, Parker Hannifin Corp
+// This code is licensed under MIT license (see LICENSE file for details)
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include <array>
+#include <cstring>
+
+#include "microstrain_inertial_driver_common/utils/cdr_serializer.h"
+
+#if MICROSTRAIN_ROS_VERSION == 2
+
+namespace microstrain
+{
+
+// Every serialized message starts with a 4 byte encapsulation header. Alignment in the rest of the message is relative to the end of it
+constexpr size_t CDR_ENCAPSULATION_SIZE = 4;
+
+// Number of doubles in the body of each supported message
+constexpr size_t CDR_IMU_NUM_DOUBLES = 4 + 9 + 3 + 9 + 3 + 9;
+constexpr size_t CDR_ODOMETRY_NUM_DOUBLES = 3 + 4 + 36 + 3 + 3 + 36;
+constexpr size_t CDR_TWIST_WITH_COVARIANCE_STAMPED_NUM_DOUBLES = 3 + 3 + 36;
+
+/**
+ * \brief Rounds an offset up to the next multiple of an alignment
+ * \param offset The offset to align
+ * \param alignment The alignment to round up to
+ * \return The aligned offset
+ */
+static size_t cdrAlign(const size_t offset, const size_t alignment)
+{
+  return (offset + alignment - 1) & ~(alignment - 1);
+}
+
+/**
+ * \brief Writes a CDR string, which is the length including the null terminator followed by the characters and the null terminator
+ * \param buffer Buffer to write the string to
+ * \param value The string to write
+ */
+static void cdrWriteString(uint8_t* buffer, const std::string& value)
+{
+  const uint32_t length = static_cast<uint32_t>(value.size() + 1);
+  memcpy(buffer, &length, sizeof(length));
+  memcpy(buffer + sizeof(length), value.c_str(), length);
+}
+
+void CdrLayout::begin(rclcpp::SerializedMessage* serialized_msg, const RosHeaderType& header, const std::string* child_frame_id, const size_t num_doubles)
+{
+  rcl_serialized_message_t& rcl_serialized_msg = serialized_msg->get_rcl_serialized_message();
+
+  // Only the strings can move the doubles, so only compute the layout again if they change
+  const bool has_child_frame_id = child_frame_id != nullptr;
+  if (body_offset_ == 0 || header.frame_id != frame_id_ || has_child_frame_id != has_child_frame_id_ ||
+      (has_child_frame_id && *child_frame_id != child_frame_id_) || num_doubles != num_doubles_)
+  {
+    frame_id_ = header.frame_id;
+    has_child_frame_id_ = has_child_frame_id;
+    child_frame_id_ = has_child_frame_id ? *child_frame_id : std::string();
+    num_doubles_ = num_doubles;
+
+    // The stamp is two 4 byte integers, followed by the frame ID, the optional child frame ID, and then the doubles
+    const size_t frame_id_offset = 8;
+    size_t offset = frame_id_offset + sizeof(uint32_t) + frame_id_.size() + 1;
+    const size_t child_frame_id_offset = cdrAlign(offset, sizeof(uint32_t));
+    if (has_child_frame_id_)
+      offset = child_frame_id_offset + sizeof(uint32_t) + child_frame_id_.size() + 1;
+    body_offset_ = CDR_ENCAPSULATION_SIZE + cdrAlign(offset, sizeof(double));
+
+    const size_t length = body_offset_ + num_doubles_ * sizeof(double);
+    serialized_msg->reserve(length);
+    uint8_t* buffer = rcl_serialized_msg.buffer;
+    memset(buffer, 0, length);
+
+    // Plain CDR in the byte order of this machine
+    const uint16_t byte_order_test = 1;
+    buffer[1] = *reinterpret_cast<const uint8_t*>(&byte_order_test) == 1 ? 0x01 : 0x00;
+
+    cdrWriteString(buffer + CDR_ENCAPSULATION_SIZE + frame_id_offset, frame_id_);
+    if (has_child_frame_id_)
+      cdrWriteString(buffer + CDR_ENCAPSULATION_SIZE + child_frame_id_offset, child_frame_id_);
+    rcl_serialized_msg.buffer_length = length;
+  }
+
+  buffer_ = rcl_serialized_msg.buffer;
+  memcpy(buffer_ + CDR_ENCAPSULATION_SIZE, &header.stamp.sec, sizeof(header.stamp.sec));
+  memcpy(buffer_ + CDR_ENCAPSULATION_SIZE + sizeof(header.stamp.sec), &header.stamp.nanosec, sizeof(header.stamp.nanosec));
+  cursor_ = body_offset_;
+}
+
+void CdrLayout::put(const double value)
+{
+  memcpy(buffer_ + cursor_, &value, sizeof(value));
+  cursor_ += sizeof(value);
+}
+
+const rclcpp::SerializedMessage& CdrSerializer<ImuMsg>::serialize(const ImuMsg& msg)
+{
+  layout_.begin(&serialized_msg_, msg.header, nullptr, CDR_IMU_NUM_DOUBLES);
+  layout_.put(msg.orientation.x);
+  layout_.put(msg.orientation.y);
+  layout_.put(msg.orientation.z);
+  layout_.put(msg.orientation.w);
+  layout_.putArray(msg.orientation_covariance);
+  layout_.put(msg.angular_velocity.x);
+  layout_.put(msg.angular_velocity.y);
+  layout_.put(msg.angular_velocity.z);
+  layout_.putArray(msg.angular_velocity_covariance);
+  layout_.put(msg.linear_acceleration.x);
+  layout_.put(msg.linear_acceleration.y);
+  layout_.put(msg.linear_acceleration.z);
+  layout_.putArray(msg.linear_acceleration_covariance);
+  return serialized_msg_;
+}
+
+const rclcpp::SerializedMessage& CdrSerializer<ImuSample>::serialize(const ImuSample& sample)
+{
+  // Same layout as the IMU message toRosMessage would convert the sample to. The raw IMU data does not contain an orientation
+  layout_.begin(&serialized_msg_, sample.header, nullptr, CDR_IMU_NUM_DOUBLES);
+  for (size_t i = 0; i < 4 + 9; i++)
+    layout_.put(0);
+  layout_.put(sample.angular_velocity.x);
+  layout_.put(sample.angular_velocity.y);
+  layout_.put(sample.angular_velocity.z);
+  if (sample.covariance != nullptr)
+    layout_.putArray(sample.covariance->angular_velocity);
+  else
+    layout_.putArray(std::array<double, 9>());
+  layout_.put(sample.linear_acceleration.x);
+  layout_.put(sample.linear_acceleration.y);
+  layout_.put(sample.linear_acceleration.z);
+  if (sample.covariance != nullptr)
+    layout_.putArray(sample.covariance->linear_acceleration);
+  else
+    layout_.putArray(std::array<double, 9>());
+  return serialized_msg_;
+}
+
+const rclcpp::SerializedMessage& CdrSerializer<OdometryMsg>::serialize(const OdometryMsg& msg)
+{
+  layout_.begin(&serialized_msg_, msg.header, &msg.child_frame_id, CDR_ODOMETRY_NUM_DOUBLES);
+  layout_.put(msg.pose.pose.position.x);
+  layout_.put(msg.pose.pose.position.y);
+  layout_.put(msg.pose.pose.position.z);
+  layout_.put(msg.pose.pose.orientation.x);
+  layout_.put(msg.pose.pose.orientation.y);
+  layout_.put(msg.pose.pose.orientation.z);
+  layout_.put(msg.pose.pose.orientation.w);
+  layout_.putArray(msg.pose.covariance);
+  layout_.put(msg.twist.twist.linear.x);
+  layout_.put(msg.twist.twist.linear.y);
+  layout_.put(msg.twist.twist.linear.z);
+  layout_.put(msg.twist.twist.angular.x);
+  layout_.put(msg.twist.twist.angular.y);
+  layout_.put(msg.twist.twist.angular.z);
+  layout_.putArray(msg.twist.covariance);
+  return serialized_msg_;
+}
+
+const rclcpp::SerializedMessage& CdrSerializer<TwistWithCovarianceStampedMsg>::serialize(const TwistWithCovarianceStampedMsg& msg)
+{
+  layout_.begin(&serialized_msg_, msg.header, nullptr, CDR_TWIST_WITH_COVARIANCE_STAMPED_NUM_DOUBLES);
+  layout_.put(msg.twist.twist.linear.x);
+  layout_.put(msg.twist.twist.linear.y);
+  layout_.put(msg.twist.twist.linear.z);
+  layout_.put(msg.twist.twist.angular.x);
+  layout_.put(msg.twist.twist.angular.y);
+  layout_.put(msg.twist.twist.angular.z);
+  layout_.putArray(msg.twist.covariance);
+  return serialized_msg_;
+}
+
+}  // namespace microstrain
+
+#endif
@@ -0,0 +1,62 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Parker-Lord Inertial Device Driver Implementation File
+//
+// Copyright (c) 2017, Brian Bingham
+// Copyright (c) 2020, Parker Hannifin Corp
+// This code is licensed under MIT license (see LICENSE file for details)
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include <cmath>
+#include <chrono>
+#include <thread>
+
+#include "microstrain_inertial_driver_common/utils/clock.h"
+
+namespace microstrain
+{
+
+RosClock::RosClock(RosNodeType* node) : node_(node)
+{
+}
+
+RosTimeType RosClock::rosNow() const
+{
+  return rosTimeNow(node_);
+}
+
+void RosClock::sleepFor(const double seconds)
+{
+  if (seconds > 0)
+    std::this_thread::sleep_for(std::chrono::duration<double>(seconds));
+}
+
+VirtualClock::VirtualClock(const int64_t start_nanoseconds) : nanoseconds_(start_nanoseconds)
+{
+}
+
+RosTimeType VirtualClock::rosNow() const
+{
+  // Split the integer time instead of going through a double, so the stamps are exactly the recorded ones
+  const int64_t nanoseconds = nanoseconds_.load();
+  RosTimeType time;
+  setRosTime(&time, static_cast<int32_t>(nanoseconds / 1000000000), static_cast<int32_t>(nanoseconds % 1000000000));
+  return time;
+}
+
+void VirtualClock::sleepFor(const double seconds)
+{
+  if (seconds > 0)
+    advanceTo(nanoseconds_.load() + static_cast<int64_t>(std::llround(seconds * 1000000000.0)));
+}
+
+void VirtualClock::advanceTo(const int64_t nanoseconds)
+{
+  int64_t current = nanoseconds_.load();
+  while (nanoseconds > current && !nanoseconds_.compare_exchange_weak(current, nanoseconds))
+  {
+  }
+}
+
+}  // namespace microstrain
@@ -66,5 +66,12 @@ void ClockBiasMonitor::reset()
   delta_time_average_vector_.clear();
 }
 
+void ClockBiasMonitor::restore(const double bias_estimate)
+{
+  bias_estimate_ = bias_estimate;
+  have_bias_estimate_ = true;
+  delta_time_average_vector_.clear();
+}
+
 
 }  // namespace microstrain
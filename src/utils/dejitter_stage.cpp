@@ -0,0 +1,89 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Parker-Lord Inertial Device Driver Implementation File
+//
+// Copyright (c) 2017, Brian Bingham
+// Copyright (c) 2020, Parker Hannifin Corp
+// This code is licensed under MIT license (see LICENSE file for details)
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include <sys/prctl.h>
+
+#include <sstream>
+#include <algorithm>
+
+#include "microstrain_inertial_driver_common/utils/dejitter_stage.h"
+
+namespace microstrain
+{
+
+void setMinimumTimerSlack()
+{
+  // The default slack of 50us would add that much jitter to every release
+  prctl(PR_SET_TIMERSLACK, 1, 0, 0, 0);
+}
+
+DejitterStatistics::DejitterStatistics(const double delay, const size_t capacity) : delay_(delay), capacity_(capacity)
+{
+}
+
+void DejitterStatistics::recordRelease(const double error)
+{
+  std::lock_guard<AuditedMutex> lock(mutex_);
+  released_++;
+  release_error_sum_ += error;
+  release_error_max_ = std::max(release_error_max_, error);
+}
+
+void DejitterStatistics::recordMiss(const double lateness)
+{
+  std::lock_guard<AuditedMutex> lock(mutex_);
+  missed_++;
+  miss_lateness_max_ = std::max(miss_lateness_max_, lateness);
+}
+
+void DejitterStatistics::recordOverflow()
+{
+  std::lock_guard<AuditedMutex> lock(mutex_);
+  dropped_++;
+}
+
+uint64_t DejitterStatistics::takeNewMisses()
+{
+  std::lock_guard<AuditedMutex> lock(mutex_);
+  const uint64_t misses = missed_ + dropped_;
+  const uint64_t new_misses = misses - reported_misses_;
+  reported_misses_ = misses;
+  return new_misses;
+}
+
+std::string DejitterStatistics::toYaml() const
+{
+  std::stringstream yaml;
+
+  std::lock_guard<AuditedMutex> lock(mutex_);
+  yaml << "delay: " << delay_ << "\n";
+  yaml << "capacity: " << capacity_ << "\n";
+  yaml << "released: " << released_ << "\n";
+  yaml << "missed: " << missed_ << "\n";
+  yaml << "dropped: " << dropped_ << "\n";
+  yaml << "release_error_mean: " << (released_ > 0 ? release_error_sum_ / released_ : 0) << "\n";
+  yaml << "release_error_max: " << release_error_max_ << "\n";
+  yaml << "miss_lateness_max: " << miss_lateness_max_ << "\n";
+  return yaml.str();
+}
+
+void DejitterStatistics::reset()
+{
+  std::lock_guard<AuditedMutex> lock(mutex_);
+  released_ = 0;
+  missed_ = 0;
+  dropped_ = 0;
+  reported_misses_ = 0;
+  release_error_sum_ = 0;
+  release_error_max_ = 0;
+  miss_lateness_max_ = 0;
+}
+
+}  // namespace microstrain
@@ -0,0 +1,152 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Parker-Lord Inertial Device Driver Implementation File
+//
+// Copyright (c) 2017, Brian Bingham
+// Copyright (c) 2020, Parker Hannifin Corp
+// This code is licensed under MIT license (see LICENSE file for details)
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include <algorithm>
+
+#include "microstrain_inertial_driver_common/utils/gnss_integrity.h"
+
+namespace microstrain
+{
+
+// Corrections have to get this much younger than the stale age before they count as fresh again, so an age hovering around it does not flap
+constexpr double CORRECTIONS_FRESH_RATIO = 0.8;
+
+// Name of each value populated by toArray, in order
+static const char* FIELD_NAMES[GnssIntegrity::NUM_FIELDS] = {"fix_class", "corrections_state", "corrections_age", "jamming_state", "spoofing_state", "sbas_available"};
+
+GnssIntegrity::GnssIntegrity(const Settings& settings)
+  : settings_(settings)
+{
+}
+
+void GnssIntegrity::updateFix(const uint8_t fix_class)
+{
+  fix_class_.reported = fix_class;
+  fix_class_.pending = true;
+  seen_ = true;
+}
+
+void GnssIntegrity::updateRfBand(const uint8_t rf_band, const uint8_t jamming_state, const uint8_t spoofing_state)
+{
+  if (rf_band >= NUM_RF_BANDS)
+    return;
+  rf_band_jamming_state_[rf_band] = jamming_state;
+  rf_band_spoofing_state_[rf_band] = spoofing_state;
+
+  // The receiver reports each band in its own field, so the receiver is only as good as its worst band
+  jamming_state_.reported = *std::max_element(rf_band_jamming_state_.begin(), rf_band_jamming_state_.end());
+  jamming_state_.pending = true;
+  spoofing_state_.reported = *std::max_element(rf_band_spoofing_state_.begin(), rf_band_spoofing_state_.end());
+  spoofing_state_.pending = true;
+  seen_ = true;
+}
+
+void GnssIntegrity::updateSbas(const bool available)
+{
+  sbas_available_.reported = available ? 1 : 0;
+  sbas_available_.pending = true;
+  seen_ = true;
+}
+
+void GnssIntegrity::updateCorrectionsAge(const double age, const double now)
+{
+  state_.corrections_age = age < 0 ? -1 : age;
+  last_corrections_time_ = now;
+
+  // Between the fresh and stale ages, keep whatever the corrections were
+  if (age < 0)
+    corrections_.reported = CORRECTIONS_NONE;
+  else if (age > settings_.corrections_stale_age)
+    corrections_.reported = CORRECTIONS_STALE;
+  else if (age <= settings_.corrections_stale_age * CORRECTIONS_FRESH_RATIO)
+    corrections_.reported = CORRECTIONS_FRESH;
+  else
+    corrections_.reported = state_.corrections == CORRECTIONS_NONE ? CORRECTIONS_STALE : state_.corrections;
+  corrections_.pending = true;
+}
+
+bool GnssIntegrity::evaluate(const double now)
+{
+  if (!seen_)
+    return false;
+
+  bool changed = false;
+  changed |= debounce(&fix_class_, &state_.fix_class, false);
+  changed |= debounce(&corrections_, &state_.corrections, false);
+  changed |= debounce(&jamming_state_, &state_.jamming_state, true);
+  changed |= debounce(&spoofing_state_, &state_.spoofing_state, true);
+
+  uint8_t sbas_available = state_.sbas_available ? 1 : 0;
+  changed |= debounce(&sbas_available_, &sbas_available, false);
+  state_.sbas_available = sbas_available != 0;
+
+  // If the corrections status stops arriving, the corrections the receiver has are only getting older
+  if (state_.corrections != CORRECTIONS_NONE && now - last_corrections_time_ > settings_.corrections_stale_age)
+  {
+    state_.corrections = CORRECTIONS_NONE;
+    state_.corrections_age = -1;
+    corrections_ = Debounced();
+    changed = true;
+  }
+
+  // Time going backwards most likely means the device reconnected, so report the state instead of waiting for the heartbeat
+  if (!changed && last_report_time_ >= 0 && now >= last_report_time_ && now - last_report_time_ < settings_.heartbeat_period)
+    return false;
+  last_report_time_ = now;
+  return true;
+}
+
+const GnssIntegrity::State& GnssIntegrity::state() const
+{
+  return state_;
+}
+
+void GnssIntegrity::toArray(double* data) const
+{
+  data[0] = state_.fix_class;
+  data[1] = state_.corrections;
+  data[2] = state_.corrections_age;
+  data[3] = state_.jamming_state;
+  data[4] = state_.spoofing_state;
+  data[5] = state_.sbas_available ? 1 : 0;
+}
+
+const char* GnssIntegrity::fieldName(const size_t field)
+{
+  return field < NUM_FIELDS ? FIELD_NAMES[field] : "unknown";
+}
+
+bool GnssIntegrity::debounce(Debounced* debounced, uint8_t* value, const bool higher_is_worse)
+{
+  if (!debounced->pending)
+    return false;
+  debounced->pending = false;
+
+  if (debounced->reported == *value)
+  {
+    debounced->count = 0;
+    return false;
+  }
+  if (debounced->count == 0 || debounced->reported != debounced->candidate)
+  {
+    debounced->candidate = debounced->reported;
+    debounced->count = 0;
+  }
+
+  const bool worse = higher_is_worse ? debounced->candidate > *value : debounced->candidate < *value;
+  if (++debounced->count < std::max<uint32_t>(worse ? settings_.degrade_count : settings_.upgrade_count, 1))
+    return false;
+
+  *value = debounced->candidate;
+  debounced->count = 0;
+  return true;
+}
+
+}  // namespace microstrain
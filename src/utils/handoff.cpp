@@ -0,0 +1,453 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Parker-Lord Inertial Device Driver Implementation File
+//
+// Copyright (c) 2017, Brian Bingham
+// Copyright (c) 2020, Parker Hannifin Corp
+// This code is licensed under MIT license (see LICENSE file for details)
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include <poll.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/un.h>
+#include <sys/socket.h>
+
+#include <chrono>
+#include <cstring>
+#include <algorithm>
+
+#include "microstrain_inertial_driver_common/utils/handoff.h"
+
+namespace microstrain
+{
+
+constexpr uint32_t HANDOFF_MAGIC = 0x4F48534D;  // "MSHO"
+constexpr uint32_t HANDOFF_VERSION = 2;
+constexpr uint8_t HANDOFF_ACK = 0x06;
+constexpr uint32_t HANDOFF_MAX_PAYLOAD_SIZE = 65536;
+
+// Sent along with the file descriptors, so the receiver knows how much state follows
+struct HandoffHeader
+{
+  uint32_t magic;
+  uint32_t version;
+  uint32_t num_fds;
+  uint32_t payload_size;
+};
+
+/**
+ * \brief Appends the bytes of a value to a buffer
+ * \param buffer The buffer to append to
+ * \param value The value to append
+ * \param size Number of bytes in value
+ */
+static void writeBytes(std::vector<uint8_t>* buffer, const void* value, const size_t size)
+{
+  const uint8_t* bytes = static_cast<const uint8_t*>(value);
+  buffer->insert(buffer->end(), bytes, bytes + size);
+}
+
+/**
+ * Reads values out of a serialized buffer, and remembers if it ran past the end
+ */
+class HandoffReader
+{
+ public:
+  explicit HandoffReader(const std::vector<uint8_t>& buffer) : buffer_(buffer) {}
+
+  void read(void* value, const size_t size)
+  {
+    if (offset_ + size > buffer_.size())
+    {
+      ok_ = false;
+      memset(value, 0, size);
+      return;
+    }
+    memcpy(value, buffer_.data() + offset_, size);
+    offset_ += size;
+  }
+
+  bool ok() const
+  {
+    return ok_;
+  }
+
+ private:
+  const std::vector<uint8_t>& buffer_;
+  size_t offset_ = 0;
+  bool ok_ = true;
+};
+
+/**
+ * \brief Serializes the state, except for the file descriptors which are sent separately
+ * \param state The state to serialize
+ * \return The serialized state
+ */
+static std::vector<uint8_t> serializeHandoffState(const HandoffState& state)
+{
+  std::vector<uint8_t> buffer;
+  const mip::commands_base::BaseDeviceInfo& device_info = state.device_info;
+  writeBytes(&buffer, &state.stream_hash, sizeof(state.stream_hash));
+  writeBytes(&buffer, &state.config_hash, sizeof(state.config_hash));
+  writeBytes(&buffer, &device_info.firmware_version, sizeof(device_info.firmware_version));
+  writeBytes(&buffer, device_info.model_name, sizeof(device_info.model_name));
+  writeBytes(&buffer, device_info.model_number, sizeof(device_info.model_number));
+  writeBytes(&buffer, device_info.serial_number, sizeof(device_info.serial_number));
+  writeBytes(&buffer, device_info.lot_number, sizeof(device_info.lot_number));
+  writeBytes(&buffer, device_info.device_options, sizeof(device_info.device_options));
+
+  const uint32_t num_descriptors = static_cast<uint32_t>(state.supported_descriptors.size());
+  writeBytes(&buffer, &num_descriptors, sizeof(num_descriptors));
+  writeBytes(&buffer, state.supported_descriptors.data(), num_descriptors * sizeof(uint16_t));
+
+  const uint32_t num_base_rates = static_cast<uint32_t>(state.base_rates.size());
+  writeBytes(&buffer, &num_base_rates, sizeof(num_base_rates));
+  for (const auto& base_rate : state.base_rates)
+  {
+    writeBytes(&buffer, &base_rate.first, sizeof(base_rate.first));
+    writeBytes(&buffer, &base_rate.second, sizeof(base_rate.second));
+  }
+  writeBytes(&buffer, &state.max_external_frame_ids, sizeof(state.max_external_frame_ids));
+
+  writeBytes(&buffer, &state.map_to_earth_valid, sizeof(state.map_to_earth_valid));
+  writeBytes(&buffer, state.map_to_earth_translation, sizeof(state.map_to_earth_translation));
+  writeBytes(&buffer, state.map_to_earth_rotation, sizeof(state.map_to_earth_rotation));
+  writeBytes(&buffer, &state.clock_bias_valid, sizeof(state.clock_bias_valid));
+  writeBytes(&buffer, &state.clock_bias, sizeof(state.clock_bias));
+  return buffer;
+}
+
+/**
+ * \brief Deserializes the state, except for the file descriptors which are received separately
+ * \param buffer The serialized state
+ * \param state The state to populate
+ * \return true if the buffer contained a complete state
+ */
+static bool deserializeHandoffState(const std::vector<uint8_t>& buffer, HandoffState* state)
+{
+  HandoffReader reader(buffer);
+  mip::commands_base::BaseDeviceInfo& device_info = state->device_info;
+  reader.read(&state->stream_hash, sizeof(state->stream_hash));
+  reader.read(&state->config_hash, sizeof(state->config_hash));
+  reader.read(&device_info.firmware_version, sizeof(device_info.firmware_version));
+  reader.read(device_info.model_name, sizeof(device_info.model_name));
+  reader.read(device_info.model_number, sizeof(device_info.model_number));
+  reader.read(device_info.serial_number, sizeof(device_info.serial_number));
+  reader.read(device_info.lot_number, sizeof(device_info.lot_number));
+  reader.read(device_info.device_options, sizeof(device_info.device_options));
+
+  uint32_t num_descriptors = 0;
+  reader.read(&num_descriptors, sizeof(num_descriptors));
+  if (num_descriptors * sizeof(uint16_t) > buffer.size())
+    return false;
+  state->supported_descriptors.resize(num_descriptors);
+  reader.read(state->supported_descriptors.data(), num_descriptors * sizeof(uint16_t));
+
+  uint32_t num_base_rates = 0;
+  reader.read(&num_base_rates, sizeof(num_base_rates));
+  state->base_rates.clear();
+  for (uint32_t i = 0; i < num_base_rates && reader.ok(); i++)
+  {
+    uint8_t descriptor_set;
+    uint16_t base_rate;
+    reader.read(&descriptor_set, sizeof(descriptor_set));
+    reader.read(&base_rate, sizeof(base_rate));
+    state->base_rates[descriptor_set] = base_rate;
+  }
+  reader.read(&state->max_external_frame_ids, sizeof(state->max_external_frame_ids));
+
+  reader.read(&state->map_to_earth_valid, sizeof(state->map_to_earth_valid));
+  reader.read(state->map_to_earth_translation, sizeof(state->map_to_earth_translation));
+  reader.read(state->map_to_earth_rotation, sizeof(state->map_to_earth_rotation));
+  reader.read(&state->clock_bias_valid, sizeof(state->clock_bias_valid));
+  reader.read(&state->clock_bias, sizeof(state->clock_bias));
+  return reader.ok();
+}
+
+/**
+ * \brief Fills out the address of a Unix socket
+ * \param socket_path Path of the socket
+ * \param address The address to populate
+ * \param error Will be populated if the path is too long
+ * \return true if the address was populated
+ */
+static bool makeSocketAddress(const std::string& socket_path, struct sockaddr_un* address, std::string* error)
+{
+  memset(address, 0, sizeof(*address));
+  address->sun_family = AF_UNIX;
+  if (socket_path.empty() || socket_path.size() >= sizeof(address->sun_path))
+  {
+    *error = "Socket path must be between 1 and " + std::to_string(sizeof(address->sun_path) - 1) + " characters";
+    return false;
+  }
+  strncpy(address->sun_path, socket_path.c_str(), sizeof(address->sun_path) - 1);
+  return true;
+}
+
+/**
+ * \brief Waits for a socket to become ready
+ * \param fd The socket to wait on
+ * \param events The poll events to wait for
+ * \param deadline Time after which to give up
+ * \return true if the socket is ready
+ */
+static bool waitForSocket(const int fd, const short events, const std::chrono::steady_clock::time_point& deadline)
+{
+  while (true)
+  {
+    const auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now()).count();
+    if (remaining <= 0)
+      return false;
+    struct pollfd poll_fd = {fd, events, 0};
+    const int ready = poll(&poll_fd, 1, static_cast<int>(remaining));
+    if (ready > 0)
+      return true;
+    if (ready < 0 && errno != EINTR)
+      return false;
+  }
+}
+
+/**
+ * \brief Writes all of a buffer to a socket
+ * \param fd The socket to write to
+ * \param data The data to write
+ * \param size Number of bytes to write
+ * \param deadline Time after which to give up
+ * \return true if everything was written
+ */
+static bool writeAll(const int fd, const uint8_t* data, const size_t size, const std::chrono::steady_clock::time_point& deadline)
+{
+  size_t written = 0;
+  while (written < size)
+  {
+    if (!waitForSocket(fd, POLLOUT, deadline))
+      return false;
+    const ssize_t count = ::send(fd, data + written, size - written, MSG_NOSIGNAL);
+    if (count < 0 && errno != EINTR && errno != EAGAIN)
+      return false;
+    if (count > 0)
+      written += count;
+  }
+  return true;
+}
+
+/**
+ * \brief Reads a fixed number of bytes from a socket
+ * \param fd The socket to read from
+ * \param data Buffer to read into
+ * \param size Number of bytes to read
+ * \param deadline Time after which to give up
+ * \return true if everything was read
+ */
+static bool readAll(const int fd, uint8_t* data, const size_t size, const std::chrono::steady_clock::time_point& deadline)
+{
+  size_t received = 0;
+  while (received < size)
+  {
+    if (!waitForSocket(fd, POLLIN, deadline))
+      return false;
+    const ssize_t count = recv(fd, data + received, size - received, 0);
+    if (count == 0 || (count < 0 && errno != EINTR && errno != EAGAIN))
+      return false;
+    if (count > 0)
+      received += count;
+  }
+  return true;
+}
+
+HandoffServer::~HandoffServer()
+{
+  if (client_fd_ >= 0)
+    close(client_fd_);
+  if (listen_fd_ >= 0)
+  {
+    close(listen_fd_);
+    unlink(socket_path_.c_str());
+  }
+}
+
+bool HandoffServer::listen(const std::string& socket_path, std::string* error)
+{
+  struct sockaddr_un address;
+  if (!makeSocketAddress(socket_path, &address, error))
+    return false;
+
+  listen_fd_ = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+  if (listen_fd_ < 0)
+  {
+    *error = std::string("socket: ") + strerror(errno);
+    return false;
+  }
+
+  // A previous driver that did not exit cleanly may have left the socket file behind
+  unlink(socket_path.c_str());
+  if (bind(listen_fd_, reinterpret_cast<struct sockaddr*>(&address), sizeof(address)) != 0 || ::listen(listen_fd_, 1) != 0)
+  {
+    *error = std::string("bind: ") + strerror(errno);
+    close(listen_fd_);
+    listen_fd_ = -1;
+    return false;
+  }
+  socket_path_ = socket_path;
+  return true;
+}
+
+bool HandoffServer::pending()
+{
+  if (client_fd_ >= 0)
+    return true;
+  if (listen_fd_ < 0)
+    return false;
+  client_fd_ = accept4(listen_fd_, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+  return client_fd_ >= 0;
+}
+
+bool HandoffServer::send(const HandoffState& state, const int timeout_ms, std::string* error)
+{
+  if (!pending())
+  {
+    *error = "No replacement driver is connected";
+    return false;
+  }
+  const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+  const std::vector<uint8_t> payload = serializeHandoffState(state);
+
+  // The descriptors travel with the header, and the rest of the state follows it
+  int fds[2] = {state.main_fd, state.aux_fd};
+  const uint32_t num_fds = state.aux_fd >= 0 ? 2 : 1;
+  HandoffHeader header = {HANDOFF_MAGIC, HANDOFF_VERSION, num_fds, static_cast<uint32_t>(payload.size())};
+
+  struct iovec iov = {&header, sizeof(header)};
+  union
+  {
+    char buffer[CMSG_SPACE(sizeof(fds))];
+    struct cmsghdr align;
+  } control;
+  memset(&control, 0, sizeof(control));
+
+  struct msghdr msg;
+  memset(&msg, 0, sizeof(msg));
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  msg.msg_control = control.buffer;
+  msg.msg_controllen = CMSG_SPACE(num_fds * sizeof(int));
+  struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+  cmsg->cmsg_level = SOL_SOCKET;
+  cmsg->cmsg_type = SCM_RIGHTS;
+  cmsg->cmsg_len = CMSG_LEN(num_fds * sizeof(int));
+  memcpy(CMSG_DATA(cmsg), fds, num_fds * sizeof(int));
+
+  bool success = waitForSocket(client_fd_, POLLOUT, deadline) && sendmsg(client_fd_, &msg, MSG_NOSIGNAL) == static_cast<ssize_t>(sizeof(header));
+  if (success)
+    success = writeAll(client_fd_, payload.data(), payload.size(), deadline);
+
+  // Only stop using the device once the replacement confirms it has everything it needs
+  uint8_t ack = 0;
+  if (success)
+    success = readAll(client_fd_, &ack, sizeof(ack), deadline) && ack == HANDOFF_ACK;
+  if (!success)
+    *error = "The replacement driver did not accept the handoff";
+
+  close(client_fd_);
+  client_fd_ = -1;
+  return success;
+}
+
+bool receiveHandoff(const std::string& socket_path, const int timeout_ms, HandoffState* state, std::string* error)
+{
+  struct sockaddr_un address;
+  if (!makeSocketAddress(socket_path, &address, error))
+    return false;
+
+  const int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if (fd < 0)
+  {
+    *error = std::string("socket: ") + strerror(errno);
+    return false;
+  }
+  if (connect(fd, reinterpret_cast<struct sockaddr*>(&address), sizeof(address)) != 0)
+  {
+    *error = std::string("No running driver to take over from: ") + strerror(errno);
+    close(fd);
+    return false;
+  }
+  const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+
+  HandoffHeader header;
+  struct iovec iov = {&header, sizeof(header)};
+  union
+  {
+    char buffer[CMSG_SPACE(2 * sizeof(int))];
+    struct cmsghdr align;
+  } control;
+  struct msghdr msg;
+  memset(&msg, 0, sizeof(msg));
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  msg.msg_control = control.buffer;
+  msg.msg_controllen = sizeof(control.buffer);
+
+  ssize_t count = -1;
+  if (waitForSocket(fd, POLLIN, deadline))
+    count = recvmsg(fd, &msg, MSG_CMSG_CLOEXEC | MSG_WAITALL);
+
+  // Take ownership of any descriptors we were sent, even if something else is wrong, so they are not leaked
+  int fds[2] = {-1, -1};
+  size_t num_fds = 0;
+  for (struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg); count > 0 && cmsg != nullptr; cmsg = CMSG_NXTHDR(&msg, cmsg))
+  {
+    if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS)
+    {
+      num_fds = (cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+      memcpy(fds, CMSG_DATA(cmsg), std::min(num_fds, static_cast<size_t>(2)) * sizeof(int));
+    }
+  }
+  const auto fail = [&](const std::string& reason)
+  {
+    *error = reason;
+    for (const int received_fd : fds)
+      if (received_fd >= 0)
+        close(received_fd);
+    close(fd);
+    return false;
+  };
+
+  if (count != static_cast<ssize_t>(sizeof(header)) || (msg.msg_flags & MSG_CTRUNC))
+    return fail("Did not receive the ports from the running driver");
+  if (header.magic != HANDOFF_MAGIC || header.version != HANDOFF_VERSION)
+    return fail("The running driver uses an incompatible handoff version");
+  if (header.num_fds != num_fds || fds[0] < 0 || header.payload_size > HANDOFF_MAX_PAYLOAD_SIZE)
+    return fail("The running driver sent an invalid handoff");
+
+  std::vector<uint8_t> payload(header.payload_size);
+  if (!readAll(fd, payload.data(), payload.size(), deadline))
+    return fail("Timed out receiving the state of the running driver");
+  if (!deserializeHandoffState(payload, state))
+    return fail("The running driver sent an incomplete state");
+
+  // Once the running driver sees this it will stop touching the device
+  const uint8_t ack = HANDOFF_ACK;
+  if (!writeAll(fd, &ack, sizeof(ack), deadline))
+    return fail("Failed to acknowledge the handoff");
+  close(fd);
+
+  state->main_fd = fds[0];
+  state->aux_fd = fds[1];
+  return true;
+}
+
+uint64_t hashHandoffConfig(const std::string& config_text)
+{
+  uint64_t hash = 0xCBF29CE484222325;
+  for (const char c : config_text)
+  {
+    hash ^= static_cast<uint8_t>(c);
+    hash *= 0x100000001B3;
+  }
+  return hash;
+}
+
+}  // namespace microstrain
@@ -0,0 +1,51 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Parker-Lord Inertial Device Driver Implementation File
+//
+// Copyright (c) 2017, Brian Bingham
+// Copyright (c) 2020, Parker Hannifin Corp
+// This code is licensed under MIT license (see LICENSE file for details)
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include <algorithm>
+
+#include "microstrain_inertial_driver_common/utils/imu_sample.h"
+
+namespace microstrain
+{
+
+void toRosMessage(const ImuSample& sample, ImuMsg* imu_msg)
+{
+  imu_msg->header = sample.header;
+  imu_msg->angular_velocity = sample.angular_velocity;
+  imu_msg->linear_acceleration = sample.linear_acceleration;
+  if (sample.covariance != nullptr)
+  {
+    std::copy(sample.covariance->angular_velocity.begin(), sample.covariance->angular_velocity.end(), imu_msg->angular_velocity_covariance.begin());
+    std::copy(sample.covariance->linear_acceleration.begin(), sample.covariance->linear_acceleration.end(), imu_msg->linear_acceleration_covariance.begin());
+  }
+  else
+  {
+    std::fill(imu_msg->angular_velocity_covariance.begin(), imu_msg->angular_velocity_covariance.end(), 0);
+    std::fill(imu_msg->linear_acceleration_covariance.begin(), imu_msg->linear_acceleration_covariance.end(), 0);
+  }
+
+  // The raw IMU data does not contain an orientation
+  imu_msg->orientation = QuaternionMsg();
+  std::fill(imu_msg->orientation_covariance.begin(), imu_msg->orientation_covariance.end(), 0);
+}
+
+void fromRosMessage(const ImuMsg& imu_msg, ImuSample* sample)
+{
+  sample->header = imu_msg.header;
+  sample->angular_velocity = imu_msg.angular_velocity;
+  sample->linear_acceleration = imu_msg.linear_acceleration;
+
+  auto covariance = std::make_shared<ImuSample::Covariance>();
+  std::copy(imu_msg.angular_velocity_covariance.begin(), imu_msg.angular_velocity_covariance.end(), covariance->angular_velocity.begin());
+  std::copy(imu_msg.linear_acceleration_covariance.begin(), imu_msg.linear_acceleration_covariance.end(), covariance->linear_acceleration.begin());
+  sample->covariance = covariance;
+}
+
+}  // namespace microstrain
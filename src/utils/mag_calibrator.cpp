@@ -0,0 +1,181 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Parker-Lord Inertial Device Driver Implementation File
+//
+// Copyright (c) 2017, Brian Bingham
+// Copyright (c) 2020, Parker Hannifin Corp
+// This code is licensed under MIT license (see LICENSE file for details)
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include <cmath>
+#include <sstream>
+#include <algorithm>
+
+#include <Eigen/Dense>
+
+#include "microstrain_inertial_driver_common/utils/mag_calibrator.h"
+
+namespace microstrain
+{
+
+using NormalMatrix = Eigen::Matrix<double, 9, 9, Eigen::RowMajor>;
+using NormalVector = Eigen::Matrix<double, 9, 1>;
+
+// Fraction of the field strength the fitted hard iron offset has to move by before the coverage is thrown away and built up again around the new center
+constexpr double COVERAGE_RECENTER_FRACTION = 0.05;
+
+MagCalibrator::MagCalibrator(const Thresholds& thresholds)
+  : thresholds_(thresholds)
+{
+}
+
+void MagCalibrator::add(const double x, const double y, const double z)
+{
+  // Terms of the general ellipsoid a*x^2 + b*y^2 + c*z^2 + 2d*xy + 2e*xz + 2f*yz + 2g*x + 2h*y + 2i*z = 1
+  const NormalVector terms = (NormalVector() << x * x, y * y, z * z, 2 * x * y, 2 * x * z, 2 * y * z, 2 * x, 2 * y, 2 * z).finished();
+
+  std::lock_guard<AuditedMutex> lock(mutex_);
+  Eigen::Map<NormalMatrix>(normal_matrix_.data()) += terms * terms.transpose();
+  Eigen::Map<NormalVector>(normal_vector_.data()) += terms;
+  samples_++;
+
+  // Directions are only meaningful once they are measured from a fitted center, as the hard iron offset can be larger than the field itself
+  if (!coverage_centered_)
+    return;
+
+  // Bands are equal slices of z, which have equal area on a sphere
+  const double dx = x - coverage_center_[0];
+  const double dy = y - coverage_center_[1];
+  const double dz = z - coverage_center_[2];
+  const double norm = std::sqrt(dx * dx + dy * dy + dz * dz);
+  if (norm <= 0)
+    return;
+  const size_t band = std::min<size_t>(static_cast<size_t>((dz / norm + 1) / 2 * NUM_COVERAGE_BANDS), NUM_COVERAGE_BANDS - 1);
+  const size_t sector = std::min<size_t>(static_cast<size_t>((std::atan2(dy, dx) + M_PI) / (2 * M_PI) * NUM_COVERAGE_SECTORS), NUM_COVERAGE_SECTORS - 1);
+  coverage_[band * NUM_COVERAGE_SECTORS + sector] = true;
+}
+
+MagCalibrator::Result MagCalibrator::fit()
+{
+  Result result;
+
+  std::lock_guard<AuditedMutex> lock(mutex_);
+  result.samples = samples_;
+  result.coverage = static_cast<double>(std::count(coverage_.begin(), coverage_.end(), true)) / NUM_COVERAGE_BINS;
+  if (samples_ < NUM_TERMS)
+    return result;
+
+  const Eigen::Map<const NormalMatrix> normal_matrix(normal_matrix_.data());
+  const Eigen::Map<const NormalVector> normal_vector(normal_vector_.data());
+  const NormalVector p = normal_matrix.ldlt().solve(normal_vector);
+  if (!p.allFinite())
+    return result;
+
+  // (x - center)^T * A * (x - center) = scale describes the ellipsoid. When the hard iron offset is larger than the field, the origin is outside the ellipsoid
+  // and both A and scale come out negative, so only the sign of A / scale matters
+  Eigen::Matrix3d a;
+  a << p[0], p[3], p[4],
+       p[3], p[1], p[5],
+       p[4], p[5], p[2];
+  const Eigen::Vector3d v(p[6], p[7], p[8]);
+  const Eigen::FullPivLU<Eigen::Matrix3d> a_lu(a);
+  if (!a_lu.isInvertible())
+    return result;
+  const Eigen::Vector3d center = -a_lu.solve(v);
+  const double scale = 1 + center.dot(a * center);
+  if (!(std::abs(scale) > 0))
+    return result;
+
+  // Every axis of the ellipsoid must be real for it to be an ellipsoid and not some other quadric
+  const Eigen::SelfAdjointEigenSolver<Eigen::Matrix3d> solver(a / scale);
+  const Eigen::Vector3d eigenvalues = solver.eigenvalues();
+  if (!(eigenvalues.minCoeff() > 0))
+    return result;
+
+  // Map the ellipsoid onto a sphere with the same volume, so the corrected field keeps about the same strength
+  const double field_strength = std::pow(eigenvalues.prod(), -1.0 / 6.0);
+  const Eigen::Matrix3d soft_iron = field_strength * solver.eigenvectors() * eigenvalues.cwiseSqrt().asDiagonal() * solver.eigenvectors().transpose();
+
+  // The algebraic residual of each sample is |scale| * (|corrected|^2 / field_strength^2 - 1), which is about twice the relative error in field strength
+  const double residual = std::max(p.dot(normal_matrix * p) - 2 * p.dot(normal_vector) + samples_, 0.0);
+
+  // Directions binned around a center that has since moved may be wrong, so start the coverage over whenever the center moves noticeably
+  Eigen::Map<Eigen::Vector3d> coverage_center(coverage_center_);
+  if (!coverage_centered_ || (center - coverage_center).norm() > COVERAGE_RECENTER_FRACTION * field_strength)
+  {
+    coverage_.fill(false);
+    coverage_center = center;
+    coverage_centered_ = true;
+    result.coverage = 0;
+  }
+
+  result.valid = true;
+  result.fit_error = std::sqrt(residual / samples_) / (2 * std::abs(scale));
+  result.field_strength = field_strength;
+  for (size_t i = 0; i < 3; i++)
+  {
+    result.hard_iron[i] = center[i];
+    for (size_t j = 0; j < 3; j++)
+      result.soft_iron[i * 3 + j] = soft_iron(i, j);
+  }
+  return result;
+}
+
+bool MagCalibrator::meetsThresholds(const Result& result) const
+{
+  return result.valid && result.samples >= thresholds_.min_samples && result.coverage >= thresholds_.min_coverage && result.fit_error <= thresholds_.max_fit_error;
+}
+
+const MagCalibrator::Thresholds& MagCalibrator::thresholds() const
+{
+  return thresholds_;
+}
+
+bool MagCalibrator::compose(const float current_hard_iron[3], const float current_soft_iron[9], const Result& result, float hard_iron[3], float soft_iron[9])
+{
+  // soft_iron * (soft_iron_0 * (m - hard_iron_0) - hard_iron) = soft_iron * soft_iron_0 * (m - (hard_iron_0 + soft_iron_0^-1 * hard_iron))
+  const Eigen::Matrix3d current_soft_iron_matrix = Eigen::Map<const Eigen::Matrix<float, 3, 3, Eigen::RowMajor>>(current_soft_iron).cast<double>();
+  const Eigen::FullPivLU<Eigen::Matrix3d> current_soft_iron_lu(current_soft_iron_matrix);
+  if (!current_soft_iron_lu.isInvertible())
+    return false;
+
+  const Eigen::Vector3d new_hard_iron = Eigen::Map<const Eigen::Vector3f>(current_hard_iron).cast<double>() + current_soft_iron_lu.solve(Eigen::Map<const Eigen::Vector3d>(result.hard_iron));
+  const Eigen::Matrix3d new_soft_iron = Eigen::Map<const Eigen::Matrix<double, 3, 3, Eigen::RowMajor>>(result.soft_iron) * current_soft_iron_matrix;
+  Eigen::Map<Eigen::Vector3f> hard_iron_out(hard_iron);
+  Eigen::Map<Eigen::Matrix<float, 3, 3, Eigen::RowMajor>> soft_iron_out(soft_iron);
+  hard_iron_out = new_hard_iron.cast<float>();
+  soft_iron_out = new_soft_iron.cast<float>();
+  return true;
+}
+
+std::string MagCalibrator::toYaml(const Result& result) const
+{
+  std::stringstream yaml;
+  yaml << "valid: " << (result.valid ? "true" : "false") << "\n";
+  yaml << "meets_thresholds: " << (meetsThresholds(result) ? "true" : "false") << "\n";
+  yaml << "samples: " << result.samples << "\n";
+  yaml << "min_samples: " << thresholds_.min_samples << "\n";
+  yaml << "coverage: " << result.coverage << "\n";
+  yaml << "min_coverage: " << thresholds_.min_coverage << "\n";
+  yaml << "fit_error: " << result.fit_error << "\n";
+  yaml << "max_fit_error: " << thresholds_.max_fit_error << "\n";
+  yaml << "field_strength: " << result.field_strength << "\n";
+  yaml << "hard_iron: [" << result.hard_iron[0] << ", " << result.hard_iron[1] << ", " << result.hard_iron[2] << "]\n";
+  yaml << "soft_iron: [";
+  for (size_t i = 0; i < 9; i++)
+    yaml << result.soft_iron[i] << (i < 8 ? ", " : "]\n");
+  return yaml.str();
+}
+
+void MagCalibrator::reset()
+{
+  std::lock_guard<AuditedMutex> lock(mutex_);
+  normal_matrix_.fill(0);
+  normal_vector_.fill(0);
+  samples_ = 0;
+  coverage_.fill(false);
+  coverage_centered_ = false;
+}
+
+}  // namespace microstrain
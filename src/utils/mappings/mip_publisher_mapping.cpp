@@ -15,11 +15,43 @@
 #include <algorithm>
 
 #include "microstrain_inertial_driver_common/config.h"
+#include "microstrain_inertial_driver_common/utils/build_profile.h"
 #include "microstrain_inertial_driver_common/utils/mappings/mip_publisher_mapping.h"
 
 namespace microstrain
 {
 
+/**
+ * \brief Checks whether the handler for a field was compiled into this build of the driver
+ * \param descriptor_set The descriptor set of the field
+ * \param field_descriptor The field descriptor of the field
+ * \return true if the field can be handled by this build
+ */
+static bool fieldBuilt(const uint8_t descriptor_set, const uint8_t field_descriptor)
+{
+  switch (descriptor_set)
+  {
+    case mip::data_gnss::DESCRIPTOR_SET:
+    case mip::data_gnss::MIP_GNSS1_DATA_DESC_SET:
+    case mip::data_gnss::MIP_GNSS2_DATA_DESC_SET:
+      return BuildFeatures::GNSS;
+    case mip::data_gnss::MIP_GNSS3_DATA_DESC_SET:
+      return BuildFeatures::RTK;
+    case mip::data_filter::DESCRIPTOR_SET:
+      if (field_descriptor == mip::data_filter::GnssPosAidStatus::FIELD_DESCRIPTOR)
+        return BuildFeatures::GNSS;
+      if (field_descriptor == mip::data_filter::MultiAntennaOffsetCorrection::FIELD_DESCRIPTOR || field_descriptor == mip::data_filter::GnssDualAntennaStatus::FIELD_DESCRIPTOR)
+        return BuildFeatures::DUAL_ANTENNA;
+      return true;
+    case mip::data_system::DESCRIPTOR_SET:
+      if (field_descriptor == mip::data_system::BuiltInTest::FIELD_DESCRIPTOR)
+        return BuildFeatures::BUILT_IN_TEST;
+      return true;
+    default:
+      return true;
+  }
+}
+
 MipPublisherMapping::MipPublisherMapping(RosNodeType* node, const std::shared_ptr<RosMipDeviceMain> inertial_device) : node_(node), mip_device_(inertial_device)
 {
   // Add all supported descriptors to the supported mapping
@@ -33,7 +65,11 @@ MipPublisherMapping::MipPublisherMapping(RosNodeType* node, const std::shared_pt
     {
       const uint8_t descriptor_set = field->descriptorSet();
       const uint8_t field_descriptor = field->fieldDescriptor();
-      if (mip_device_->supportsDescriptor(descriptor_set, field_descriptor))
+      if (!fieldBuilt(descriptor_set, field_descriptor))
+      {
+        MICROSTRAIN_DEBUG(node_, "Note: Field 0x%02x%02x associated with topic %s is not included in the %s build profile", descriptor_set, field_descriptor, topic.c_str(), BuildFeatures::PROFILE_NAME);
+      }
+      else if (mip_device_->supportsDescriptor(descriptor_set, field_descriptor))
       {
         // Add the descriptor to the mapping for the topic
         if (topic_info_mapping_.find(topic) == topic_info_mapping_.end())
@@ -84,7 +120,7 @@ MipPublisherMapping::MipPublisherMapping(RosNodeType* node, const std::shared_pt
   }
 }
 
-bool MipPublisherMapping::configure(RosNodeType* config_node)
+bool MipPublisherMapping::configure(RosNodeType* config_node, bool write_to_device)
 {
   // Add the data rates to the topic info map
   for (auto& mapping : topic_info_mapping_)
@@ -157,6 +193,11 @@ bool MipPublisherMapping::configure(RosNodeType* config_node)
     }
   }
 
+  // Optionally send the fields of the latency critical topics first, so those messages can be published before the rest of the packet is handled
+  bool early_publish_enable; getParam(config_node, "early_publish_enable", early_publish_enable, false);
+  if (early_publish_enable)
+    orderDescriptorsByLatency();
+
   // If we are using linear accel instead of compensated accel, replace the descriptor
   bool filter_use_compensated_accel; getParam(config_node, "filter_use_compensated_accel", filter_use_compensated_accel, true);
   if (!filter_use_compensated_accel)
@@ -177,6 +218,16 @@ bool MipPublisherMapping::configure(RosNodeType* config_node)
       // Insert the new descriptor rate
       compensated_accel_rate.descriptor = mip::data_filter::DATA_LINEAR_ACCELERATION;
       descriptor_rates.insert(compensated_accel_rate_iter, compensated_accel_rate);
+
+      // Keep the topics in sync with what is actually streamed
+      for (auto& mapping : topic_info_mapping_)
+      {
+        for (auto& descriptor : mapping.second.descriptors)
+        {
+          if (descriptor.descriptor_set == mip::data_filter::DESCRIPTOR_SET && descriptor.field_descriptor == mip::data_filter::DATA_COMPENSATED_ACCELERATION)
+            descriptor.field_descriptor = mip::data_filter::DATA_LINEAR_ACCELERATION;
+        }
+      }
     }
   }
 
@@ -200,7 +251,7 @@ bool MipPublisherMapping::configure(RosNodeType* config_node)
 
   // Stream RTK data if the RTK dongle is enabled
   bool rtk_dongle_enable; getParam(config_node, "rtk_dongle_enable", rtk_dongle_enable, true);
-  if (rtk_dongle_enable)
+  if (BuildFeatures::RTK && rtk_dongle_enable)
   {
     if (mip_device_->supportsDescriptor(mip::data_gnss::MIP_GNSS3_DATA_DESC_SET, mip::data_gnss::DATA_RTK_CORRECTIONS_STATUS))
     {
@@ -213,7 +264,7 @@ bool MipPublisherMapping::configure(RosNodeType* config_node)
 
   // If the relative position mode is based on the base station, stream that information
   int filter_relative_pos_source; getParam(config_node, "filter_relative_position_source", filter_relative_pos_source, REL_POS_SOURCE_AUTO);
-  if (filter_relative_pos_source == REL_POS_SOURCE_BASE_STATION)
+  if (BuildFeatures::RTK && filter_relative_pos_source == REL_POS_SOURCE_BASE_STATION)
   {
     if (mip_device_->supportsDescriptor(mip::data_gnss::MIP_GNSS3_DATA_DESC_SET, mip::data_gnss::DATA_RTK_CORRECTIONS_STATUS))
     {
@@ -224,6 +275,13 @@ bool MipPublisherMapping::configure(RosNodeType* config_node)
     }
   }
 
+  if (write_to_device)
+    return writeMessageFormats();
+  return true;
+}
+
+bool MipPublisherMapping::writeMessageFormats()
+{
   // Enable each of the descriptor sets and save the message format
   for (const auto& streamed_descriptor_mapping : streamed_descriptors_mapping_)
   {
@@ -246,6 +304,62 @@ bool MipPublisherMapping::configure(RosNodeType* config_node)
   return true;
 }
 
+void MipPublisherMapping::orderDescriptorsByLatency()
+{
+  // Lower priorities are streamed first. The filter status always comes first, as the other filter handlers use the filter state
+  const size_t lowest_priority = static_latency_critical_topics_.size() + 1;
+  const auto priority = [this, lowest_priority](const uint8_t descriptor_set, const uint8_t field_descriptor)
+  {
+    if (descriptor_set == mip::data_filter::DESCRIPTOR_SET && field_descriptor == mip::data_filter::Status::FIELD_DESCRIPTOR)
+      return static_cast<size_t>(0);
+    for (size_t i = 0; i < static_latency_critical_topics_.size(); i++)
+    {
+      const auto topic_info = topic_info_mapping_.find(static_latency_critical_topics_[i]);
+      if (topic_info == topic_info_mapping_.end() || topic_info->second.data_rate == DATA_CLASS_DATA_RATE_DO_NOT_STREAM)
+        continue;
+      for (const auto& descriptor : topic_info->second.descriptors)
+      {
+        if (descriptor.descriptor_set == descriptor_set && descriptor.field_descriptor == field_descriptor)
+          return i + 1;
+      }
+    }
+    return lowest_priority;
+  };
+
+  // Everything else keeps the order it was added in
+  for (auto& streamed_descriptor_mapping : streamed_descriptors_mapping_)
+  {
+    const uint8_t descriptor_set = streamed_descriptor_mapping.first;
+    std::stable_sort(streamed_descriptor_mapping.second.begin(), streamed_descriptor_mapping.second.end(), [&priority, descriptor_set](const mip::DescriptorRate& a, const mip::DescriptorRate& b)
+    {
+      return priority(descriptor_set, a.descriptor) < priority(descriptor_set, b.descriptor);
+    }
+    );
+  }
+}
+
+uint64_t MipPublisherMapping::streamHash() const
+{
+  // FNV-1a over every streamed descriptor and its decimation. The map is ordered, so the hash does not depend on insertion order
+  uint64_t hash = 0xCBF29CE484222325;
+  const auto hash_byte = [&hash](const uint8_t byte)
+  {
+    hash ^= byte;
+    hash *= 0x100000001B3;
+  };
+  for (const auto& streamed_descriptor_mapping : streamed_descriptors_mapping_)
+  {
+    hash_byte(streamed_descriptor_mapping.first);
+    for (const mip::DescriptorRate& descriptor_rate : streamed_descriptor_mapping.second)
+    {
+      hash_byte(descriptor_rate.descriptor);
+      hash_byte(static_cast<uint8_t>(descriptor_rate.decimation >> 8));
+      hash_byte(static_cast<uint8_t>(descriptor_rate.decimation & 0xFF));
+    }
+  }
+  return hash;
+}
+
 std::vector<uint8_t> MipPublisherMapping::getDescriptorSets(const std::string& topic) const
 {
   if (topic_info_mapping_.find(topic) != topic_info_mapping_.end())
@@ -521,4 +635,14 @@ const std::map<std::string, std::string> MipPublisherMapping::static_topic_to_da
   {MIP_SYSTEM_BUILT_IN_TEST_TOPIC, "mip_system_built_in_test_data_rate"},
 };
 
+const std::vector<std::string> MipPublisherMapping::static_latency_critical_topics_ =
+{
+  IMU_DATA_RAW_TOPIC,
+  IMU_DATA_TOPIC,
+  FILTER_IMU_DATA_TOPIC,
+  FILTER_ODOMETRY_MAP_TOPIC,
+  FILTER_ODOMETRY_EARTH_TOPIC,
+  FILTER_VELOCITY_TOPIC,
+};
+
 }  // namespace microstrain
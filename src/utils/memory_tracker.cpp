@@ -0,0 +1,238 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Parker-Lord Inertial Device Driver Implementation File
+//
+// Copyright (c) 2017, Brian Bingham
+// Copyright (c) 2020, Parker Hannifin Corp
+// This code is licensed under MIT license (see LICENSE file for details)
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include <new>
+#include <atomic>
+#include <cstdlib>
+
+#include "microstrain_inertial_driver_common/utils/realtime.h"
+#include "microstrain_inertial_driver_common/utils/memory_tracker.h"
+
+namespace microstrain
+{
+
+static const char* MEMORY_TAG_NAMES[NUM_MEMORY_TAGS] = {"other", "connection", "publishers", "subscribers", "services", "tf", "recording", "logging"};
+
+// Tag of the innermost scope on each thread. A plain type so that reading it from inside the allocation functions never allocates
+static thread_local MemoryTag memory_tracker_tag = MEMORY_TAG_OTHER;
+
+#ifdef MICROSTRAIN_MEMORY_TRACKING
+/**
+ * Stored right in front of every tracked allocation so it can be removed from the right tag, and the whole block freed, when it is freed
+ */
+struct AllocationHeader
+{
+  size_t size;
+  size_t offset;
+  MemoryTag tag;
+};
+
+// Space in front of the memory returned to the caller. Keeps that memory aligned the same as malloc
+constexpr size_t ALLOCATION_HEADER_SIZE = alignof(std::max_align_t) >= sizeof(AllocationHeader) ? alignof(std::max_align_t) : 2 * alignof(std::max_align_t);
+
+// Constant initialized, so they are usable by allocations made before main
+static std::atomic<uint64_t> memory_tracker_live_bytes[NUM_MEMORY_TAGS];
+static std::atomic<uint64_t> memory_tracker_peak_bytes[NUM_MEMORY_TAGS];
+static std::atomic<uint64_t> memory_tracker_allocations[NUM_MEMORY_TAGS];
+#endif
+
+MemoryTracker::Scope::Scope(const MemoryTag tag) : previous_tag_(memory_tracker_tag)
+{
+  memory_tracker_tag = tag;
+}
+
+MemoryTracker::Scope::~Scope()
+{
+  memory_tracker_tag = previous_tag_;
+}
+
+bool MemoryTracker::supported()
+{
+#ifdef MICROSTRAIN_MEMORY_TRACKING
+  return true;
+#else
+  return false;
+#endif
+}
+
+MemoryTracker::Usage MemoryTracker::usage(const MemoryTag tag)
+{
+  Usage usage;
+  if (tag >= NUM_MEMORY_TAGS)
+    return usage;
+#ifdef MICROSTRAIN_MEMORY_TRACKING
+  usage.live_bytes = memory_tracker_live_bytes[tag].load(std::memory_order_relaxed);
+  usage.peak_bytes = memory_tracker_peak_bytes[tag].load(std::memory_order_relaxed);
+  usage.allocations = memory_tracker_allocations[tag].load(std::memory_order_relaxed);
+#endif
+  return usage;
+}
+
+const char* MemoryTracker::tagName(const MemoryTag tag)
+{
+  return tag < NUM_MEMORY_TAGS ? MEMORY_TAG_NAMES[tag] : "unknown";
+}
+
+/**
+ * \brief Allocates memory with an alignment malloc does not guarantee
+ * \param alignment Alignment of the memory. Must be a power of two and a multiple of the size of a pointer
+ * \param size Number of bytes to allocate
+ * \return Pointer to the memory, or nullptr if the allocation failed. Freed with free
+ */
+static void* allocateAligned(const size_t alignment, const size_t size)
+{
+  void* memory = nullptr;
+  return posix_memalign(&memory, alignment, size) == 0 ? memory : nullptr;
+}
+
+void* MemoryTracker::allocate(const size_t size, const size_t alignment)
+{
+  const bool over_aligned = alignment > alignof(std::max_align_t);
+#ifdef MICROSTRAIN_MEMORY_TRACKING
+  // Over aligned memory has its header padded out to the alignment, so the memory after it stays aligned
+  const size_t offset = over_aligned && alignment > ALLOCATION_HEADER_SIZE ? alignment : ALLOCATION_HEADER_SIZE;
+  unsigned char* memory = static_cast<unsigned char*>(over_aligned ? allocateAligned(alignment, offset + size) : malloc(offset + size));
+  if (memory == nullptr)
+    return nullptr;
+
+  const MemoryTag tag = memory_tracker_tag;
+  AllocationHeader* header = reinterpret_cast<AllocationHeader*>(memory + offset) - 1;
+  header->size = size;
+  header->offset = offset;
+  header->tag = tag;
+
+  memory_tracker_allocations[tag].fetch_add(1, std::memory_order_relaxed);
+  const uint64_t live_bytes = memory_tracker_live_bytes[tag].fetch_add(size, std::memory_order_relaxed) + size;
+  uint64_t peak_bytes = memory_tracker_peak_bytes[tag].load(std::memory_order_relaxed);
+  while (live_bytes > peak_bytes && !memory_tracker_peak_bytes[tag].compare_exchange_weak(peak_bytes, live_bytes, std::memory_order_relaxed))
+  {
+  }
+  return memory + offset;
+#else
+  return over_aligned ? allocateAligned(alignment, size) : malloc(size);
+#endif
+}
+
+void MemoryTracker::deallocate(void* ptr)
+{
+#ifdef MICROSTRAIN_MEMORY_TRACKING
+  if (ptr == nullptr)
+    return;
+
+  const AllocationHeader* header = reinterpret_cast<const AllocationHeader*>(ptr) - 1;
+  memory_tracker_live_bytes[header->tag].fetch_sub(header->size, std::memory_order_relaxed);
+  free(static_cast<unsigned char*>(ptr) - header->offset);
+#else
+  free(ptr);
+#endif
+}
+
+}  // namespace microstrain
+
+#if defined(MICROSTRAIN_RT_AUDIT) || defined(MICROSTRAIN_MEMORY_TRACKING)
+// Replacements for the global allocation functions that report allocations made on the hot path, and attribute allocations to a tag.
+// When malloc is audited, the allocation is reported by malloc instead, so it is not counted twice
+void* operator new(std::size_t size)
+{
+#ifndef MICROSTRAIN_RT_AUDIT_MALLOC
+  microstrain::RealtimeAudit::recordAllocation();
+#endif
+  void* ptr = microstrain::MemoryTracker::allocate(size == 0 ? 1 : size);
+  if (ptr == nullptr)
+    throw std::bad_alloc();
+  return ptr;
+}
+
+void* operator new[](std::size_t size)
+{
+  return operator new(size);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+#ifndef MICROSTRAIN_RT_AUDIT_MALLOC
+  microstrain::RealtimeAudit::recordAllocation();
+#endif
+  return microstrain::MemoryTracker::allocate(size == 0 ? 1 : size);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept
+{
+  return operator new(size, std::nothrow);
+}
+
+void operator delete(void* ptr) noexcept
+{
+  microstrain::MemoryTracker::deallocate(ptr);
+}
+
+void operator delete[](void* ptr) noexcept
+{
+  microstrain::MemoryTracker::deallocate(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept
+{
+  microstrain::MemoryTracker::deallocate(ptr);
+}
+
+void operator delete[](void* ptr, std::size_t) noexcept
+{
+  microstrain::MemoryTracker::deallocate(ptr);
+}
+
+#ifdef __cpp_aligned_new
+// Over aligned types are allocated with posix_memalign, which is not audited, so these always report hot path allocations themselves
+void* operator new(std::size_t size, std::align_val_t alignment)
+{
+  microstrain::RealtimeAudit::recordAllocation();
+  void* ptr = microstrain::MemoryTracker::allocate(size == 0 ? 1 : size, static_cast<std::size_t>(alignment));
+  if (ptr == nullptr)
+    throw std::bad_alloc();
+  return ptr;
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment)
+{
+  return operator new(size, alignment);
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+  microstrain::RealtimeAudit::recordAllocation();
+  return microstrain::MemoryTracker::allocate(size == 0 ? 1 : size, static_cast<std::size_t>(alignment));
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+  return operator new(size, alignment, std::nothrow);
+}
+
+void operator delete(void* ptr, std::align_val_t) noexcept
+{
+  microstrain::MemoryTracker::deallocate(ptr);
+}
+
+void operator delete[](void* ptr, std::align_val_t) noexcept
+{
+  microstrain::MemoryTracker::deallocate(ptr);
+}
+
+void operator delete(void* ptr, std::size_t, std::align_val_t) noexcept
+{
+  microstrain::MemoryTracker::deallocate(ptr);
+}
+
+void operator delete[](void* ptr, std::size_t, std::align_val_t) noexcept
+{
+  microstrain::MemoryTracker::deallocate(ptr);
+}
+#endif
+#endif
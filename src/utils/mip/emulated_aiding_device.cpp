@@ -0,0 +1,128 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Parker-Lord Inertial Device Driver Implementation File
+//
+// Copyright (c) 2017, Brian Bingham
+// Copyright (c) 2020, Parker Hannifin Corp
+// This code is licensed under MIT license (see LICENSE file for details)
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include <cstring>
+#include <algorithm>
+
+#include "microstrain_inertial_driver_common/utils/mip/emulated_aiding_device.h"
+
+namespace microstrain
+{
+
+// MIP packet layout
+constexpr uint8_t MIP_SYNC1 = 0x75;
+constexpr uint8_t MIP_SYNC2 = 0x65;
+constexpr size_t MIP_HEADER_SIZE = 4;
+constexpr size_t MIP_CHECKSUM_SIZE = 2;
+constexpr uint8_t MIP_REPLY_FIELD_DESCRIPTOR = 0xF1;
+constexpr uint8_t MIP_REPLY_FIELD_SIZE = 4;
+constexpr uint8_t MIP_ACK_OK = 0x00;
+
+// How long the emulated device waits for a command before giving up on parsing it, and the base timeout for its replies
+constexpr mip::Timeout EMULATED_PARSE_TIMEOUT_MS = 100;
+constexpr mip::Timeout EMULATED_BASE_REPLY_TIMEOUT_MS = 1000;
+
+EmulatedAidingConnection::EmulatedAidingConnection(const double ack_latency)
+  : ack_latency_(std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(std::max(ack_latency, 0.0))))
+{
+}
+
+bool EmulatedAidingConnection::isConnected() const
+{
+  return true;
+}
+
+bool EmulatedAidingConnection::connect()
+{
+  return true;
+}
+
+bool EmulatedAidingConnection::disconnect()
+{
+  return true;
+}
+
+bool EmulatedAidingConnection::sendToDevice(const uint8_t* data, const size_t length)
+{
+  if (length < MIP_HEADER_SIZE + MIP_CHECKSUM_SIZE || data[0] != MIP_SYNC1 || data[1] != MIP_SYNC2 || length != MIP_HEADER_SIZE + data[3] + MIP_CHECKSUM_SIZE)
+    return false;
+
+  // Acknowledge every field of the command in a single reply, the same way a device does
+  Reply reply;
+  reply.packet = {MIP_SYNC1, MIP_SYNC2, data[2], 0};
+  for (size_t field = MIP_HEADER_SIZE; field + 1 < length - MIP_CHECKSUM_SIZE && data[field] >= 2; field += data[field])
+  {
+    if (reply.packet.size() + MIP_REPLY_FIELD_SIZE > MIP_HEADER_SIZE + UINT8_MAX)
+      break;
+    reply.packet.insert(reply.packet.end(), {MIP_REPLY_FIELD_SIZE, MIP_REPLY_FIELD_DESCRIPTOR, data[field + 1], MIP_ACK_OK});
+  }
+  reply.packet[3] = static_cast<uint8_t>(reply.packet.size() - MIP_HEADER_SIZE);
+
+  // Fletcher checksum over the header and payload
+  uint8_t checksum_msb = 0, checksum_lsb = 0;
+  for (const uint8_t byte : reply.packet)
+  {
+    checksum_msb += byte;
+    checksum_lsb += checksum_msb;
+  }
+  reply.packet.push_back(checksum_msb);
+  reply.packet.push_back(checksum_lsb);
+
+  reply.due = std::chrono::steady_clock::now() + ack_latency_;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    replies_.push_back(std::move(reply));
+  }
+  condition_.notify_all();
+  return true;
+}
+
+bool EmulatedAidingConnection::recvFromDevice(uint8_t* buffer, const size_t max_length, const mip::Timeout wait_time, size_t* count_out, mip::Timestamp* timestamp_out)
+{
+  *count_out = 0;
+
+  // Wait for the oldest reply to be due, or for the wait to run out
+  std::unique_lock<std::mutex> lock(mutex_);
+  const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(wait_time);
+  while (replies_.empty() || replies_.front().due > std::chrono::steady_clock::now())
+  {
+    const auto wake = replies_.empty() ? deadline : std::min(deadline, replies_.front().due);
+    if (condition_.wait_until(lock, wake) == std::cv_status::timeout && std::chrono::steady_clock::now() >= deadline)
+      break;
+  }
+
+  // Hand back every reply that is due and fits
+  const auto now = std::chrono::steady_clock::now();
+  while (!replies_.empty() && replies_.front().due <= now && *count_out + replies_.front().packet.size() <= max_length)
+  {
+    memcpy(buffer + *count_out, replies_.front().packet.data(), replies_.front().packet.size());
+    *count_out += replies_.front().packet.size();
+    replies_.pop_front();
+  }
+  *timestamp_out = static_cast<mip::Timestamp>(std::chrono::duration_cast<std::chrono::milliseconds>(now.time_since_epoch()).count());
+  return true;
+}
+
+const char* EmulatedAidingConnection::interfaceName() const
+{
+  return "emulated aiding device";
+}
+
+uint32_t EmulatedAidingConnection::parameter() const
+{
+  return 0;
+}
+
+EmulatedAidingDevice::EmulatedAidingDevice(const double ack_latency)
+  : connection_(ack_latency), device_(&connection_, buffer_, sizeof(buffer_), EMULATED_PARSE_TIMEOUT_MS, EMULATED_BASE_REPLY_TIMEOUT_MS)
+{
+}
+
+}  // namespace microstrain
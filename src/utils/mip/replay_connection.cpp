@@ -0,0 +1,119 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Parker-Lord Inertial Device Driver Implementation File
+//
+// Copyright (c) 2017, Brian Bingham
+// Copyright (c) 2020, Parker Hannifin Corp
+// This code is licensed under MIT license (see LICENSE file for details)
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include <string>
+#include <cstring>
+#include <algorithm>
+
+#include "microstrain_inertial_driver_common/utils/mip/replay_connection.h"
+
+namespace microstrain
+{
+
+// Largest chunk we will believe a capture contains. Anything larger means the file is not a timed capture or is corrupt
+constexpr uint32_t MAX_CHUNK_SIZE = 1024 * 1024;
+
+ReplayConnection::ReplayConnection(const std::string& path, std::shared_ptr<VirtualClock> clock)
+  : path_(path), clock_(clock)
+{
+}
+
+bool ReplayConnection::writeRecord(std::ostream* stream, const int64_t arrival_nanoseconds, const uint8_t* data, const size_t length)
+{
+  const uint32_t size = static_cast<uint32_t>(length);
+  stream->write(reinterpret_cast<const char*>(&arrival_nanoseconds), sizeof(arrival_nanoseconds));
+  stream->write(reinterpret_cast<const char*>(&size), sizeof(size));
+  stream->write(reinterpret_cast<const char*>(data), size);
+  return static_cast<bool>(*stream);
+}
+
+bool ReplayConnection::isConnected() const
+{
+  return file_.is_open();
+}
+
+bool ReplayConnection::connect()
+{
+  // Connecting again keeps reading where we left off, the same way reconnecting to a device gets whatever it sends next
+  if (file_.is_open())
+    return true;
+  file_.open(path_, std::ios::in | std::ios::binary);
+  chunk_.clear();
+  chunk_offset_ = 0;
+  finished_ = false;
+  return file_.is_open();
+}
+
+bool ReplayConnection::disconnect()
+{
+  file_.close();
+  return true;
+}
+
+bool ReplayConnection::sendToDevice(const uint8_t* data, const size_t length)
+{
+  return file_.is_open();
+}
+
+bool ReplayConnection::recvFromDevice(uint8_t* buffer, const size_t max_length, const mip::Timeout wait_time, size_t* count_out, mip::Timestamp* timestamp_out)
+{
+  *count_out = 0;
+  if (!file_.is_open())
+    return false;
+
+  // Read the next chunk once the last one has been used up
+  if (chunk_offset_ >= chunk_.size() && !finished_)
+  {
+    int64_t arrival_nanoseconds;
+    uint32_t size;
+    file_.read(reinterpret_cast<char*>(&arrival_nanoseconds), sizeof(arrival_nanoseconds));
+    file_.read(reinterpret_cast<char*>(&size), sizeof(size));
+    if (file_ && size <= MAX_CHUNK_SIZE)
+    {
+      chunk_.resize(size);
+      file_.read(reinterpret_cast<char*>(chunk_.data()), size);
+    }
+    if (!file_ || size > MAX_CHUNK_SIZE)
+    {
+      // A truncated last record is what we get if the recording driver was killed, so treat it the same as the end of the capture
+      chunk_.clear();
+      finished_ = true;
+    }
+    else
+    {
+      clock_->advanceTo(arrival_nanoseconds);
+    }
+    chunk_offset_ = 0;
+  }
+
+  // Once the capture is over, nothing else will arrive, so let the wait pass instantly. Otherwise a command waiting on a reply would never time out
+  if (finished_)
+    clock_->sleepFor(wait_time / 1000.0);
+
+  const size_t count = std::min(max_length, chunk_.size() - chunk_offset_);
+  if (count > 0)
+    memcpy(buffer, chunk_.data() + chunk_offset_, count);
+  chunk_offset_ += count;
+  *count_out = count;
+  *timestamp_out = static_cast<mip::Timestamp>(clock_->nowNanoseconds() / 1000000);
+  return true;
+}
+
+const char* ReplayConnection::interfaceName() const
+{
+  return path_.c_str();
+}
+
+uint32_t ReplayConnection::parameter() const
+{
+  return 0;
+}
+
+}  // namespace microstrain
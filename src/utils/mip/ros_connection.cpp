@@ -10,6 +10,8 @@
 
 #include <sys/stat.h>
 
+#include <cctype>
+#include <cstring>
 #include <vector>
 #include <chrono>
 #include <string>
@@ -20,17 +22,26 @@
 #include "mip/extras/recording_connection.hpp"
 
 #include "microstrain_inertial_driver_common/utils/mip/ros_connection.h"
+#include "microstrain_inertial_driver_common/utils/build_profile.h"
 #include "microstrain_inertial_driver_common/utils/mip/ros_mip_device.h"
+#include "microstrain_inertial_driver_common/utils/memory_tracker.h"
 
 namespace microstrain
 {
 
 constexpr auto NMEA_MAX_LENGTH = 82;
 
-RosConnection::RosConnection(RosNodeType* node) : node_(node)
+RosConnection::RosConnection(RosNodeType* node, std::shared_ptr<Clock> clock) : node_(node), clock_(clock)
 {
 }
 
+RosConnection::~RosConnection()
+{
+  // The proxy may outlive us, so make sure it no longer sends through this connection
+  if (proxy_ != nullptr)
+    proxy_->setSender(nullptr);
+}
+
 bool RosConnection::isConnected() const
 {
   if (connection_)
@@ -97,11 +108,26 @@ bool RosConnection::connect(RosNodeType* config_node, const std::string& port, c
     }
   }
 
+  // If the port may be handed to another driver, we need a connection that exposes the file descriptor
+  bool handoff_enable;
+  getParam<bool>(config_node, "handoff_enable", handoff_enable, false);
+
   // If the raw file is enabled, use a different connection type
   try
   {
     MICROSTRAIN_INFO(node_, "Attempting to open serial port <%s> at <%d>", port.c_str(), baudrate);
-    connection_ = std::unique_ptr<RecordingSerialConnection>(new RecordingSerialConnection(&record_file_, nullptr, port, baudrate));
+    connection_.reset();
+    fd_connection_.reset();
+    replay_connection_.reset();
+    if (handoff_enable)
+    {
+      fd_connection_ = std::unique_ptr<SerialFdConnection>(new SerialFdConnection(port, baudrate));
+      connection_ = std::unique_ptr<mip::extras::RecordingConnection>(new mip::extras::RecordingConnection(fd_connection_.get(), &record_file_, nullptr));
+    }
+    else
+    {
+      connection_ = std::unique_ptr<RecordingSerialConnection>(new RecordingSerialConnection(&record_file_, nullptr, port, baudrate));
+    }
   }
   catch (const std::exception& e)
   {
@@ -120,17 +146,61 @@ bool RosConnection::connect(RosNodeType* config_node, const std::string& port, c
   return true;
 }
 
-bool RosConnection::configure(RosNodeType* config_node, RosMipDevice* device)
+bool RosConnection::adopt(int fd, const std::string& port, const int32_t baudrate)
 {
-  // Setup the path to the raw file even if we are not recording
-  time_t raw_time;
-  struct tm curr_time;
-  char curr_time_buffer[100];
+  MICROSTRAIN_INFO(node_, "Using serial port <%s> at <%d> handed off by the previous driver", port.c_str(), baudrate);
+  connection_.reset();
+  replay_connection_.reset();
+  fd_connection_ = std::unique_ptr<SerialFdConnection>(new SerialFdConnection(fd, port, baudrate));
+  connection_ = std::unique_ptr<mip::extras::RecordingConnection>(new mip::extras::RecordingConnection(fd_connection_.get(), &record_file_, nullptr));
 
-  std::string raw_file_directory;
-  getParam<bool>(config_node, "raw_file_enable", should_record_, false);
-  getParam<std::string>(config_node, "raw_file_directory", raw_file_directory, std::string("."));
+  // Same timeouts as a port we opened ourselves
+  parse_timeout_ = 1000;
+  base_reply_timeout_ = 1000;
+  return true;
+}
+
+bool RosConnection::replay(const std::string& replay_file_path, std::shared_ptr<VirtualClock> clock)
+{
+  MICROSTRAIN_INFO(node_, "Replaying timed capture <%s> instead of connecting to a device", replay_file_path.c_str());
+  connection_.reset();
+  fd_connection_.reset();
+  replay_connection_ = std::unique_ptr<ReplayConnection>(new ReplayConnection(replay_file_path, clock));
+  connection_ = std::unique_ptr<mip::extras::RecordingConnection>(new mip::extras::RecordingConnection(replay_connection_.get(), &record_file_, nullptr));
+  if (!connection_->connect())
+  {
+    MICROSTRAIN_ERROR(node_, "Unable to open timed capture <%s>", replay_file_path.c_str());
+    return false;
+  }
 
+  // Same timeouts as a serial port, so commands time out at the same point in the capture they did when it was recorded
+  parse_timeout_ = 1000;
+  base_reply_timeout_ = 1000;
+  return true;
+}
+
+bool RosConnection::replayFinished() const
+{
+  return replay_connection_ != nullptr && replay_connection_->finished();
+}
+
+bool RosConnection::startTimedCapture(const std::string& timed_capture_file_path)
+{
+  MemoryTracker::Scope memory_scope(MEMORY_TAG_RECORDING);
+  if (timed_capture_file_.is_open())
+    timed_capture_file_.close();
+  timed_capture_file_.open(timed_capture_file_path, std::ios::out | std::ios::binary | std::ios::trunc);
+  if (!timed_capture_file_.is_open())
+  {
+    MICROSTRAIN_ERROR(node_, "ERROR opening timed capture at %s", timed_capture_file_path.c_str());
+    return false;
+  }
+  MICROSTRAIN_INFO(node_, "Timed capture opened at %s", timed_capture_file_path.c_str());
+  return true;
+}
+
+bool RosConnection::configure(RosNodeType* config_node, RosMipDevice* device)
+{
   // Get the device info
   mip::CmdResult mip_cmd_result;
   mip::commands_base::BaseDeviceInfo device_info;
@@ -139,6 +209,19 @@ bool RosConnection::configure(RosNodeType* config_node, RosMipDevice* device)
     MICROSTRAIN_MIP_SDK_ERROR(node_, mip_cmd_result, "Unable to read device info for binary file");
     return false;
   }
+  return configure(config_node, device_info);
+}
+
+bool RosConnection::configure(RosNodeType* config_node, const mip::commands_base::BaseDeviceInfo& device_info)
+{
+  // Setup the path to the raw file even if we are not recording
+  time_t raw_time;
+  struct tm curr_time;
+  char curr_time_buffer[100];
+
+  std::string raw_file_directory;
+  getParam<bool>(config_node, "raw_file_enable", should_record_, false);
+  getParam<std::string>(config_node, "raw_file_directory", raw_file_directory, std::string("."));
 
   // Get the current time
   time(&raw_time);
@@ -161,6 +244,14 @@ bool RosConnection::configure(RosNodeType* config_node, RosMipDevice* device)
   return true;
 }
 
+int RosConnection::fd() const
+{
+  if (fd_connection_)
+    return fd_connection_->fd();
+  else
+    return -1;
+}
+
 bool RosConnection::shouldParseNmea() const
 {
   return should_parse_nmea_;
@@ -200,6 +291,8 @@ std::string RosConnection::rawFilePath()
 
 bool RosConnection::updateRecordingState(const bool should_record, const std::string& record_file_path)
 {
+  MemoryTracker::Scope memory_scope(MEMORY_TAG_RECORDING);
+
   // If we are already recording, we need to close the file, but keep that in mind in case we fail to update
   const bool was_recording = record_file_.is_open();
   if (was_recording)
@@ -233,8 +326,26 @@ bool RosConnection::updateRecordingState(const bool should_record, const std::st
   return true;
 }
 
+void RosConnection::proxy(std::shared_ptr<ByteProxy> proxy)
+{
+  proxy_ = proxy;
+  if (proxy_ != nullptr)
+    proxy_->setSender([this](const uint8_t* data, size_t length) { return send(data, length); });
+}
+
 bool RosConnection::sendToDevice(const uint8_t* data, size_t length)
 {
+  // Make sure no command from a proxy client is waiting on a reply that the driver could mistake for the reply to this one.
+  // If one is, the proxy sends the command once that reply has arrived, and the driver keeps reading from the device in the meantime
+  if (proxy_ != nullptr && !proxy_->beginDriverCommand(data, length))
+    return true;
+  return send(data, length);
+}
+
+bool RosConnection::send(const uint8_t* data, size_t length)
+{
+  MemoryTracker::Scope memory_scope(MEMORY_TAG_CONNECTION);
+  std::lock_guard<std::mutex> lock(send_mutex_);
   if (connection_ != nullptr)
     return connection_->sendToDevice(data, length);
   else
@@ -243,14 +354,24 @@ bool RosConnection::sendToDevice(const uint8_t* data, size_t length)
 
 bool RosConnection::recvFromDevice(uint8_t* buffer, size_t max_length, mip::Timeout timeout, size_t* count_out, mip::Timestamp* timestamp_out)
 {
+  MemoryTracker::Scope memory_scope(MEMORY_TAG_CONNECTION);
   const bool success = (connection_ != nullptr) ? connection_->recvFromDevice(buffer, max_length, timeout, count_out, timestamp_out) : false;
   if (success)
   {
-    *timestamp_out = static_cast<mip::Timestamp>(getTimeRefSecs(rosTimeNow(node_)) * 1000.0);
+    const int64_t arrival_nanoseconds = clock_->nowNanoseconds();
+    *timestamp_out = static_cast<mip::Timestamp>(arrival_nanoseconds / 1000000);
+
+    // Save the data with the time it arrived, so a replay can stamp it the same way
+    if (timed_capture_file_.is_open() && *count_out > 0)
+      ReplayConnection::writeRecord(&timed_capture_file_, arrival_nanoseconds, buffer, *count_out);
 
     // Parse NMEA sentences if we were asked to
-    if (should_parse_nmea_)
+    if (BuildFeatures::NMEA && should_parse_nmea_)
       extractNmea(buffer, *count_out);
+
+    // Mirror the data to anyone watching the port
+    if (proxy_ != nullptr)
+      proxy_->write(buffer, *count_out);
   }
   return success;
 }
@@ -288,8 +409,9 @@ void RosConnection::extractNmea(const uint8_t* data, size_t data_len)
       const size_t nmea_end_index = nmea_string_.find("\r\n", i + 1);
       if (nmea_end_index == std::string::npos)
       {
-        MICROSTRAIN_DEBUG(node_, "Could not find end of NMEA sentence. Continuing...");
-        continue;
+        // No later sentence can have an end either, so stop instead of searching the rest of the buffer again for every start character
+        MICROSTRAIN_DEBUG(node_, "Could not find end of NMEA sentence. Waiting for more data");
+        break;
       }
       MICROSTRAIN_DEBUG(node_, "Found possible end of NMEA sentence at %lu", nmea_end_index + 1);
 
@@ -302,8 +424,9 @@ void RosConnection::extractNmea(const uint8_t* data, size_t data_len)
       }
 
       // Attempt to find the checksum
+      // The checksum must be inside this sentence, and must be exactly two hex digits
       const size_t checksum_delimiter_index = nmea_string_.rfind('*', nmea_end_index);
-      if (checksum_delimiter_index == std::string::npos)
+      if (checksum_delimiter_index == std::string::npos || checksum_delimiter_index < i)
       {
         MICROSTRAIN_DEBUG(node_, "Found beginning and end of NMEA sentence, but could not find the checksum. Skipping");
         continue;
@@ -312,21 +435,17 @@ void RosConnection::extractNmea(const uint8_t* data, size_t data_len)
 
       // Extract the expected checksum
       const std::string& expected_checksum_str = nmea_string_.substr(checksum_start_index, nmea_end_index - checksum_start_index);
-      uint16_t expected_checksum;
-      try
-      {
-        expected_checksum = static_cast<uint16_t>(std::stoi(expected_checksum_str, nullptr, 16));
-      }
-      catch (const std::exception& e)
+      if (expected_checksum_str.size() != 2 || !std::isxdigit(static_cast<unsigned char>(expected_checksum_str[0])) || !std::isxdigit(static_cast<unsigned char>(expected_checksum_str[1])))
       {
-        MICROSTRAIN_DEBUG(node_, "Checksum at end of NMEA sentence cannot be parsed into a hex number: %s", expected_checksum_str.c_str());
+        MICROSTRAIN_DEBUG(node_, "Checksum at end of NMEA sentence is not two hex digits: %s", expected_checksum_str.c_str());
         continue;
       }
+      const uint16_t expected_checksum = static_cast<uint16_t>(std::stoi(expected_checksum_str, nullptr, 16));
 
-      // Calculate the actual checksum
+      // Calculate the actual checksum. Bytes are XORed unsigned so bytes above 0x7F can not sign extend into the upper byte
       uint16_t actual_checksum = 0;
-      for (size_t k = i + 1; k < checksum_start_index - 1; k++)
-        actual_checksum ^= nmea_string_[k];
+      for (size_t k = i + 1; k < checksum_delimiter_index; k++)
+        actual_checksum ^= static_cast<uint8_t>(nmea_string_[k]);
 
       // Extract the sentence
       const std::string& sentence = nmea_string_.substr(i, (nmea_end_index - i) + 2);
@@ -343,7 +462,7 @@ void RosConnection::extractNmea(const uint8_t* data, size_t data_len)
 
       // Looks like it is a valid NMEA sentence. Publish
       NMEASentenceMsg msg;
-      msg.header.stamp = rosTimeNow(node_);
+      msg.header.stamp = clock_->rosNow();
       msg.sentence = sentence;
       nmea_msgs_.push_back(msg);
 
@@ -10,6 +10,8 @@
 
 #include <stdio.h>
 
+#include <array>
+#include <cstring>
 #include <vector>
 #include <string>
 #include <thread>
@@ -26,7 +28,7 @@
 namespace microstrain
 {
 
-RosMipDevice::RosMipDevice(RosNodeType* node) : node_(node)
+RosMipDevice::RosMipDevice(RosNodeType* node, std::shared_ptr<Clock> clock) : node_(node), clock_(clock)
 {
 }
 
@@ -28,7 +28,7 @@ bool RosMipDeviceAux::configure(RosNodeType* config_node)
   int32_t baudrate;
   getParam<std::string>(config_node, "aux_port", port, "/dev/ttyACM1");
   getParam<int32_t>(config_node, "aux_baudrate", baudrate, 115200);
-  connection_ = std::make_shared<RosConnection>(node_);
+  connection_ = std::make_shared<RosConnection>(node_, clock_);
   if (!connection_->connect(config_node, port, baudrate))
     return false;
 
@@ -57,4 +57,17 @@ bool RosMipDeviceAux::configure(RosNodeType* config_node)
   return true;
 }
 
+bool RosMipDeviceAux::adopt(RosNodeType* config_node, int fd, const mip::commands_base::BaseDeviceInfo& device_info)
+{
+  std::string port;
+  int32_t baudrate;
+  getParam<std::string>(config_node, "aux_port", port, "/dev/ttyACM1");
+  getParam<int32_t>(config_node, "aux_baudrate", baudrate, 115200);
+  connection_ = std::make_shared<RosConnection>(node_, clock_);
+  if (!connection_->adopt(fd, port, baudrate))
+    return false;
+  device_ = std::unique_ptr<mip::DeviceInterface>(new mip::DeviceInterface(connection_.get(), buffer_, sizeof(buffer_), connection_->parseTimeout(), connection_->baseReplyTimeout()));
+  return connection_->configure(config_node, device_info);
+}
+
 }  // namespace microstrain
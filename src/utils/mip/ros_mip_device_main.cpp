@@ -10,10 +10,10 @@
 
 #include <stdio.h>
 
+#include <cmath>
+#include <cstring>
 #include <string>
 #include <memory>
-#include <thread>
-#include <chrono>
 #include <stdexcept>
 
 #include "mip/mip.hpp"
@@ -34,9 +34,34 @@ bool RosMipDeviceMain::configure(RosNodeType* config_node)
   getParam<std::string>(config_node, "port", port, "/dev/ttyACM0");
   getParam<int32_t>(config_node, "baudrate", baudrate, 115200);
   getParam<bool>(config_node, "set_baud", set_baud, false);
-  connection_ = std::make_shared<RosConnection>(node_);
-  if (!connection_->connect(config_node, port, baudrate))
-    return false;
+
+  // Either replay a capture, or connect to the device and optionally capture everything it sends
+  std::string replay_file;
+  std::string timed_capture_file;
+  getParam<std::string>(config_node, "replay_file", replay_file, "");
+  getParam<std::string>(config_node, "timed_capture_file", timed_capture_file, "");
+  connection_ = std::make_shared<RosConnection>(node_, clock_);
+  if (!replay_file.empty())
+  {
+    const auto virtual_clock = std::dynamic_pointer_cast<VirtualClock>(clock_);
+    if (virtual_clock == nullptr)
+    {
+      MICROSTRAIN_ERROR(node_, "Replaying a timed capture requires a virtual clock");
+      return false;
+    }
+    if (!connection_->replay(replay_file, virtual_clock))
+      return false;
+
+    // There is no port to reopen, and the capture already contains whatever baudrate changes happened when it was recorded
+    set_baud = false;
+  }
+  else
+  {
+    if (!timed_capture_file.empty() && !connection_->startTimedCapture(timed_capture_file))
+      return false;
+    if (!connection_->connect(config_node, port, baudrate))
+      return false;
+  }
 
   // Setup the device interface
   mip::CmdResult mip_cmd_result;
@@ -97,7 +122,7 @@ bool RosMipDeviceMain::configure(RosNodeType* config_node)
     if (changed_baud)
     {
       // Wait for the changes to take affect
-      std::this_thread::sleep_for(std::chrono::milliseconds(250));
+      clock_->sleepFor(0.25);
 
       // Reopen the device now
       if (!connection_->connect(config_node, port, baudrate))
@@ -160,6 +185,47 @@ bool RosMipDeviceMain::configure(RosNodeType* config_node)
   return true;
 }
 
+bool RosMipDeviceMain::adopt(RosNodeType* config_node, const HandoffState& state)
+{
+  std::string port;
+  int32_t baudrate;
+  getParam<std::string>(config_node, "port", port, "/dev/ttyACM0");
+  getParam<int32_t>(config_node, "baudrate", baudrate, 115200);
+  connection_ = std::make_shared<RosConnection>(node_, clock_);
+  if (!connection_->adopt(state.main_fd, port, baudrate))
+    return false;
+  device_ = std::unique_ptr<mip::DeviceInterface>(new mip::DeviceInterface(connection_.get(), buffer_, sizeof(buffer_), connection_->parseTimeout(), connection_->baseReplyTimeout()));
+
+  // Everything we would normally read from the device was already read by the previous driver
+  device_info_ = state.device_info;
+  max_external_frame_ids_ = state.max_external_frame_ids;
+  base_rates_ = state.base_rates;
+  supported_descriptors_ = state.supported_descriptors;
+  supported_descriptor_sets_.clear();
+  for (const uint16_t descriptor : supported_descriptors_)
+  {
+    const uint8_t descriptor_set = static_cast<uint8_t>((descriptor & 0xFF00) >> 8);
+    if (std::find(supported_descriptor_sets_.begin(), supported_descriptor_sets_.end(), descriptor_set) == supported_descriptor_sets_.end())
+      supported_descriptor_sets_.push_back(descriptor_set);
+  }
+  MICROSTRAIN_INFO(node_, R"(Main Connection Info (handed off):
+    #######################
+    Model Name:       %s
+    Serial Number:    %s
+    Firmware Version: %s
+    #######################)", device_info_.model_name, device_info_.serial_number, firmwareVersionString(device_info_.firmware_version).c_str());
+
+  return connection_->configure(config_node, device_info_);
+}
+
+void RosMipDeviceMain::saveHandoffState(HandoffState* state) const
+{
+  state->device_info = device_info_;
+  state->max_external_frame_ids = max_external_frame_ids_;
+  state->base_rates = base_rates_;
+  state->supported_descriptors = supported_descriptors_;
+}
+
 mip::CmdResult RosMipDeviceMain::forceIdle()
 {
   // Setting to idle may fail the first couple times, so call it a few times in case the device is streaming too much data
@@ -170,7 +236,7 @@ mip::CmdResult RosMipDeviceMain::forceIdle()
     if (!!(result = mip::commands_base::setIdle(*device_)))
       break;
     else
-      std::this_thread::sleep_for(std::chrono::seconds(1));
+      clock_->sleepFor(1.0);
   }
   return result;
 }
@@ -0,0 +1,156 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Parker-Lord Inertial Device Driver Implementation File
+//
+// Copyright (c) 2017, Brian Bingham
+// Copyright (c) 2020, Parker Hannifin Corp
+// This code is licensed under MIT license (see LICENSE file for details)
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include <poll.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <unistd.h>
+#include <termios.h>
+
+#include <chrono>
+#include <string>
+
+#include "microstrain_inertial_driver_common/utils/mip/serial_fd_connection.h"
+
+namespace microstrain
+{
+
+/**
+ * \brief Converts a baudrate to the termios speed constant
+ * \param baudrate The baudrate to convert
+ * \return The speed constant, or B0 if the baudrate is not supported
+ */
+static speed_t termiosSpeed(const uint32_t baudrate)
+{
+  switch (baudrate)
+  {
+    case 9600: return B9600;
+    case 19200: return B19200;
+    case 38400: return B38400;
+    case 57600: return B57600;
+    case 115200: return B115200;
+    case 230400: return B230400;
+    case 460800: return B460800;
+    case 921600: return B921600;
+    default: return B0;
+  }
+}
+
+SerialFdConnection::SerialFdConnection(const std::string& port, const uint32_t baudrate) : port_(port), baudrate_(baudrate)
+{
+}
+
+SerialFdConnection::SerialFdConnection(const int fd, const std::string& port, const uint32_t baudrate) : fd_(fd), port_(port), baudrate_(baudrate)
+{
+}
+
+SerialFdConnection::~SerialFdConnection()
+{
+  disconnect();
+}
+
+bool SerialFdConnection::isConnected() const
+{
+  return fd_ >= 0;
+}
+
+bool SerialFdConnection::connect()
+{
+  if (fd_ >= 0)
+    return true;
+
+  const speed_t speed = termiosSpeed(baudrate_);
+  if (speed == B0)
+    return false;
+
+  const int fd = open(port_.c_str(), O_RDWR | O_NOCTTY | O_CLOEXEC);
+  if (fd < 0)
+    return false;
+
+  // Raw mode, with reads returning whatever is available
+  struct termios settings;
+  if (tcgetattr(fd, &settings) != 0)
+  {
+    close(fd);
+    return false;
+  }
+  cfmakeraw(&settings);
+  settings.c_cflag |= CLOCAL | CREAD;
+  settings.c_cc[VMIN] = 0;
+  settings.c_cc[VTIME] = 0;
+  if (cfsetispeed(&settings, speed) != 0 || cfsetospeed(&settings, speed) != 0 || tcsetattr(fd, TCSANOW, &settings) != 0)
+  {
+    close(fd);
+    return false;
+  }
+
+  // Drop anything left over from before we opened the port
+  tcflush(fd, TCIOFLUSH);
+  fd_ = fd;
+  return true;
+}
+
+bool SerialFdConnection::disconnect()
+{
+  // Does not flush, since another process may still be reading from the same port
+  if (fd_ >= 0)
+    close(fd_);
+  fd_ = -1;
+  return true;
+}
+
+bool SerialFdConnection::sendToDevice(const uint8_t* data, const size_t length)
+{
+  size_t written = 0;
+  while (fd_ >= 0 && written < length)
+  {
+    const ssize_t count = write(fd_, data + written, length - written);
+    if (count < 0 && errno != EINTR && errno != EAGAIN)
+      return false;
+    if (count > 0)
+      written += count;
+  }
+  return written == length;
+}
+
+bool SerialFdConnection::recvFromDevice(uint8_t* buffer, const size_t max_length, const mip::Timeout wait_time, size_t* count_out, mip::Timestamp* timestamp_out)
+{
+  *count_out = 0;
+  *timestamp_out = static_cast<mip::Timestamp>(std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+  if (fd_ < 0)
+    return false;
+
+  struct pollfd poll_fd = {fd_, POLLIN, 0};
+  const int ready = poll(&poll_fd, 1, static_cast<int>(wait_time));
+  if (ready < 0)
+    return errno == EINTR;
+  if (ready == 0)
+    return true;
+  if (poll_fd.revents & (POLLERR | POLLHUP | POLLNVAL))
+    return false;
+
+  const ssize_t count = read(fd_, buffer, max_length);
+  if (count < 0)
+    return errno == EINTR || errno == EAGAIN;
+  *count_out = static_cast<size_t>(count);
+  return true;
+}
+
+const char* SerialFdConnection::interfaceName() const
+{
+  return port_.c_str();
+}
+
+uint32_t SerialFdConnection::parameter() const
+{
+  return baudrate_;
+}
+
+}  // namespace microstrain
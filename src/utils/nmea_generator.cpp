@@ -0,0 +1,243 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Parker-Lord Inertial Device Driver Implementation File
+//
+// Copyright (c) 2017, Brian Bingham
+// Copyright (c) 2020, Parker Hannifin Corp
+// This code is licensed under MIT license (see LICENSE file for details)
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include <cmath>
+#include <ctime>
+#include <cstdio>
+
+#include "microstrain_inertial_driver_common/utils/ros_compat.h"
+#include "microstrain_inertial_driver_common/utils/nmea_generator.h"
+
+namespace microstrain
+{
+
+constexpr auto METERS_PER_SECOND_TO_KNOTS = 1.943844492;
+constexpr auto METERS_PER_SECOND_TO_KILOMETERS_PER_HOUR = 3.6;
+
+// Allow a little bit of slop when deciding if a sentence is due, so jitter in the device timestamps does not cause us to skip a sentence
+constexpr auto NMEA_RATE_TOLERANCE_SECS = 0.001;
+
+/**
+ * \brief Formats a latitude or longitude into the NMEA degrees and decimal minutes format including the hemisphere
+ * \param value Latitude or longitude in degrees
+ * \param degree_digits Number of digits to use for the degrees. 2 for latitude, 3 for longitude
+ * \param positive Hemisphere character to use if the value is positive
+ * \param negative Hemisphere character to use if the value is negative
+ * \return Formatted string that can be directly inserted into a sentence
+ */
+static std::string formatDegreesMinutes(const double value, const int degree_digits, const char positive, const char negative)
+{
+  // Do the math in millionths of a minute so rounding can never produce 60 minutes
+  constexpr long long micro_minutes_per_degree = 60LL * 1000000LL;
+  const long long total_micro_minutes = std::llround(std::fabs(value) * micro_minutes_per_degree);
+  const long long degrees = total_micro_minutes / micro_minutes_per_degree;
+  const long long micro_minutes = total_micro_minutes % micro_minutes_per_degree;
+
+  char buffer[32];
+  snprintf(buffer, sizeof(buffer), "%0*lld%02lld.%06lld,%c", degree_digits, degrees, micro_minutes / 1000000LL, micro_minutes % 1000000LL, value >= 0 ? positive : negative);
+  return buffer;
+}
+
+NmeaGenerator::NmeaGenerator(const std::string& talker_id, const float gga_rate_hz, const float rmc_rate_hz, const float vtg_rate_hz)
+  : talker_id_(talker_id), gga_rate_hz_(gga_rate_hz), rmc_rate_hz_(rmc_rate_hz), vtg_rate_hz_(vtg_rate_hz)
+{
+}
+
+bool NmeaGenerator::enabled() const
+{
+  return gga_rate_hz_ > 0 || rmc_rate_hz_ > 0 || vtg_rate_hz_ > 0;
+}
+
+void NmeaGenerator::updatePosition(const double latitude, const double longitude, const double msl_height, const double geoid_separation)
+{
+  has_position_ = true;
+  latitude_ = latitude;
+  longitude_ = longitude;
+  msl_height_ = msl_height;
+  geoid_separation_ = geoid_separation;
+}
+
+void NmeaGenerator::updateVelocity(const double north, const double east)
+{
+  has_velocity_ = true;
+  north_velocity_ = north;
+  east_velocity_ = east;
+}
+
+void NmeaGenerator::updateFix(const uint8_t quality, const uint8_t num_sv)
+{
+  quality_ = quality;
+  num_sv_ = num_sv;
+}
+
+std::vector<std::string> NmeaGenerator::generate(const mip::data_shared::GpsTimestamp& gps_timestamp, std::string* gga_sentence)
+{
+  std::vector<std::string> sentences;
+  const double gps_time = gps_timestamp.week_number * 604800 + gps_timestamp.tow;
+  const bool gga_due = due(gga_rate_hz_, &last_gga_time_, gps_time);
+  const bool rmc_due = due(rmc_rate_hz_, &last_rmc_time_, gps_time);
+  const bool vtg_due = due(vtg_rate_hz_, &last_vtg_time_, gps_time);
+  if (!gga_due && !rmc_due && !vtg_due)
+    return sentences;
+
+  // Convert the GPS time to UTC, keeping the subseconds separate so we can round them to the precision of the sentence
+  double utc_seconds = 315964800 + gps_timestamp.week_number * 604800 - GPS_LEAP_SECONDS;
+  double tow_seconds;
+  long long centiseconds = std::llround(modf(gps_timestamp.tow, &tow_seconds) * 100);
+  utc_seconds += tow_seconds;
+  if (centiseconds >= 100)
+  {
+    utc_seconds += 1;
+    centiseconds -= 100;
+  }
+  const time_t utc_time = static_cast<time_t>(utc_seconds);
+  struct tm utc_tm;
+  gmtime_r(&utc_time, &utc_tm);
+
+  char time_buffer[32];
+  snprintf(time_buffer, sizeof(time_buffer), "%02d%02d%02d.%02lld", utc_tm.tm_hour, utc_tm.tm_min, utc_tm.tm_sec, centiseconds);
+  char date_buffer[32];
+  snprintf(date_buffer, sizeof(date_buffer), "%02d%02d%02d", utc_tm.tm_mday, utc_tm.tm_mon + 1, utc_tm.tm_year % 100);
+
+  if (gga_due)
+  {
+    sentences.push_back(finalize(gga(time_buffer)));
+    if (gga_sentence != nullptr)
+      *gga_sentence = sentences.back();
+  }
+  if (rmc_due)
+    sentences.push_back(finalize(rmc(time_buffer, date_buffer)));
+  if (vtg_due)
+    sentences.push_back(finalize(vtg()));
+  return sentences;
+}
+
+uint8_t NmeaGenerator::checksum(const std::string& body)
+{
+  uint8_t checksum = 0;
+  for (const char c : body)
+    checksum ^= static_cast<uint8_t>(c);
+  return checksum;
+}
+
+std::string NmeaGenerator::finalize(const std::string& body)
+{
+  char checksum_buffer[8];
+  snprintf(checksum_buffer, sizeof(checksum_buffer), "*%02X\r\n", checksum(body));
+  return "$" + body + checksum_buffer;
+}
+
+bool NmeaGenerator::due(const float rate_hz, double* last_time, const double time)
+{
+  if (rate_hz <= 0)
+    return false;
+
+  // Also generate the sentence if time went backwards, since that likely means the device was reset
+  if (*last_time < 0 || time < *last_time || time - *last_time >= (1.0 / rate_hz) - NMEA_RATE_TOLERANCE_SECS)
+  {
+    *last_time = time;
+    return true;
+  }
+  return false;
+}
+
+std::string NmeaGenerator::gga(const std::string& time_str) const
+{
+  // HDOP, age of differential data and differential station ID are not available, so they are left empty
+  std::string body = talker_id_ + "GGA," + time_str + ",";
+  if (has_position_)
+  {
+    char buffer[64];
+    snprintf(buffer, sizeof(buffer), ",%d,%02d,,%.3f,M,%.3f,M,,", quality_, num_sv_, msl_height_, geoid_separation_);
+    body += formatDegreesMinutes(latitude_, 2, 'N', 'S') + "," + formatDegreesMinutes(longitude_, 3, 'E', 'W') + buffer;
+  }
+  else
+  {
+    char buffer[32];
+    snprintf(buffer, sizeof(buffer), ",,,,%d,%02d,,,M,,M,,", FIX_QUALITY_INVALID, num_sv_);
+    body += buffer;
+  }
+  return body;
+}
+
+std::string NmeaGenerator::rmc(const std::string& time_str, const std::string& date_str) const
+{
+  const bool valid = has_position_ && quality_ != FIX_QUALITY_INVALID;
+  std::string body = talker_id_ + "RMC," + time_str + "," + (valid ? "A" : "V") + ",";
+  if (has_position_)
+    body += formatDegreesMinutes(latitude_, 2, 'N', 'S') + "," + formatDegreesMinutes(longitude_, 3, 'E', 'W') + ",";
+  else
+    body += ",,,,";
+  if (has_velocity_)
+  {
+    char buffer[32];
+    snprintf(buffer, sizeof(buffer), "%.3f,%.2f,", speedOverGround() * METERS_PER_SECOND_TO_KNOTS, courseOverGround());
+    body += buffer;
+  }
+  else
+  {
+    body += ",,";
+  }
+
+  // Magnetic variation is not available
+  body += date_str + ",,," + modeIndicator();
+  return body;
+}
+
+std::string NmeaGenerator::vtg() const
+{
+  std::string body = talker_id_ + "VTG,";
+  if (has_velocity_)
+  {
+    char buffer[64];
+    snprintf(buffer, sizeof(buffer), "%.2f,T,,M,%.3f,N,%.3f,K,", courseOverGround(), speedOverGround() * METERS_PER_SECOND_TO_KNOTS, speedOverGround() * METERS_PER_SECOND_TO_KILOMETERS_PER_HOUR);
+    body += buffer;
+  }
+  else
+  {
+    body += ",T,,M,,N,,K,";
+  }
+  body += modeIndicator();
+  return body;
+}
+
+char NmeaGenerator::modeIndicator() const
+{
+  switch (quality_)
+  {
+    case FIX_QUALITY_GNSS:
+      return 'A';
+    case FIX_QUALITY_DGNSS:
+      return 'D';
+    case FIX_QUALITY_RTK_FIXED:
+      return 'R';
+    case FIX_QUALITY_RTK_FLOAT:
+      return 'F';
+    case FIX_QUALITY_ESTIMATED:
+      return 'E';
+    default:
+      return 'N';
+  }
+}
+
+double NmeaGenerator::speedOverGround() const
+{
+  return std::sqrt(north_velocity_ * north_velocity_ + east_velocity_ * east_velocity_);
+}
+
+double NmeaGenerator::courseOverGround() const
+{
+  double course = std::atan2(east_velocity_, north_velocity_) * 180.0 / M_PI;
+  if (course < 0)
+    course += 360.0;
+  return course;
+}
+
+}  // namespace microstrain
@@ -0,0 +1,206 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Parker-Lord Inertial Device Driver Implementation File
+//
+// Copyright (c) 2017, Brian Bingham
+// Copyright (c) 2020, Parker Hannifin Corp
+// This code is licensed under MIT license (see LICENSE file for details)
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include <cstdio>
+#include <cerrno>
+#include <cstring>
+#include <sstream>
+
+#ifdef __linux__
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#endif
+
+#include "microstrain_inertial_driver_common/utils/perf_profiler.h"
+
+namespace microstrain
+{
+
+static const char* STAGE_NAMES[PerfProfiler::NUM_STAGES] = {"update", "handlers", "publish"};
+static const char* COUNTER_NAMES[PerfProfiler::NUM_COUNTERS] = {"instructions", "cycles", "cache_misses", "branch_misses"};
+
+PerfProfiler::~PerfProfiler()
+{
+#ifdef __linux__
+  for (int& fd : fds_)
+  {
+    if (fd >= 0)
+      close(fd);
+    fd = -1;
+  }
+#endif
+}
+
+bool PerfProfiler::open(std::string* error)
+{
+#ifdef __linux__
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  // Opening again from the same thread, for example after a reconnect, keeps the existing counters
+  if (group_fd_ >= 0)
+  {
+    if (measuring())
+      return true;
+    *error = "Counters are already open on another thread";
+    return false;
+  }
+
+  static const uint64_t configs[NUM_COUNTERS] = {PERF_COUNT_HW_INSTRUCTIONS, PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES};
+  for (size_t i = 0; i < NUM_COUNTERS; i++)
+  {
+    perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.config = configs[i];
+    attr.disabled = group_fd_ < 0 ? 1 : 0;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+    // Measure only the calling thread on any CPU. Not every CPU supports every counter, so only the leader is required
+    fds_[i] = static_cast<int>(syscall(__NR_perf_event_open, &attr, 0, -1, group_fd_, 0));
+    if (fds_[i] < 0)
+    {
+      if (group_fd_ < 0)
+      {
+        *error = std::string("perf_event_open failed: ") + strerror(errno) + ". Check /proc/sys/kernel/perf_event_paranoid";
+        return false;
+      }
+      continue;
+    }
+    if (group_fd_ < 0)
+      group_fd_ = fds_[i];
+    num_open_++;
+  }
+
+  ioctl(group_fd_, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+  ioctl(group_fd_, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+
+  // Set last, so the counters are only used once they are all open
+  thread_id_.store(std::this_thread::get_id(), std::memory_order_release);
+  return true;
+#else
+  *error = "Performance counters are only supported on Linux";
+  return false;
+#endif
+}
+
+void PerfProfiler::begin(const Stage stage)
+{
+  if (!measuring())
+    return;
+  read(&begin_readings_[stage]);
+}
+
+void PerfProfiler::end(const Stage stage, const uint8_t descriptor_set)
+{
+  if (!measuring())
+    return;
+
+  Reading end_reading;
+  if (!read(&end_reading))
+    return;
+
+  // The counters are all in one group, so they are scheduled together. If they only ran for part of the stage, scale them up to the whole stage
+  const Reading& begin_reading = begin_readings_[stage];
+  const uint64_t time_enabled = end_reading.time_enabled - begin_reading.time_enabled;
+  const uint64_t time_running = end_reading.time_running - begin_reading.time_running;
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  Totals& totals = totals_[stage][descriptor_set];
+  if (time_running == 0)
+  {
+    totals.unscheduled_samples++;
+    return;
+  }
+  const double scale = time_running < time_enabled ? static_cast<double>(time_enabled) / time_running : 1.0;
+  totals.samples++;
+  if (time_running < time_enabled)
+    totals.multiplexed_samples++;
+  for (size_t i = 0; i < NUM_COUNTERS; i++)
+    totals.counters[i] += (end_reading.counters[i] - begin_reading.counters[i]) * scale;
+}
+
+std::string PerfProfiler::toYaml() const
+{
+  std::stringstream yaml;
+  yaml.precision(6);
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (size_t stage = 0; stage < NUM_STAGES; stage++)
+  {
+    yaml << STAGE_NAMES[stage] << ":\n";
+    for (size_t descriptor_set = 0; descriptor_set < 256; descriptor_set++)
+    {
+      const Totals& totals = totals_[stage][descriptor_set];
+      if (totals.samples == 0 && totals.unscheduled_samples == 0)
+        continue;
+
+      char descriptor_set_name[8];
+      if (descriptor_set == DESCRIPTOR_SET_ALL)
+        snprintf(descriptor_set_name, sizeof(descriptor_set_name), "all");
+      else
+        snprintf(descriptor_set_name, sizeof(descriptor_set_name), "0x%02x", static_cast<unsigned int>(descriptor_set));
+      yaml << "  " << descriptor_set_name << ":\n";
+      yaml << "    samples: " << totals.samples << "\n";
+      yaml << "    multiplexed_samples: " << totals.multiplexed_samples << "\n";
+      yaml << "    unscheduled_samples: " << totals.unscheduled_samples << "\n";
+      if (totals.samples == 0)
+        continue;
+      for (size_t i = 0; i < NUM_COUNTERS; i++)
+      {
+        if (fds_[i] >= 0)
+          yaml << "    " << COUNTER_NAMES[i] << "_per_sample: " << totals.counters[i] / totals.samples << "\n";
+      }
+      if (fds_[COUNTER_CYCLES] >= 0 && totals.counters[COUNTER_CYCLES] > 0)
+        yaml << "    instructions_per_cycle: " << totals.counters[COUNTER_INSTRUCTIONS] / totals.counters[COUNTER_CYCLES] << "\n";
+    }
+  }
+  return yaml.str();
+}
+
+void PerfProfiler::reset()
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (auto& stage_totals : totals_)
+    for (Totals& totals : stage_totals)
+      totals = Totals();
+}
+
+bool PerfProfiler::read(Reading* reading) const
+{
+#ifdef __linux__
+  // The leader returns the number of counters, the time enabled, the time running, and then the value of each counter in the order they were opened
+  uint64_t buffer[3 + NUM_COUNTERS];
+  const ssize_t expected_size = static_cast<ssize_t>((3 + num_open_) * sizeof(uint64_t));
+  if (::read(group_fd_, buffer, sizeof(buffer)) < expected_size)
+    return false;
+
+  reading->time_enabled = buffer[1];
+  reading->time_running = buffer[2];
+  size_t group_index = 3;
+  for (size_t i = 0; i < NUM_COUNTERS; i++)
+    reading->counters[i] = fds_[i] >= 0 ? buffer[group_index++] : 0;
+  return true;
+#else
+  return false;
+#endif
+}
+
+bool PerfProfiler::measuring() const
+{
+  // No thread has the default ID, so this is false until the counters are open
+  return std::this_thread::get_id() == thread_id_.load(std::memory_order_acquire);
+}
+
+}  // namespace microstrain
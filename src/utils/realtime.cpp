@@ -0,0 +1,249 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Parker-Lord Inertial Device Driver Implementation File
+//
+// Copyright (c) 2017, Brian Bingham
+// Copyright (c) 2020, Parker Hannifin Corp
+// This code is licensed under MIT license (see LICENSE file for details)
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include <cstdlib>
+#include <cstring>
+#include <cerrno>
+
+#ifdef __linux__
+#include <sched.h>
+#include <alloca.h>
+#include <malloc.h>
+#include <pthread.h>
+#include <execinfo.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#endif
+
+#include <algorithm>
+
+#include "microstrain_inertial_driver_common/utils/realtime.h"
+
+namespace microstrain
+{
+
+// Number of stack frames to save for the first allocation on the hot path
+constexpr int RT_AUDIT_MAX_FRAMES = 16;
+
+// Stack size glibc gives new threads when the stack size limit is unlimited
+constexpr size_t RT_UNLIMITED_STACK_SIZE = 2 * 1024 * 1024;
+
+// Stack left untouched by prefaultStack for the frames already on the stack when it is called
+constexpr size_t RT_STACK_PREFAULT_MARGIN = 64 * 1024;
+
+// Per thread state used by the allocation audit. Only plain types so that reading them from inside the allocation functions never allocates.
+// On Linux they are kept in the static TLS block, since the first access to dynamic TLS can call malloc, which is audited itself
+#ifdef __linux__
+#define RT_AUDIT_TLS __attribute__((tls_model("initial-exec")))
+#else
+#define RT_AUDIT_TLS
+#endif
+static thread_local int rt_audit_hot_path_depth RT_AUDIT_TLS = 0;
+static thread_local uint64_t rt_audit_violations RT_AUDIT_TLS = 0;
+static thread_local uint64_t rt_audit_contentions RT_AUDIT_TLS = 0;
+static thread_local void* rt_audit_frames[RT_AUDIT_MAX_FRAMES] RT_AUDIT_TLS;
+static thread_local int rt_audit_num_frames RT_AUDIT_TLS = 0;
+#if defined(MICROSTRAIN_RT_AUDIT) && defined(__linux__)
+static thread_local bool rt_audit_in_hook RT_AUDIT_TLS = false;
+#endif
+
+bool Realtime::lockMemory(std::string* error)
+{
+#ifdef __linux__
+  if (mlockall(MCL_CURRENT | MCL_FUTURE) != 0)
+  {
+    *error = std::string("mlockall failed: ") + strerror(errno) + ". Make sure the process has CAP_IPC_LOCK or a large enough memlock limit";
+    return false;
+  }
+
+  // Keep freed memory in the heap instead of returning it to the OS, and do not use mmap for large allocations, so locked pages stay locked
+  mallopt(M_TRIM_THRESHOLD, -1);
+  mallopt(M_MMAP_MAX, 0);
+  return true;
+#else
+  *error = "Memory locking is only supported on Linux";
+  return false;
+#endif
+}
+
+void Realtime::prefaultStack(const size_t size)
+{
+#ifdef __linux__
+  // Volatile so the compiler can not optimize the writes away. Allocated on the stack of the calling thread on purpose,
+  // and never more than the stack can hold, as alloca does not check
+  const size_t prefault_size = std::min(size, maxPrefaultStackSize());
+  volatile unsigned char* stack = static_cast<volatile unsigned char*>(alloca(prefault_size));
+  for (size_t i = 0; i < prefault_size; i += 4096)
+    stack[i] = 0;
+#endif
+}
+
+size_t Realtime::maxPrefaultStackSize()
+{
+#ifdef __linux__
+  // New threads get the soft limit as their stack size as well, so this holds for the port threads too
+  size_t stack_size = RT_UNLIMITED_STACK_SIZE;
+  rlimit limit;
+  if (getrlimit(RLIMIT_STACK, &limit) == 0 && limit.rlim_cur != RLIM_INFINITY)
+    stack_size = limit.rlim_cur;
+  return stack_size > RT_STACK_PREFAULT_MARGIN ? stack_size - RT_STACK_PREFAULT_MARGIN : 0;
+#else
+  return 0;
+#endif
+}
+
+void Realtime::prefaultHeap(const size_t size)
+{
+  unsigned char* heap = static_cast<unsigned char*>(malloc(size));
+  if (heap == nullptr)
+    return;
+  for (size_t i = 0; i < size; i += 4096)
+    heap[i] = 0;
+  free(heap);
+}
+
+bool Realtime::setThreadScheduling(const std::string& policy, const int priority, std::string* error)
+{
+#ifdef __linux__
+  int sched_policy;
+  if (policy == RT_SCHEDULING_POLICY_OTHER)
+    sched_policy = SCHED_OTHER;
+  else if (policy == RT_SCHEDULING_POLICY_FIFO)
+    sched_policy = SCHED_FIFO;
+  else if (policy == RT_SCHEDULING_POLICY_RR)
+    sched_policy = SCHED_RR;
+  else
+  {
+    *error = "Invalid scheduling policy " + policy + ". Must be one of '" + RT_SCHEDULING_POLICY_OTHER + "', '" + RT_SCHEDULING_POLICY_FIFO + "', or '" + RT_SCHEDULING_POLICY_RR + "'";
+    return false;
+  }
+
+  sched_param param = {};
+  param.sched_priority = sched_policy == SCHED_OTHER ? 0 : priority;
+  const int result = pthread_setschedparam(pthread_self(), sched_policy, &param);
+  if (result != 0)
+  {
+    *error = std::string("pthread_setschedparam failed: ") + strerror(result) + ". Make sure the process has CAP_SYS_NICE or a large enough rtprio limit";
+    return false;
+  }
+  return true;
+#else
+  *error = "Thread scheduling is only supported on Linux";
+  return false;
+#endif
+}
+
+RealtimeAudit::Scope::Scope()
+{
+  rt_audit_hot_path_depth++;
+}
+
+RealtimeAudit::Scope::~Scope()
+{
+  rt_audit_hot_path_depth--;
+}
+
+bool RealtimeAudit::supported()
+{
+#if defined(MICROSTRAIN_RT_AUDIT) && defined(__linux__)
+  return true;
+#else
+  return false;
+#endif
+}
+
+const char* RealtimeAudit::auditedFunctions()
+{
+#if defined(MICROSTRAIN_RT_AUDIT_MALLOC)
+  return "operator new, malloc, calloc, realloc";
+#elif defined(MICROSTRAIN_RT_AUDIT) && defined(__linux__)
+  return "operator new";
+#else
+  return "";
+#endif
+}
+
+uint64_t RealtimeAudit::takeViolations(std::string* call_site)
+{
+  const uint64_t violations = rt_audit_violations;
+  rt_audit_violations = 0;
+
+#ifdef __linux__
+  if (violations > 0 && rt_audit_num_frames > 0)
+  {
+    // Skip the first two frames as they are always the audit hook and the allocation function
+    char** symbols = backtrace_symbols(rt_audit_frames, rt_audit_num_frames);
+    call_site->clear();
+    if (symbols != nullptr)
+    {
+      for (int i = 2; i < rt_audit_num_frames; i++)
+        *call_site += std::string("\n    ") + symbols[i];
+      free(symbols);
+    }
+  }
+#endif
+  rt_audit_num_frames = 0;
+  return violations;
+}
+
+void RealtimeAudit::recordAllocation()
+{
+#if defined(MICROSTRAIN_RT_AUDIT) && defined(__linux__)
+  if (rt_audit_hot_path_depth <= 0 || rt_audit_in_hook)
+    return;
+
+  // backtrace can allocate the first time it is called, so make sure we do not recurse
+  rt_audit_in_hook = true;
+  if (rt_audit_violations++ == 0)
+    rt_audit_num_frames = backtrace(rt_audit_frames, RT_AUDIT_MAX_FRAMES);
+  rt_audit_in_hook = false;
+#endif
+}
+
+uint64_t RealtimeAudit::takeContentions()
+{
+  const uint64_t contentions = rt_audit_contentions;
+  rt_audit_contentions = 0;
+  return contentions;
+}
+
+void RealtimeAudit::recordContention()
+{
+  if (rt_audit_hot_path_depth > 0)
+    rt_audit_contentions++;
+}
+
+}  // namespace microstrain
+
+#ifdef MICROSTRAIN_RT_AUDIT_MALLOC
+// The glibc allocation functions the replacements below forward to
+extern "C" void* __libc_malloc(size_t size);
+extern "C" void* __libc_calloc(size_t count, size_t size);
+extern "C" void* __libc_realloc(void* ptr, size_t size);
+
+// Replacements for the C allocation functions that report allocations made on the hot path, including the ones made by the MIP SDK and by operator new
+extern "C" void* malloc(size_t size)
+{
+  microstrain::RealtimeAudit::recordAllocation();
+  return __libc_malloc(size);
+}
+
+extern "C" void* calloc(size_t count, size_t size)
+{
+  microstrain::RealtimeAudit::recordAllocation();
+  return __libc_calloc(count, size);
+}
+
+extern "C" void* realloc(void* ptr, size_t size)
+{
+  microstrain::RealtimeAudit::recordAllocation();
+  return __libc_realloc(ptr, size);
+}
+#endif
@@ -0,0 +1,195 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Parker-Lord Inertial Device Driver Implementation File
+//
+// Copyright (c) 2017, Brian Bingham
+// Copyright (c) 2020, Parker Hannifin Corp
+// This code is licensed under MIT license (see LICENSE file for details)
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include <array>
+#include <sstream>
+
+#include "microstrain_inertial_driver_common/utils/rtcm_framer.h"
+
+namespace microstrain
+{
+
+constexpr uint8_t RtcmFramer::PREAMBLE;
+constexpr size_t RtcmFramer::HEADER_SIZE;
+constexpr size_t RtcmFramer::CRC_SIZE;
+constexpr size_t RtcmFramer::MAX_PAYLOAD_SIZE;
+constexpr size_t RtcmFramer::NUM_MESSAGE_TYPES;
+
+// Generator polynomial of CRC-24Q
+constexpr uint32_t CRC24Q_POLYNOMIAL = 0x1864CFB;
+
+/**
+ * \brief Builds the lookup table for CRC-24Q, so the CRC can be computed a byte at a time
+ * \return The CRC of each byte value
+ */
+static std::array<uint32_t, 256> makeCrc24qTable()
+{
+  std::array<uint32_t, 256> table;
+  for (uint32_t i = 0; i < table.size(); i++)
+  {
+    uint32_t crc = i << 16;
+    for (int bit = 0; bit < 8; bit++)
+    {
+      crc <<= 1;
+      if (crc & 0x1000000)
+        crc ^= CRC24Q_POLYNOMIAL;
+    }
+    table[i] = crc & 0xFFFFFF;
+  }
+  return table;
+}
+
+uint32_t RtcmFramer::crc24q(const uint8_t* data, const size_t size)
+{
+  static const std::array<uint32_t, 256> table = makeCrc24qTable();
+  uint32_t crc = 0;
+  for (size_t i = 0; i < size; i++)
+    crc = ((crc << 8) & 0xFFFFFF) ^ table[((crc >> 16) ^ data[i]) & 0xFF];
+  return crc;
+}
+
+std::vector<uint16_t> RtcmFramer::defaultMessageTypes(const bool glonass_enable, const bool galileo_enable, const bool beidou_enable)
+{
+  // Station coordinates, antenna and receiver descriptors, and GLONASS code-phase biases
+  std::vector<uint16_t> message_types = {1005, 1006, 1007, 1008, 1033, 1230};
+
+  // GPS legacy observations, ephemeris, and MSM
+  for (uint16_t message_type = 1001; message_type <= 1004; message_type++)
+    message_types.push_back(message_type);
+  message_types.push_back(1019);
+  for (uint16_t message_type = 1071; message_type <= 1077; message_type++)
+    message_types.push_back(message_type);
+
+  if (glonass_enable)
+  {
+    for (uint16_t message_type = 1009; message_type <= 1012; message_type++)
+      message_types.push_back(message_type);
+    message_types.push_back(1020);
+    for (uint16_t message_type = 1081; message_type <= 1087; message_type++)
+      message_types.push_back(message_type);
+  }
+  if (galileo_enable)
+  {
+    message_types.push_back(1045);
+    message_types.push_back(1046);
+    for (uint16_t message_type = 1091; message_type <= 1097; message_type++)
+      message_types.push_back(message_type);
+  }
+  if (beidou_enable)
+  {
+    message_types.push_back(1042);
+    for (uint16_t message_type = 1121; message_type <= 1127; message_type++)
+      message_types.push_back(message_type);
+  }
+  return message_types;
+}
+
+void RtcmFramer::setAllowedMessageTypes(const std::vector<uint16_t>& message_types)
+{
+  allowed_.clear();
+  if (message_types.empty())
+    return;
+
+  allowed_.resize(NUM_MESSAGE_TYPES, false);
+  for (const uint16_t message_type : message_types)
+    if (message_type < NUM_MESSAGE_TYPES)
+      allowed_[message_type] = true;
+}
+
+void RtcmFramer::process(const uint8_t* data, const size_t size, std::vector<uint8_t>* frames)
+{
+  buffer_.insert(buffer_.end(), data, data + size);
+
+  std::lock_guard<std::mutex> lock(statistics_mutex_);
+  size_t offset = 0;
+  while (offset < buffer_.size())
+  {
+    // Skip anything that can not be the start of a frame
+    if (buffer_[offset] != PREAMBLE)
+    {
+      offset++;
+      discarded_bytes_++;
+      continue;
+    }
+    if (buffer_.size() - offset < HEADER_SIZE)
+      break;
+
+    // The 6 bits after the preamble are reserved and always 0, so anything else was a preamble byte in the middle of other data
+    const uint8_t* frame = buffer_.data() + offset;
+    if ((frame[1] & 0xFC) != 0)
+    {
+      offset++;
+      discarded_bytes_++;
+      continue;
+    }
+
+    const size_t payload_size = (static_cast<size_t>(frame[1] & 0x03) << 8) | frame[2];
+    const size_t frame_size = HEADER_SIZE + payload_size + CRC_SIZE;
+    if (buffer_.size() - offset < frame_size)
+      break;
+
+    const uint32_t expected_crc = (static_cast<uint32_t>(frame[frame_size - 3]) << 16) | (static_cast<uint32_t>(frame[frame_size - 2]) << 8) | frame[frame_size - 1];
+    if (crc24q(frame, HEADER_SIZE + payload_size) != expected_crc)
+    {
+      // Start looking for the next frame right after this preamble, in case the length was garbage
+      crc_failures_++;
+      offset++;
+      discarded_bytes_++;
+      continue;
+    }
+
+    // The message type is the first 12 bits of the payload
+    const uint16_t message_type = payload_size >= 2 ? static_cast<uint16_t>((frame[3] << 4) | (frame[4] >> 4)) : 0;
+    TypeStatistics& statistics = type_statistics_[message_type];
+    if (allowed_.empty() || allowed_[message_type])
+    {
+      frames->insert(frames->end(), frame, frame + frame_size);
+      statistics.frames++;
+      statistics.bytes += frame_size;
+    }
+    else
+    {
+      statistics.dropped_frames++;
+      statistics.dropped_bytes += frame_size;
+    }
+    offset += frame_size;
+  }
+  buffer_.erase(buffer_.begin(), buffer_.begin() + offset);
+}
+
+std::string RtcmFramer::toYaml() const
+{
+  std::stringstream yaml;
+
+  std::lock_guard<std::mutex> lock(statistics_mutex_);
+  yaml << "crc_failures: " << crc_failures_ << "\n";
+  yaml << "discarded_bytes: " << discarded_bytes_ << "\n";
+  yaml << "message_types:\n";
+  for (const auto& type_statistics : type_statistics_)
+  {
+    const TypeStatistics& statistics = type_statistics.second;
+    yaml << "  " << type_statistics.first << ":\n";
+    yaml << "    frames: " << statistics.frames << "\n";
+    yaml << "    bytes: " << statistics.bytes << "\n";
+    yaml << "    dropped_frames: " << statistics.dropped_frames << "\n";
+    yaml << "    dropped_bytes: " << statistics.dropped_bytes << "\n";
+  }
+  return yaml.str();
+}
+
+void RtcmFramer::reset()
+{
+  std::lock_guard<std::mutex> lock(statistics_mutex_);
+  type_statistics_.clear();
+  crc_failures_ = 0;
+  discarded_bytes_ = 0;
+}
+
+}  // namespace microstrain
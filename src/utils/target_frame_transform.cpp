@@ -0,0 +1,141 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Parker-Lord Inertial Device Driver Implementation File
+//
+// Copyright (c) 2017, Brian Bingham
+// Copyright (c) 2020, Parker Hannifin Corp
+// This code is licensed under MIT license (see LICENSE file for details)
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "microstrain_inertial_driver_common/utils/target_frame_transform.h"
+
+namespace microstrain
+{
+
+// Angular acceleration is not estimated across gaps longer than this, as the difference would no longer be meaningful
+constexpr double TARGET_FRAME_MAX_ANGULAR_ACCELERATION_DT = 0.5;
+
+void TargetFrameTransform::set(const tf2::Transform& frame_to_target_transform)
+{
+  rotation_ = frame_to_target_transform.getBasis();
+  target_to_frame_rotation_ = frame_to_target_transform.getRotation().inverse();
+
+  // The origin of the target frame is where the inverse transform takes the origin of the target frame
+  lever_arm_ = frame_to_target_transform.inverse().getOrigin();
+  has_lever_arm_ = !lever_arm_.isZero();
+
+  has_previous_angular_velocity_ = false;
+  valid_ = true;
+}
+
+void TargetFrameTransform::reset()
+{
+  valid_ = false;
+  has_previous_angular_velocity_ = false;
+}
+
+void TargetFrameTransform::transformImu(const ImuMsg& imu_msg, ImuMsg* target_imu_msg)
+{
+  target_imu_msg->header.stamp = imu_msg.header.stamp;
+
+  const tf2::Vector3 angular_velocity(imu_msg.angular_velocity.x, imu_msg.angular_velocity.y, imu_msg.angular_velocity.z);
+  tf2::Vector3 linear_acceleration(imu_msg.linear_acceleration.x, imu_msg.linear_acceleration.y, imu_msg.linear_acceleration.z);
+
+  // A point fixed to the body sees the centripetal acceleration, and the tangential acceleration from the change in angular rate
+  if (has_lever_arm_)
+  {
+    const double stamp = getTimeRefSecs(imu_msg.header.stamp);
+    const double dt = stamp - previous_stamp_;
+    tf2::Vector3 angular_acceleration(0, 0, 0);
+    if (has_previous_angular_velocity_ && dt > 0 && dt < TARGET_FRAME_MAX_ANGULAR_ACCELERATION_DT)
+      angular_acceleration = (angular_velocity - previous_angular_velocity_) / dt;
+    previous_angular_velocity_ = angular_velocity;
+    previous_stamp_ = stamp;
+    has_previous_angular_velocity_ = true;
+
+    linear_acceleration += angular_acceleration.cross(lever_arm_) + angular_velocity.cross(angular_velocity.cross(lever_arm_));
+  }
+
+  const tf2::Vector3 target_angular_velocity = rotation_ * angular_velocity;
+  const tf2::Vector3 target_linear_acceleration = rotation_ * linear_acceleration;
+  target_imu_msg->angular_velocity.x = target_angular_velocity.x();
+  target_imu_msg->angular_velocity.y = target_angular_velocity.y();
+  target_imu_msg->angular_velocity.z = target_angular_velocity.z();
+  target_imu_msg->linear_acceleration.x = target_linear_acceleration.x();
+  target_imu_msg->linear_acceleration.y = target_linear_acceleration.y();
+  target_imu_msg->linear_acceleration.z = target_linear_acceleration.z();
+  rotateCovariance(imu_msg.angular_velocity_covariance.data(), target_imu_msg->angular_velocity_covariance.data(), 3, 0, 0);
+  rotateCovariance(imu_msg.linear_acceleration_covariance.data(), target_imu_msg->linear_acceleration_covariance.data(), 3, 0, 0);
+
+  // The orientation covariance is about the fixed axes, so only the orientation itself changes
+  target_imu_msg->orientation_covariance = imu_msg.orientation_covariance;
+  if (imu_msg.orientation_covariance[0] != -1)
+  {
+    tf2::Quaternion orientation;
+    tf2::fromMsg(imu_msg.orientation, orientation);
+    target_imu_msg->orientation = tf2::toMsg(orientation * target_to_frame_rotation_);
+  }
+  else
+  {
+    target_imu_msg->orientation = imu_msg.orientation;
+  }
+}
+
+void TargetFrameTransform::transformOdometry(const OdometryMsg& odometry_msg, OdometryMsg* target_odometry_msg) const
+{
+  target_odometry_msg->header.stamp = odometry_msg.header.stamp;
+
+  // Move the position along the lever arm rotated into the parent frame
+  tf2::Quaternion orientation;
+  tf2::fromMsg(odometry_msg.pose.pose.orientation, orientation);
+  const tf2::Vector3 position(odometry_msg.pose.pose.position.x, odometry_msg.pose.pose.position.y, odometry_msg.pose.pose.position.z);
+  const tf2::Vector3 target_position = position + tf2::quatRotate(orientation, lever_arm_);
+  target_odometry_msg->pose.pose.position.x = target_position.x();
+  target_odometry_msg->pose.pose.position.y = target_position.y();
+  target_odometry_msg->pose.pose.position.z = target_position.z();
+  target_odometry_msg->pose.pose.orientation = tf2::toMsg(orientation * target_to_frame_rotation_);
+  target_odometry_msg->pose.covariance = odometry_msg.pose.covariance;
+
+  // The twist is in the child frame, so the velocity of the target origin is rotated into the target frame
+  const tf2::Vector3 angular_velocity(odometry_msg.twist.twist.angular.x, odometry_msg.twist.twist.angular.y, odometry_msg.twist.twist.angular.z);
+  const tf2::Vector3 linear_velocity(odometry_msg.twist.twist.linear.x, odometry_msg.twist.twist.linear.y, odometry_msg.twist.twist.linear.z);
+  const tf2::Vector3 target_angular_velocity = rotation_ * angular_velocity;
+  const tf2::Vector3 target_linear_velocity = rotation_ * (linear_velocity + angular_velocity.cross(lever_arm_));
+  target_odometry_msg->twist.twist.linear.x = target_linear_velocity.x();
+  target_odometry_msg->twist.twist.linear.y = target_linear_velocity.y();
+  target_odometry_msg->twist.twist.linear.z = target_linear_velocity.z();
+  target_odometry_msg->twist.twist.angular.x = target_angular_velocity.x();
+  target_odometry_msg->twist.twist.angular.y = target_angular_velocity.y();
+  target_odometry_msg->twist.twist.angular.z = target_angular_velocity.z();
+  for (size_t row = 0; row < 6; row += 3)
+    for (size_t column = 0; column < 6; column += 3)
+      rotateCovariance(odometry_msg.twist.covariance.data(), target_odometry_msg->twist.covariance.data(), 6, row, column);
+}
+
+void TargetFrameTransform::rotateCovariance(const double* covariance, double* target_covariance, const size_t stride, const size_t row, const size_t column) const
+{
+  // R * C * R^T for a single block
+  double rotated[3][3];
+  for (int i = 0; i < 3; i++)
+  {
+    for (int j = 0; j < 3; j++)
+    {
+      rotated[i][j] = 0;
+      for (int k = 0; k < 3; k++)
+        rotated[i][j] += rotation_[i][k] * covariance[(row + k) * stride + column + j];
+    }
+  }
+  for (int i = 0; i < 3; i++)
+  {
+    for (int j = 0; j < 3; j++)
+    {
+      double value = 0;
+      for (int k = 0; k < 3; k++)
+        value += rotated[i][k] * rotation_[j][k];
+      target_covariance[(row + i) * stride + column + j] = value;
+    }
+  }
+}
+
+}  // namespace microstrain
@@ -0,0 +1,258 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Parker-Lord Inertial Device Driver Implementation File
+//
+// Copyright (c) 2017, Brian Bingham
+// Copyright (c) 2020, Parker Hannifin Corp
+// This code is licensed under MIT license (see LICENSE file for details)
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include <cmath>
+#include <limits>
+#include <algorithm>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#include "microstrain_inertial_driver_common/utils/vibration_analyzer.h"
+
+namespace microstrain
+{
+
+// If the worker thread falls this far behind, the oldest segments are dropped so memory does not grow without bound
+constexpr size_t MAX_QUEUED_SEGMENTS = 64;
+
+VibrationAnalyzer::VibrationAnalyzer(const double sample_rate, const size_t window_size, const double overlap, const std::vector<double>& band_edges)
+  : sample_rate_(sample_rate), window_size_(window_size), band_edges_(band_edges),
+    pending_(NUM_SIGNALS), psd_sum_(NUM_SIGNALS, std::vector<double>(window_size / 2 + 1, 0.0)), psd_count_(NUM_SIGNALS, 0)
+{
+  hop_size_ = std::max<size_t>(1, static_cast<size_t>(std::lround(window_size_ * (1.0 - overlap))));
+
+  // Hann window
+  window_.resize(window_size_);
+  window_power_ = 0;
+  for (size_t i = 0; i < window_size_; i++)
+  {
+    window_[i] = 0.5 - 0.5 * std::cos(2.0 * M_PI * i / window_size_);
+    window_power_ += window_[i] * window_[i];
+  }
+
+  // FFT tables
+  twiddles_.resize(window_size_ / 2);
+  for (size_t i = 0; i < twiddles_.size(); i++)
+    twiddles_[i] = std::polar(1.0, -2.0 * M_PI * i / window_size_);
+  size_t bits = 0;
+  while ((static_cast<size_t>(1) << bits) < window_size_)
+    bits++;
+  bit_reversal_.resize(window_size_);
+  for (size_t i = 0; i < window_size_; i++)
+  {
+    size_t reversed = 0;
+    for (size_t b = 0; b < bits; b++)
+      reversed |= ((i >> b) & 1) << (bits - 1 - b);
+    bit_reversal_[i] = reversed;
+  }
+
+  for (auto& pending : pending_)
+    pending.reserve(window_size_);
+  free_samples_.reserve(MAX_QUEUED_SEGMENTS + 1);
+}
+
+VibrationAnalyzer::~VibrationAnalyzer()
+{
+  stop();
+}
+
+void VibrationAnalyzer::start()
+{
+  std::lock_guard<AuditedMutex> lock(queue_mutex_);
+  if (running_)
+    return;
+  running_ = true;
+  worker_ = std::thread(&VibrationAnalyzer::run, this);
+}
+
+void VibrationAnalyzer::stop()
+{
+  {
+    std::lock_guard<AuditedMutex> lock(queue_mutex_);
+    running_ = false;
+    queue_.clear();
+  }
+  queue_condition_.notify_all();
+  if (worker_.joinable())
+    worker_.join();
+}
+
+void VibrationAnalyzer::add(const size_t first_signal, const double x, const double y, const double z)
+{
+  if (first_signal + 2 >= NUM_SIGNALS)
+    return;
+
+  const double values[3] = {x, y, z};
+  for (size_t i = 0; i < 3; i++)
+  {
+    const size_t signal = first_signal + i;
+    std::vector<double>& pending = pending_[signal];
+    pending.push_back(values[i]);
+    if (pending.size() < window_size_)
+      continue;
+
+    // Keep the overlapping samples in a recycled buffer, and hand the complete one to the worker.
+    // Only the overlap is copied, and not while holding the lock the worker and the caller share
+    std::vector<double> samples;
+    {
+      std::lock_guard<AuditedMutex> lock(queue_mutex_);
+      if (!free_samples_.empty())
+      {
+        samples = std::move(free_samples_.back());
+        free_samples_.pop_back();
+      }
+    }
+    samples.reserve(window_size_);
+    samples.assign(pending.begin() + hop_size_, pending.end());
+    std::swap(samples, pending);
+    {
+      std::lock_guard<AuditedMutex> lock(queue_mutex_);
+      if (queue_.size() >= MAX_QUEUED_SEGMENTS)
+      {
+        free_samples_.push_back(std::move(queue_.front().samples));
+        queue_.pop_front();
+      }
+      queue_.push_back({signal, std::move(samples)});
+    }
+    queue_condition_.notify_one();
+  }
+}
+
+size_t VibrationAnalyzer::numColumns() const
+{
+  return band_edges_.size() - 1 + 2;
+}
+
+void VibrationAnalyzer::summarize(std::vector<double>* summary)
+{
+  const size_t num_columns = numColumns();
+  const size_t num_bands = num_columns - 2;
+  const double frequency_resolution = sample_rate_ / window_size_;
+  summary->assign(NUM_SIGNALS * num_columns, std::numeric_limits<double>::quiet_NaN());
+
+  std::lock_guard<std::mutex> lock(psd_mutex_);
+  for (size_t signal = 0; signal < NUM_SIGNALS; signal++)
+  {
+    if (psd_count_[signal] == 0)
+      continue;
+
+    // Welch's estimate is the average of the periodograms
+    std::vector<double>& psd = psd_sum_[signal];
+    for (double& power : psd)
+      power /= psd_count_[signal];
+
+    double* columns = summary->data() + signal * num_columns;
+    for (size_t band = 0; band < num_bands; band++)
+    {
+      double energy = 0;
+      for (size_t bin = 0; bin < psd.size(); bin++)
+      {
+        const double frequency = bin * frequency_resolution;
+        if (frequency >= band_edges_[band] && frequency < band_edges_[band + 1])
+          energy += psd[bin] * frequency_resolution;
+      }
+      columns[band] = energy;
+    }
+
+    // Skip the DC bin when looking for the peak, since the mean of the segment was removed
+    const auto peak = std::max_element(psd.begin() + 1, psd.end());
+    columns[num_bands] = (peak - psd.begin()) * frequency_resolution;
+    columns[num_bands + 1] = *peak;
+
+    std::fill(psd.begin(), psd.end(), 0.0);
+    psd_count_[signal] = 0;
+  }
+}
+
+void VibrationAnalyzer::run()
+{
+#ifdef __linux__
+  // Only run when nothing else wants the CPU
+  sched_param param = {};
+  pthread_setschedparam(pthread_self(), SCHED_IDLE, &param);
+#endif
+
+  while (true)
+  {
+    Segment segment;
+    {
+      std::unique_lock<AuditedMutex> lock(queue_mutex_);
+      queue_condition_.wait(lock, [this]() { return !running_ || !queue_.empty(); });
+      if (!running_)
+        return;
+      segment = std::move(queue_.front());
+      queue_.pop_front();
+    }
+    processSegment(segment);
+
+    // Give the buffer back, so the next segment does not need a new one
+    std::lock_guard<AuditedMutex> lock(queue_mutex_);
+    if (free_samples_.size() < MAX_QUEUED_SEGMENTS)
+      free_samples_.push_back(std::move(segment.samples));
+  }
+}
+
+void VibrationAnalyzer::processSegment(const Segment& segment)
+{
+  // Remove the mean so the DC component does not leak into the low frequency bins, then apply the window
+  double mean = 0;
+  for (const double sample : segment.samples)
+    mean += sample;
+  mean /= segment.samples.size();
+
+  std::vector<std::complex<double>> data(window_size_);
+  for (size_t i = 0; i < window_size_; i++)
+    data[i] = (segment.samples[i] - mean) * window_[i];
+  fft(&data);
+
+  // One sided power spectral density in units^2/Hz
+  const double scale = 1.0 / (sample_rate_ * window_power_);
+  std::vector<double> periodogram(window_size_ / 2 + 1);
+  for (size_t bin = 0; bin < periodogram.size(); bin++)
+  {
+    periodogram[bin] = std::norm(data[bin]) * scale;
+    if (bin != 0 && bin != window_size_ / 2)
+      periodogram[bin] *= 2;
+  }
+
+  std::lock_guard<std::mutex> lock(psd_mutex_);
+  std::vector<double>& psd = psd_sum_[segment.signal];
+  for (size_t bin = 0; bin < psd.size(); bin++)
+    psd[bin] += periodogram[bin];
+  psd_count_[segment.signal]++;
+}
+
+void VibrationAnalyzer::fft(std::vector<std::complex<double>>* data) const
+{
+  std::vector<std::complex<double>>& x = *data;
+  for (size_t i = 0; i < window_size_; i++)
+    if (i < bit_reversal_[i])
+      std::swap(x[i], x[bit_reversal_[i]]);
+
+  for (size_t length = 2; length <= window_size_; length <<= 1)
+  {
+    const size_t half = length / 2;
+    const size_t twiddle_stride = window_size_ / length;
+    for (size_t start = 0; start < window_size_; start += length)
+    {
+      for (size_t k = 0; k < half; k++)
+      {
+        const std::complex<double> odd = twiddles_[k * twiddle_stride] * x[start + k + half];
+        x[start + k + half] = x[start + k] - odd;
+        x[start + k] += odd;
+      }
+    }
+  }
+}
+
+}  // namespace microstrain
@@ -0,0 +1,105 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Parker-Lord Inertial Device Driver Implementation File
+//
+// Copyright (c) 2017, Brian Bingham
+// Copyright (c) 2020, Parker Hannifin Corp
+// This code is licensed under MIT license (see LICENSE file for details)
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include <cmath>
+#include <limits>
+#include <algorithm>
+
+#include "microstrain_inertial_driver_common/utils/windowed_statistics.h"
+
+namespace microstrain
+{
+
+WindowedStatistics::WindowedStatistics(const size_t num_signals)
+  : count_(num_signals), shift_(num_signals), min_(num_signals), max_(num_signals), sum_(num_signals), sum_squares_(num_signals)
+{
+  reset();
+}
+
+void WindowedStatistics::add(const size_t signal, const double value)
+{
+  if (signal >= count_.size())
+    return;
+
+  // Use the first sample in the window as the shift for the rest of the samples
+  if (count_[signal] == 0)
+    shift_[signal] = value;
+
+  const double shifted = value - shift_[signal];
+  count_[signal]++;
+  min_[signal] = std::min(min_[signal], value);
+  max_[signal] = std::max(max_[signal], value);
+  sum_[signal] += shifted;
+  sum_squares_[signal] += shifted * shifted;
+}
+
+void WindowedStatistics::add(const size_t first_signal, const double x, const double y, const double z)
+{
+  if (first_signal + 2 >= count_.size())
+    return;
+
+  // Written as a loop over contiguous signals so the compiler is free to vectorize it
+  const double values[3] = {x, y, z};
+  for (size_t i = 0; i < 3; i++)
+  {
+    const size_t signal = first_signal + i;
+    if (count_[signal] == 0)
+      shift_[signal] = values[i];
+    const double shifted = values[i] - shift_[signal];
+    count_[signal]++;
+    min_[signal] = std::min(min_[signal], values[i]);
+    max_[signal] = std::max(max_[signal], values[i]);
+    sum_[signal] += shifted;
+    sum_squares_[signal] += shifted * shifted;
+  }
+}
+
+size_t WindowedStatistics::numSignals() const
+{
+  return count_.size();
+}
+
+void WindowedStatistics::summarize(std::vector<double>* summary)
+{
+  summary->resize(count_.size() * NUM_STATISTICS);
+  for (size_t signal = 0; signal < count_.size(); signal++)
+  {
+    double* statistics = summary->data() + signal * NUM_STATISTICS;
+    if (count_[signal] == 0)
+    {
+      std::fill(statistics, statistics + NUM_STATISTICS, std::numeric_limits<double>::quiet_NaN());
+      continue;
+    }
+
+    // Population variance from the shifted sums, and RMS from the variance and the unshifted mean
+    const double count = static_cast<double>(count_[signal]);
+    const double shifted_mean = sum_[signal] / count;
+    const double mean = shift_[signal] + shifted_mean;
+    const double variance = std::max(0.0, sum_squares_[signal] / count - shifted_mean * shifted_mean);
+    statistics[STATISTIC_MIN] = min_[signal];
+    statistics[STATISTIC_MAX] = max_[signal];
+    statistics[STATISTIC_MEAN] = mean;
+    statistics[STATISTIC_RMS] = std::sqrt(variance + mean * mean);
+    statistics[STATISTIC_VARIANCE] = variance;
+  }
+  reset();
+}
+
+void WindowedStatistics::reset()
+{
+  std::fill(count_.begin(), count_.end(), 0);
+  std::fill(shift_.begin(), shift_.end(), 0.0);
+  std::fill(min_.begin(), min_.end(), std::numeric_limits<double>::infinity());
+  std::fill(max_.begin(), max_.end(), -std::numeric_limits<double>::infinity());
+  std::fill(sum_.begin(), sum_.end(), 0.0);
+  std::fill(sum_squares_.begin(), sum_squares_.end(), 0.0);
+}
+
+}  // namespace microstrain
@@ -0,0 +1,215 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Parker-Lord Inertial Device Driver Implementation File
+//
+// Copyright (c) 2017, Brian Bingham
+// Copyright (c) 2020, Parker Hannifin Corp
+// This code is licensed under MIT license (see LICENSE file for details)
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include <poll.h>
+#include <unistd.h>
+#include <sys/un.h>
+#include <sys/socket.h>
+
+#include <mutex>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+#include <cstring>
+
+#include <gtest/gtest.h>
+
+#include "microstrain_inertial_driver_common/utils/byte_proxy.h"
+
+namespace microstrain
+{
+
+// How long to wait for the proxy thread before failing a test
+constexpr std::chrono::milliseconds TEST_TIMEOUT(2000);
+
+/**
+ * \brief Builds a MIP packet with a single field
+ * \param descriptor_set Descriptor set of the packet
+ * \param field_descriptor Descriptor of the field
+ * \param payload Payload of the field
+ * \return The packet, including its checksum
+ */
+static std::vector<uint8_t> mipPacket(const uint8_t descriptor_set, const uint8_t field_descriptor, const std::vector<uint8_t>& payload)
+{
+  std::vector<uint8_t> packet = {0x75, 0x65, descriptor_set, static_cast<uint8_t>(payload.size() + 2), static_cast<uint8_t>(payload.size() + 2), field_descriptor};
+  packet.insert(packet.end(), payload.begin(), payload.end());
+  uint8_t checksum_msb = 0, checksum_lsb = 0;
+  for (const uint8_t byte : packet)
+  {
+    checksum_msb += byte;
+    checksum_lsb += checksum_msb;
+  }
+  packet.push_back(checksum_msb);
+  packet.push_back(checksum_lsb);
+  return packet;
+}
+
+/**
+ * \brief Builds the reply the device sends to a command
+ * \param descriptor_set Descriptor set of the command
+ * \param field_descriptor Descriptor of the command
+ * \return The reply, acknowledging the command
+ */
+static std::vector<uint8_t> mipReply(const uint8_t descriptor_set, const uint8_t field_descriptor)
+{
+  return mipPacket(descriptor_set, 0xF1, {field_descriptor, 0x00});
+}
+
+/**
+ * Stands in for the device the proxy forwards commands to
+ */
+class FakeDevice
+{
+ public:
+  bool send(const uint8_t* data, size_t size)
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    commands_.emplace_back(data, data + size);
+    return true;
+  }
+
+  std::vector<std::vector<uint8_t>> commands()
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return commands_;
+  }
+
+  bool waitForCommands(const size_t count)
+  {
+    const auto deadline = std::chrono::steady_clock::now() + TEST_TIMEOUT;
+    while (commands().size() < count)
+    {
+      if (std::chrono::steady_clock::now() > deadline)
+        return false;
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return true;
+  }
+
+ private:
+  std::mutex mutex_;
+  std::vector<std::vector<uint8_t>> commands_;
+};
+
+class ByteProxyTest : public ::testing::Test
+{
+ protected:
+  void SetUp() override
+  {
+    socket_path_ = "/tmp/microstrain_test_byte_proxy_" + std::to_string(getpid()) + ".sock";
+    proxy_.reset(new ByteProxy(4096, true, 1000));
+    std::string error;
+    ASSERT_TRUE(proxy_->start(socket_path_, &error)) << error;
+    proxy_->setSender([this](const uint8_t* data, size_t size) { return device_.send(data, size); });
+  }
+
+  void TearDown() override
+  {
+    for (const int fd : client_fds_)
+      close(fd);
+    proxy_.reset();
+  }
+
+  int connectClient()
+  {
+    const int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    struct sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    strncpy(address.sun_path, socket_path_.c_str(), sizeof(address.sun_path) - 1);
+    EXPECT_EQ(connect(fd, reinterpret_cast<struct sockaddr*>(&address), sizeof(address)), 0);
+    client_fds_.push_back(fd);
+
+    // Give the proxy thread a chance to accept the client, so it is sent everything written from here on
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    return fd;
+  }
+
+  static std::vector<uint8_t> readClient(const int fd, const size_t size)
+  {
+    std::vector<uint8_t> data;
+    const auto deadline = std::chrono::steady_clock::now() + TEST_TIMEOUT;
+    while (data.size() < size && std::chrono::steady_clock::now() < deadline)
+    {
+      struct pollfd poll_fd = {fd, POLLIN, 0};
+      if (poll(&poll_fd, 1, 10) <= 0)
+        continue;
+      uint8_t buffer[256];
+      const ssize_t count = recv(fd, buffer, sizeof(buffer), 0);
+      if (count <= 0)
+        break;
+      data.insert(data.end(), buffer, buffer + count);
+    }
+    return data;
+  }
+
+  std::string socket_path_;
+  FakeDevice device_;
+  std::unique_ptr<ByteProxy> proxy_;
+  std::vector<int> client_fds_;
+};
+
+TEST_F(ByteProxyTest, DriverCommandWaitingOnClientCommandDoesNotBlock)
+{
+  const int client_fd = connectClient();
+  const int other_client_fd = connectClient();
+
+  // A client sends a command, and the proxy forwards it to the device
+  const std::vector<uint8_t> client_command = mipPacket(0x01, 0x03, {});
+  ASSERT_EQ(send(client_fd, client_command.data(), client_command.size(), 0), static_cast<ssize_t>(client_command.size()));
+  ASSERT_TRUE(device_.waitForCommands(1));
+  EXPECT_EQ(device_.commands()[0], client_command);
+
+  // The driver sends its own command before the client's is answered. It has to be queued, not sent, and must not wait for the reply,
+  // as the reply can only arrive through the driver reading from the device on this same thread
+  const std::vector<uint8_t> driver_command = mipPacket(0x0C, 0x01, {0x01});
+  const auto begin_time = std::chrono::steady_clock::now();
+  EXPECT_FALSE(proxy_->beginDriverCommand(driver_command.data(), driver_command.size()));
+  EXPECT_LT(std::chrono::steady_clock::now() - begin_time, std::chrono::milliseconds(100));
+  EXPECT_EQ(device_.commands().size(), 1u);
+
+  // The driver reads the reply to the client's command. The proxy routes it to the client and then sends the driver's command
+  const std::vector<uint8_t> client_reply = mipReply(0x01, 0x03);
+  proxy_->write(client_reply.data(), client_reply.size());
+  ASSERT_TRUE(device_.waitForCommands(2));
+  EXPECT_EQ(device_.commands()[1], driver_command);
+
+  // The reply to the driver's command is for everyone, but the reply to the client's command is only for the client
+  const std::vector<uint8_t> driver_reply = mipReply(0x0C, 0x01);
+  proxy_->write(driver_reply.data(), driver_reply.size());
+
+  std::vector<uint8_t> expected = client_reply;
+  expected.insert(expected.end(), driver_reply.begin(), driver_reply.end());
+  EXPECT_EQ(readClient(client_fd, expected.size()), expected);
+  EXPECT_EQ(readClient(other_client_fd, driver_reply.size()), driver_reply);
+}
+
+TEST_F(ByteProxyTest, ClientCommandWaitsOnDriverCommand)
+{
+  const int client_fd = connectClient();
+
+  // With nothing outstanding, the driver sends its command itself
+  const std::vector<uint8_t> driver_command = mipPacket(0x0C, 0x01, {0x01});
+  EXPECT_TRUE(proxy_->beginDriverCommand(driver_command.data(), driver_command.size()));
+
+  // A command from a client is held back until the driver's command is answered
+  const std::vector<uint8_t> client_command = mipPacket(0x01, 0x03, {});
+  ASSERT_EQ(send(client_fd, client_command.data(), client_command.size(), 0), static_cast<ssize_t>(client_command.size()));
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  EXPECT_TRUE(device_.commands().empty());
+
+  const std::vector<uint8_t> driver_reply = mipReply(0x0C, 0x01);
+  proxy_->write(driver_reply.data(), driver_reply.size());
+  ASSERT_TRUE(device_.waitForCommands(1));
+  EXPECT_EQ(device_.commands()[0], client_command);
+}
+
+}  // namespace microstrain
@@ -0,0 +1,188 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Parker-Lord Inertial Device Driver Implementation File
+//
+// Copyright (c) 2017, Brian Bingham
+// Copyright (c) 2020, Parker Hannifin Corp
+// This code is licensed under MIT license (see LICENSE file for details)
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include <poll.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <termios.h>
+
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+#include <cstring>
+
+#include <gtest/gtest.h>
+
+#include "microstrain_inertial_driver_common/utils/handoff.h"
+
+namespace microstrain
+{
+
+// How long each side of the handoff waits for the other
+constexpr int TEST_HANDOFF_TIMEOUT_MS = 2000;
+
+/**
+ * \brief Reads bytes from a port until the expected number arrived or it times out
+ * \param fd The port to read from
+ * \param size Number of bytes to read
+ * \return The bytes that were read
+ */
+static std::vector<uint8_t> readPort(const int fd, const size_t size)
+{
+  std::vector<uint8_t> data;
+  const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(TEST_HANDOFF_TIMEOUT_MS);
+  while (data.size() < size && std::chrono::steady_clock::now() < deadline)
+  {
+    struct pollfd poll_fd = {fd, POLLIN, 0};
+    if (poll(&poll_fd, 1, 10) <= 0)
+      continue;
+    uint8_t buffer[256];
+    const ssize_t count = read(fd, buffer, sizeof(buffer));
+    if (count <= 0)
+      break;
+    data.insert(data.end(), buffer, buffer + count);
+  }
+  return data;
+}
+
+/**
+ * Hands off a pty that stands in for the serial port of a device, the same way a running driver hands off its main port
+ */
+class HandoffTest : public ::testing::Test
+{
+ protected:
+  void SetUp() override
+  {
+    socket_path_ = "/tmp/microstrain_test_handoff_" + std::to_string(getpid()) + ".sock";
+
+    // The master end plays the device, and the running driver has the slave end open like it would a serial port
+    device_fd_ = posix_openpt(O_RDWR | O_NOCTTY);
+    ASSERT_GE(device_fd_, 0);
+    ASSERT_EQ(grantpt(device_fd_), 0);
+    ASSERT_EQ(unlockpt(device_fd_), 0);
+    port_fd_ = open(ptsname(device_fd_), O_RDWR | O_NOCTTY);
+    ASSERT_GE(port_fd_, 0);
+    struct termios settings;
+    ASSERT_EQ(tcgetattr(port_fd_, &settings), 0);
+    cfmakeraw(&settings);
+    ASSERT_EQ(tcsetattr(port_fd_, TCSANOW, &settings), 0);
+  }
+
+  void TearDown() override
+  {
+    for (const int fd : {device_fd_, port_fd_, received_.main_fd, received_.aux_fd})
+      if (fd >= 0)
+        close(fd);
+  }
+
+  /**
+   * \brief Runs a handoff from a server with the given state to a receiver on another thread
+   * \param state The state the running driver sends
+   * \return true if both sides report the handoff succeeded
+   */
+  bool handOff(const HandoffState& state)
+  {
+    HandoffServer server;
+    std::string server_error;
+    if (!server.listen(socket_path_, &server_error))
+    {
+      ADD_FAILURE() << server_error;
+      return false;
+    }
+
+    bool received = false;
+    std::string receive_error;
+    std::thread receiver([&]()
+    {
+      received = receiveHandoff(socket_path_, TEST_HANDOFF_TIMEOUT_MS, &received_, &receive_error);
+    });
+
+    // The running driver checks for a replacement from its parsing loop
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(TEST_HANDOFF_TIMEOUT_MS);
+    while (!server.pending() && std::chrono::steady_clock::now() < deadline)
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    const bool sent = server.send(state, TEST_HANDOFF_TIMEOUT_MS, &server_error);
+    receiver.join();
+
+    EXPECT_TRUE(sent) << server_error;
+    EXPECT_TRUE(received) << receive_error;
+    return sent && received;
+  }
+
+  std::string socket_path_;
+  int device_fd_ = -1;
+  int port_fd_ = -1;
+  HandoffState received_;
+};
+
+TEST_F(HandoffTest, ReplacementTakesOverOpenPort)
+{
+  HandoffState state;
+  state.main_fd = port_fd_;
+  state.stream_hash = 0x0123456789ABCDEF;
+  state.config_hash = hashHandoffConfig("port=/dev/ttyACM0\n");
+  strncpy(state.device_info.model_name, "3DM-GQ7", sizeof(state.device_info.model_name) - 1);
+  state.device_info.firmware_version = 1234;
+  state.supported_descriptors = {0x0101, 0x0C01, 0x8001};
+  state.base_rates = {{0x80, 1000}, {0x82, 500}};
+  state.max_external_frame_ids = 4;
+  state.map_to_earth_valid = true;
+  state.map_to_earth_translation[0] = 1.5;
+  state.map_to_earth_rotation[3] = -1;
+  state.clock_bias_valid = true;
+  state.clock_bias = 0.25;
+  ASSERT_TRUE(handOff(state));
+
+  EXPECT_GE(received_.main_fd, 0);
+  EXPECT_EQ(received_.aux_fd, -1);
+  EXPECT_EQ(received_.stream_hash, state.stream_hash);
+  EXPECT_EQ(received_.config_hash, state.config_hash);
+  EXPECT_STREQ(received_.device_info.model_name, "3DM-GQ7");
+  EXPECT_EQ(received_.device_info.firmware_version, 1234);
+  EXPECT_EQ(received_.supported_descriptors, state.supported_descriptors);
+  EXPECT_EQ(received_.base_rates, state.base_rates);
+  EXPECT_EQ(received_.max_external_frame_ids, 4);
+  EXPECT_TRUE(received_.map_to_earth_valid);
+  EXPECT_EQ(received_.map_to_earth_translation[0], 1.5);
+  EXPECT_EQ(received_.map_to_earth_rotation[3], -1);
+  EXPECT_TRUE(received_.clock_bias_valid);
+  EXPECT_EQ(received_.clock_bias, 0.25);
+
+  // The running driver closes its copy of the port once it has handed it off, and the device keeps talking to the replacement
+  close(port_fd_);
+  port_fd_ = -1;
+  const std::vector<uint8_t> from_device = {0x75, 0x65, 0x80, 0x02, 0x02, 0x01, 0xE8, 0xC9};
+  ASSERT_EQ(write(device_fd_, from_device.data(), from_device.size()), static_cast<ssize_t>(from_device.size()));
+  EXPECT_EQ(readPort(received_.main_fd, from_device.size()), from_device);
+
+  const std::vector<uint8_t> to_device = {0x75, 0x65, 0x01, 0x02, 0x02, 0x01, 0xE0, 0xC6};
+  ASSERT_EQ(write(received_.main_fd, to_device.data(), to_device.size()), static_cast<ssize_t>(to_device.size()));
+  EXPECT_EQ(readPort(device_fd_, to_device.size()), to_device);
+}
+
+TEST_F(HandoffTest, NoRunningDriver)
+{
+  std::string error;
+  EXPECT_FALSE(receiveHandoff(socket_path_, TEST_HANDOFF_TIMEOUT_MS, &received_, &error));
+  EXPECT_FALSE(error.empty());
+  EXPECT_EQ(received_.main_fd, -1);
+}
+
+TEST(HandoffConfigTest, HashDependsOnEveryParameter)
+{
+  const std::string config = "filter_auto_heading_alignment_selector=1\nport=/dev/ttyACM0\n";
+  EXPECT_EQ(hashHandoffConfig(config), hashHandoffConfig(config));
+  EXPECT_NE(hashHandoffConfig(config), hashHandoffConfig("filter_auto_heading_alignment_selector=2\nport=/dev/ttyACM0\n"));
+  EXPECT_NE(hashHandoffConfig(config), hashHandoffConfig(""));
+}
+
+}  // namespace microstrain
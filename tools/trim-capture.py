@@ -0,0 +1,174 @@
+#!/usr/bin/env python3
+"""Trims a capture from a real device into seeds for the fuzzing harnesses in fuzz/.
+
+A capture is mostly the same few packets over and over, so it is split into small seeds of a few consecutive packets,
+and only the first seed of each layout is kept. Run the seeds through the harness with -merge=1 afterwards, so only
+the ones that add coverage end up in the corpus. See fuzz/README.md.
+
+  mip   Raw binary file recorded by the driver with raw_file_enable, for mip_dispatch_fuzzer and mip_parser_fuzzer.
+        Each seed is a few consecutive MIP packets, kept once per sequence of descriptor sets and field descriptors
+  nmea  Raw binary file recorded from a port the device sends NMEA on, for nmea_fuzzer.
+        Each seed is a few consecutive sentences with whatever was sent between them, kept once per sequence of sentence types
+  rtcm  RTCM 3 stream, like the corrections an NTRIP caster sends, for rtcm_framer_fuzzer.
+        Each seed is a few consecutive frames in the input format of the harness, kept once per sequence of message types
+"""
+
+import argparse
+import os
+import sys
+
+MIP_SYNC = b'\x75\x65'
+MIP_HEADER_SIZE = 4
+MIP_CHECKSUM_SIZE = 2
+
+RTCM_PREAMBLE = 0xD3
+RTCM_HEADER_SIZE = 3
+RTCM_CRC_SIZE = 3
+
+# Longest NMEA sentence the driver extracts, and the most bytes kept between two sentences
+NMEA_MAX_LENGTH = 82
+NMEA_MAX_GAP = 256
+
+# Options byte the RTCM seeds start with: the allowlist on, with GLONASS, Galileo and BeiDou in it
+RTCM_SEED_OPTIONS = 0x0F
+
+# Largest message the RTCM harness takes at once. Longer frames are split over several messages
+RTCM_MAX_MESSAGE_SIZE = 255
+
+
+def mip_checksum(packet):
+  msb = lsb = 0
+  for byte in packet:
+    msb = (msb + byte) & 0xFF
+    lsb = (lsb + msb) & 0xFF
+  return bytes([msb, lsb])
+
+
+def split_mip(data):
+  """Yields the valid MIP packets in data, and their layout"""
+  offset = 0
+  while True:
+    offset = data.find(MIP_SYNC, offset)
+    if offset < 0 or offset + MIP_HEADER_SIZE > len(data):
+      return
+    end = offset + MIP_HEADER_SIZE + data[offset + 3] + MIP_CHECKSUM_SIZE
+    packet = data[offset:end]
+    if len(packet) != end - offset or mip_checksum(packet[:-MIP_CHECKSUM_SIZE]) != packet[-MIP_CHECKSUM_SIZE:]:
+      offset += 1
+      continue
+
+    descriptors = []
+    field = MIP_HEADER_SIZE
+    while field + 1 < len(packet) - MIP_CHECKSUM_SIZE and packet[field] >= 2:
+      descriptors.append(packet[field + 1])
+      field += packet[field]
+    yield packet, (packet[2], tuple(descriptors))
+    offset = end
+
+
+def split_nmea(data):
+  """Yields each valid NMEA sentence in data along with the bytes before it, and the type of the sentence"""
+  offset = 0
+  previous_end = 0
+  while True:
+    starts = [start for start in (data.find(b'$', offset), data.find(b'!', offset)) if start >= 0]
+    if not starts:
+      return
+    start = min(starts)
+    end = data.find(b'\r\n', start)
+    if end < 0:
+      return
+    end += 2
+    sentence = data[start:end]
+    offset = start + 1
+    if len(sentence) > NMEA_MAX_LENGTH or len(sentence) < 6 or sentence[-5:-4] != b'*':
+      continue
+    checksum = 0
+    for byte in sentence[1:-5]:
+      checksum ^= byte
+    try:
+      if checksum != int(sentence[-4:-2], 16):
+        continue
+    except ValueError:
+      continue
+    yield data[max(previous_end, start - NMEA_MAX_GAP):end], sentence.split(b',')[0][1:]
+    previous_end = offset = end
+
+
+def crc24q(data):
+  crc = 0
+  for byte in data:
+    crc ^= byte << 16
+    for _ in range(8):
+      crc <<= 1
+      if crc & 0x1000000:
+        crc ^= 0x1864CFB
+  return crc & 0xFFFFFF
+
+
+def split_rtcm(data):
+  """Yields the valid RTCM 3 frames in data, and their message type"""
+  offset = 0
+  while True:
+    offset = data.find(bytes([RTCM_PREAMBLE]), offset)
+    if offset < 0 or offset + RTCM_HEADER_SIZE > len(data):
+      return
+    payload_size = ((data[offset + 1] & 0x03) << 8) | data[offset + 2]
+    end = offset + RTCM_HEADER_SIZE + payload_size + RTCM_CRC_SIZE
+    frame = data[offset:end]
+    if (data[offset + 1] & 0xFC) != 0 or len(frame) != end - offset or crc24q(frame[:-RTCM_CRC_SIZE]) != int.from_bytes(frame[-RTCM_CRC_SIZE:], 'big'):
+      offset += 1
+      continue
+    message_type = (frame[3] << 4) | (frame[4] >> 4) if payload_size >= 2 else 0
+    yield frame, message_type
+    offset = end
+
+
+def rtcm_seed(frames):
+  """Writes frames in the input format of rtcm_framer_fuzzer: the options byte, then messages of a length byte followed by that many bytes"""
+  seed = bytearray([RTCM_SEED_OPTIONS])
+  data = b''.join(frames)
+  for offset in range(0, len(data), RTCM_MAX_MESSAGE_SIZE):
+    message = data[offset:offset + RTCM_MAX_MESSAGE_SIZE]
+    seed.append(len(message))
+    seed += message
+  return bytes(seed)
+
+
+def main():
+  parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+  parser.add_argument('format', choices=['mip', 'nmea', 'rtcm'], help='What the capture contains')
+  parser.add_argument('capture', help='The capture to trim')
+  parser.add_argument('output', help='Directory to write the seeds to')
+  parser.add_argument('--count', type=int, default=4, help='Number of packets, sentences or frames in each seed')
+  parser.add_argument('--max-seeds', type=int, default=64, help='Most seeds to write')
+  args = parser.parse_args()
+
+  with open(args.capture, 'rb') as capture:
+    data = capture.read()
+  split = {'mip': split_mip, 'nmea': split_nmea, 'rtcm': split_rtcm}[args.format]
+  pieces = list(split(data))
+  if not pieces:
+    sys.exit('No valid {} data found in {}'.format(args.format, args.capture))
+
+  os.makedirs(args.output, exist_ok=True)
+  prefix = os.path.splitext(os.path.basename(args.capture))[0]
+  layouts = set()
+  written = 0
+  for start in range(0, len(pieces), args.count):
+    window = pieces[start:start + args.count]
+    layout = tuple(piece[1] for piece in window)
+    if layout in layouts:
+      continue
+    layouts.add(layout)
+    seed = rtcm_seed([piece[0] for piece in window]) if args.format == 'rtcm' else b''.join(piece[0] for piece in window)
+    with open(os.path.join(args.output, '{}_{:04d}'.format(prefix, written)), 'wb') as seed_file:
+      seed_file.write(seed)
+    written += 1
+    if written >= args.max_seeds:
+      break
+  print('Wrote {} seeds from {} {} pieces with {} layouts'.format(written, len(pieces), args.format, len(layouts)))
+
+
+if __name__ == '__main__':
+  main()